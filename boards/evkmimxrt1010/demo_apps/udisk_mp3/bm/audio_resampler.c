@@ -0,0 +1,274 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <math.h>
+#include <string.h>
+#include "audio_resampler.h"
+#include "arm_math.h"
+#include "fsl_common.h"
+#include "fsl_debug_console.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define RESAMPLER_HISTORY    (AUDIO_RESAMPLER_TAPS - 1U)
+#define RESAMPLER_MAX_FRAMES (AUDIO_RESAMPLER_MAX_BLOCK_SIZE / 4U)
+
+/*! @brief Kaiser window parameter, about 70 dB of stopband */
+#define RESAMPLER_KAISER_BETA (7.0f)
+
+/*! @brief the conversion in progress */
+typedef struct _audio_resampler
+{
+    const audio_source_t *source; /*!< source being converted */
+    uint32_t inRate;              /*!< source sample rate */
+    uint32_t outRate;             /*!< output sample rate */
+    uint64_t phaseScale;          /*!< acc * phaseScale >> 32 is the filter phase in 16.16 */
+    uint32_t acc;                 /*!< position past the pos input sample, in 1/outRate of an input sample */
+    uint32_t pos;                 /*!< input sample the next output ends its filter on */
+    uint32_t fill;                /*!< input samples in the history buffers */
+    uint32_t inWordBytes;         /*!< bytes per sample read from the source, 2 or 4 */
+    uint32_t blockFrames;         /*!< output frames per block */
+    bool end;                     /*!< the source has no more to read */
+    uint64_t frames;              /*!< frames produced */
+    uint64_t cycles;              /*!< core cycles spent filtering */
+} audio_resampler_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static audio_resampler_t s_rs;
+/* row p holds the filter taps for phase p / AUDIO_RESAMPLER_PHASES, oldest input sample first */
+static q15_t s_coeffs[(AUDIO_RESAMPLER_PHASES + 1U) * AUDIO_RESAMPLER_TAPS];
+/* per channel, the last RESAMPLER_HISTORY samples already read followed by the new ones */
+static q15_t s_history[2][RESAMPLER_HISTORY + RESAMPLER_MAX_FRAMES];
+/* the source reads into this as it would into a PCM ring block, the WAV source by disk DMA */
+SDK_L1DCACHE_ALIGN(static uint8_t s_input[AUDIO_RESAMPLER_MAX_BLOCK_SIZE]);
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static float AUDIO_ResamplerBesselI0(float x)
+{
+    float sum  = 1.0f;
+    float term = 1.0f;
+    uint32_t k;
+
+    for (k = 1U; k < 25U; k++)
+    {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/* Tabulate a Kaiser windowed sinc cutting off at cutoff cycles per input sample, each phase
+ * scaled to unity gain so the level does not ripple with the position. */
+static void AUDIO_ResamplerDesign(float cutoff)
+{
+    const float center = AUDIO_RESAMPLER_TAPS / 2.0f;
+    const float i0Beta = AUDIO_ResamplerBesselI0(RESAMPLER_KAISER_BETA);
+    float row[AUDIO_RESAMPLER_TAPS];
+    float t;
+    float u;
+    float sum;
+    uint32_t p;
+    uint32_t i;
+
+    for (p = 0U; p <= AUDIO_RESAMPLER_PHASES; p++)
+    {
+        sum = 0.0f;
+        for (i = 0U; i < AUDIO_RESAMPLER_TAPS; i++)
+        {
+            /* tap i weighs the input sample TAPS - 1 - i before the newest one */
+            t = (float)(AUDIO_RESAMPLER_TAPS - 1U - i) + (float)p / AUDIO_RESAMPLER_PHASES - center;
+            u = t / center;
+            row[i] = 2.0f * cutoff;
+            if (t != 0.0f)
+            {
+                row[i] = sinf(2.0f * PI * cutoff * t) / (PI * t);
+            }
+            row[i] *=
+                (u * u < 1.0f) ? AUDIO_ResamplerBesselI0(RESAMPLER_KAISER_BETA * sqrtf(1.0f - u * u)) / i0Beta : 0.0f;
+            sum += row[i];
+        }
+        for (i = 0U; i < AUDIO_RESAMPLER_TAPS; i++)
+        {
+            s_coeffs[p * AUDIO_RESAMPLER_TAPS + i] = (q15_t)__SSAT((int32_t)lrintf(row[i] / sum * 32768.0f), 16);
+        }
+    }
+}
+
+/* Read the next block of the source behind the samples still needed. */
+static void AUDIO_ResamplerFill(void)
+{
+    uint32_t pcmOffset;
+    uint32_t pcmSize;
+    uint32_t frames;
+    uint32_t shift;
+    uint32_t i;
+    const int16_t *pcm16;
+    const int32_t *pcm32;
+
+    if (s_rs.source->read(s_input, &pcmOffset, &pcmSize) == AUDIO_SOURCE_END)
+    {
+        s_rs.end = true;
+        return;
+    }
+
+    shift = s_rs.fill - RESAMPLER_HISTORY;
+    for (i = 0U; i < 2U; i++)
+    {
+        memmove(s_history[i], s_history[i] + shift, RESAMPLER_HISTORY * sizeof(q15_t));
+    }
+    s_rs.pos -= shift;
+    s_rs.fill = RESAMPLER_HISTORY;
+
+    frames = pcmSize / (2U * s_rs.inWordBytes);
+    if (s_rs.inWordBytes == 2U)
+    {
+        pcm16 = (const int16_t *)(s_input + pcmOffset);
+        for (i = 0U; i < frames; i++)
+        {
+            s_history[0][s_rs.fill + i] = pcm16[2U * i];
+            s_history[1][s_rs.fill + i] = pcm16[2U * i + 1U];
+        }
+    }
+    else
+    {
+        pcm32 = (const int32_t *)(s_input + pcmOffset);
+        for (i = 0U; i < frames; i++)
+        {
+            s_history[0][s_rs.fill + i] = (q15_t)(pcm32[2U * i] >> 16);
+            s_history[1][s_rs.fill + i] = (q15_t)(pcm32[2U * i + 1U] >> 16);
+        }
+    }
+    s_rs.fill += frames;
+}
+
+/* Filter output frames into out while the input lasts, return how many. */
+static uint32_t AUDIO_ResamplerConvert(int16_t *out, uint32_t maxFrames)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t frames = 0U;
+    uint32_t phase;
+    uint32_t ch;
+    const q15_t *row;
+    q15_t *x;
+    q63_t y0;
+    q63_t y1;
+
+    while ((frames < maxFrames) && (s_rs.pos < s_rs.fill))
+    {
+        phase = (uint32_t)(((uint64_t)s_rs.acc * s_rs.phaseScale) >> 32U);
+        row   = &s_coeffs[(phase >> 16U) * AUDIO_RESAMPLER_TAPS];
+        for (ch = 0U; ch < 2U; ch++)
+        {
+            x = &s_history[ch][s_rs.pos - RESAMPLER_HISTORY];
+            arm_dot_prod_q15((q15_t *)row, x, AUDIO_RESAMPLER_TAPS, &y0);
+            arm_dot_prod_q15((q15_t *)row + AUDIO_RESAMPLER_TAPS, x, AUDIO_RESAMPLER_TAPS, &y1);
+            y0 += ((y1 - y0) * (q63_t)(phase & 0xFFFFU)) >> 16U;
+            *out++ = (int16_t)__SSAT((int32_t)(y0 >> 15U), 16);
+        }
+        frames++;
+
+        s_rs.acc += s_rs.inRate;
+        while (s_rs.acc >= s_rs.outRate)
+        {
+            s_rs.acc -= s_rs.outRate;
+            s_rs.pos++;
+        }
+    }
+    s_rs.frames += frames;
+    s_rs.cycles += DWT->CYCCNT - start;
+
+    return frames;
+}
+
+/* Fill block from what is left of the last source block, reading one more if that runs out. */
+static uint8_t AUDIO_ResamplerRead(uint8_t *block, uint32_t *pcmOffset, uint32_t *pcmSize)
+{
+    int16_t *out = (int16_t *)block;
+    uint32_t frames;
+
+    frames = AUDIO_ResamplerConvert(out, s_rs.blockFrames);
+    if ((frames < s_rs.blockFrames) && !s_rs.end)
+    {
+        AUDIO_ResamplerFill();
+        frames += AUDIO_ResamplerConvert(out + 2U * frames, s_rs.blockFrames - frames);
+    }
+    if ((frames == 0U) && s_rs.end)
+    {
+        return AUDIO_SOURCE_END;
+    }
+    *pcmOffset = 0U;
+    *pcmSize   = frames * 4U;
+
+    return AUDIO_SOURCE_OK;
+}
+
+static void AUDIO_ResamplerService(void)
+{
+    if (s_rs.source->service != NULL)
+    {
+        s_rs.source->service();
+    }
+}
+
+static void AUDIO_ResamplerClose(void)
+{
+    uint32_t cyclesPerFrame = (s_rs.frames != 0U) ? (uint32_t)(s_rs.cycles / s_rs.frames) : 0U;
+    /* in hundredths of a percent of the core */
+    uint32_t load = (uint32_t)((uint64_t)cyclesPerFrame * s_rs.outRate * 10000U / SystemCoreClock);
+
+    s_rs.source->close();
+    PRINTF("resampler: %d -> %d Hz, %d cycles/frame, %d.%02d%% CPU\r\n", s_rs.inRate, s_rs.outRate,
+           cyclesPerFrame, load / 100U, load % 100U);
+}
+
+static const audio_source_t s_resamplerSource = {
+    "resampler", NULL, NULL, AUDIO_ResamplerRead, AUDIO_ResamplerService, AUDIO_ResamplerClose,
+};
+
+const audio_source_t *AUDIO_ResamplerOpen(const audio_source_t *source,
+                                           audio_source_format_t *format,
+                                           uint32_t sampleRate_Hz)
+{
+    if ((format->blockSize > AUDIO_RESAMPLER_MAX_BLOCK_SIZE) || (format->sampleRate_Hz == 0U))
+    {
+        source->close();
+        return NULL;
+    }
+
+    memset(&s_rs, 0, sizeof(s_rs));
+    memset(s_history, 0, sizeof(s_history));
+    s_rs.source      = source;
+    s_rs.inRate      = format->sampleRate_Hz;
+    s_rs.outRate     = sampleRate_Hz;
+    s_rs.phaseScale  = ((uint64_t)AUDIO_RESAMPLER_PHASES << 48U) / sampleRate_Hz;
+    s_rs.pos         = RESAMPLER_HISTORY;
+    s_rs.fill        = RESAMPLER_HISTORY;
+    s_rs.inWordBytes = format->bitWidth / 8U;
+    s_rs.blockFrames = format->blockSize / 4U;
+
+    /* below the lower of the two Nyquist rates, in cycles per input sample */
+    AUDIO_ResamplerDesign(0.5f * MIN(1.0f, (float)sampleRate_Hz / (float)format->sampleRate_Hz));
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    PRINTF("resampler: %d -> %d Hz\r\n", format->sampleRate_Hz, sampleRate_Hz);
+    format->sampleRate_Hz = sampleRate_Hz;
+    format->bitWidth      = 16U;
+
+    return &s_resamplerSource;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _AUDIO_RESAMPLER_H_
+#define _AUDIO_RESAMPLER_H_
+
+#include <stdint.h>
+#include "audio_source.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief input samples each output sample is filtered from, a multiple of 4 for the CMSIS-DSP dot product */
+#define AUDIO_RESAMPLER_TAPS (32U)
+/*! @brief filter phases tabulated per input sample, the outputs in between interpolate two of them */
+#define AUDIO_RESAMPLER_PHASES (64U)
+/*! @brief largest audio_source_format_t::blockSize of a source that can be resampled */
+#define AUDIO_RESAMPLER_MAX_BLOCK_SIZE (2304U)
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Play an opened source at another sample rate.
+ *
+ * The returned source reads the given one and converts its PCM through a polyphase
+ * windowed-sinc filter, with the CMSIS-DSP q15 dot product as the kernel: every output
+ * sample is filtered from AUDIO_RESAMPLER_TAPS input samples per channel with the two
+ * tabulated phases around its position, and the two results interpolated. Any ratio works,
+ * the position is kept as an exact fraction of the two rates so it never drifts. The
+ * output is 16-bit, 24-bit sources lose their low bits. Closing it closes the source, and
+ * prints the CPU time the conversion took.
+ *
+ * @param source        source with a track open.
+ * @param format        format of that source on entry, of the returned source on return.
+ * @param sampleRate_Hz rate to play at.
+ *
+ * @return the source to play, or NULL with the track closed if its blocks are too large.
+ */
+const audio_source_t *AUDIO_ResamplerOpen(const audio_source_t *source,
+                                           audio_source_format_t *format,
+                                           uint32_t sampleRate_Hz);
+
+#endif /* _AUDIO_RESAMPLER_H_ */
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include "audio_source.h"
+#include "ff.h"
+#include "fsl_common.h"
+#include "fsl_debug_console.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* Tried in this order, the first source whose probe accepts the header plays the file. */
+static const audio_source_t *const s_audioSources[] = {
+    &g_wavSource,
+    &g_mp3Source,
+};
+
+/* the disk reads the header straight into the FIL sector buffer */
+AT_NONCACHEABLE_SECTION(static FIL s_probeFile);
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+const audio_source_t *AUDIO_SourceOpen(const char *path, audio_source_format_t *format)
+{
+    uint8_t header[AUDIO_SOURCE_PROBE_SIZE];
+    const audio_source_t *source = NULL;
+    UINT br = 0U;
+    uint32_t i;
+
+    if (f_open(&s_probeFile, path, FA_READ) != FR_OK)
+    {
+        PRINTF("%s: cannot open\r\n", path);
+        return NULL;
+    }
+    if (f_read(&s_probeFile, header, sizeof(header), &br) != FR_OK)
+    {
+        br = 0U;
+    }
+    f_close(&s_probeFile);
+
+    for (i = 0U; i < ARRAY_SIZE(s_audioSources); i++)
+    {
+        if (s_audioSources[i]->probe(header, br))
+        {
+            source = s_audioSources[i];
+            break;
+        }
+    }
+    if (source == NULL)
+    {
+        PRINTF("%s: unknown file type\r\n", path);
+        return NULL;
+    }
+    if (source->open(path, format) != 0U)
+    {
+        PRINTF("%s: cannot play as %s\r\n", path, source->name);
+        return NULL;
+    }
+
+    return source;
+}
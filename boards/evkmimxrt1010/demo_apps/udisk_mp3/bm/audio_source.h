@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _AUDIO_SOURCE_H_
+#define _AUDIO_SOURCE_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief bytes of the file header handed to audio_source_t::probe */
+#define AUDIO_SOURCE_PROBE_SIZE (64U)
+
+/*! @brief audio_source_t::read return values */
+#define AUDIO_SOURCE_END (0U) /*!< the track is over, nothing was read */
+#define AUDIO_SOURCE_OK  (1U) /*!< block filled, possibly with no audio at all */
+
+/*!
+ * @brief What a source puts into the PCM ring, and so how the SAI and the codec have to run.
+ *
+ * PCM is always interleaved stereo, in 16-bit words or in 32-bit words with the sample
+ * MSB aligned.
+ */
+typedef struct _audio_source_format
+{
+    uint32_t sampleRate_Hz; /*!< sample rate of the track */
+    uint32_t bitWidth;      /*!< SAI word width, 16 or 32 bits */
+    uint32_t blockSize;     /*!< PCM ring block size in bytes, one audio_source_t::read at most */
+} audio_source_format_t;
+
+/*!
+ * @brief A kind of audio file the player can play.
+ *
+ * A track is played by one source from open to close. The player calls read whenever a PCM
+ * ring block is free and queues what it returns to the SAI EDMA; service runs on every pass
+ * of the main loop, whether or not a block was free.
+ */
+typedef struct _audio_source
+{
+    const char *name; /*!< for messages */
+    /*! @brief check the first bytes of a file (up to AUDIO_SOURCE_PROBE_SIZE), nonzero if this source takes it */
+    uint8_t (*probe)(const uint8_t *header, uint32_t size);
+    /*! @brief start playing path from its beginning, fill in format; 0 on success */
+    uint8_t (*open)(const char *path, audio_source_format_t *format);
+    /*! @brief fill block (format.blockSize bytes), the audio is the pcmSize bytes from block + pcmOffset */
+    uint8_t (*read)(uint8_t *block, uint32_t *pcmOffset, uint32_t *pcmSize);
+    /*! @brief background work such as read-ahead, never waits; NULL if there is none */
+    void (*service)(void);
+    /*! @brief stop playing and release the file */
+    void (*close)(void);
+} audio_source_t;
+
+/*! @brief WAVE files holding 16 or 24-bit PCM, streamed into the PCM ring without decoding */
+extern const audio_source_t g_wavSource;
+/*! @brief MPEG audio layer 3, through the Helix decoder */
+extern const audio_source_t g_mp3Source;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Open a file with the first registered source that recognizes its header.
+ *
+ * @param path   file to play.
+ * @param format filled in with what the source produces.
+ *
+ * @return the source playing the file, or NULL if the file cannot be read or its source refused it.
+ */
+const audio_source_t *AUDIO_SourceOpen(const char *path, audio_source_format_t *format);
+
+#endif /* _AUDIO_SOURCE_H_ */
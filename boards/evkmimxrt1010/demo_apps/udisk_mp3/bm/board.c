@@ -133,9 +133,10 @@ void BOARD_ConfigMPU(void)
     MPU->RBAR = ARM_MPU_RBAR(4, 0x00000000U);
     MPU->RASR = ARM_MPU_RASR(0, ARM_MPU_AP_FULL, 0, 0, 1, 1, 0, ARM_MPU_REGION_SIZE_32KB);
 
-    /* Region 5 setting: Memory with Normal type, not shareable, outer/inner write back */
+    /* Region 5 setting: Memory with Normal type, not shareable, outer/inner write back.
+     * 64KB covers the largest DTCM the FlexRAM profiles of the linker file allocate. */
     MPU->RBAR = ARM_MPU_RBAR(5, 0x20000000U);
-    MPU->RASR = ARM_MPU_RASR(0, ARM_MPU_AP_FULL, 0, 0, 1, 1, 0, ARM_MPU_REGION_SIZE_32KB);
+    MPU->RASR = ARM_MPU_RASR(0, ARM_MPU_AP_FULL, 0, 0, 1, 1, 0, ARM_MPU_REGION_SIZE_64KB);
 
 #if defined(OCRAM_IS_SHAREABLE)
     /* Region 6 setting: Memory with Normal type, shareable, outer/inner write back */
@@ -0,0 +1,401 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "disk_cache.h"
+#include "fsl_common.h"
+#include "fsl_usb_disk.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if (FF_MIN_SS != FF_MAX_SS)
+#error "the disk cache needs a fixed sector size"
+#endif
+
+#if (DISK_CACHE_FAT_LINE_SECTORS > 8U) || (DISK_CACHE_DIR_LINE_SECTORS > 8U) || (DISK_CACHE_DATA_LINE_SECTORS > 8U)
+#error "a cache line holds 8 sectors at most"
+#endif
+
+#define DISK_CACHE_SECTOR_SIZE (FF_MAX_SS)
+
+/*! @brief one line, a run of lineSectors sectors starting at a multiple of lineSectors */
+typedef struct _disk_cache_line
+{
+    DWORD sector;     /*!< first sector of the line */
+    uint32_t lastUse; /*!< s_CacheUseCount at the last access, the smallest one is evicted */
+    BYTE pdrv;        /*!< drive the line belongs to */
+    uint8_t valid;    /*!< bit n set: sector + n holds disk data */
+    uint8_t dirty;    /*!< bit n set: sector + n is newer than the disk */
+} disk_cache_line_t;
+
+/*! @brief the lines of one sector class and their data */
+typedef struct _disk_cache_pool
+{
+    disk_cache_line_t *lines;
+    uint8_t *buffer;
+    uint8_t lineCount;
+    uint8_t lineSectors;
+} disk_cache_pool_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+SDK_L1DCACHE_ALIGN(
+    static uint8_t s_CacheFatBuffer[DISK_CACHE_FAT_LINES * DISK_CACHE_FAT_LINE_SECTORS * DISK_CACHE_SECTOR_SIZE]);
+SDK_L1DCACHE_ALIGN(
+    static uint8_t s_CacheDirBuffer[DISK_CACHE_DIR_LINES * DISK_CACHE_DIR_LINE_SECTORS * DISK_CACHE_SECTOR_SIZE]);
+SDK_L1DCACHE_ALIGN(
+    static uint8_t s_CacheDataBuffer[DISK_CACHE_DATA_LINES * DISK_CACHE_DATA_LINE_SECTORS * DISK_CACHE_SECTOR_SIZE]);
+static disk_cache_line_t s_CacheFatLines[DISK_CACHE_FAT_LINES];
+static disk_cache_line_t s_CacheDirLines[DISK_CACHE_DIR_LINES];
+static disk_cache_line_t s_CacheDataLines[DISK_CACHE_DATA_LINES];
+
+static const disk_cache_pool_t s_CachePool[kDISK_CacheClassNum] = {
+    {s_CacheFatLines, s_CacheFatBuffer, DISK_CACHE_FAT_LINES, DISK_CACHE_FAT_LINE_SECTORS},
+    {s_CacheDirLines, s_CacheDirBuffer, DISK_CACHE_DIR_LINES, DISK_CACHE_DIR_LINE_SECTORS},
+    {s_CacheDataLines, s_CacheDataBuffer, DISK_CACHE_DATA_LINES, DISK_CACHE_DATA_LINE_SECTORS},
+};
+
+static const FATFS *s_CacheFs;
+static uint32_t s_CacheUseCount;
+static disk_cache_stats_t s_CacheStats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static disk_cache_class_t DISK_CacheClassify(const BYTE *buff, DWORD sector)
+{
+    if ((s_CacheFs == NULL) || (buff != s_CacheFs->win))
+    {
+        return kDISK_CacheData;
+    }
+    /* fs_type is 0 while find_volume still reads the boot sectors */
+    if ((s_CacheFs->fs_type != 0U) && (sector >= s_CacheFs->fatbase) &&
+        ((sector - s_CacheFs->fatbase) < ((DWORD)s_CacheFs->n_fats * s_CacheFs->fsize)))
+    {
+        return kDISK_CacheFat;
+    }
+    return kDISK_CacheDir;
+}
+
+static uint8_t *DISK_CacheSectorData(const disk_cache_pool_t *pool, const disk_cache_line_t *line, uint32_t index)
+{
+    return pool->buffer + ((uint32_t)(line - pool->lines) * pool->lineSectors + index) * DISK_CACHE_SECTOR_SIZE;
+}
+
+/* the line of any pool holding sector, a sector is never valid in two lines */
+static disk_cache_line_t *DISK_CacheFind(BYTE pdrv, DWORD sector, disk_cache_class_t *cacheClass, uint32_t *index)
+{
+    const disk_cache_pool_t *pool;
+    disk_cache_line_t *line;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < kDISK_CacheClassNum; i++)
+    {
+        pool = &s_CachePool[i];
+        for (j = 0U; j < pool->lineCount; j++)
+        {
+            line = &pool->lines[j];
+            if ((line->valid != 0U) && (line->pdrv == pdrv) && (sector >= line->sector) &&
+                ((sector - line->sector) < pool->lineSectors) &&
+                ((line->valid & (1U << (sector - line->sector))) != 0U))
+            {
+                *cacheClass = (disk_cache_class_t)i;
+                *index      = sector - line->sector;
+                return line;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* write the dirty sectors of a line back, contiguous ones in one command */
+static DRESULT DISK_CacheWriteBack(disk_cache_class_t cacheClass, disk_cache_line_t *line)
+{
+    const disk_cache_pool_t *pool = &s_CachePool[cacheClass];
+    DRESULT result                = RES_OK;
+    uint32_t first;
+    uint32_t last;
+
+    first = 0U;
+    while (first < pool->lineSectors)
+    {
+        if ((line->dirty & (1U << first)) == 0U)
+        {
+            first++;
+            continue;
+        }
+        last = first + 1U;
+        while ((last < pool->lineSectors) && ((line->dirty & (1U << last)) != 0U))
+        {
+            last++;
+        }
+        if (USB_HostMsdWriteDisk(line->pdrv, DISK_CacheSectorData(pool, line, first), line->sector + first,
+                                 last - first) == RES_OK)
+        {
+            line->dirty &= (uint8_t)~(((1U << last) - 1U) & ~((1U << first) - 1U));
+            s_CacheStats.writeBacks[cacheClass] += last - first;
+        }
+        else if (result == RES_OK)
+        {
+            result = RES_ERROR;
+        }
+        first = last;
+    }
+    return result;
+}
+
+/* the line of the pool for the line-aligned sector, taking the least recently used one if none is */
+static DRESULT DISK_CacheGetLine(BYTE pdrv, disk_cache_class_t cacheClass, DWORD sector, disk_cache_line_t **line)
+{
+    const disk_cache_pool_t *pool = &s_CachePool[cacheClass];
+    disk_cache_line_t *victim     = &pool->lines[0];
+    DWORD lineSector              = sector - (sector % pool->lineSectors);
+    DRESULT result;
+    uint32_t i;
+
+    for (i = 0U; i < pool->lineCount; i++)
+    {
+        if ((pool->lines[i].valid != 0U) && (pool->lines[i].pdrv == pdrv) && (pool->lines[i].sector == lineSector))
+        {
+            *line = &pool->lines[i];
+            return RES_OK;
+        }
+        if ((victim->valid != 0U) && ((pool->lines[i].valid == 0U) || (pool->lines[i].lastUse < victim->lastUse)))
+        {
+            victim = &pool->lines[i];
+        }
+    }
+
+    result = DISK_CacheWriteBack(cacheClass, victim);
+    if (result != RES_OK)
+    {
+        /* keep the dirty sectors, the caller fails instead */
+        return result;
+    }
+    victim->pdrv   = pdrv;
+    victim->sector = lineSector;
+    victim->valid  = 0U;
+    victim->dirty  = 0U;
+    *line          = victim;
+    return RES_OK;
+}
+
+/* read one sector into its pool, with the rest of the line when the line is empty */
+static DRESULT DISK_CacheFill(
+    BYTE pdrv, disk_cache_class_t cacheClass, DWORD sector, disk_cache_line_t **line, uint32_t *index)
+{
+    const disk_cache_pool_t *pool = &s_CachePool[cacheClass];
+    disk_cache_class_t otherClass;
+    uint32_t otherIndex;
+    uint32_t i;
+    DRESULT result;
+
+    result = DISK_CacheGetLine(pdrv, cacheClass, sector, line);
+    if (result != RES_OK)
+    {
+        return result;
+    }
+    *index = sector - (*line)->sector;
+
+    if ((*line)->valid == 0U)
+    {
+        /* read the whole line unless another pool already holds one of its sectors */
+        for (i = 0U; i < pool->lineSectors; i++)
+        {
+            if (DISK_CacheFind(pdrv, (*line)->sector + i, &otherClass, &otherIndex) != NULL)
+            {
+                break;
+            }
+        }
+        if ((i == pool->lineSectors) &&
+            (USB_HostMsdReadDisk(pdrv, DISK_CacheSectorData(pool, *line, 0U), (*line)->sector, pool->lineSectors) ==
+             RES_OK))
+        {
+            (*line)->valid = (uint8_t)((1U << pool->lineSectors) - 1U);
+            return RES_OK;
+        }
+        /* or the line runs past the end of the disk: read the sector alone */
+    }
+
+    result = USB_HostMsdReadDisk(pdrv, DISK_CacheSectorData(pool, *line, *index), sector, 1U);
+    if (result == RES_OK)
+    {
+        (*line)->valid |= (uint8_t)(1U << *index);
+    }
+    return result;
+}
+
+void DISK_CacheAttach(const FATFS *fs)
+{
+    s_CacheFs = fs;
+}
+
+void DISK_CacheInvalidate(BYTE pdrv)
+{
+    const disk_cache_pool_t *pool;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < kDISK_CacheClassNum; i++)
+    {
+        pool = &s_CachePool[i];
+        for (j = 0U; j < pool->lineCount; j++)
+        {
+            if (pool->lines[j].pdrv == pdrv)
+            {
+                pool->lines[j].valid = 0U;
+                pool->lines[j].dirty = 0U;
+            }
+        }
+    }
+}
+
+void DISK_CacheOverlay(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    disk_cache_class_t cacheClass;
+    disk_cache_line_t *line;
+    uint32_t index;
+    UINT i;
+
+    /* the cached copies are never older than the disk */
+    for (i = 0U; i < count; i++)
+    {
+        line = DISK_CacheFind(pdrv, sector + i, &cacheClass, &index);
+        if (line != NULL)
+        {
+            memcpy(buff + i * DISK_CACHE_SECTOR_SIZE, DISK_CacheSectorData(&s_CachePool[cacheClass], line, index),
+                   DISK_CACHE_SECTOR_SIZE);
+        }
+    }
+}
+
+DRESULT DISK_CacheRead(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    disk_cache_class_t cacheClass;
+    disk_cache_line_t *line;
+    uint32_t index;
+    DRESULT result;
+
+    if (count > 1U)
+    {
+        result = USB_HostMsdReadDisk(pdrv, buff, sector, count);
+        if (result != RES_OK)
+        {
+            return result;
+        }
+        DISK_CacheOverlay(pdrv, buff, sector, count);
+        s_CacheStats.bypassed += count;
+        return RES_OK;
+    }
+
+    line = DISK_CacheFind(pdrv, sector, &cacheClass, &index);
+    if (line != NULL)
+    {
+        s_CacheStats.hits[cacheClass]++;
+    }
+    else
+    {
+        cacheClass = DISK_CacheClassify(buff, sector);
+        result     = DISK_CacheFill(pdrv, cacheClass, sector, &line, &index);
+        if (result != RES_OK)
+        {
+            return result;
+        }
+        s_CacheStats.misses[cacheClass]++;
+    }
+    line->lastUse = ++s_CacheUseCount;
+    memcpy(buff, DISK_CacheSectorData(&s_CachePool[cacheClass], line, index), DISK_CACHE_SECTOR_SIZE);
+    return RES_OK;
+}
+
+DRESULT DISK_CacheWrite(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    disk_cache_class_t cacheClass;
+    disk_cache_line_t *line;
+    uint32_t index;
+    DRESULT result;
+    UINT i;
+
+    if (count > 1U)
+    {
+        result = USB_HostMsdWriteDisk(pdrv, buff, sector, count);
+        if (result != RES_OK)
+        {
+            return result;
+        }
+        for (i = 0U; i < count; i++)
+        {
+            line = DISK_CacheFind(pdrv, sector + i, &cacheClass, &index);
+            if (line != NULL)
+            {
+                memcpy(DISK_CacheSectorData(&s_CachePool[cacheClass], line, index), buff + i * DISK_CACHE_SECTOR_SIZE,
+                       DISK_CACHE_SECTOR_SIZE);
+                line->dirty &= (uint8_t) ~(1U << index);
+            }
+        }
+        s_CacheStats.bypassed += count;
+        return RES_OK;
+    }
+
+    line = DISK_CacheFind(pdrv, sector, &cacheClass, &index);
+    if (line == NULL)
+    {
+        /* a whole sector is written, nothing has to be read first */
+        cacheClass = DISK_CacheClassify(buff, sector);
+        result     = DISK_CacheGetLine(pdrv, cacheClass, sector, &line);
+        if (result != RES_OK)
+        {
+            return result;
+        }
+        index = sector - line->sector;
+        line->valid |= (uint8_t)(1U << index);
+    }
+    line->dirty |= (uint8_t)(1U << index);
+    line->lastUse = ++s_CacheUseCount;
+    memcpy(DISK_CacheSectorData(&s_CachePool[cacheClass], line, index), buff, DISK_CACHE_SECTOR_SIZE);
+    return RES_OK;
+}
+
+DRESULT DISK_CacheSync(BYTE pdrv)
+{
+    const disk_cache_pool_t *pool;
+    DRESULT result = RES_OK;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < kDISK_CacheClassNum; i++)
+    {
+        pool = &s_CachePool[i];
+        for (j = 0U; j < pool->lineCount; j++)
+        {
+            if ((pool->lines[j].pdrv == pdrv) && (pool->lines[j].dirty != 0U) &&
+                (DISK_CacheWriteBack((disk_cache_class_t)i, &pool->lines[j]) != RES_OK) && (result == RES_OK))
+            {
+                result = RES_ERROR;
+            }
+        }
+    }
+    return result;
+}
+
+void DISK_CacheGetStats(disk_cache_stats_t *stats)
+{
+    *stats = s_CacheStats;
+}
+
+void DISK_CacheResetStats(void)
+{
+    memset(&s_CacheStats, 0, sizeof(s_CacheStats));
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _DISK_CACHE_H_
+#define _DISK_CACHE_H_
+
+#include <stdint.h>
+#include "ff.h"
+#include "diskio.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief lines in the FAT pool, and sectors per line; a miss reads the whole line in one command */
+#define DISK_CACHE_FAT_LINES (4U)
+#define DISK_CACHE_FAT_LINE_SECTORS (2U)
+/*! @brief lines in the directory pool (boot sector, FSINFO and directory entries), and sectors per line */
+#define DISK_CACHE_DIR_LINES (2U)
+#define DISK_CACHE_DIR_LINE_SECTORS (1U)
+/*! @brief lines in the data read-ahead pool, and sectors per line; only single sector file data goes here */
+#define DISK_CACHE_DATA_LINES (1U)
+#define DISK_CACHE_DATA_LINE_SECTORS (4U)
+
+/*!
+ * @brief Sector classes, each cached in its own pool.
+ *
+ * Write-back LRU sector cache between FatFs and the USB disk, enabled by USB_DISK_CACHE_ENABLE
+ * in ffconf.h. FatFs reads FAT and directory sectors one at a time through FATFS::win, over and
+ * over on cluster chain walks and directory scans; those land in their own pools so that file
+ * data cannot evict them. Multi-sector data transfers go straight to the disk, as do the
+ * asynchronous reads of the stream prefetcher; reads lay the cached sectors over what came
+ * from the disk (DISK_CacheOverlay), so they see sectors still dirty in the cache too.
+ */
+typedef enum _disk_cache_class
+{
+    kDISK_CacheFat = 0U, /*!< sectors of the FAT copies */
+    kDISK_CacheDir,      /*!< other sectors FatFs reads through FATFS::win */
+    kDISK_CacheData,     /*!< file data, read ahead line by line */
+    kDISK_CacheClassNum,
+} disk_cache_class_t;
+
+/*!
+ * @brief Sector counts since the last DISK_CacheResetStats.
+ *
+ * Hits and misses count sectors FatFs asked for, so a miss that reads a line of four
+ * sectors still counts once; the sectors read with it count as hits when asked for later.
+ */
+typedef struct _disk_cache_stats
+{
+    uint32_t hits[kDISK_CacheClassNum];       /*!< sectors served from the pool */
+    uint32_t misses[kDISK_CacheClassNum];     /*!< sectors that needed a disk read */
+    uint32_t writeBacks[kDISK_CacheClassNum]; /*!< dirty sectors written on eviction or sync */
+    uint32_t bypassed;                        /*!< sectors of multi-sector data transfers, not cached */
+} disk_cache_stats_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Tell the cache which filesystem object reads through it.
+ *
+ * Sectors are classified by FATFS::win and the FAT location of fs, before this is called
+ * (or while fs is not mounted) every single sector read counts as file data or directory.
+ *
+ * @param fs filesystem object registered with f_mount, NULL to detach.
+ */
+void DISK_CacheAttach(const FATFS *fs);
+
+/*!
+ * @brief Drop every line without writing anything back, for a new medium.
+ *
+ * Dirty sectors are lost, call DISK_CacheSync first while the old medium is still there.
+ *
+ * @param pdrv Physical drive number.
+ */
+void DISK_CacheInvalidate(BYTE pdrv);
+
+/*!
+ * @brief Read sectors through the cache, disk_read semantics.
+ *
+ * @param pdrv   Physical drive number.
+ * @param buff   Pointer to the data buffer to store read data.
+ * @param sector Start sector number.
+ * @param count  Number of sectors to read.
+ *
+ * @return the result of the disk reads and of the write-backs of evicted lines.
+ */
+DRESULT DISK_CacheRead(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+
+/*!
+ * @brief Lay the cached copies of sectors over data read straight from the disk.
+ *
+ * For reads that bypass the cache, such as the asynchronous reads of the stream prefetcher:
+ * call it once the data is in buff, sectors dirty in the cache then read as FatFs wrote them.
+ *
+ * @param pdrv   Physical drive number.
+ * @param buff   Data of count sectors read from the disk.
+ * @param sector Start sector number.
+ * @param count  Number of sectors in buff.
+ */
+void DISK_CacheOverlay(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+
+/*!
+ * @brief Write sectors through the cache, disk_write semantics.
+ *
+ * Single sectors stay dirty in the cache until they are evicted or synced.
+ *
+ * @param pdrv   Physical drive number.
+ * @param buff   Pointer to the data to be written.
+ * @param sector Start sector number.
+ * @param count  Number of sectors to write.
+ *
+ * @return the result of the disk writes and of the write-backs of evicted lines.
+ */
+DRESULT DISK_CacheWrite(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+/*!
+ * @brief Write every dirty sector back to the disk, for CTRL_SYNC.
+ *
+ * @param pdrv Physical drive number.
+ *
+ * @return RES_OK, or the first failed write; the failed sectors stay dirty.
+ */
+DRESULT DISK_CacheSync(BYTE pdrv);
+
+/*!
+ * @brief Copy the hit and miss counters.
+ *
+ * @param stats receives the counters.
+ */
+void DISK_CacheGetStats(disk_cache_stats_t *stats);
+
+/*!
+ * @brief Clear the hit and miss counters.
+ */
+void DISK_CacheResetStats(void);
+
+#endif /* _DISK_CACHE_H_ */
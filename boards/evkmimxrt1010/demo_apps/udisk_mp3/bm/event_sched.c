@@ -0,0 +1,92 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include "event_sched.h"
+#include "fsl_common.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* events posted and not taken yet */
+static volatile uint32_t s_EventPending;
+static event_sched_handler_t s_EventHandler[EVENT_SCHED_MAX_EVENTS];
+static void *s_EventParam[EVENT_SCHED_MAX_EVENTS];
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void EVENT_SchedSetHandler(uint32_t event, event_sched_handler_t handler, void *param)
+{
+    uint32_t i;
+
+    for (i = 0U; i < EVENT_SCHED_MAX_EVENTS; i++)
+    {
+        if (event == (1UL << i))
+        {
+            s_EventParam[i]   = param;
+            s_EventHandler[i] = handler;
+            break;
+        }
+    }
+}
+
+void EVENT_SchedPost(uint32_t events)
+{
+    uint32_t primask = DisableGlobalIRQ();
+
+    s_EventPending |= events;
+    EnableGlobalIRQ(primask);
+}
+
+uint32_t EVENT_SchedRun(void)
+{
+    uint32_t primask = DisableGlobalIRQ();
+    uint32_t events  = s_EventPending;
+    uint32_t i;
+
+    s_EventPending = 0U;
+    EnableGlobalIRQ(primask);
+
+    for (i = 0U; i < EVENT_SCHED_MAX_EVENTS; i++)
+    {
+        if (((events & (1UL << i)) != 0U) && (s_EventHandler[i] != NULL))
+        {
+            s_EventHandler[i](s_EventParam[i]);
+        }
+    }
+    return events;
+}
+
+void EVENT_SchedIdle(void)
+{
+    uint32_t primask = DisableGlobalIRQ();
+
+    /* with PRIMASK set a pending interrupt still ends the WFI, it is taken once PRIMASK is restored */
+    if (s_EventPending == 0U)
+    {
+        __DSB();
+        __WFI();
+        __ISB();
+    }
+    EnableGlobalIRQ(primask);
+}
+
+void EVENT_SchedWait(volatile uint8_t *busy)
+{
+    while (*busy)
+    {
+        EVENT_SchedRun();
+        if (*busy)
+        {
+            EVENT_SchedIdle();
+        }
+    }
+}
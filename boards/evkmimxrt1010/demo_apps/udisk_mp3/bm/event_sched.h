@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _EVENT_SCHED_H_
+#define _EVENT_SCHED_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief the USB host controller interrupted, its task has messages to handle */
+#define EVENT_SCHED_USB (1U << 0U)
+/*! @brief the SAI played out a block, the PCM ring has room */
+#define EVENT_SCHED_AUDIO (1U << 1U)
+/*! @brief number of event bits the scheduler keeps handlers for */
+#define EVENT_SCHED_MAX_EVENTS (2U)
+
+/*!
+ * @brief Handler run by EVENT_SchedRun for a posted event.
+ *
+ * Interrupts post events, the main loop takes them in EVENT_SchedRun and sleeps in
+ * EVENT_SchedIdle while none is pending. An event with no handler only wakes the core;
+ * whoever sleeps on it checks the state it stands for again before sleeping once more.
+ *
+ * Handlers run in the main loop context, one after the other, and may post events again.
+ * EVENT_SchedRun is also called from inside blocking waits, so a handler must not block
+ * or start work that waits on the scheduler itself.
+ */
+typedef void (*event_sched_handler_t)(void *param);
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Set the handler of an event, NULL leaves it as a wake-up only.
+ *
+ * @param event   one EVENT_SCHED_ bit.
+ * @param handler run by EVENT_SchedRun while the event is pending.
+ * @param param   passed to handler.
+ */
+void EVENT_SchedSetHandler(uint32_t event, event_sched_handler_t handler, void *param);
+
+/*!
+ * @brief Mark events pending, safe from interrupts.
+ *
+ * @param events EVENT_SCHED_ bits.
+ */
+void EVENT_SchedPost(uint32_t events);
+
+/*!
+ * @brief Take every pending event and run the handlers of those that have one.
+ *
+ * @return the events taken.
+ */
+uint32_t EVENT_SchedRun(void);
+
+/*!
+ * @brief Sleep until an event is pending, returns at once if one already is.
+ *
+ * The check and the WFI run with interrupts masked, an interrupt between them still ends the sleep.
+ */
+void EVENT_SchedIdle(void);
+
+/*!
+ * @brief Run the scheduler until *busy drops to 0, sleeping in between.
+ *
+ * For completion flags cleared by a handler or by a callback a handler runs.
+ *
+ * @param busy flag to wait on.
+ */
+void EVENT_SchedWait(volatile uint8_t *busy);
+
+#endif /* _EVENT_SCHED_H_ */
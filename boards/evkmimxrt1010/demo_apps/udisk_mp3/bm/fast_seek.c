@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "fast_seek.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief a cluster link map and the file it maps */
+typedef struct _fast_seek_map
+{
+    FIL *file;        /*!< open file using the map, NULL while the map is free */
+    FATFS *fs;        /*!< volume of the mapped file, NULL if the map holds nothing */
+    WORD id;          /*!< mount ID of fs when the map was built */
+    DWORD sclust;     /*!< first cluster of the mapped file */
+    FSIZE_t size;     /*!< size of the mapped file */
+    uint32_t lastUse; /*!< s_FastSeekUseCount at the last close, the smallest free one is rebuilt */
+    DWORD table[FAST_SEEK_MAP_SIZE];
+} fast_seek_map_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static fast_seek_map_t s_FastSeekMap[FAST_SEEK_MAP_NUM];
+static uint32_t s_FastSeekUseCount;
+static fast_seek_stats_t s_FastSeekStats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void FAST_SeekMap(FIL *file)
+{
+    fast_seek_map_t *map = NULL;
+    uint32_t i;
+
+    if (file->obj.sclust == 0U)
+    {
+        /* empty file, nothing to seek in */
+        return;
+    }
+
+    for (i = 0U; i < FAST_SEEK_MAP_NUM; i++)
+    {
+        if ((s_FastSeekMap[i].file == NULL) && (s_FastSeekMap[i].fs == file->obj.fs) &&
+            (s_FastSeekMap[i].id == file->obj.id) && (s_FastSeekMap[i].sclust == file->obj.sclust) &&
+            (s_FastSeekMap[i].size == file->obj.objsize))
+        {
+            s_FastSeekMap[i].file = file;
+            file->cltbl           = s_FastSeekMap[i].table;
+            s_FastSeekStats.reused++;
+            return;
+        }
+        if ((s_FastSeekMap[i].file == NULL) && ((map == NULL) || (s_FastSeekMap[i].lastUse < map->lastUse)))
+        {
+            map = &s_FastSeekMap[i];
+        }
+    }
+    if (map == NULL)
+    {
+        s_FastSeekStats.unmapped++;
+        return;
+    }
+
+    map->fs       = NULL;
+    map->table[0] = FAST_SEEK_MAP_SIZE;
+    file->cltbl   = map->table;
+    if (f_lseek(file, CREATE_LINKMAP) != FR_OK)
+    {
+        /* FR_NOT_ENOUGH_CORE for a file in too many fragments, it keeps walking the FAT */
+        file->cltbl = NULL;
+        s_FastSeekStats.unmapped++;
+        return;
+    }
+    map->file   = file;
+    map->fs     = file->obj.fs;
+    map->id     = file->obj.id;
+    map->sclust = file->obj.sclust;
+    map->size   = file->obj.objsize;
+    s_FastSeekStats.built++;
+}
+
+FRESULT FAST_SeekOpen(FIL *file, const TCHAR *path)
+{
+    FRESULT res = f_open(file, path, FA_READ);
+
+    if (res == FR_OK)
+    {
+        FAST_SeekMap(file);
+    }
+    return res;
+}
+
+FRESULT FAST_SeekClose(FIL *file)
+{
+    uint32_t i;
+
+    for (i = 0U; i < FAST_SEEK_MAP_NUM; i++)
+    {
+        if (s_FastSeekMap[i].file == file)
+        {
+            s_FastSeekMap[i].file    = NULL;
+            s_FastSeekMap[i].lastUse = ++s_FastSeekUseCount;
+        }
+    }
+    return f_close(file);
+}
+
+void FAST_SeekGetStats(fast_seek_stats_t *stats)
+{
+    *stats = s_FastSeekStats;
+}
+
+void FAST_SeekResetStats(void)
+{
+    memset(&s_FastSeekStats, 0, sizeof(s_FastSeekStats));
+}
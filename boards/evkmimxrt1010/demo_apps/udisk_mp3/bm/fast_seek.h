@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _FAST_SEEK_H_
+#define _FAST_SEEK_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if !FF_USE_FASTSEEK
+#error "fast_seek needs FF_USE_FASTSEEK in ffconf.h"
+#endif
+
+/*! @brief cluster link maps in the pool: the player has one file open at a time (the mp3_get_info probe
+ *  closes its file before the track opens it, a track before the next one), so one map follows the track */
+#define FAST_SEEK_MAP_NUM (1U)
+/*! @brief DWORDs per map, a file in up to (FAST_SEEK_MAP_SIZE - 2) / 2 fragments gets one */
+#define FAST_SEEK_MAP_SIZE (64U)
+
+/*!
+ * @brief Counts since the last FAST_SeekResetStats.
+ *
+ * Files opened through FAST_SeekOpen get a cluster link map (CLMT) from the pool, FatFs then
+ * finds the cluster of any offset in the map instead of walking the FAT chain from the start of
+ * the file, for f_lseek and for f_read crossing a cluster. The map is built by one chain walk at
+ * open. A map stays in the pool once its file is closed and is taken up again, without a chain
+ * walk, when a file with the same first cluster and size on the same mount is opened: files
+ * opened through FAST_SeekOpen must not be rewritten on the disk while the volume is mounted.
+ */
+typedef struct _fast_seek_stats
+{
+    uint32_t built;    /*!< maps built by a chain walk */
+    uint32_t reused;   /*!< opens that took up the map of a closed file */
+    uint32_t unmapped; /*!< opens left to seek through the FAT: pool in use or file too fragmented */
+} fast_seek_stats_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Open a file for reading and give it a cluster link map.
+ *
+ * Without a free map, or if the file has more fragments than a map holds, the file is still
+ * opened and seeks the usual way.
+ *
+ * @param file file object.
+ * @param path file to open.
+ *
+ * @return the result of f_open.
+ */
+FRESULT FAST_SeekOpen(FIL *file, const TCHAR *path);
+
+/*!
+ * @brief Return the map of a file to the pool and close the file.
+ *
+ * @param file file opened with FAST_SeekOpen.
+ *
+ * @return the result of f_close.
+ */
+FRESULT FAST_SeekClose(FIL *file);
+
+/*!
+ * @brief Copy the map counters.
+ *
+ * @param stats receives the counters.
+ */
+void FAST_SeekGetStats(fast_seek_stats_t *stats);
+
+/*!
+ * @brief Clear the map counters.
+ */
+void FAST_SeekResetStats(void);
+
+#endif /* _FAST_SEEK_H_ */
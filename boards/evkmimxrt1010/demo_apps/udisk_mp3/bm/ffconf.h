@@ -11,6 +11,8 @@
 / MSDK adaptation configuration
 /---------------------------------------------------------------------------*/
 #define USB_DISK_ENABLE
+/* sector cache between FatFs and the USB disk, see disk_cache.h */
+#define USB_DISK_CACHE_ENABLE
 
 /*---------------------------------------------------------------------------/
 / Function Configurations
@@ -45,7 +47,7 @@
 #define FF_USE_MKFS 1
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
-#define FF_USE_FASTSEEK 0
+#define FF_USE_FASTSEEK 1
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 #define FF_USE_EXPAND 0
@@ -23,6 +23,25 @@
 /*! @brief mass storage read/write retry time */
 #define USB_HOST_FATFS_RW_RETRY_TIMES                   (2U)
 
+/*! @brief most bytes one READ(10) or WRITE(10) moves, larger requests are split and read two commands
+ *  at a time; the EHCI driver needs a qTD per 16 to 20 KB of data, see USB_HOST_CONFIG_EHCI_MAX_QTD */
+#define USB_HOST_FATFS_MAX_TRANSFER_SIZE                (64U * 1024U)
+
+/*! @brief with cacheable USB buffers, sectors to or from a buffer that is not aligned to the cache
+ *  line are bounced through a buffer of this many bytes, several sectors per command */
+#define USB_HOST_FATFS_BOUNCE_BUFFER_SIZE               (16U * 1024U)
+
+/*!
+ * @brief completion callback of USB_HostMsdReadDiskAsync.
+ *
+ * Runs from the USB host task, which the event scheduler runs after a USB interrupt. It must not issue
+ * disk commands or wait on the disk itself.
+ *
+ * @param param          the parameter given to USB_HostMsdReadDiskAsync.
+ * @param result         RES_OK, or RES_NOTRDY when the read failed.
+ */
+typedef void (*usb_host_disk_callback_t)(void *param, DRESULT result);
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -59,6 +78,28 @@ extern DSTATUS USB_HostMsdGetDiskStatus(BYTE pdrv);
  */
 extern DRESULT USB_HostMsdReadDisk(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
 
+/*!
+ * @brief start a READ(10) without waiting for it to complete.
+ *
+ * Only one asynchronous read can be outstanding; the blocking functions below wait for it
+ * before they issue their own command. The data is transferred directly into buff, so buff
+ * must be DMA accessible and the caller owns any cache maintenance on it.
+ *
+ * @param pdrv           Physical drive number.
+ * @param buff           Pointer to the data buffer to store read data.
+ * @param sector         Start sector number.
+ * @param count          Number of sectors to read.
+ * @param callback       called once the read has finished, not when this returns an error.
+ * @param param          passed to callback.
+ *
+ * @retval RES_OK        the command is queued.
+ * @retval RES_PARERR    parameter error.
+ * @retval RES_ERROR     usb stack driver error.
+ * @retval RES_NOTRDY    the previous asynchronous read is still in flight.
+ */
+extern DRESULT USB_HostMsdReadDiskAsync(
+    BYTE pdrv, BYTE *buff, DWORD sector, UINT count, usb_host_disk_callback_t callback, void *param);
+
 /*!
  * @brief fatfs call this function to write data to physical disk.
  *
@@ -13,6 +13,10 @@
 #ifdef USB_DISK_ENABLE
 
 #include "fsl_usb_disk.h" /* FatFs lower layer API */
+#include "event_sched.h"
+#if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
+#include "fsl_cache.h"
+#endif
 
 
 /*******************************************************************************
@@ -35,21 +39,54 @@
  */
 static void USB_HostMsdUfiCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status);
 
+/*!
+ * @brief host msd asynchronous read callback.
+ *
+ * This function is used as callback function for the READ(10) started by USB_HostMsdReadDiskAsync,
+ * it passes the result on to the caller's callback.
+ *
+ * @param param      NULL.
+ * @param data       data buffer pointer.
+ * @param dataLength data length.
+ * @status           transfer result status.
+ */
+static void USB_HostMsdAsyncReadCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status);
+
+/*!
+ * @brief host msd pipelined read callback.
+ *
+ * This function is used as callback function for the READ(10) commands of USB_HostMsdReadDisk.
+ *
+ * @param param      index of the command in s_ReadIng.
+ * @param data       data buffer pointer.
+ * @param dataLength data length.
+ * @status           transfer result status.
+ */
+static void USB_HostMsdReadCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status);
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 
-extern usb_host_handle g_HostHandle;
-
 usb_host_class_handle g_UsbFatfsClassHandle;
 static uint32_t s_FatfsSectorSize;
 /* command on-going state. It should set to 1 when start command, it is set to 0 in the callback */
 static volatile uint8_t ufiIng;
 /* command callback status */
 static volatile usb_status_t ufiStatus;
+/* asynchronous read on-going state, it is set to 0 in the callback */
+static volatile uint8_t s_AsyncReadIng;
+/* asynchronous read completion callback and its parameter */
+static usb_host_disk_callback_t s_AsyncReadCallback;
+static void *s_AsyncReadParam;
+/* pipelined READ(10) on-going state, one per command in flight, set to 0 in the callback */
+static volatile uint8_t s_ReadIng[2];
+/* pipelined READ(10) callback status */
+static volatile usb_status_t s_ReadStatus[2];
 
 #if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t s_UsbTransferBuffer[FF_MAX_SS];
+/* bounce buffer for sectors to and from buffers not aligned to the cache line */
+USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t s_UsbTransferBuffer[USB_HOST_FATFS_BOUNCE_BUFFER_SIZE];
 #else
 USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t s_UsbTransferBuffer[20];
 #endif
@@ -64,26 +101,32 @@ static void USB_HostMsdUfiCallback(void *param, uint8_t *data, uint32_t dataLeng
     ufiStatus = status;
 }
 
-static inline void USB_HostControllerTaskFunction(usb_host_handle hostHandle)
+static void USB_HostMsdAsyncReadCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status)
+{
+    s_AsyncReadIng = 0;
+    s_AsyncReadCallback(s_AsyncReadParam, (status == kStatus_USB_Success) ? RES_OK : RES_NOTRDY);
+}
+
+static void USB_HostMsdReadCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status)
 {
-#if ((defined USB_HOST_CONFIG_KHCI) && (USB_HOST_CONFIG_KHCI))
-    USB_HostKhciTaskFunction(hostHandle);
-#endif /* USB_HOST_CONFIG_KHCI */
-#if ((defined USB_HOST_CONFIG_EHCI) && (USB_HOST_CONFIG_EHCI))
-    USB_HostEhciTaskFunction(hostHandle);
-#endif /* USB_HOST_CONFIG_EHCI */
-#if ((defined USB_HOST_CONFIG_IP3516HS) && (USB_HOST_CONFIG_IP3516HS > 0U))
-        USB_HostIp3516HsTaskFunction(g_HostHandle);
-#endif /* USB_HOST_CONFIG_IP3516HS */
-#if ((defined USB_HOST_CONFIG_OHCI) && (USB_HOST_CONFIG_OHCI > 0U))
-        USB_HostOhciTaskFunction(g_HostHandle);
-#endif /* USB_HOST_CONFIG_OHCI */
+    uint32_t slot = (uint32_t)param;
+
+    s_ReadStatus[slot] = status;
+    s_ReadIng[slot] = 0;
+}
+
+/* the msd class runs one command at a time, let an asynchronous read finish before a blocking command */
+static void USB_HostMsdWaitAsyncRead(void)
+{
+    EVENT_SchedWait(&s_AsyncReadIng);
 }
 
 DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
 {
     uint32_t address;
 
+    USB_HostMsdWaitAsyncRead();
+
     /* test unit ready */
     ufiIng = 1;
     if (g_UsbFatfsClassHandle == NULL)
@@ -94,10 +137,7 @@ DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
     {
         return STA_NOINIT;
     }
-    while (ufiIng) /* wait the command */
-    {
-        USB_HostControllerTaskFunction(g_HostHandle);
-    }
+    EVENT_SchedWait(&ufiIng); /* wait the command */
 
     /*request sense */
     ufiIng = 1;
@@ -110,10 +150,7 @@ DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
     {
         return STA_NOINIT;
     }
-    while (ufiIng) /* wait the command */
-    {
-        USB_HostControllerTaskFunction(g_HostHandle);
-    }
+    EVENT_SchedWait(&ufiIng); /* wait the command */
 
     /* get the sector size */
     ufiIng = 1;
@@ -128,10 +165,7 @@ DSTATUS USB_HostMsdInitializeDisk(BYTE pdrv)
     }
     else
     {
-        while (ufiIng)
-        {
-            USB_HostControllerTaskFunction(g_HostHandle);
-        }
+        EVENT_SchedWait(&ufiIng);
         if (ufiStatus == kStatus_USB_Success)
         {
             address = (uint32_t)&s_UsbTransferBuffer[0];
@@ -152,135 +186,272 @@ DSTATUS USB_HostMsdGetDiskStatus(BYTE pdrv)
     return 0x00;
 }
 
-DRESULT USB_HostMsdReadDisk(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+/* one READ(10) or WRITE(10) of count sectors through buff, retried on failure */
+static DRESULT USB_HostMsdTransferSectors(uint8_t write, uint8_t *buff, uint32_t sector, uint32_t count)
 {
     DRESULT fatfs_code = RES_ERROR;
     usb_status_t status = kStatus_USB_Success;
     uint32_t retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-    uint8_t *transferBuf;
-    uint32_t sectorCount;
-    uint32_t sectorIndex;
-#if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-    uint32_t index;
-#endif
 
-    if (!count)
+    while (retry--)
     {
-        return RES_PARERR;
+        ufiIng = 1;
+        if (g_UsbFatfsClassHandle == NULL)
+        {
+            return RES_ERROR;
+        }
+        if (write)
+        {
+            status = USB_HostMsdWrite10(g_UsbFatfsClassHandle, 0, sector, buff, s_FatfsSectorSize * count, count,
+                                        USB_HostMsdUfiCallback, NULL);
+        }
+        else
+        {
+            status = USB_HostMsdRead10(g_UsbFatfsClassHandle, 0, sector, buff, s_FatfsSectorSize * count, count,
+                                       USB_HostMsdUfiCallback, NULL);
+        }
+        if (status != kStatus_USB_Success)
+        {
+            fatfs_code = RES_ERROR;
+        }
+        else
+        {
+            EVENT_SchedWait(&ufiIng);
+            if (ufiStatus == kStatus_USB_Success)
+            {
+                fatfs_code = RES_OK;
+                break;
+            }
+            else
+            {
+                fatfs_code = RES_NOTRDY;
+            }
+        }
     }
+    return fatfs_code;
+}
+
+/* sectors moved per command, bounded so a transfer never needs more qTDs than the controller has */
+static uint32_t USB_HostMsdMaxSectors(void)
+{
+    uint32_t sectors = USB_HOST_FATFS_MAX_TRANSFER_SIZE / s_FatfsSectorSize;
+
+    return (sectors != 0U) ? sectors : 1U;
+}
 
 #if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-    transferBuf = s_UsbTransferBuffer;
-    sectorCount = 1;
-    for (index = 0; index < count; ++index)
-    {
-        sectorIndex = sector + index;
-#else
-        transferBuf = buff;
-        sectorCount = count;
-        sectorIndex = sector;
+/* whether the controller can move data straight to buff: the cache maintenance around the transfer then
+ * covers whole lines of buff only */
+static uint8_t USB_HostMsdIsDirect(const BYTE *buff)
+{
+    return ((((uint32_t)buff % USB_DATA_ALIGN_SIZE) == 0U) && ((s_FatfsSectorSize % USB_DATA_ALIGN_SIZE) == 0U));
+}
 #endif
-        retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-        while (retry--)
+
+/* Read count sectors straight into buff, maxSectors per READ(10), with the next command always queued
+ * behind the one in flight so the device gets its CBW as soon as it has sent the CSW. Stops issuing at
+ * the first failure and returns how many sectors from the start were read, the caller reads the rest
+ * again one command at a time. */
+static uint32_t USB_HostMsdReadSectorsPipelined(uint8_t *buff, uint32_t sector, uint32_t count, uint32_t maxSectors)
+{
+    uint32_t sectors[2];
+    uint32_t issued   = 0U;
+    uint32_t done     = 0U;
+    uint32_t head     = 0U;
+    uint32_t inFlight = 0U;
+    uint32_t slot;
+    uint8_t failed = 0U;
+
+    while (1)
+    {
+        if ((!failed) && (inFlight < 2U) && (issued < count) && (g_UsbFatfsClassHandle != NULL))
         {
-            ufiIng = 1;
-            if (g_UsbFatfsClassHandle == NULL)
+            slot = (head + inFlight) & 1U;
+            sectors[slot] = MIN(count - issued, maxSectors);
+            s_ReadIng[slot] = 1;
+            /* kStatus_USB_Busy while the class cannot queue yet, try again after the next completion */
+            if (USB_HostMsdRead10(g_UsbFatfsClassHandle, 0, sector + issued, buff + s_FatfsSectorSize * issued,
+                                  s_FatfsSectorSize * sectors[slot], sectors[slot], USB_HostMsdReadCallback,
+                                  (void *)slot) == kStatus_USB_Success)
             {
-                return RES_ERROR;
+                issued += sectors[slot];
+                inFlight++;
+                continue;
             }
-            status = USB_HostMsdRead10(g_UsbFatfsClassHandle, 0, sectorIndex, (uint8_t *)transferBuf,
-                                       (uint32_t)(s_FatfsSectorSize * sectorCount), sectorCount, USB_HostMsdUfiCallback, NULL);
-            if (status != kStatus_USB_Success)
+            s_ReadIng[slot] = 0;
+        }
+        if (inFlight == 0U)
+        {
+            break;
+        }
+
+        EVENT_SchedRun();
+        if (s_ReadIng[head])
+        {
+            /* nothing to collect, and the class takes no further command before a completion either */
+            EVENT_SchedIdle();
+        }
+        else
+        {
+            if (s_ReadStatus[head] != kStatus_USB_Success)
             {
-                fatfs_code = RES_ERROR;
+                failed = 1U;
+            }
+            else if (!failed)
+            {
+                done += sectors[head];
             }
             else
             {
-                while (ufiIng)
-                {
-                    USB_HostControllerTaskFunction(g_HostHandle);
-                }
-                if (ufiStatus == kStatus_USB_Success)
-                {
-                    fatfs_code = RES_OK;
-                    break;
-                }
-                else
-                {
-                    fatfs_code = RES_NOTRDY;
-                }
             }
+            head ^= 1U;
+            inFlight--;
         }
+    }
+    return done;
+}
+
+DRESULT USB_HostMsdReadDisk(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    DRESULT fatfs_code = RES_OK;
+    uint8_t *transferBuf = buff;
+    uint32_t sectorCount;
+    uint32_t maxSectors;
+
+    if (!count)
+    {
+        return RES_PARERR;
+    }
+    USB_HostMsdWaitAsyncRead();
+
+    maxSectors = USB_HostMsdMaxSectors();
 #if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-        memcpy(buff + index * s_FatfsSectorSize, s_UsbTransferBuffer, s_FatfsSectorSize);
+    /* buffers not aligned to the cache line go through s_UsbTransferBuffer, a whole bounce buffer per command */
+    if (!USB_HostMsdIsDirect(buff))
+    {
+        transferBuf = s_UsbTransferBuffer;
+        maxSectors  = MIN(maxSectors, sizeof(s_UsbTransferBuffer) / s_FatfsSectorSize);
     }
 #endif
+    if (transferBuf == buff)
+    {
+        sectorCount = USB_HostMsdReadSectorsPipelined(buff, sector, count, maxSectors);
+#if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
+        DCACHE_InvalidateByRange((uint32_t)buff, s_FatfsSectorSize * sectorCount);
+#endif
+        transferBuf += s_FatfsSectorSize * sectorCount;
+        buff += s_FatfsSectorSize * sectorCount;
+        sector += sectorCount;
+        count -= sectorCount;
+    }
+    /* the bounce buffer takes one command at a time, and so does whatever the pipelined read left */
+    while (count)
+    {
+        sectorCount = MIN(count, maxSectors);
+        fatfs_code  = USB_HostMsdTransferSectors(0U, transferBuf, sector, sectorCount);
+        if (fatfs_code != RES_OK)
+        {
+            break;
+        }
+#if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
+        /* the host stack cleaned and invalidated the buffer before the transfer, drop the lines
+         * the core may have fetched again while the data was coming in */
+        DCACHE_InvalidateByRange((uint32_t)transferBuf, s_FatfsSectorSize * sectorCount);
+        if (transferBuf == s_UsbTransferBuffer)
+        {
+            memcpy(buff, s_UsbTransferBuffer, s_FatfsSectorSize * sectorCount);
+        }
+        else
+        {
+            transferBuf += s_FatfsSectorSize * sectorCount;
+        }
+#else
+        transferBuf += s_FatfsSectorSize * sectorCount;
+#endif
+        buff += s_FatfsSectorSize * sectorCount;
+        sector += sectorCount;
+        count -= sectorCount;
+    }
     return fatfs_code;
 }
 
+DRESULT USB_HostMsdReadDiskAsync(
+    BYTE pdrv, BYTE *buff, DWORD sector, UINT count, usb_host_disk_callback_t callback, void *param)
+{
+    if (!count)
+    {
+        return RES_PARERR;
+    }
+    if (g_UsbFatfsClassHandle == NULL)
+    {
+        return RES_ERROR;
+    }
+    if (s_AsyncReadIng)
+    {
+        return RES_NOTRDY;
+    }
+
+    /* the data stage goes straight to buff, there is no bounce through s_UsbTransferBuffer here */
+    s_AsyncReadCallback = callback;
+    s_AsyncReadParam    = param;
+    s_AsyncReadIng      = 1;
+    if (USB_HostMsdRead10(g_UsbFatfsClassHandle, 0, sector, (uint8_t *)buff, (uint32_t)(s_FatfsSectorSize * count),
+                          count, USB_HostMsdAsyncReadCallback, NULL) != kStatus_USB_Success)
+    {
+        s_AsyncReadIng = 0;
+        return RES_ERROR;
+    }
+    return RES_OK;
+}
+
 DRESULT USB_HostMsdWriteDisk(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
 {
     DRESULT fatfs_code = RES_ERROR;
-    usb_status_t status = kStatus_USB_Success;
-    uint32_t retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-    const uint8_t *transferBuf;
+    uint8_t *transferBuf = (uint8_t *)buff;
     uint32_t sectorCount;
-    uint32_t sectorIndex;
-#if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-    uint32_t index;
-#endif
+    uint32_t maxSectors;
 
     if (!count)
     {
         return RES_PARERR;
     }
+    USB_HostMsdWaitAsyncRead();
 
+    maxSectors = USB_HostMsdMaxSectors();
 #if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-    transferBuf = (const uint8_t *)s_UsbTransferBuffer;
-    sectorCount = 1;
-    for (index = 0; index < count; ++index)
+    if (!USB_HostMsdIsDirect(buff))
     {
-        sectorIndex = sector + index;
-        memcpy(s_UsbTransferBuffer, buff + index * s_FatfsSectorSize, s_FatfsSectorSize);
-#else
-        transferBuf = buff;
-        sectorCount = count;
-        sectorIndex = sector;
+        transferBuf = s_UsbTransferBuffer;
+        maxSectors  = MIN(maxSectors, sizeof(s_UsbTransferBuffer) / s_FatfsSectorSize);
+    }
 #endif
-        retry = USB_HOST_FATFS_RW_RETRY_TIMES;
-        while (retry--)
+    while (count)
+    {
+        sectorCount = MIN(count, maxSectors);
+#if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
+        /* the host stack cleans the buffer out of the D-cache before the transfer */
+        if (transferBuf == s_UsbTransferBuffer)
         {
-            ufiIng = 1;
-            if (g_UsbFatfsClassHandle == NULL)
-            {
-                return RES_ERROR;
-            }
-            status = USB_HostMsdWrite10(g_UsbFatfsClassHandle, 0, sectorIndex, (uint8_t *)transferBuf,
-                                        (uint32_t)(s_FatfsSectorSize * sectorCount), sectorCount, USB_HostMsdUfiCallback, NULL);
-            if (status != kStatus_USB_Success)
-            {
-                fatfs_code = RES_ERROR;
-            }
-            else
-            {
-                while (ufiIng)
-                {
-                    USB_HostControllerTaskFunction(g_HostHandle);
-                }
-                if (ufiStatus == kStatus_USB_Success)
-                {
-                    fatfs_code = RES_OK;
-                    break;
-                }
-                else
-                {
-                    fatfs_code = RES_NOTRDY;
-                }
-            }
+            memcpy(s_UsbTransferBuffer, buff, s_FatfsSectorSize * sectorCount);
+        }
+#endif
+        fatfs_code = USB_HostMsdTransferSectors(1U, transferBuf, sector, sectorCount);
+        if (fatfs_code != RES_OK)
+        {
+            break;
         }
 #if defined(USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE) && (USB_HOST_CONFIG_BUFFER_PROPERTY_CACHEABLE)
-    }
+        if (transferBuf != s_UsbTransferBuffer)
+        {
+            transferBuf += s_FatfsSectorSize * sectorCount;
+        }
+#else
+        transferBuf += s_FatfsSectorSize * sectorCount;
 #endif
+        buff += s_FatfsSectorSize * sectorCount;
+        sector += sectorCount;
+        count -= sectorCount;
+    }
     return fatfs_code;
 }
 
@@ -291,6 +462,8 @@ DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
     usb_status_t status = kStatus_USB_Success;
     uint32_t value;
 
+    USB_HostMsdWaitAsyncRead();
+
     switch (cmd)
     {
         case GET_SECTOR_COUNT:
@@ -313,10 +486,7 @@ DRESULT USB_HostMsdIoctlDisk(BYTE pdrv, BYTE cmd, void *buff)
             }
             else
             {
-                while (ufiIng)
-                {
-                    USB_HostControllerTaskFunction(g_HostHandle);
-                }
+                EVENT_SchedWait(&ufiIng);
                 if (ufiStatus == kStatus_USB_Success)
                 {
                     fatfs_code = RES_OK;
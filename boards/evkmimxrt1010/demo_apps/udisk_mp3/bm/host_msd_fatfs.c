@@ -22,9 +22,10 @@
 
 #if MSD_FATFS_THROUGHPUT_TEST_ENABLE
 #include "fsl_device_registers.h"
-#define THROUGHPUT_BUFFER_SIZE (64 * 1024) /* throughput test buffer */
-#define MCU_CORE_CLOCK (120000000)         /* mcu core clock, user need to configure it. */
-#endif                                     /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
+#define THROUGHPUT_BUFFER_SIZE (64 * 1024)       /* throughput test buffer */
+#define THROUGHPUT_READ_SIZE (8 * 1024 * 1024) /* bytes the read benchmark reads for every command size */
+#define MCU_CORE_CLOCK (SystemCoreClock)         /* mcu core clock */
+#endif                                           /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
 
 /*******************************************************************************
  * Prototypes
@@ -55,6 +56,33 @@ static void USB_HostMsdFatfsTestDone(void);
  */
 static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance);
 
+#if (MSD_FATFS_THROUGHPUT_TEST_ENABLE == 2U)
+/*!
+ * @brief host msd read benchmark callback.
+ *
+ * @param param      index of the command in readBenchIng.
+ * @param data       data buffer pointer.
+ * @param dataLength data length.
+ * @status           transfer result status.
+ */
+static void USB_HostMsdFatfsReadBenchCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status);
+
+/*!
+ * @brief read the start of the disk with raw READ(10) commands.
+ *
+ * @param msdFatfsInstance   the host fatfs instance pointer.
+ * @param blockSize          the disk's block size.
+ * @param commandSize        bytes per command.
+ * @param depth              commands kept in flight, 1 or 2.
+ *
+ * @return the speed in KB/s, 0 if a command failed.
+ */
+static uint32_t USB_HostMsdFatfsReadBench(usb_host_msd_fatfs_instance_t *msdFatfsInstance,
+                                          uint32_t blockSize,
+                                          uint32_t commandSize,
+                                          uint32_t depth);
+#endif
+
 #else
 
 /*!
@@ -98,6 +126,7 @@ extern usb_status_t USB_HostTestModeInit(usb_device_handle deviceHandle);
 
 /*! @brief msd class handle array for fatfs */
 extern usb_host_class_handle g_UsbFatfsClassHandle;
+extern usb_host_handle g_HostHandle;
 
 usb_host_msd_fatfs_instance_t g_MsdFatfsInstance; /* global msd fatfs instance */
 static FATFS fatfs;
@@ -109,6 +138,13 @@ volatile usb_status_t controlStatus;
 #if MSD_FATFS_THROUGHPUT_TEST_ENABLE
 USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint32_t testThroughputBuffer[THROUGHPUT_BUFFER_SIZE / 4]; /* the buffer for throughput test */
 uint32_t testSizeArray[] = {20 * 1024, 20 * 1024}; /* test time and test size (uint: K)*/
+#if (MSD_FATFS_THROUGHPUT_TEST_ENABLE == 2U)
+uint32_t readCommandSizeArray[] = {4 * 1024, 16 * 1024, 32 * 1024, 64 * 1024}; /* READ(10) sizes to benchmark */
+/* read benchmark command on-going state, set to 0 in the callback */
+static volatile uint8_t readBenchIng[2];
+/* read benchmark command callback status */
+static volatile usb_status_t readBenchStatus[2];
+#endif
 #else
 USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) static uint8_t testBuffer[(FF_MAX_SS > 256) ? FF_MAX_SS : 256]; /* normal test buffer */
 #endif /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
@@ -137,6 +173,80 @@ static void USB_HostMsdFatfsTestDone(void)
 
 #if ((defined MSD_FATFS_THROUGHPUT_TEST_ENABLE) && (MSD_FATFS_THROUGHPUT_TEST_ENABLE))
 
+#if (MSD_FATFS_THROUGHPUT_TEST_ENABLE == 2U)
+static void USB_HostMsdFatfsReadBenchCallback(void *param, uint8_t *data, uint32_t dataLength, usb_status_t status)
+{
+    uint32_t index = (uint32_t)param;
+
+    readBenchStatus[index] = status;
+    readBenchIng[index] = 0;
+}
+
+static uint32_t USB_HostMsdFatfsReadBench(usb_host_msd_fatfs_instance_t *msdFatfsInstance,
+                                          uint32_t blockSize,
+                                          uint32_t commandSize,
+                                          uint32_t depth)
+{
+    uint64_t totalTime;
+    uint32_t blockNumber = commandSize / blockSize;
+    uint32_t issued = 0;
+    uint32_t done = 0;
+    uint32_t head = 0;
+    uint32_t inFlight = 0;
+    uint32_t index;
+
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= (1 << DWT_CTRL_CYCCNTENA_Pos);
+    while (done < (THROUGHPUT_READ_SIZE / commandSize))
+    {
+        /* every command reads into the same buffer, only the time counts */
+        if ((inFlight < depth) && (issued < (THROUGHPUT_READ_SIZE / commandSize)))
+        {
+            index = (head + inFlight) % 2;
+            readBenchIng[index] = 1;
+            if (USB_HostMsdRead10(msdFatfsInstance->classHandle, 0, issued * blockNumber,
+                                  (uint8_t *)testThroughputBuffer, commandSize, blockNumber,
+                                  USB_HostMsdFatfsReadBenchCallback, (void *)index) == kStatus_USB_Success)
+            {
+                issued++;
+                inFlight++;
+                continue;
+            }
+            readBenchIng[index] = 0;
+            if (inFlight == 0)
+            {
+                return 0;
+            }
+        }
+        if (msdFatfsInstance->deviceState != kStatus_DEV_Attached)
+        {
+            return 0;
+        }
+        /* polled rather than slept on in the event scheduler, a completion is taken without the wake-up latency */
+        USB_HostEhciTaskFunction(g_HostHandle);
+        if ((inFlight != 0) && (!readBenchIng[head]))
+        {
+            if (readBenchStatus[head] != kStatus_USB_Success)
+            {
+                /* let the other command finish */
+                while (readBenchIng[(head + 1) % 2])
+                {
+                    USB_HostEhciTaskFunction(g_HostHandle);
+                }
+                return 0;
+            }
+            head = (head + 1) % 2;
+            inFlight--;
+            done++;
+        }
+    }
+    totalTime = DWT->CYCCNT;
+    DWT->CTRL &= ~(1 << DWT_CTRL_CYCCNTENA_Pos);
+
+    return (uint32_t)((uint64_t)(THROUGHPUT_READ_SIZE / 1024) * (uint64_t)MCU_CORE_CLOCK / totalTime);
+}
+#endif
+
 static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFatfsInstance)
 {
     uint64_t totalTime;
@@ -170,6 +280,30 @@ static void USB_HostMsdFatfsThroughputTest(usb_host_msd_fatfs_instance_t *msdFat
         return;
     }
 
+#if (MSD_FATFS_THROUGHPUT_TEST_ENABLE == 2U)
+    if ((disk_ioctl(USBDISK, GET_SECTOR_SIZE, &testSize) != RES_OK) || (testSize == 0) ||
+        ((THROUGHPUT_BUFFER_SIZE % testSize) != 0))
+    {
+        USB_HostMsdFatfsTestDone();
+        return;
+    }
+    usb_echo("read benchmark, %dKB from the start of the disk:\r\n", THROUGHPUT_READ_SIZE / 1024);
+    for (testIndex = 0; testIndex < (sizeof(readCommandSizeArray) / 4); ++testIndex)
+    {
+        if ((readCommandSizeArray[testIndex] % testSize) != 0)
+        {
+            continue;
+        }
+        /* one READ(10) at a time, then the next one queued behind the one in flight */
+        resultSize = USB_HostMsdFatfsReadBench(msdFatfsInstance, testSize, readCommandSizeArray[testIndex], 1);
+        usb_echo("    READ(10) of %dKB: %d KB/s serial, ", readCommandSizeArray[testIndex] / 1024, resultSize);
+        resultSize = USB_HostMsdFatfsReadBench(msdFatfsInstance, testSize, readCommandSizeArray[testIndex], 2);
+        usb_echo("%d KB/s pipelined\r\n", resultSize);
+    }
+    USB_HostMsdFatfsTestDone();
+    return;
+#endif
+
     sprintf(test_file_name, "%c:/thput.dat", USBDISK + '0');
     usb_echo("throughput test:\r\n");
     for (testIndex = 0; testIndex < (sizeof(testSizeArray) / 4); ++testIndex)
@@ -894,11 +1028,11 @@ void USB_HostMsdTask(void *arg)
             break;
 
         case kUSB_HostMsdRunMassStorageTest: /* set interface succeed */
-//#if ((defined MSD_FATFS_THROUGHPUT_TEST_ENABLE) && (MSD_FATFS_THROUGHPUT_TEST_ENABLE))
-//            USB_HostMsdFatfsThroughputTest(msdFatfsInstance); /* test throughput */
-//#else
+#if ((defined MSD_FATFS_THROUGHPUT_TEST_ENABLE) && (MSD_FATFS_THROUGHPUT_TEST_ENABLE))
+            USB_HostMsdFatfsThroughputTest(msdFatfsInstance); /* test throughput, then play */
+#else
 //            USB_HostMsdFatfsTest(msdFatfsInstance); /* test msd device */
-//#endif /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
+#endif /* MSD_FATFS_THROUGHPUT_TEST_ENABLE */
 //            msdFatfsInstance->runState = kUSB_HostMsdRunIdle;
           Audio_task();
             break;
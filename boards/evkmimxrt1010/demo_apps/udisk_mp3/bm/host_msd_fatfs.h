@@ -16,7 +16,9 @@
  * Definitions
  ******************************************************************************/
 
-/*! @brief 0 - execute normal fatfs test code; 1 - execute throughput test code */
+/*! @brief 0 - execute normal fatfs test code; 1 - execute throughput test code; 2 - execute the read-only throughput
+ *  benchmark, raw READ(10) commands of each size one at a time and pipelined, which never writes the disk.
+ *  With 1 or 2 the test runs once before playback starts. */
 #define MSD_FATFS_THROUGHPUT_TEST_ENABLE (0U)
 
 /*! @brief host app run status */
@@ -42,21 +42,74 @@
  *
  * - inline rountines with access to 64-bit multiply results 
  * - x86 (_WIN32) and ARM (ARM_ADS, _WIN32_WCE) versions included
+ * - Cortex-M DSP extension kernels (HELIX_DSP_KERNELS) on any compiler with CMSIS-Core
+ * - portable C versions for other hosts (e.g. GCC on x86-64 Linux, see ../host)
  * - some inline functions are mix of asm and C for speed
  * - some functions are in native asm files, so only the prototype is given here
  *
  * MULSHIFT32(x, y)    signed multiply of two 32-bit integers (x and y), returns top 32 bits of 64-bit result
  * FASTABS(x)          branchless absolute value of signed integer x
  * CLZ(x)              count leading zeros in x
- * MADD64(sum, x, y)   (Windows only) sum [64-bit] += x [32-bit] * y [32-bit]
+ * MADD64(sum, x, y)   (Windows, HELIX_DSP_KERNELS, portable C) sum [64-bit] += x [32-bit] * y [32-bit]
  * SHL64(sum, x, y)    (Windows only) 64-bit left shift using __int64
- * SAR64(sum, x, y)    (Windows only) 64-bit right shift using __int64
+ * SAR64(sum, x, y)    (Windows, HELIX_DSP_KERNELS, portable C) 64-bit right shift using __int64
+ * SSAT16(x)           (HELIX_DSP_KERNELS only) saturate x to a signed 16-bit value
  */
 
 #ifndef _ASSEMBLY_H
 #define _ASSEMBLY_H
 
-#if (defined _WIN32 && !defined _WIN32_WCE) || (defined __WINS__ && defined _SYMBIAN) || defined(_OPENWAVE_SIMULATOR) || defined(WINCE_EMULATOR)    /* Symbian emulator for Ix86 */
+#if HELIX_DSP_KERNELS
+
+typedef long long Word64;
+
+/* Cortex-M4/M7 DSP extension: everything inline, using the CMSIS-Core intrinsics where
+ *   C has no equivalent, so IAR, ARMCC and GCC all generate SMULL/SMLAL/CLZ/SSAT in place
+ *   instead of calling into hylix_mp3_asm.a (same results, bit for bit)
+ */
+#include "cmsis_compiler.h"
+
+static __inline int MULSHIFT32(int x, int y)
+{
+	/* SMULL, keep the high word */
+	return (int)(((Word64)x * y) >> 32);
+}
+
+static __inline int FASTABS(int x) 
+{
+	int sign;
+
+	sign = x >> (sizeof(int) * 8 - 1);
+	x ^= sign;
+	x -= sign;
+
+	return x;
+}
+
+static __inline int CLZ(int x)
+{
+	/* __CLZ(0) may be undefined with some compilers (__builtin_clz) */
+	if (!x)
+		return (sizeof(int) * 8);
+
+	return (int)__CLZ((unsigned int)x);
+}
+
+static __inline Word64 MADD64(Word64 sum, int x, int y)
+{
+	/* SMLAL */
+	return (sum + ((Word64)x * y));
+}
+
+static __inline Word64 SAR64(Word64 x, int n)
+{
+	return (x >> n);
+}
+
+/* saturate to [-32768, 32767] with SSAT */
+#define SSAT16(x)	__SSAT((x), 16)
+
+#elif (defined _WIN32 && !defined _WIN32_WCE) || (defined __WINS__ && defined _SYMBIAN) || defined(_OPENWAVE_SIMULATOR) || defined(WINCE_EMULATOR)    /* Symbian emulator for Ix86 */
 
 #pragma warning( disable : 4035 )	/* complains about inline asm not returning a value */
 
@@ -273,6 +326,53 @@ static __inline int CLZ(int x)
 	return numZeros;
 }
 
+#elif defined(__GNUC__)
+
+/* portable C for host builds, the same arithmetic as the ARM assembly helpers */
+typedef long long Word64;
+
+static __inline int MULSHIFT32(int x, int y)
+{
+	return (int)(((Word64)x * y) >> 32);
+}
+
+static __inline int FASTABS(int x) 
+{
+	int sign;
+
+	sign = x >> (sizeof(int) * 8 - 1);
+	x ^= sign;
+	x -= sign;
+
+	return x;
+}
+
+static __inline int CLZ(int x)
+{
+	int numZeros;
+
+	if (!x)
+		return (sizeof(int) * 8);
+
+	numZeros = 0;
+	while (!(x & 0x80000000)) {
+		numZeros++;
+		x <<= 1;
+	} 
+
+	return numZeros;
+}
+
+static __inline Word64 MADD64(Word64 sum, int x, int y)
+{
+	return (sum + ((Word64)x * y));
+}
+
+static __inline Word64 SAR64(Word64 x, int n)
+{
+	return (x >> n);
+}
+
 #else
 
 #error Unsupported platform in assembly.h
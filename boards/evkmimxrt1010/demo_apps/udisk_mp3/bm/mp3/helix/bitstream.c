@@ -64,6 +64,88 @@ void SetBitstreamPointer(BitStreamInfo *bsi, int nBytes, unsigned char *buf)
 	bsi->iCache = 0;		/* 4-byte unsigned int */
 	bsi->cachedBits = 0;	/* i.e. zero bits in cache */
 	bsi->nBytes = nBytes;
+	bsi->mc = 0;
+}
+
+/**************************************************************************************
+ * Function:    SetBitstreamCursor
+ *
+ * Description: initialize bitstream reader over main data which may be split into runs
+ *
+ * Inputs:      pointer to BitStreamInfo struct
+ *              number of bytes in bitstream
+ *              pointer to main data cursor, advanced as bytes are read
+ *
+ * Outputs:     filled bitstream info struct
+ *
+ * Return:      none
+ *
+ * Notes:       bytePtr is unused, use nBytes to find how much has been read
+ **************************************************************************************/
+void SetBitstreamCursor(BitStreamInfo *bsi, int nBytes, MainDataCursor *mc)
+{
+	bsi->bytePtr = 0;
+	bsi->iCache = 0;
+	bsi->cachedBits = 0;
+	bsi->nBytes = nBytes;
+	bsi->mc = mc;
+}
+
+/**************************************************************************************
+ * Function:    NextMainDataByte
+ *
+ * Description: read a byte when the cursor has reached the end of its current run
+ *
+ * Inputs:      pointer to main data cursor with ptr == end
+ *
+ * Outputs:     cursor moved to the next run
+ *
+ * Return:      the first byte of the next run, or 0 if there are no more runs
+ *
+ * Notes:       called by GetMainDataByte() only, keeps the common case inline
+ **************************************************************************************/
+unsigned char NextMainDataByte(MainDataCursor *mc)
+{
+	const MainDataRun *run;
+
+	while (mc->run != mc->lastRun) {
+		mc->run = (mc->run + 1) & (MAX_MAINRUNS - 1);
+		run = &mc->runs[mc->run];
+		mc->ptr = run->ptr;
+		mc->end = run->ptr + run->len;
+		if (mc->ptr != mc->end)
+			return *mc->ptr++;
+	}
+
+	return 0;
+}
+
+/**************************************************************************************
+ * Function:    SkipMainData
+ *
+ * Description: advance a main data cursor
+ *
+ * Inputs:      pointer to main data cursor
+ *              number of bytes to skip
+ *
+ * Outputs:     updated cursor
+ *
+ * Return:      none
+ **************************************************************************************/
+void SkipMainData(MainDataCursor *mc, int nBytes)
+{
+	const MainDataRun *run;
+
+	while (nBytes > mc->end - mc->ptr && mc->run != mc->lastRun) {
+		nBytes -= (int)(mc->end - mc->ptr);
+		mc->run = (mc->run + 1) & (MAX_MAINRUNS - 1);
+		run = &mc->runs[mc->run];
+		mc->ptr = run->ptr;
+		mc->end = run->ptr + run->len;
+	}
+	if (nBytes > mc->end - mc->ptr)
+		nBytes = (int)(mc->end - mc->ptr);
+	mc->ptr += nBytes;
 }
 
 /**************************************************************************************
@@ -90,16 +172,24 @@ static __inline void RefillBitstreamCache(BitStreamInfo *bsi)
 
 	/* optimize for common case, independent of machine endian-ness */
 	if (nBytes >= 4) {
-		bsi->iCache  = (*bsi->bytePtr++) << 24;
-		bsi->iCache |= (*bsi->bytePtr++) << 16;
-		bsi->iCache |= (*bsi->bytePtr++) <<  8;
-		bsi->iCache |= (*bsi->bytePtr++);
+		if (bsi->mc) {
+			/* main data, may continue in the next run */
+			bsi->iCache  = GetMainDataByte(bsi->mc) << 24;
+			bsi->iCache |= GetMainDataByte(bsi->mc) << 16;
+			bsi->iCache |= GetMainDataByte(bsi->mc) <<  8;
+			bsi->iCache |= GetMainDataByte(bsi->mc);
+		} else {
+			bsi->iCache  = (*bsi->bytePtr++) << 24;
+			bsi->iCache |= (*bsi->bytePtr++) << 16;
+			bsi->iCache |= (*bsi->bytePtr++) <<  8;
+			bsi->iCache |= (*bsi->bytePtr++);
+		}
 		bsi->cachedBits = 32;
 		bsi->nBytes -= 4;
 	} else {
 		bsi->iCache = 0;
 		while (nBytes--) {
-			bsi->iCache |= (*bsi->bytePtr++);
+			bsi->iCache |= (bsi->mc ? GetMainDataByte(bsi->mc) : *bsi->bytePtr++);
 			bsi->iCache <<= 8;
 		}
 		bsi->iCache <<= ((3 - bsi->nBytes)*8);
@@ -252,6 +342,7 @@ int UnpackFrameHeader(MP3DecInfo *mp3DecInfo, unsigned char *buf)
 
 	/* init user-accessible data */
 	mp3DecInfo->nChans = (fh->sMode == Mono ? 1 : 2);
+	mp3DecInfo->nOutChans = (mp3DecInfo->monoDownmix ? 1 : mp3DecInfo->nChans);
 	mp3DecInfo->samprate = samplerateTab[fh->ver][fh->srIdx];
 	mp3DecInfo->nGrans = (fh->ver == MPEG1 ? NGRANS_MPEG1 : NGRANS_MPEG2);
 	mp3DecInfo->nGranSamps = ((int)samplesPerFrameTab[fh->ver][fh->layer - 1]) / mp3DecInfo->nGrans;
@@ -51,19 +51,26 @@
 #include "coder.h"
 
 //#define static_buffers
-#ifdef static_buffers
-MP3DecInfo  mp3DecInfo;     //  0x7f0 =  2032 
-SubbandInfo sbi;            // 0x2204 =  8708
-IMDCTInfo mi;               // 0x1b20 =  6944
-HuffmanInfo hi;             // 0x1210 =  4624
-DequantInfo di;             //  0x348 =   840
-ScaleFactorInfo sfi;        //  0x124 =   292
-SideInfo si;                //  0x148 =   328
-FrameHeader fh;             //   0x38 =    56
-#else
+#ifndef static_buffers
 #include <malloc.h> 
 #endif
 
+/* every decoder lives in one block, carved up in this order with each piece on an
+ *   8-byte boundary (MP3DecInfo holds 64-bit profile counters)
+ * a header-only instance stops after FrameHeader: enough for MP3GetNextFrameInfo,
+ *   MP3GetLastFrameInfo and the ring input calls, not for MP3Decode
+ */
+#define ARENA_ALIGN(n)		(((n) + 7) & ~7)
+#define ARENA_HEADER_BYTES	(ARENA_ALIGN(sizeof(MP3DecInfo)) + ARENA_ALIGN(sizeof(FrameHeader)))
+#define ARENA_BYTES			(ARENA_HEADER_BYTES + ARENA_ALIGN(sizeof(SideInfo)) + ARENA_ALIGN(sizeof(ScaleFactorInfo)) + \
+							 ARENA_ALIGN(sizeof(HuffmanInfo)) + ARENA_ALIGN(sizeof(DequantInfo)) + \
+							 ARENA_ALIGN(sizeof(IMDCTInfo)) + ARENA_ALIGN(sizeof(SubbandInfo)))
+
+#ifdef static_buffers
+/* the instance handed out by MP3InitDecoder (about 24 KB, mostly SubbandInfo, IMDCTInfo and HuffmanInfo) */
+HELIX_FAST_STATE(static unsigned long long decArena[ARENA_BYTES / 8]);
+#endif
+
 /**************************************************************************************
  * Function:    ClearBuffer
  *
@@ -88,6 +95,80 @@ void ClearBuffer(void *buf, int nBytes)
 
 }
 
+/**************************************************************************************
+ * Function:    GetBufferSize
+ *
+ * Description: size of the memory block AllocateBuffersInPlace needs
+ *
+ * Inputs:      0 for a full decoder, 1 for a header-only instance
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes, including up to 7 bytes lost aligning an arbitrary block
+ **************************************************************************************/
+int GetBufferSize(int headerOnly)
+{
+	return (int)(headerOnly ? ARENA_HEADER_BYTES : ARENA_BYTES) + 7;
+}
+
+/**************************************************************************************
+ * Function:    AllocateBuffersInPlace
+ *
+ * Description: lay out the decoder buffers in a block of memory owned by the caller
+ *
+ * Inputs:      pointer to the block (any alignment)
+ *              size of the block in bytes
+ *
+ * Outputs:     none
+ *
+ * Return:      pointer to MP3DecInfo structure (initialized with pointers to all 
+ *                the internal buffers needed for decoding, all other members of 
+ *                MP3DecInfo structure set to 0), 0 if the block is too small
+ *
+ * Notes:       a block of at least GetBufferSize(0) bytes gets a full decoder, one of
+ *                at least GetBufferSize(1) bytes a header-only instance (every pointer
+ *                past FrameHeaderPS stays 0)
+ *              the block must stay untouched until the decoder is no longer used
+ **************************************************************************************/
+MP3DecInfo *AllocateBuffersInPlace(void *arena, int size)
+{
+	MP3DecInfo *mp3DecInfo;
+	unsigned char *buf;
+	int nBytes;
+
+	if (!arena)
+		return 0;
+
+	buf = (unsigned char *)arena;
+	buf += (8 - ((unsigned int)(unsigned long)buf & 7)) & 7;
+	size -= (int)(buf - (unsigned char *)arena);
+
+	if (size >= (int)ARENA_BYTES)
+		nBytes = ARENA_BYTES;
+	else if (size >= (int)ARENA_HEADER_BYTES)
+		nBytes = ARENA_HEADER_BYTES;
+	else
+		return 0;
+
+	/* important to do this - DSP primitives assume a bunch of state variables are 0 on first use */
+	ClearBuffer(buf, nBytes);
+
+	mp3DecInfo = (MP3DecInfo *)buf;
+	buf += ARENA_ALIGN(sizeof(MP3DecInfo));
+	mp3DecInfo->FrameHeaderPS =     (void *)buf;	buf += ARENA_ALIGN(sizeof(FrameHeader));
+	if (nBytes == ARENA_HEADER_BYTES)
+		return mp3DecInfo;
+
+	mp3DecInfo->SideInfoPS =        (void *)buf;	buf += ARENA_ALIGN(sizeof(SideInfo));
+	mp3DecInfo->ScaleFactorInfoPS = (void *)buf;	buf += ARENA_ALIGN(sizeof(ScaleFactorInfo));
+	mp3DecInfo->HuffmanInfoPS =     (void *)buf;	buf += ARENA_ALIGN(sizeof(HuffmanInfo));
+	mp3DecInfo->DequantInfoPS =     (void *)buf;	buf += ARENA_ALIGN(sizeof(DequantInfo));
+	mp3DecInfo->IMDCTInfoPS =       (void *)buf;	buf += ARENA_ALIGN(sizeof(IMDCTInfo));
+	mp3DecInfo->SubbandInfoPS =     (void *)buf;
+
+	return mp3DecInfo;
+}
+
 /**************************************************************************************
  * Function:    AllocateBuffers
  *
@@ -101,90 +182,32 @@ void ClearBuffer(void *buf, int nBytes)
  *                the internal buffers needed for decoding, all other members of 
  *                MP3DecInfo structure set to 0)
  *
- * Notes:       if one or more mallocs fail, function frees any buffers already
- *                allocated before returning
+ * Notes:       with static_buffers there is one block, so every call returns the same
+ *                (cleared) decoder; otherwise each call mallocs a block of its own
  *
  *              Changed by Kasper Jepsen to support static buffers as well.
  *
  **************************************************************************************/
 MP3DecInfo *AllocateBuffers(void)
 {
-  MP3DecInfo *mp3DecInfo_pointer;
-  #ifdef static_buffers
-  mp3DecInfo_pointer = (MP3DecInfo*)&mp3DecInfo;
-  ClearBuffer((void*)&mp3DecInfo, sizeof(MP3DecInfo));
-
-  	mp3DecInfo.FrameHeaderPS =     (void*)&fh;
-	mp3DecInfo.SideInfoPS =        (void*)&si;
-	mp3DecInfo.ScaleFactorInfoPS = (void*)&sfi;
-	mp3DecInfo.HuffmanInfoPS =     (void*)&hi;
-	mp3DecInfo.DequantInfoPS =     (void*)&di;
-	mp3DecInfo.IMDCTInfoPS =       (void*)&mi;
-	mp3DecInfo.SubbandInfoPS =     (void*)&sbi;
+#ifdef static_buffers
+	return AllocateBuffersInPlace(decArena, sizeof(decArena));
+#else
+	MP3DecInfo *mp3DecInfo_pointer;
+	void *block;
 
-	/* important to do this - DSP primitives assume a bunch of state variables are 0 on first use */
-    ClearBuffer((void*)&fh,  sizeof(FrameHeader));
-	ClearBuffer((void*)&si,  sizeof(SideInfo));
-	ClearBuffer((void*)&sfi, sizeof(ScaleFactorInfo));
-	ClearBuffer((void*)&hi,  sizeof(HuffmanInfo));
-	ClearBuffer((void*)&di,  sizeof(DequantInfo));
-	ClearBuffer((void*)&mi,  sizeof(IMDCTInfo));
-	ClearBuffer((void*)&sbi, sizeof(SubbandInfo));
-   // return mp3DecInfo_pointer;
-
-  #else
-	FrameHeader *fh;
-	SideInfo *si;
-	ScaleFactorInfo *sfi;
-	HuffmanInfo *hi;
-	DequantInfo *di;
-	IMDCTInfo *mi;
-	SubbandInfo *sbi;
-
-	mp3DecInfo_pointer = (MP3DecInfo *)mymalloc(SRAMIN,sizeof(MP3DecInfo));
-	if (!mp3DecInfo_pointer)
-		return 0;
-	ClearBuffer(mp3DecInfo_pointer, sizeof(MP3DecInfo));
-	
-	fh =  (FrameHeader *)     mymalloc(SRAMIN,sizeof(FrameHeader));
-	si =  (SideInfo *)        mymalloc(SRAMIN,sizeof(SideInfo));
-	sfi = (ScaleFactorInfo *) mymalloc(SRAMIN,sizeof(ScaleFactorInfo));
-	hi =  (HuffmanInfo *)     mymalloc(SRAMIN,sizeof(HuffmanInfo));
-	di =  (DequantInfo *)     mymalloc(SRAMIN,sizeof(DequantInfo));
-	mi =  (IMDCTInfo *)       mymalloc(SRAMIN,sizeof(IMDCTInfo));
-	sbi = (SubbandInfo *)     mymalloc(SRAMIN,sizeof(SubbandInfo));
-
-	mp3DecInfo_pointer->FrameHeaderPS =     (void *)fh;
-	mp3DecInfo_pointer->SideInfoPS =        (void *)si;
-	mp3DecInfo_pointer->ScaleFactorInfoPS = (void *)sfi;
-	mp3DecInfo_pointer->HuffmanInfoPS =     (void *)hi;
-	mp3DecInfo_pointer->DequantInfoPS =     (void *)di;
-	mp3DecInfo_pointer->IMDCTInfoPS =       (void *)mi;
-	mp3DecInfo_pointer->SubbandInfoPS =     (void *)sbi;
-
-	if (!fh || !si || !sfi || !hi || !di || !mi || !sbi) {
-		FreeBuffers(mp3DecInfo_pointer);	/* safe to call - only frees memory that was successfully allocated */
+	block = mymalloc(SRAMIN, GetBufferSize(0));
+	mp3DecInfo_pointer = AllocateBuffersInPlace(block, GetBufferSize(0));
+	if (!mp3DecInfo_pointer) {
+		if (block)
+			myfree(SRAMIN, block);
 		return 0;
 	}
+	mp3DecInfo_pointer->heapBlock = block;
 
-	/* important to do this - DSP primitives assume a bunch of state variables are 0 on first use */
-	//Optimized away.. hmm
-    ClearBuffer(fh,  sizeof(FrameHeader));
-	ClearBuffer(si,  sizeof(SideInfo));
-	ClearBuffer(sfi, sizeof(ScaleFactorInfo));
-	ClearBuffer(hi,  sizeof(HuffmanInfo));
-	ClearBuffer(di,  sizeof(DequantInfo));
-	ClearBuffer(mi,  sizeof(IMDCTInfo));
-	ClearBuffer(sbi, sizeof(SubbandInfo));
-
-#endif
 	return mp3DecInfo_pointer;
-}
-
-
-#ifndef static_buffers
-#define SAFE_FREE(x)	{if (x)	myfree(SRAMIN,x);	(x) = 0;}	/* helper macro */
 #endif
+}
 
 /**************************************************************************************
  * Function:    FreeBuffers
@@ -197,22 +220,39 @@ MP3DecInfo *AllocateBuffers(void)
  *
  * Return:      none
  *
- * Notes:       safe to call even if some buffers were not allocated (uses SAFE_FREE)
+ * Notes:       only blocks malloc'ed by AllocateBuffers are released, the static block
+ *                and the caller's blocks given to AllocateBuffersInPlace stay as they are
  **************************************************************************************/
 void FreeBuffers(MP3DecInfo *mp3DecInfo)
 {
-#ifndef static_buffers	
     if (!mp3DecInfo)
 		return;
 
-	SAFE_FREE(mp3DecInfo->FrameHeaderPS);
-	SAFE_FREE(mp3DecInfo->SideInfoPS);
-	SAFE_FREE(mp3DecInfo->ScaleFactorInfoPS);
-	SAFE_FREE(mp3DecInfo->HuffmanInfoPS);
-	SAFE_FREE(mp3DecInfo->DequantInfoPS);
-	SAFE_FREE(mp3DecInfo->IMDCTInfoPS);
-	SAFE_FREE(mp3DecInfo->SubbandInfoPS);
-
-	SAFE_FREE(mp3DecInfo);
+#ifndef static_buffers
+	if (mp3DecInfo->heapBlock)
+		myfree(SRAMIN, mp3DecInfo->heapBlock);
 #endif
 }
+
+/**************************************************************************************
+ * Function:    ResetBuffers
+ *
+ * Description: clear the DSP state a decoder carries from one granule to the next
+ *
+ * Inputs:      pointer to initialized MP3DecInfo structure
+ *
+ * Outputs:     IMDCT overlap and synthesis filter history as after AllocateBuffers
+ *
+ * Return:      none
+ *
+ * Notes:       the other buffers are written before they are read in every granule,
+ *                so they are left alone; nothing to do for a header-only instance
+ **************************************************************************************/
+void ResetBuffers(MP3DecInfo *mp3DecInfo)
+{
+	if (!mp3DecInfo || !mp3DecInfo->SubbandInfoPS)
+		return;
+
+	ClearBuffer(mp3DecInfo->IMDCTInfoPS, sizeof(IMDCTInfo));
+	ClearBuffer(mp3DecInfo->SubbandInfoPS, sizeof(SubbandInfo));
+}
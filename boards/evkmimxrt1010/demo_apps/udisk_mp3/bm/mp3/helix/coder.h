@@ -63,6 +63,27 @@
 #define MIN(a,b)	((a) < (b) ? (a) : (b))
 #endif
 
+/* memory placement of the hot paths (see HELIX_TCM_PLACEMENT in mp3dec.h)
+ *   HELIX_FAST_CODE  - functions that run for every granule, for ITCM
+ *   HELIX_FAST_DATA  - small lookup tables read by those functions, for DTCM
+ *   HELIX_FAST_STATE - large per-decoder working buffers, for DTCM when the FlexRAM split leaves room
+ * wrap the declarator only, e.g. HELIX_FAST_DATA(const int tab[4]) = { ... };
+ * keep const and non-const objects of one source file in different sections (GCC refuses to mix them)
+ */
+#if HELIX_TCM_PLACEMENT && defined(__ICCARM__)
+#define HELIX_FAST_CODE(decl)	decl @ "CodeQuickAccess"
+#define HELIX_FAST_DATA(decl)	decl @ "DataQuickAccess"
+#define HELIX_FAST_STATE(decl)	decl @ "StateQuickAccess"
+#elif HELIX_TCM_PLACEMENT && (defined(__GNUC__) || defined(__CC_ARM) || defined(__ARMCC_VERSION))
+#define HELIX_FAST_CODE(decl)	__attribute__((section("CodeQuickAccess"), noinline)) decl
+#define HELIX_FAST_DATA(decl)	__attribute__((section("DataQuickAccess"))) decl
+#define HELIX_FAST_STATE(decl)	__attribute__((section("StateQuickAccess"))) decl
+#else
+#define HELIX_FAST_CODE(decl)	decl
+#define HELIX_FAST_DATA(decl)	decl
+#define HELIX_FAST_STATE(decl)	decl
+#endif
+
 /* clip to range [-2^n, 2^n - 1] */
 #define CLIP_2N(y, n) { \
 	int sign = (y) >> 31;  \
@@ -71,6 +92,15 @@
 	} \
 }
 
+/* sample type of the back end buffers: Q format integers, or floats with HELIX_FLOAT_DSP
+ *   (the Huffman output in HuffmanInfo stays int either way)
+ */
+#if HELIX_FLOAT_DSP
+typedef float DSPSample;
+#else
+typedef int DSPSample;
+#endif
+
 #define SIBYTES_MPEG1_MONO		17
 #define SIBYTES_MPEG1_STEREO	32
 #define SIBYTES_MPEG2_MONO		 9
@@ -91,6 +121,7 @@
 
 /* additional external symbols to name-mangle for static linking */
 #define	SetBitstreamPointer	STATNAME(SetBitstreamPointer)
+#define	SetBitstreamCursor	STATNAME(SetBitstreamCursor)
 #define	GetBits				STATNAME(GetBits)
 #define	CalcBitsUsed		STATNAME(CalcBitsUsed)
 #define	DequantChannel		STATNAME(DequantChannel)
@@ -130,6 +161,7 @@ typedef struct _BitStreamInfo {
 	unsigned int iCache;
 	int cachedBits;
 	int nBytes;
+	MainDataCursor *mc;		/* if not null, bytes come from mc instead of bytePtr */
 } BitStreamInfo;
 
 typedef struct _FrameHeader {
@@ -183,12 +215,13 @@ typedef struct {
 } CriticalBandInfo;
 
 typedef struct _DequantInfo {
-	int workBuf[MAX_REORDER_SAMPS];		/* workbuf for reordering short blocks */
+	DSPSample workBuf[MAX_REORDER_SAMPS];	/* workbuf for reordering short blocks */
 	CriticalBandInfo cbi[MAX_NCHAN];	/* filled in dequantizer, used in joint stereo reconstruction */
 } DequantInfo;
 
 typedef struct _HuffmanInfo {
-	int huffDecBuf[MAX_NCHAN][MAX_NSAMP];		/* used both for decoded Huffman values and dequantized coefficients */
+	int huffDecBuf[MAX_NCHAN][MAX_NSAMP];		/* used both for decoded Huffman values and dequantized coefficients
+												 *   (floats in the same storage with HELIX_FLOAT_DSP) */
 	int nonZeroBound[MAX_NCHAN];				/* number of coeffs in huffDecBuf[ch] which can be > 0 */
 	int gb[MAX_NCHAN];							/* minimum number of guard bits in huffDecBuf[ch] */
 } HuffmanInfo;
@@ -209,12 +242,13 @@ typedef struct _HuffTabLookup {
 } HuffTabLookup;
 
 typedef struct _IMDCTInfo {
-	int outBuf[MAX_NCHAN][BLOCK_SIZE][NBANDS];	/* output of IMDCT */	
-	int overBuf[MAX_NCHAN][MAX_NSAMP / 2];		/* overlap-add buffer (by symmetry, only need 1/2 size) */
+	DSPSample outBuf[MAX_NCHAN][BLOCK_SIZE][NBANDS];	/* output of IMDCT */	
+	DSPSample overBuf[MAX_NCHAN][MAX_NSAMP / 2];		/* overlap-add buffer (by symmetry, only need 1/2 size) */
 	int numPrevIMDCT[MAX_NCHAN];				/* how many IMDCT's calculated in this channel on prev. granule */
 	int prevType[MAX_NCHAN];
 	int prevWinSwitch[MAX_NCHAN];
 	int gb[MAX_NCHAN];
+	int downmixState;							/* what overBuf holds with a mono downmix (see DownmixSpectrum) */
 } IMDCTInfo;
 
 typedef struct _BlockCount {
@@ -251,12 +285,13 @@ typedef struct _ScaleFactorInfo {
  *   last 15 blocks to shift them down one, a hardware style FIFO)
  */ 
 typedef struct _SubbandInfo {
-	int vbuf[MAX_NCHAN * VBUF_LENGTH];		/* vbuf for fast DCT-based synthesis PQMF - double size for speed (no modulo indexing) */
+	DSPSample vbuf[MAX_NCHAN * VBUF_LENGTH];	/* vbuf for fast DCT-based synthesis PQMF - double size for speed (no modulo indexing) */
 	int vindex;								/* internal index for tracking position in vbuf */
 } SubbandInfo;
 
 /* bitstream.c */
 void SetBitstreamPointer(BitStreamInfo *bsi, int nBytes, unsigned char *buf);
+void SetBitstreamCursor(BitStreamInfo *bsi, int nBytes, MainDataCursor *mc);
 unsigned int GetBits(BitStreamInfo *bsi, int nBits);
 int CalcBitsUsed(BitStreamInfo *bsi, unsigned char *startBuf, int startOffset);
 
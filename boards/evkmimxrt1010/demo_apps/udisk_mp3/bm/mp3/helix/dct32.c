@@ -40,11 +40,15 @@
  *
  * dct32.c - optimized implementations of 32-point DCT for matrixing stage of 
  *             polyphase filter
+ *
+ * Not built with HELIX_FLOAT_DSP, subbandf.c takes its place
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if !HELIX_FLOAT_DSP
+
 #define COS0_0  0x4013c251	/* Q31 */
 #define COS0_1  0x40b345bd	/* Q31 */
 #define COS0_2  0x41fa2d6d	/* Q31 */
@@ -81,7 +85,7 @@
 
 #define COS4_0  0x5a82799a	/* Q31 */
 
-static const int dcttab[48] = {
+HELIX_FAST_DATA(static const int dcttab[48]) = {
 	/* first pass */
 	COS0_0, COS0_15, COS1_0,	/* 31, 27, 31 */
 	COS0_1, COS0_14, COS1_1,	/* 31, 29, 31 */
@@ -139,7 +143,7 @@ static const int dcttab[48] = {
  *              possibly interleave stereo (cut # of coef loads in half - may not have
  *                enough registers)
  **************************************************************************************/
-void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb)
+HELIX_FAST_CODE(void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb))
 {
     int i, s, tmp, es;
     const int *cptr = dcttab;
@@ -276,3 +280,5 @@ void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb)
 		}
 	}
 }
+
+#endif	/* !HELIX_FLOAT_DSP */
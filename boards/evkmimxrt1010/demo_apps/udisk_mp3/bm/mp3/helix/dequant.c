@@ -40,11 +40,15 @@
  *
  * dequant.c - dequantization, stereo processing (intensity, mid-side), short-block
  *               coefficient reordering
+ *
+ * Not built with HELIX_FLOAT_DSP, dequantf.c takes its place
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if !HELIX_FLOAT_DSP
+
 /**************************************************************************************
  * Function:    Dequantize
  *
@@ -70,7 +74,7 @@
  *              Equivalently, we can think of the dequantized coefficients as 
  *                Q(DQ_FRACBITS_OUT - 15) with no implicit bias. 
  **************************************************************************************/
-int Dequantize(MP3DecInfo *mp3DecInfo, int gr)
+HELIX_FAST_CODE(int Dequantize(MP3DecInfo *mp3DecInfo, int gr))
 {
 	int i, ch, nSamps, mOut[2];
 	FrameHeader *fh;
@@ -156,3 +160,5 @@ int Dequantize(MP3DecInfo *mp3DecInfo, int gr)
 	/* output format Q(DQ_FRACBITS_OUT) */
 	return 0;
 }
+
+#endif	/* !HELIX_FLOAT_DSP */
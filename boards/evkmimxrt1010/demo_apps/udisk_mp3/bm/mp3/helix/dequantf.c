@@ -0,0 +1,602 @@
+/* ***** BEGIN LICENSE BLOCK ***** 
+ * Version: RCSL 1.0/RPSL 1.0 
+ *  
+ * Portions Copyright (c) 1995-2002 RealNetworks, Inc. All Rights Reserved. 
+ *      
+ * The contents of this file, and the files included with this file, are 
+ * subject to the current version of the RealNetworks Public Source License 
+ * Version 1.0 (the "RPSL") available at 
+ * http://www.helixcommunity.org/content/rpsl unless you have licensed 
+ * the file under the RealNetworks Community Source License Version 1.0 
+ * (the "RCSL") available at http://www.helixcommunity.org/content/rcsl, 
+ * in which case the RCSL will apply. You may also obtain the license terms 
+ * directly from RealNetworks.  You may not use this file except in 
+ * compliance with the RPSL or, if you have a valid RCSL with RealNetworks 
+ * applicable to this file, the RCSL.  Please see the applicable RPSL or 
+ * RCSL for the rights, obligations and limitations governing use of the 
+ * contents of the file.  
+ *  
+ * This file is part of the Helix DNA Technology. RealNetworks is the 
+ * developer of the Original Code and owns the copyrights in the portions 
+ * it created. 
+ *  
+ * This file, and the files included with this file, is distributed and made 
+ * available on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER 
+ * EXPRESS OR IMPLIED, AND REALNETWORKS HEREBY DISCLAIMS ALL SUCH WARRANTIES, 
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT. 
+ * 
+ * Technology Compatibility Kit Test Suite(s) Location: 
+ *    http://www.helixcommunity.org/content/tck 
+ * 
+ * Contributor(s): 
+ *  
+ * ***** END LICENSE BLOCK ***** */ 
+
+
+/**************************************************************************************
+ * Floating-point back end for the fixed-point MP3 decoder
+ *
+ * dequantf.c - dequantization, stereo processing (intensity, mid-side), short-block
+ *                coefficient reordering in single precision
+ *
+ * Built only with HELIX_FLOAT_DSP, in place of dequant.c, dqchan.c and stproc.c
+ * Every stage of the float back end follows the fixed-point code step for step. A float
+ *   sample is the matching fixed-point sample times 2^-8, which leaves the synthesis
+ *   window in subbandf.c equal to D[] of the spec. Guard bits, rescaling and clipping
+ *   are not needed.
+ **************************************************************************************/
+
+#include "coder.h"
+#include "assembly.h"
+
+#if HELIX_FLOAT_DSP
+
+typedef float ARRAY3[3];	/* for short-block reordering */
+
+/* optional pre-emphasis for high-frequency scale factor bands */
+static const char preTab[22] = { 0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,2,2,3,3,3,2,0 };
+
+/* pow(2,-i/4) for i=0..3 */
+HELIX_FAST_DATA(static const float pow14[4]) = { 
+	1.0f, 0.840896428f, 0.707106769f, 0.594603539f
+};
+
+/* pow(j,4/3) for j=0..63 */
+HELIX_FAST_DATA(static const float pow43[64]) = {
+	0.0f, 1.0f, 2.51984215f, 4.32674885f,
+	6.34960413f, 8.54988003f, 10.9027233f, 13.3905182f,
+	16.0f, 18.7207546f, 21.5443478f, 24.4637814f,
+	27.4731426f, 30.5673504f, 33.741993f, 36.9931793f,
+	40.3174744f, 43.7117882f, 47.1733437f, 50.6996307f,
+	54.288353f, 57.9374084f, 61.6448669f, 65.4089432f,
+	69.2279816f, 73.100441f, 77.0248947f, 81.0f,
+	85.0244904f, 89.0971909f, 93.2169724f, 97.3827972f,
+	101.593666f, 105.848633f, 110.146805f, 114.48732f,
+	118.869385f, 123.292206f, 127.755066f, 132.257248f,
+	136.79808f, 141.376907f, 145.993118f, 150.646118f,
+	155.335327f, 160.060196f, 164.820206f, 169.614822f,
+	174.443573f, 179.305984f, 184.201569f, 189.129913f,
+	194.090576f, 199.083145f, 204.107208f, 209.162384f,
+	214.248291f, 219.364563f, 224.510849f, 229.686783f,
+	234.892059f, 240.126328f, 245.389282f, 250.680603f,
+};
+
+/* pow(2,i*4/3) for i=0..8 */
+HELIX_FAST_DATA(static const float pow2_43[9]) = {
+	1.0f, 2.51984215f, 6.34960413f, 16.0f, 40.3174744f, 101.593666f, 256.0f, 645.07959f, 
+	1625.49866f
+};
+
+/* pow(2,n), n = [-126, 127] */
+static __inline float Pow2Int(int n)
+{
+	union { float f; unsigned int i; } u;
+
+	u.i = (unsigned int)(n + 127) << 23;
+	return u.f;
+}
+
+/**************************************************************************************
+ * Function:    Pow43Large
+ *
+ * Description: pow(x, 4/3) for the linbits range, x = [64, 8206]
+ *
+ * Inputs:      x
+ *
+ * Outputs:     none
+ *
+ * Return:      pow(x, 4/3), relative error < 1E-7
+ *
+ * Notes:       x = t * 2^s * (1 + f) with t = [32, 63] and f = [0, 1/32), so
+ *                pow(x, 4/3) = pow43[t] * pow2_43[s] * pow(1 + f, 4/3)
+ *                and three terms of the binomial series are enough for the last factor
+ **************************************************************************************/
+static float Pow43Large(int x)
+{
+	int s, b;
+	float f;
+
+	s = 26 - CLZ(x);
+	b = (x >> s) << s;
+	f = (float)(x - b) / (float)b;
+
+	return pow43[x >> s] * pow2_43[s] * (1.0f + f * (1.333333333f + f * (0.222222222f - f * 0.049382716f)));
+}
+
+/**************************************************************************************
+ * Function:    DequantBlock
+ *
+ * Description: dequantizer performing the operation
+ *              y = pow(x, 4.0/3.0) * pow(2, 17 - scale/4.0)
+ *
+ * Inputs:      input buffer of decode Huffman codewords (signed-magnitude)
+ *              output buffer of same length (in-place (outbuf = inbuf) is allowed)
+ *              number of samples
+ *              
+ * Outputs:     dequantized samples
+ *
+ * Return:      bitwise-OR of the input magnitudes (non-zero if any output is non-zero)
+ **************************************************************************************/
+HELIX_FAST_CODE(static int DequantBlock(int *inbuf, float *outbuf, int num, int scale))
+{
+	int sx, x, mask;
+	float scalef, y;
+
+	scalef = pow14[scale & 0x3] * Pow2Int(17 - (scale >> 2));
+	mask = 0;
+
+	do {
+		sx = *inbuf++;
+		x = sx & 0x7fffffff;	/* sx = sign|mag */
+		mask |= x;
+
+		y = (x < 64 ? pow43[x] : Pow43Large(x)) * scalef;
+
+		/* sign and store */
+		*outbuf++ = (sx < 0) ? -y : y;
+
+	} while (--num);
+
+	return mask;
+}
+
+/**************************************************************************************
+ * Function:    DequantChannelF
+ *
+ * Description: dequantize one granule, one channel worth of decoded Huffman codewords
+ *
+ * Inputs:      sample buffer (decoded Huffman codewords), length = MAX_NSAMP samples
+ *              work buffer for reordering short-block, length = MAX_REORDER_SAMPS
+ *                samples (3 * width of largest short-block critical band)
+ *              non-zero bound for this channel/granule
+ *              valid FrameHeader, SideInfoSub, ScaleFactorInfoSub, and CriticalBandInfo
+ *                structures for this channel/granule
+ *
+ * Outputs:     MAX_NSAMP dequantized float samples, in place of the codewords
+ *              updated non-zero bound (indicating which samples are != 0 after DQ)
+ *              filled-in cbi structure indicating start and end critical bands
+ *
+ * Return:      none
+ *
+ * Notes:       same band walk as DequantChannel() in dqchan.c
+ *              a band counts as non-zero when any of its codewords is, even if the
+ *                fixed-point path would have shifted the dequantized values down to 0
+ **************************************************************************************/
+HELIX_FAST_CODE(static void DequantChannelF(int *sampleBuf, float *workBuf, int *nonZeroBound, FrameHeader *fh, SideInfoSub *sis, 
+					ScaleFactorInfoSub *sfis, CriticalBandInfo *cbi))
+{
+	int i, j, w, cb;
+	int cbEndL, cbStartS, cbEndS;
+	int nSamps, nonZero, sfactMultiplier;
+	int globalGain, gainI;
+	int cbMax[3];
+	float *xr;
+	ARRAY3 *buf;    /* short block reorder */
+	
+	/* the floats replace the codewords in the same storage */
+	xr = (float *)sampleBuf;
+
+	/* set default start/end points for short/long blocks - will update with non-zero cb info */
+	if (sis->blockType == 2) {
+		if (sis->mixedBlock) { 
+			cbEndL = (fh->ver == MPEG1 ? 8 : 6); 
+			cbStartS = 3; 
+		} else {
+			cbEndL = 0; 
+			cbStartS = 0;
+		}
+		cbEndS = 13;
+	} else {
+		/* long block */
+		cbEndL =   22;
+		cbStartS = 13;
+		cbEndS =   13;
+	}
+	cbMax[2] = cbMax[1] = cbMax[0] = 0;
+	i = 0;
+
+	/* same gain offsets as the fixed-point path: -2 for the 1/sqrt(2) of MidSideProcF(),
+	 *   +IMDCT_SCALE for the window tables of the fast IMDCT36
+	 */
+	sfactMultiplier = 2 * (sis->sfactScale + 1);
+	globalGain = sis->globalGain;
+	if (fh->modeExt >> 1)
+		 globalGain -= 2;
+	globalGain += IMDCT_SCALE;
+
+	/* long blocks */
+	for (cb = 0; cb < cbEndL; cb++) {
+
+		nSamps = fh->sfBand->l[cb + 1] - fh->sfBand->l[cb];
+		gainI = 210 - globalGain + sfactMultiplier * (sfis->l[cb] + (sis->preFlag ? (int)preTab[cb] : 0));
+
+		nonZero = DequantBlock(sampleBuf + i, xr + i, nSamps, gainI);
+		i += nSamps;
+
+		/* update highest non-zero critical band */
+		if (nonZero) 
+			cbMax[0] = cb;
+
+		if (i >= *nonZeroBound) 
+			break;
+	}
+
+	/* set cbi (Type, EndS[], EndSMax will be overwritten if we proceed to do short blocks) */
+	cbi->cbType = 0;			/* long only */
+	cbi->cbEndL  = cbMax[0];
+	cbi->cbEndS[0] = cbi->cbEndS[1] = cbi->cbEndS[2] = 0;
+	cbi->cbEndSMax = 0;
+
+	/* early exit if no short blocks */
+	if (cbStartS >= 12) 
+		return;
+	
+	/* short blocks */
+	cbMax[2] = cbMax[1] = cbMax[0] = cbStartS;
+	for (cb = cbStartS; cb < cbEndS; cb++) {
+
+		nSamps = fh->sfBand->s[cb + 1] - fh->sfBand->s[cb];
+		for (w = 0; w < 3; w++) {
+			gainI = 210 - globalGain + 8*sis->subBlockGain[w] + sfactMultiplier*(sfis->s[cb][w]);
+
+			nonZero = DequantBlock(sampleBuf + i + nSamps*w, workBuf + nSamps*w, nSamps, gainI);
+
+			/* update highest non-zero critical band */
+			if (nonZero)
+				cbMax[w] = cb;
+		}
+
+		/* reorder blocks */
+		buf = (ARRAY3 *)(xr + i);
+		i += 3*nSamps;
+		for (j = 0; j < nSamps; j++) {
+			buf[j][0] = workBuf[0*nSamps + j];
+			buf[j][1] = workBuf[1*nSamps + j];
+			buf[j][2] = workBuf[2*nSamps + j];
+		}
+
+		ASSERT(3*nSamps <= MAX_REORDER_SAMPS);
+
+		if (i >= *nonZeroBound) 
+			break;
+	}
+
+	/* i = last non-zero INPUT sample processed (see DequantChannel()) */
+	*nonZeroBound = i;
+
+	ASSERT(*nonZeroBound <= MAX_NSAMP);
+
+	cbi->cbType = (sis->mixedBlock ? 2 : 1);	/* 2 = mixed short/long, 1 = short only */
+
+	cbi->cbEndS[0] = cbMax[0];
+	cbi->cbEndS[1] = cbMax[1];
+	cbi->cbEndS[2] = cbMax[2];
+
+	cbi->cbEndSMax = cbMax[0];
+	cbi->cbEndSMax = MAX(cbi->cbEndSMax, cbMax[1]);
+	cbi->cbEndSMax = MAX(cbi->cbEndSMax, cbMax[2]);
+}
+
+/**************************************************************************************
+ * Function:    MidSideProcF
+ *
+ * Description: sum-difference stereo reconstruction
+ *
+ * Inputs:      vector x with dequantized samples from left and right channels
+ *              number of non-zero samples (MAX of left and right)
+ *
+ * Outputs:     updated sample vector x
+ *
+ * Return:      none
+ *
+ * Notes:       L = (M+S)/sqrt(2), R = (M-S)/sqrt(2), the 1/sqrt(2) is done in 
+ *                DequantChannelF()
+ **************************************************************************************/
+HELIX_FAST_CODE(static void MidSideProcF(float x[MAX_NCHAN][MAX_NSAMP], int nSamps))
+{
+	int i;
+	float xl, xr;
+
+	for (i = 0; i < nSamps; i++) {
+		xl = x[0][i];
+		xr = x[1][i];
+		x[0][i] = xl + xr;
+		x[1][i] = xl - xr;
+	}
+}
+
+/* intensity stereo gains come from the Q30 tables in trigtabs.c */
+#define ISF_SCALE	(1.0f / 1073741824.0f)
+
+/**************************************************************************************
+ * Function:    IntensityProcMPEG1F
+ *
+ * Description: intensity stereo processing for MPEG1
+ *
+ * Inputs:      vector x with dequantized samples from left and right channels
+ *              number of non-zero samples in left channel
+ *              valid FrameHeader struct
+ *              two each of ScaleFactorInfoSub, CriticalBandInfo structs (both channels)
+ *              flag indicating midSide on/off
+ *
+ * Outputs:     updated sample vector x
+ *
+ * Return:      none
+ *
+ * Notes:       same band walk as IntensityProcMPEG1() in stproc.c
+ **************************************************************************************/
+static void IntensityProcMPEG1F(float x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh, ScaleFactorInfoSub *sfis, 
+						CriticalBandInfo *cbi, int midSideFlag)
+{
+	int i=0, j=0, n=0, cb=0, w=0;
+	int sampsLeft, isf;
+	int cbStartL=0, cbStartS=0, cbEndL=0, cbEndS=0;
+	const int *isfTab;
+	float fl, fr, fls[3], frs[3];
+	
+	if (cbi[1].cbType == 0) {
+		/* long block */
+		cbStartL = cbi[1].cbEndL + 1;
+		cbEndL =   cbi[0].cbEndL + 1;
+		cbStartS = cbEndS = 0;
+		i = fh->sfBand->l[cbStartL];
+	} else if (cbi[1].cbType == 1 || cbi[1].cbType == 2) {
+		/* short or mixed block */
+		cbStartS = cbi[1].cbEndSMax + 1;
+		cbEndS =   cbi[0].cbEndSMax + 1;
+		cbStartL = cbEndL = 0;
+		i = 3 * fh->sfBand->s[cbStartS];
+	}
+
+	sampsLeft = nSamps - i;		/* process to length of left */
+	isfTab = ISFMpeg1[midSideFlag];
+
+	/* long blocks */
+	for (cb = cbStartL; cb < cbEndL && sampsLeft > 0; cb++) {
+		isf = sfis->l[cb];
+		if (isf == 7) {
+			fl = (float)ISFIIP[midSideFlag][0] * ISF_SCALE;
+			fr = (float)ISFIIP[midSideFlag][1] * ISF_SCALE;
+		} else {
+			fl = (float)isfTab[isf] * ISF_SCALE;	
+			fr = (float)(isfTab[6] - isfTab[isf]) * ISF_SCALE;
+		}
+
+		n = fh->sfBand->l[cb + 1] - fh->sfBand->l[cb];
+		for (j = 0; j < n && sampsLeft > 0; j++, i++) {
+			x[1][i] = fr * x[0][i];
+			x[0][i] = fl * x[0][i];
+			sampsLeft--;
+		}
+	}
+
+	/* short blocks */
+	for (cb = cbStartS; cb < cbEndS && sampsLeft >= 3; cb++) {
+		for (w = 0; w < 3; w++) {
+			isf = sfis->s[cb][w];
+			if (isf == 7) {
+				fls[w] = (float)ISFIIP[midSideFlag][0] * ISF_SCALE;
+				frs[w] = (float)ISFIIP[midSideFlag][1] * ISF_SCALE;
+			} else {
+				fls[w] = (float)isfTab[isf] * ISF_SCALE;
+				frs[w] = (float)(isfTab[6] - isfTab[isf]) * ISF_SCALE;
+			}
+		}
+
+		n = fh->sfBand->s[cb + 1] - fh->sfBand->s[cb];
+		for (j = 0; j < n && sampsLeft >= 3; j++, i+=3) {
+			x[1][i+0] = frs[0] * x[0][i+0];	x[0][i+0] = fls[0] * x[0][i+0];
+			x[1][i+1] = frs[1] * x[0][i+1];	x[0][i+1] = fls[1] * x[0][i+1];
+			x[1][i+2] = frs[2] * x[0][i+2];	x[0][i+2] = fls[2] * x[0][i+2];
+			sampsLeft -= 3;
+		}
+	}
+}
+
+/**************************************************************************************
+ * Function:    IntensityProcMPEG2F
+ *
+ * Description: intensity stereo processing for MPEG2
+ *
+ * Inputs:      vector x with dequantized samples from left and right channels
+ *              number of non-zero samples in left channel
+ *              valid FrameHeader struct
+ *              two each of ScaleFactorInfoSub, CriticalBandInfo structs (both channels)
+ *              ScaleFactorJS struct with joint stereo info from UnpackSFMPEG2()
+ *              flag indicating midSide on/off
+ *
+ * Outputs:     updated sample vector x
+ *
+ * Return:      none
+ *
+ * Notes:       same band walk as IntensityProcMPEG2() in stproc.c
+ **************************************************************************************/
+static void IntensityProcMPEG2F(float x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh, ScaleFactorInfoSub *sfis, 
+						CriticalBandInfo *cbi, ScaleFactorJS *sfjs, int midSideFlag)
+{
+	int i, j, k, n, r, cb, w;
+	int sampsLeft;
+	int isf, sfIdx, tmp, il[23];
+	const int *isfTab;
+	int cbStartL, cbStartS, cbEndL, cbEndS;
+	float fl, fr;
+	
+	isfTab = ISFMpeg2[sfjs->intensityScale][midSideFlag];
+
+	/* fill buffer with illegal intensity positions (depending on slen) */
+	for (k = r = 0; r < 4; r++) {
+		tmp = (1 << sfjs->slen[r]) - 1;
+		for (j = 0; j < sfjs->nr[r]; j++, k++) 
+			il[k] = tmp;
+	}
+
+	if (cbi[1].cbType == 0) {
+		/* long blocks */
+		il[21] = il[22] = 1;
+		cbStartL = cbi[1].cbEndL + 1;	/* start at end of right */
+		cbEndL =   cbi[0].cbEndL + 1;	/* process to end of left */
+		i = fh->sfBand->l[cbStartL];
+		sampsLeft = nSamps - i;
+
+		for(cb = cbStartL; cb < cbEndL; cb++) {
+			sfIdx = sfis->l[cb];
+			if (sfIdx == il[cb]) {
+				fl = (float)ISFIIP[midSideFlag][0] * ISF_SCALE;
+				fr = (float)ISFIIP[midSideFlag][1] * ISF_SCALE;
+			} else {
+				isf = (sfis->l[cb] + 1) >> 1;
+				fl = (float)isfTab[(sfIdx & 0x01 ? isf : 0)] * ISF_SCALE;
+				fr = (float)isfTab[(sfIdx & 0x01 ? 0 : isf)] * ISF_SCALE;
+			}
+			n = MIN(fh->sfBand->l[cb + 1] - fh->sfBand->l[cb], sampsLeft);
+
+			for(j = 0; j < n; j++, i++) {
+				x[1][i] = fr * x[0][i];
+				x[0][i] = fl * x[0][i];
+			}
+
+			/* early exit once we've used all the non-zero samples */
+			sampsLeft -= n;
+			if (sampsLeft == 0)		
+				break;
+		}
+	} else {
+		/* short or mixed blocks */
+		il[12] = 1;
+
+		for(w = 0; w < 3; w++) {
+			cbStartS = cbi[1].cbEndS[w] + 1;		/* start at end of right */
+			cbEndS =   cbi[0].cbEndS[w] + 1;		/* process to end of left */
+			i = 3 * fh->sfBand->s[cbStartS] + w;
+
+			for(cb = cbStartS; cb < cbEndS; cb++) {
+				sfIdx = sfis->s[cb][w];
+				if (sfIdx == il[cb]) {
+					fl = (float)ISFIIP[midSideFlag][0] * ISF_SCALE;
+					fr = (float)ISFIIP[midSideFlag][1] * ISF_SCALE;
+				} else {
+					isf = (sfis->s[cb][w] + 1) >> 1;
+					fl = (float)isfTab[(sfIdx & 0x01 ? isf : 0)] * ISF_SCALE;
+					fr = (float)isfTab[(sfIdx & 0x01 ? 0 : isf)] * ISF_SCALE;
+				}
+				n = fh->sfBand->s[cb + 1] - fh->sfBand->s[cb];
+
+				for(j = 0; j < n; j++, i+=3) {
+					x[1][i] = fr * x[0][i];
+					x[0][i] = fl * x[0][i];
+				}
+			}
+		}
+	}
+}
+
+/**************************************************************************************
+ * Function:    Dequantize
+ *
+ * Description: dequantize coefficients, decode stereo, reorder short blocks
+ *                (one granule-worth)
+ *
+ * Inputs:      MP3DecInfo structure filled by UnpackFrameHeader(), UnpackSideInfo(),
+ *                UnpackScaleFactors(), and DecodeHuffman() (for this granule)
+ *              index of current granule
+ *
+ * Outputs:     dequantized and reordered float coefficients in hi->huffDecBuf 
+ *                (one granule-worth, all channels)
+ *              operates in-place on huffDecBuf but also needs di->workBuf
+ *              updated hi->nonZeroBound index for both channels
+ *
+ * Return:      0 on success, -1 if null input pointers
+ *
+ * Notes:       the codewords are read as int and written back as float, which is fine
+ *                as huffDecBuf lives in the decoder's own memory block
+ *              hi->gb is not used by the float back end and is left alone
+ **************************************************************************************/
+HELIX_FAST_CODE(int Dequantize(MP3DecInfo *mp3DecInfo, int gr))
+{
+	int ch, nSamps;
+	FrameHeader *fh;
+	SideInfo *si;
+	ScaleFactorInfo *sfi;
+	HuffmanInfo *hi;
+	DequantInfo *di;
+	CriticalBandInfo *cbi;
+	float (*xr)[MAX_NSAMP];
+
+	/* validate pointers */
+	if (!mp3DecInfo || !mp3DecInfo->FrameHeaderPS || !mp3DecInfo->SideInfoPS || !mp3DecInfo->ScaleFactorInfoPS || 
+		!mp3DecInfo->HuffmanInfoPS || !mp3DecInfo->DequantInfoPS)
+		return -1;
+
+	fh = (FrameHeader *)(mp3DecInfo->FrameHeaderPS);
+
+	/* si is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
+	si = (SideInfo *)(mp3DecInfo->SideInfoPS);
+	sfi = (ScaleFactorInfo *)(mp3DecInfo->ScaleFactorInfoPS);
+	hi = (HuffmanInfo *)mp3DecInfo->HuffmanInfoPS;
+	di = (DequantInfo *)mp3DecInfo->DequantInfoPS;
+	cbi = di->cbi;
+	xr = (float (*)[MAX_NSAMP])hi->huffDecBuf;
+
+	/* dequantize all the samples in each channel */
+	for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
+		DequantChannelF(hi->huffDecBuf[ch], di->workBuf, &hi->nonZeroBound[ch], fh, 
+			&si->sis[gr][ch], &sfi->sfis[gr][ch], &cbi[ch]);
+	}
+
+	/* do mid-side stereo processing, if enabled */
+	if (fh->modeExt >> 1) {
+		if (fh->modeExt & 0x01) {
+			/* intensity stereo enabled - run mid-side up to start of right zero region */
+			if (cbi[1].cbType == 0)
+				nSamps = fh->sfBand->l[cbi[1].cbEndL + 1];
+			else 
+				nSamps = 3 * fh->sfBand->s[cbi[1].cbEndSMax + 1];
+		} else {
+			/* intensity stereo disabled - run mid-side on whole spectrum */
+			nSamps = MAX(hi->nonZeroBound[0], hi->nonZeroBound[1]);
+		}
+		MidSideProcF(xr, nSamps);
+	}
+
+	/* do intensity stereo processing, if enabled */
+	if (fh->modeExt & 0x01) {
+		nSamps = hi->nonZeroBound[0];
+		if (fh->ver == MPEG1) {
+			IntensityProcMPEG1F(xr, nSamps, fh, &sfi->sfis[gr][1], di->cbi, fh->modeExt >> 1);
+		} else {
+			IntensityProcMPEG2F(xr, nSamps, fh, &sfi->sfis[gr][1], di->cbi, &sfi->sfjs, fh->modeExt >> 1);
+		}
+	}
+
+	/* adjust nonZeroBound if we did any stereo processing */
+	if (fh->modeExt) {
+		nSamps = MAX(hi->nonZeroBound[0], hi->nonZeroBound[1]);
+		hi->nonZeroBound[0] = nSamps;
+		hi->nonZeroBound[1] = nSamps;
+	}
+
+	return 0;
+}
+
+#endif	/* HELIX_FLOAT_DSP */
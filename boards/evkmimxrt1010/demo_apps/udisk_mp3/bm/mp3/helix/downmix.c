@@ -0,0 +1,270 @@
+/* ***** BEGIN LICENSE BLOCK ***** 
+ * Version: RCSL 1.0/RPSL 1.0 
+ *  
+ * Portions Copyright (c) 1995-2002 RealNetworks, Inc. All Rights Reserved. 
+ *      
+ * The contents of this file, and the files included with this file, are 
+ * subject to the current version of the RealNetworks Public Source License 
+ * Version 1.0 (the "RPSL") available at 
+ * http://www.helixcommunity.org/content/rpsl unless you have licensed 
+ * the file under the RealNetworks Community Source License Version 1.0 
+ * (the "RCSL") available at http://www.helixcommunity.org/content/rcsl, 
+ * in which case the RCSL will apply. You may also obtain the license terms 
+ * directly from RealNetworks.  You may not use this file except in 
+ * compliance with the RPSL or, if you have a valid RCSL with RealNetworks 
+ * applicable to this file, the RCSL.  Please see the applicable RPSL or 
+ * RCSL for the rights, obligations and limitations governing use of the 
+ * contents of the file.  
+ *  
+ * This file is part of the Helix DNA Technology. RealNetworks is the 
+ * developer of the Original Code and owns the copyrights in the portions 
+ * it created. 
+ *  
+ * This file, and the files included with this file, is distributed and made 
+ * available on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER 
+ * EXPRESS OR IMPLIED, AND REALNETWORKS HEREBY DISCLAIMS ALL SUCH WARRANTIES, 
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT. 
+ * 
+ * Technology Compatibility Kit Test Suite(s) Location: 
+ *    http://www.helixcommunity.org/content/tck 
+ * 
+ * Contributor(s): 
+ *  
+ * ***** END LICENSE BLOCK ***** */ 
+
+
+/**************************************************************************************
+ * Low-power decode options for the fixed-point MP3 decoder
+ *
+ * downmix.c - band limiting and mono downmix of stereo streams around the IMDCT
+ *
+ * Built with both back ends, samples are DSPSample (int, or float with HELIX_FLOAT_DSP)
+ **************************************************************************************/
+
+#include "coder.h"
+#include "assembly.h"
+
+#if HELIX_FLOAT_DSP
+#define HALF(x)		((x) * 0.5f)
+#define TWICE(x)	((x) * 2.0f)
+#else
+#define HALF(x)		((x) >> 1)
+#define TWICE(x)	((x) << 1)
+#endif
+
+/* what IMDCTInfo.downmixState says about overBuf, in all states overBuf[0] + overBuf[1]
+ *   is the overlap of the mono downmix (L + R) / 2
+ */
+#define DOWNMIX_NONE	0	/* stereo output, overBuf[ch] is the overlap of channel ch */
+#define DOWNMIX_SUM		1	/* overBuf[0] is the overlap of (L + R) / 2, overBuf[1] is empty */
+#define DOWNMIX_HALVES	2	/* overBuf[ch] is the overlap of channel ch at half level */
+
+/**************************************************************************************
+ * Function:    SwitchHistory
+ *
+ * Description: hand the synthesis filter history over between stereo and mono output
+ *
+ * Inputs:      SubbandInfo struct, vbuf holding 32 samples of channel 0 followed by 32
+ *                samples of channel 1 in every 64
+ *              1 when going from stereo to mono output, 0 when going back
+ *
+ * Outputs:     channel 0 history set to (L + R) / 2 (exact, the DCT is linear), or
+ *                channel 0 history copied into channel 1
+ *
+ * Return:      none
+ **************************************************************************************/
+static void SwitchHistory(SubbandInfo *sbi, int toMono)
+{
+	int i, j;
+	DSPSample *v;
+
+	for (i = 0; i < MAX_NCHAN * VBUF_LENGTH; i += 2 * NBANDS) {
+		v = sbi->vbuf + i;
+		for (j = 0; j < NBANDS; j++) {
+			if (toMono)
+				v[j] = HALF(v[j]) + HALF(v[j + NBANDS]);
+			else
+				v[j + NBANDS] = v[j];
+		}
+	}
+}
+
+/**************************************************************************************
+ * Function:    LimitBandwidth
+ *
+ * Description: drop the spectrum above the lowest nSubbands subbands
+ *
+ * Inputs:      MP3DecInfo structure after Dequantize() for this granule
+ *
+ * Outputs:     huffDecBuf[ch] zeroed from nSubbands*18 on, nonZeroBound[ch] clipped to it
+ *
+ * Return:      none
+ *
+ * Notes:       no-op unless MP3SetDecodeConfig asked for fewer than 32 subbands
+ *              after Dequantize short blocks are in subband order too, so block i of 18
+ *                samples is subband i for every block type
+ *              the IMDCT then skips the upper blocks, except one the alias reduction
+ *                spills into
+ **************************************************************************************/
+HELIX_FAST_CODE(void LimitBandwidth(MP3DecInfo *mp3DecInfo))
+{
+	int i, ch, nSamps;
+	HuffmanInfo *hi;
+
+	if (mp3DecInfo->nSubbands <= 0 || mp3DecInfo->nSubbands >= NBANDS)
+		return;
+
+	hi = (HuffmanInfo *)(mp3DecInfo->HuffmanInfoPS);
+	nSamps = mp3DecInfo->nSubbands * 18;
+	for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
+		for (i = nSamps; i < hi->nonZeroBound[ch]; i++)
+			hi->huffDecBuf[ch][i] = 0;		/* 0.0f has the same bits */
+		hi->nonZeroBound[ch] = MIN(hi->nonZeroBound[ch], nSamps);
+	}
+}
+
+/**************************************************************************************
+ * Function:    DownmixSpectrum
+ *
+ * Description: sum a stereo granule to mono ahead of the IMDCT
+ *
+ * Inputs:      MP3DecInfo structure after Dequantize() (and LimitBandwidth()) for this
+ *                granule, stereo already decoded into left and right
+ *              index of current granule
+ *
+ * Outputs:     with monoDownmix, (L + R) / 2 in huffDecBuf[0] when both channels use the
+ *                same windows, otherwise L / 2 and R / 2 in place
+ *              overlap buffers moved between the downmix states (see DOWNMIX_xxx),
+ *                synthesis history handed over when the output switches between
+ *                stereo and mono
+ *
+ * Return:      number of channels to run the IMDCT on (nChans, or 1 when summed)
+ *
+ * Notes:       the IMDCT is linear, so summing before or after it gives the same output,
+ *                but one overlap buffer can only carry one window shape: the channels
+ *                are summed up front only if their block types match and the overlap
+ *                left in channel 1 (if any) has the same window as channel 0
+ *              DownmixIMDCT() sums the channels which were transformed separately
+ *              when monoDownmix is switched on the output carries on without a seam,
+ *                when it is switched off both channels restart from the mono history
+ **************************************************************************************/
+HELIX_FAST_CODE(int DownmixSpectrum(MP3DecInfo *mp3DecInfo, int gr))
+{
+	int i, ch, nSamps, sameWin;
+	DSPSample *x0, *x1;
+	HuffmanInfo *hi;
+	IMDCTInfo *mi;
+	SideInfoSub *sis;
+
+	if (mp3DecInfo->nChans != 2)
+		return mp3DecInfo->nChans;
+
+	hi = (HuffmanInfo *)(mp3DecInfo->HuffmanInfoPS);
+	mi = (IMDCTInfo *)(mp3DecInfo->IMDCTInfoPS);
+	sis = ((SideInfo *)(mp3DecInfo->SideInfoPS))->sis[gr];
+
+	if (mp3DecInfo->nOutChans == 2) {
+		/* stereo output - give each channel back a full level overlap */
+		if (mi->downmixState == DOWNMIX_SUM) {
+			for (i = 0; i < MAX_NSAMP / 2; i++)
+				mi->overBuf[1][i] = mi->overBuf[0][i];
+			mi->numPrevIMDCT[1] = mi->numPrevIMDCT[0];
+			mi->prevType[1] = mi->prevType[0];
+			mi->prevWinSwitch[1] = mi->prevWinSwitch[0];
+		} else if (mi->downmixState == DOWNMIX_HALVES) {
+			for (ch = 0; ch < 2; ch++) {
+				for (i = 0; i < MAX_NSAMP / 2; i++)
+					mi->overBuf[ch][i] = TWICE(mi->overBuf[ch][i]);
+			}
+		}
+		if (mi->downmixState != DOWNMIX_NONE)
+			SwitchHistory((SubbandInfo *)(mp3DecInfo->SubbandInfoPS), 0);
+		mi->downmixState = DOWNMIX_NONE;
+		return 2;
+	}
+
+	if (mi->downmixState == DOWNMIX_NONE) {
+		for (ch = 0; ch < 2; ch++) {
+			for (i = 0; i < MAX_NSAMP / 2; i++)
+				mi->overBuf[ch][i] = HALF(mi->overBuf[ch][i]);
+		}
+		SwitchHistory((SubbandInfo *)(mp3DecInfo->SubbandInfoPS), 1);
+		mi->downmixState = DOWNMIX_HALVES;
+	}
+
+	sameWin = (sis[0].blockType == sis[1].blockType && sis[0].mixedBlock == sis[1].mixedBlock);
+	if (mi->downmixState == DOWNMIX_HALVES && mi->numPrevIMDCT[1] > 0)
+		sameWin &= (mi->prevType[0] == mi->prevType[1] && mi->prevWinSwitch[0] == mi->prevWinSwitch[1]);
+
+	x0 = (DSPSample *)hi->huffDecBuf[0];	/* float with HELIX_FLOAT_DSP, written by Dequantize() */
+	x1 = (DSPSample *)hi->huffDecBuf[1];
+	if (!sameWin) {
+		/* transform both at half level, DownmixIMDCT() adds them up */
+		for (i = 0; i < hi->nonZeroBound[0]; i++)
+			x0[i] = HALF(x0[i]);
+		for (i = 0; i < hi->nonZeroBound[1]; i++)
+			x1[i] = HALF(x1[i]);
+		mi->downmixState = DOWNMIX_HALVES;
+		return 2;
+	}
+
+	/* zero beyond nonZeroBound in both channels, |sum| <= MAX(|x0|, |x1|) keeps the guard bits */
+	nSamps = MAX(hi->nonZeroBound[0], hi->nonZeroBound[1]);
+	for (i = 0; i < nSamps; i++)
+		x0[i] = HALF(x0[i]) + HALF(x1[i]);
+	hi->nonZeroBound[0] = nSamps;
+	hi->gb[0] = MIN(hi->gb[0], hi->gb[1]);
+
+	if (mi->downmixState == DOWNMIX_HALVES) {
+		/* same window in both overlap buffers (or none in channel 1), fold channel 1 into 0 */
+		for (i = 0; i < MAX_NSAMP / 2; i++) {
+			mi->overBuf[0][i] += mi->overBuf[1][i];
+			mi->overBuf[1][i] = 0;
+		}
+		if (mi->numPrevIMDCT[0] < mi->numPrevIMDCT[1]) {
+			mi->numPrevIMDCT[0] = mi->numPrevIMDCT[1];
+			mi->prevType[0] = mi->prevType[1];
+			mi->prevWinSwitch[0] = mi->prevWinSwitch[1];
+		}
+		mi->numPrevIMDCT[1] = 0;
+		mi->downmixState = DOWNMIX_SUM;
+	}
+
+	return 1;
+}
+
+/**************************************************************************************
+ * Function:    DownmixIMDCT
+ *
+ * Description: sum the two halves transformed separately by DownmixSpectrum()
+ *
+ * Inputs:      IMDCT output of L / 2 and R / 2 in outBuf[0] and outBuf[1]
+ *
+ * Outputs:     (L + R) / 2 in outBuf[0], for mono synthesis
+ *              guard bits of the sum in mi->gb[0] (fixed point only)
+ *
+ * Return:      none
+ **************************************************************************************/
+HELIX_FAST_CODE(void DownmixIMDCT(MP3DecInfo *mp3DecInfo))
+{
+	int i;
+	DSPSample *y0, *y1;
+	IMDCTInfo *mi;
+#if !HELIX_FLOAT_DSP
+	int mOut = 0;
+#endif
+
+	mi = (IMDCTInfo *)(mp3DecInfo->IMDCTInfoPS);
+	y0 = mi->outBuf[0][0];
+	y1 = mi->outBuf[1][0];
+	for (i = 0; i < BLOCK_SIZE * NBANDS; i++) {
+		y0[i] += y1[i];
+#if !HELIX_FLOAT_DSP
+		mOut |= FASTABS(y0[i]);
+#endif
+	}
+#if !HELIX_FLOAT_DSP
+	mi->gb[0] = CLZ(mOut) - 1;
+#endif
+}
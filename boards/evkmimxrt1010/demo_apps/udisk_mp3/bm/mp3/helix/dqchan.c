@@ -39,23 +39,27 @@
  * August 2003
  *
  * dqchan.c - dequantization of transform coefficients
+ *
+ * Not built with HELIX_FLOAT_DSP, dequantf.c takes its place
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if !HELIX_FLOAT_DSP
+
 typedef int ARRAY3[3];	/* for short-block reordering */
 
 /* optional pre-emphasis for high-frequency scale factor bands */
-static const char preTab[22] = { 0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,2,2,3,3,3,2,0 };
+HELIX_FAST_DATA(static const char preTab[22]) = { 0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,2,2,3,3,3,2,0 };
 
 /* pow(2,-i/4) for i=0..3, Q31 format */
-static const int pow14[4] = { 
+HELIX_FAST_DATA(static const int pow14[4]) = { 
 	0x7fffffff, 0x6ba27e65, 0x5a82799a, 0x4c1bf829
 };
 
 /* pow(2,-i/4) * pow(j,4/3) for i=0..3 j=0..15, Q25 format */
-static const int pow43_14[4][16] = {
+HELIX_FAST_DATA(static const int pow43_14[4][16]) = {
 {	0x00000000, 0x10000000, 0x285145f3, 0x453a5cdb, /* Q28 */
 	0x0cb2ff53, 0x111989d6, 0x15ce31c8, 0x1ac7f203, 
 	0x20000000, 0x257106b9, 0x2b16b4a3, 0x30ed74b4, 
@@ -78,7 +82,7 @@ static const int pow43_14[4][16] = {
 };
 
 /* pow(j,4/3) for j=16..63, Q23 format */
-static const int pow43[] = {
+HELIX_FAST_DATA(static const int pow43[]) = {
 	0x1428a2fa, 0x15db1bd6, 0x1796302c, 0x19598d85, 
 	0x1b24e8bb, 0x1cf7fcfa, 0x1ed28af2, 0x20b4582a, 
 	0x229d2e6e, 0x248cdb55, 0x26832fda, 0x28800000, 
@@ -104,17 +108,97 @@ static const int pow43[] = {
  * Relative error < 1E-7
  * Coefs are scaled by 4, 2, 1, 0.5, 0.25
  */
-static const int poly43lo[5] = { 0x29a0bda9, 0xb02e4828, 0x5957aa1b, 0x236c498d, 0xff581859 };
-static const int poly43hi[5] = { 0x10852163, 0xd333f6a4, 0x46e9408b, 0x27c2cef0, 0xfef577b4 };
+HELIX_FAST_DATA(static const int poly43lo[5]) = { 0x29a0bda9, 0xb02e4828, 0x5957aa1b, 0x236c498d, 0xff581859 };
+HELIX_FAST_DATA(static const int poly43hi[5]) = { 0x10852163, 0xd333f6a4, 0x46e9408b, 0x27c2cef0, 0xfef577b4 };
 
 /* pow(2, i*4/3) as exp and frac */
-static const int pow2exp[8]  = { 14, 13, 11, 10, 9, 7, 6, 5 };
+HELIX_FAST_DATA(static const int pow2exp[8])  = { 14, 13, 11, 10, 9, 7, 6, 5 };
 
-static const int pow2frac[8] = {
+HELIX_FAST_DATA(static const int pow2frac[8]) = {
 	0x6597fa94, 0x50a28be6, 0x7fffffff, 0x6597fa94, 
 	0x50a28be6, 0x7fffffff, 0x6597fa94, 0x50a28be6
 };
 
+/**************************************************************************************
+ * Function:    DequantSample
+ *
+ * Description: dequantize the magnitude of one Huffman codeword (inner step of 
+ *                DequantBlock)
+ *
+ * Inputs:      magnitude x (sign bit already removed)
+ *              first 4 values of tab16 pre-shifted by scalei, tab16 = pow43_14[scale & 3]
+ *              fractional and integer scale (see DequantBlock)
+ *
+ * Outputs:     none
+ *
+ * Return:      dequantized magnitude in Q25 format
+ **************************************************************************************/
+static __inline int DequantSample(int x, const int *tab4, const int *tab16, int scalef, int scalei)
+{
+	int y, shift;
+	const int *coef;
+
+	if (x < 4) {
+
+		y = tab4[x];
+
+	} else if (x < 16) {
+
+		y = tab16[x];
+		y = (scalei < 0) ? y << -scalei : y >> scalei;
+
+	} else {
+
+		if (x < 64) {
+
+			y = pow43[x-16];
+
+			/* fractional scale */
+			y = MULSHIFT32(y, scalef);
+			shift = scalei - 3;
+
+		} else {
+
+			/* normalize to [0x40000000, 0x7fffffff] */
+			x <<= 17;
+			shift = 0;
+			if (x < 0x08000000)
+				x <<= 4, shift += 4;
+			if (x < 0x20000000)
+				x <<= 2, shift += 2;
+			if (x < 0x40000000)
+				x <<= 1, shift += 1;
+
+			coef = (x < SQRTHALF) ? poly43lo : poly43hi;
+
+			/* polynomial */
+			y = coef[0];
+			y = MULSHIFT32(y, x) + coef[1];
+			y = MULSHIFT32(y, x) + coef[2];
+			y = MULSHIFT32(y, x) + coef[3];
+			y = MULSHIFT32(y, x) + coef[4];
+			y = MULSHIFT32(y, pow2frac[shift]) << 3;
+
+			/* fractional scale */
+			y = MULSHIFT32(y, scalef);
+			shift = scalei - pow2exp[shift];
+		}
+
+		/* integer scale */
+		if (shift < 0) {
+			shift = -shift;
+			if (y > (0x7fffffff >> shift))
+				y = 0x7fffffff;		/* clip */
+			else
+				y <<= shift;
+		} else {
+			y >>= shift;
+		}
+	}
+
+	return y;
+}
+
 /**************************************************************************************
  * Function:    DequantBlock
  *
@@ -128,14 +212,21 @@ static const int pow2frac[8] = {
  * Outputs:     dequantized samples in Q25 format
  *
  * Return:      bitwise-OR of the unsigned outputs (for guard bit calculations)
+ *
+ * Notes:       with HELIX_DQ_KERNELS the codewords are taken two at a time (the Huffman
+ *                pairs) and an all-zero pair is stored without touching the tables,
+ *                which is most of the spectrum above a few kHz
  **************************************************************************************/
-static int DequantBlock(int *inbuf, int *outbuf, int num, int scale)
+HELIX_FAST_CODE(static int DequantBlock(int *inbuf, int *outbuf, int num, int scale))
 {
 	int tab4[4];
 	int scalef, scalei, shift;
-	int sx, x, y;
+	int sx, y;
 	int mask = 0;
-	const int *tab16, *coef;
+	const int *tab16;
+#if HELIX_DQ_KERNELS
+	int sx1, y1;
+#endif
 
 	tab16 = pow43_14[scale & 0x3];
 	scalef = pow14[scale & 0x3];
@@ -149,74 +240,47 @@ static int DequantBlock(int *inbuf, int *outbuf, int num, int scale)
 	tab4[2] = tab16[2] >> shift;
 	tab4[3] = tab16[3] >> shift;
 
-	do {
-
-		sx = *inbuf++;
-		x = sx & 0x7fffffff;	/* sx = sign|mag */
-
-		if (x < 4) {
-
-			y = tab4[x];
-
-		} else if (x < 16) {
+#if HELIX_DQ_KERNELS
+	/* scale factor band widths are even, the single step below only guards odd num */
+	for ( ; num > 1; num -= 2) {
+		sx =  inbuf[0];
+		sx1 = inbuf[1];
+		inbuf += 2;
+
+		if ((sx | sx1) == 0) {
+			outbuf[0] = 0;
+			outbuf[1] = 0;
+			outbuf += 2;
+			continue;
+		}
 
-			y = tab16[x];
-			y = (scalei < 0) ? y << -scalei : y >> scalei;
+		y =  DequantSample(sx  & 0x7fffffff, tab4, tab16, scalef, scalei);	/* sx = sign|mag */
+		y1 = DequantSample(sx1 & 0x7fffffff, tab4, tab16, scalef, scalei);
 
-		} else {
+		/* sign and store */
+		mask |= y | y1;
+		outbuf[0] = (sx  < 0) ? -y  : y;
+		outbuf[1] = (sx1 < 0) ? -y1 : y1;
+		outbuf += 2;
+	}
+	if (num) {
+		sx = *inbuf;
+		y = DequantSample(sx & 0x7fffffff, tab4, tab16, scalef, scalei);
+		mask |= y;
+		*outbuf = (sx < 0) ? -y : y;
+	}
+#else
+	do {
 
-			if (x < 64) {
-
-				y = pow43[x-16];
-
-				/* fractional scale */
-				y = MULSHIFT32(y, scalef);
-				shift = scalei - 3;
-
-			} else {
-
-				/* normalize to [0x40000000, 0x7fffffff] */
-				x <<= 17;
-				shift = 0;
-				if (x < 0x08000000)
-					x <<= 4, shift += 4;
-				if (x < 0x20000000)
-					x <<= 2, shift += 2;
-				if (x < 0x40000000)
-					x <<= 1, shift += 1;
-
-				coef = (x < SQRTHALF) ? poly43lo : poly43hi;
-
-				/* polynomial */
-				y = coef[0];
-				y = MULSHIFT32(y, x) + coef[1];
-				y = MULSHIFT32(y, x) + coef[2];
-				y = MULSHIFT32(y, x) + coef[3];
-				y = MULSHIFT32(y, x) + coef[4];
-				y = MULSHIFT32(y, pow2frac[shift]) << 3;
-
-				/* fractional scale */
-				y = MULSHIFT32(y, scalef);
-				shift = scalei - pow2exp[shift];
-			}
-
-			/* integer scale */
-			if (shift < 0) {
-				shift = -shift;
-				if (y > (0x7fffffff >> shift))
-					y = 0x7fffffff;		/* clip */
-				else
-					y <<= shift;
-			} else {
-				y >>= shift;
-			}
-		}
+		sx = *inbuf++;
+		y = DequantSample(sx & 0x7fffffff, tab4, tab16, scalef, scalei);	/* sx = sign|mag */
 
 		/* sign and store */
 		mask |= y;
 		*outbuf++ = (sx < 0) ? -y : y;
 
 	} while (--num);
+#endif
 
 	return mask;
 }
@@ -241,8 +305,8 @@ static int DequantBlock(int *inbuf, int *outbuf, int num, int scale)
  *
  * Notes:       dequantized samples in Q(DQ_FRACBITS_OUT) format 
  **************************************************************************************/
-int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound, FrameHeader *fh, SideInfoSub *sis, 
-					ScaleFactorInfoSub *sfis, CriticalBandInfo *cbi)
+HELIX_FAST_CODE(int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound, FrameHeader *fh, SideInfoSub *sis, 
+					ScaleFactorInfoSub *sfis, CriticalBandInfo *cbi))
 {
 	int i, j, w, cb;
 	int /*cbStartL,*/ cbEndL, cbStartS, cbEndS;
@@ -250,6 +314,9 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound, FrameHeader
 	int globalGain, gainI;
 	int cbMax[3];
 	ARRAY3 *buf;    /* short block reorder */
+#if HELIX_DQ_KERNELS
+	int n;
+#endif
 	
 	/* set default start/end points for short/long blocks - will update with non-zero cb info */
 	if (sis->blockType == 2) {
@@ -295,7 +362,12 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound, FrameHeader
 		nSamps = fh->sfBand->l[cb + 1] - fh->sfBand->l[cb];
 		gainI = 210 - globalGain + sfactMultiplier * (sfis->l[cb] + (sis->preFlag ? (int)preTab[cb] : 0));
 
+#if HELIX_DQ_KERNELS
+		/* in place, and everything from nonZeroBound up is already 0 */
+		nonZero |= DequantBlock(sampleBuf + i, sampleBuf + i, MIN(nSamps, *nonZeroBound - i), gainI);
+#else
 		nonZero |= DequantBlock(sampleBuf + i, sampleBuf + i, nSamps, gainI);
+#endif
 		i += nSamps;
 
 		/* update highest non-zero critical band */
@@ -326,7 +398,18 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound, FrameHeader
 			nonZero =  0;
 			gainI = 210 - globalGain + 8*sis->subBlockGain[w] + sfactMultiplier*(sfis->s[cb][w]);
 
+#if HELIX_DQ_KERNELS
+			/* windows starting at or above nonZeroBound only need their zeros copied */
+			n = MIN(nSamps, *nonZeroBound - (i + nSamps*w));
+			if (n > 0)
+				nonZero |= DequantBlock(sampleBuf + i + nSamps*w, workBuf + nSamps*w, n, gainI);
+			else
+				n = 0;
+			for (j = n; j < nSamps; j++)
+				workBuf[nSamps*w + j] = 0;
+#else
 			nonZero |= DequantBlock(sampleBuf + i + nSamps*w, workBuf + nSamps*w, nSamps, gainI);
+#endif
 
 			/* update highest non-zero critical band */
 			if (nonZero)
@@ -373,3 +456,4 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound, FrameHeader
 	return CLZ(gbMask) - 1;
 }
 
+#endif	/* !HELIX_FLOAT_DSP */
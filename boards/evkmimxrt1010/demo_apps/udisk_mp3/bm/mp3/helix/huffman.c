@@ -59,6 +59,128 @@
 /* apply sign of s to the positive number x (save in MSB, will do two's complement in dequant) */
 #define ApplySign(x, s)	{ (x) |= ((s) & 0x80000000); }
 
+#if HELIX_HUFF_FAST_BITS
+
+#if HELIX_HUFF_FAST_BITS < 7 || HELIX_HUFF_FAST_BITS > 12
+#error HELIX_HUFF_FAST_BITS must be 0 or 7 to 12
+#endif
+
+/* pair tables which chain subtables (16-23 share codewords with 16, 24-31 with 24),
+ *   with the longest codeword in each
+ * only tables whose first level is narrower than HELIX_HUFF_FAST_BITS get a wide table
+ *   (HUFF_FAST_ENTRIES adds these up at compile time, keep the numbers in step)
+ */
+#define HUFF_FAST_NTABS		10
+#define FAST_WIDTH(f, m)	(HELIX_HUFF_FAST_BITS < (m) ? HELIX_HUFF_FAST_BITS : (m))
+#define FAST_SIZE(f, m)		(FAST_WIDTH(f, m) > (f) ? 1 << FAST_WIDTH(f, m) : 0)
+#define HUFF_FAST_ENTRIES	(FAST_SIZE(6, 10) + FAST_SIZE(8, 11) + FAST_SIZE(6,  9) + FAST_SIZE(8, 11) + FAST_SIZE(8, 11) + \
+							 FAST_SIZE(7, 10) + FAST_SIZE(6, 19) + FAST_SIZE(8, 13) + FAST_SIZE(8, 17) + FAST_SIZE(9, 12))
+
+static const unsigned char fastTabIdx[HUFF_FAST_NTABS] =    { 7,  8, 9, 10, 11, 12, 13, 15, 16, 24};
+static const unsigned char fastTabMaxLen[HUFF_FAST_NTABS] = {10, 11, 9, 11, 11, 10, 19, 13, 17, 12};
+
+/* wide first-level tables, built once by InitHuffmanFastTables and shared by all decoders */
+HELIX_FAST_DATA(static unsigned short huffFastTable[HUFF_FAST_ENTRIES]);
+HELIX_FAST_DATA(static short huffFastOffset[HUFF_PAIRTABS]);
+HELIX_FAST_DATA(static unsigned char huffFastBits[HUFF_PAIRTABS]);
+static int huffFastReady;
+
+/* top up the left-justified cache to at least 25 bits, or to the last bit of the block
+ *   (bits past cachedBits are always 0, so lookups at the end see zero padding)
+ */
+#define RefillCache() { \
+	while (cachedBits <= 24 && bitsLeft > 0) { \
+		cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits); \
+		cachedBits += 8; \
+		bitsLeft -= 8; \
+	} \
+	if (bitsLeft < 0) { \
+		cachedBits += bitsLeft; \
+		bitsLeft = 0; \
+		cache &= (signed int)0x80000000 >> (cachedBits - 1); \
+	} \
+}
+
+/**************************************************************************************
+ * Function:    InitHuffmanFastTables
+ *
+ * Description: expand the first HELIX_HUFF_FAST_BITS bits of the chained pair tables
+ *                into single lookup tables
+ *
+ * Inputs:      none
+ *
+ * Outputs:     filled huffFastTable, with its offset and width per table index
+ *
+ * Return:      none
+ *
+ * Notes:       only builds the tables the first time it is called
+ *              format 0xABCD
+ *                A = total length of codeword, B = y value, C = x value
+ *              if A = 0 the codeword is longer than the wide table, and the entry is
+ *                the first level entry of huffTable for the same bits (offset of the
+ *                second level subtable where decoding continues)
+ **************************************************************************************/
+void InitHuffmanFastTables(void)
+{
+	int i, n, t, tabIdx, fastBits, firstBits, maxBits, used, total;
+	const unsigned short *tBase, *tCurr;
+	unsigned short cw, *tFast;
+
+	if (huffFastReady)
+		return;
+
+	for (t = 0; t < HUFF_PAIRTABS; t++)
+		huffFastOffset[t] = -1;
+
+	total = 0;
+	for (n = 0; n < HUFF_FAST_NTABS; n++) {
+		tabIdx = fastTabIdx[n];
+		tBase = huffTable + huffTabOffset[tabIdx];
+		fastBits = MIN(HELIX_HUFF_FAST_BITS, fastTabMaxLen[n]);
+		firstBits = GetMaxbits(tBase[0]);
+		if (fastBits <= firstBits)
+			continue;
+
+		ASSERT(total + (1 << fastBits) <= HUFF_FAST_ENTRIES);
+		tFast = huffFastTable + total;
+		for (i = 0; i < (1 << fastBits); i++) {
+			/* walk the chained tables as far as the first fastBits bits of i reach */
+			tCurr = tBase;
+			used = 0;
+			for (;;) {
+				maxBits = GetMaxbits(tCurr[0]);
+				if (used + maxBits > fastBits) {
+					cw = tBase[(i >> (fastBits - firstBits)) + 1];
+					break;
+				}
+				cw = tCurr[((i >> (fastBits - used - maxBits)) & ((1 << maxBits) - 1)) + 1];
+				if (GetHLen(cw)) {
+					cw = (unsigned short)(((used + GetHLen(cw)) << 12) | (cw & 0x0fff));
+					break;
+				}
+				used += maxBits;
+				tCurr += cw;
+			}
+			tFast[i] = cw;
+		}
+
+		for (t = 0; t < HUFF_PAIRTABS; t++) {
+			if (huffTabOffset[t] == huffTabOffset[tabIdx] &&
+				(huffTabLookup[t].tabType == loopLinbits || huffTabLookup[t].tabType == loopNoLinbits)) {
+				huffFastOffset[t] = (short)total;
+				huffFastBits[t] = (unsigned char)fastBits;
+			}
+		}
+		total += (1 << fastBits);
+	}
+
+	huffFastReady = 1;
+}
+
+#endif	/* HELIX_HUFF_FAST_BITS */
+
+#if !HELIX_HUFF_FAST_BITS
+
 /**************************************************************************************
  * Function:    DecodeHuffmanPairs
  *
@@ -69,6 +191,8 @@
  *              number of codewords to decode
  *              index of Huffman table to use
  *              number of bits remaining in bitstream
+ *              cursor pointing to the first byte of the codes (not advanced)
+ *              bit offset (0-7) of the first code bit in that byte
  *
  * Outputs:     pairs of decoded coefficients in vwxy
  *              updated BitStreamInfo struct
@@ -79,8 +203,9 @@
  *              si_huff.bit tests every Huffman codeword in every table (though not
  *                necessarily all linBits outputs for x,y > 15)
  **************************************************************************************/
-static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset)
+HELIX_FAST_CODE(static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, const MainDataCursor *cursor, int bitOffset))
 {
+	MainDataCursor mc = *cursor;
 	int i, x, y;
 	int cachedBits, padBits, len, startBits, linBits, maxBits, minBits;
 	HuffTabType tabType;
@@ -107,7 +232,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 	cache = 0;
 	cachedBits = (8 - bitOffset) & 0x07;
 	if (cachedBits)
-		cache = (unsigned int)(*buf++) << (32 - cachedBits);
+		cache = (unsigned int)GetMainDataByte(&mc) << (32 - cachedBits);
 	bitsLeft -= cachedBits;
 
 	if (tabType == noBits) {
@@ -126,15 +251,15 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 			/* refill cache - assumes cachedBits <= 16 */
 			if (bitsLeft >= 16) {
 				/* load 2 new bytes into left-justified cache */
-				cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
+				cache |= (unsigned int)GetMainDataByte(&mc) << (16 - cachedBits);
 				cachedBits += 16;
 				bitsLeft -= 16;
 			} else {
 				/* last time through, pad cache with zeros and drain cache */
 				if (cachedBits + bitsLeft <= 0)	return -1;
-				if (bitsLeft > 0)	cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				if (bitsLeft > 8)	cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				if (bitsLeft > 0)	cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
+				if (bitsLeft > 8)	cache |= (unsigned int)GetMainDataByte(&mc) << (16 - cachedBits);
 				cachedBits += bitsLeft;
 				bitsLeft = 0;
 
@@ -171,15 +296,15 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 			/* refill cache - assumes cachedBits <= 16 */
 			if (bitsLeft >= 16) {
 				/* load 2 new bytes into left-justified cache */
-				cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
+				cache |= (unsigned int)GetMainDataByte(&mc) << (16 - cachedBits);
 				cachedBits += 16;
 				bitsLeft -= 16;
 			} else {
 				/* last time through, pad cache with zeros and drain cache */
 				if (cachedBits + bitsLeft <= 0)	return -1;
-				if (bitsLeft > 0)	cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-				if (bitsLeft > 8)	cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+				if (bitsLeft > 0)	cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
+				if (bitsLeft > 8)	cache |= (unsigned int)GetMainDataByte(&mc) << (16 - cachedBits);
 				cachedBits += bitsLeft;
 				bitsLeft = 0;
 
@@ -210,7 +335,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 					if (cachedBits + bitsLeft < minBits)
 						return -1;
 					while (cachedBits < minBits) {
-						cache |= (unsigned int)(*buf++) << (24 - cachedBits);
+						cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
 						cachedBits += 8;
 						bitsLeft -= 8;
 					}
@@ -230,7 +355,7 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
 					if (cachedBits + bitsLeft < minBits)
 						return -1;
 					while (cachedBits < minBits) {
-						cache |= (unsigned int)(*buf++) << (24 - cachedBits);
+						cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
 						cachedBits += 8;
 						bitsLeft -= 8;
 					}
@@ -273,6 +398,8 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
  *              maximum number of codewords to decode
  *              index of quadword table (0 = table A, 1 = table B)
  *              number of bits remaining in bitstream
+ *              cursor pointing to the first byte of the codes (not advanced)
+ *              bit offset (0-7) of the first code bit in that byte
  *
  * Outputs:     quadruples of decoded coefficients in vwxy
  *              updated BitStreamInfo struct
@@ -282,8 +409,9 @@ static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsi
  * 
  * Notes:        si_huff.bit tests every vwxy output in both quad tables
  **************************************************************************************/
-static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset)
+HELIX_FAST_CODE(static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, const MainDataCursor *cursor, int bitOffset))
 {
+	MainDataCursor mc = *cursor;
 	int i, v, w, x, y;
 	int len, maxBits, cachedBits, padBits;
 	unsigned int cache;
@@ -299,7 +427,7 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
 	cache = 0;
 	cachedBits = (8 - bitOffset) & 0x07;
 	if (cachedBits)
-		cache = (unsigned int)(*buf++) << (32 - cachedBits);
+		cache = (unsigned int)GetMainDataByte(&mc) << (32 - cachedBits);
 	bitsLeft -= cachedBits;
 
 	i = padBits = 0;
@@ -307,15 +435,15 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
 		/* refill cache - assumes cachedBits <= 16 */
 		if (bitsLeft >= 16) {
 			/* load 2 new bytes into left-justified cache */
-			cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-			cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+			cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
+			cache |= (unsigned int)GetMainDataByte(&mc) << (16 - cachedBits);
 			cachedBits += 16;
 			bitsLeft -= 16;
 		} else {
 			/* last time through, pad cache with zeros and drain cache */
 			if (cachedBits + bitsLeft <= 0) return i;
-			if (bitsLeft > 0)	cache |= (unsigned int)(*buf++) << (24 - cachedBits);
-			if (bitsLeft > 8)	cache |= (unsigned int)(*buf++) << (16 - cachedBits);
+			if (bitsLeft > 0)	cache |= (unsigned int)GetMainDataByte(&mc) << (24 - cachedBits);
+			if (bitsLeft > 8)	cache |= (unsigned int)GetMainDataByte(&mc) << (16 - cachedBits);
 			cachedBits += bitsLeft;
 			bitsLeft = 0;
 
@@ -352,6 +480,218 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
 	return i;
 }
 
+#else	/* HELIX_HUFF_FAST_BITS */
+
+/**************************************************************************************
+ * Function:    DecodeHuffmanPairs
+ *
+ * Description: decode 2-way vector Huffman codes in the "bigValues" region of spectrum,
+ *                wide table version
+ *
+ * Inputs:      pointer to xy buffer to received decoded values
+ *              number of codewords to decode
+ *              index of Huffman table to use
+ *              number of bits remaining in bitstream
+ *              cursor pointing to the first byte of the codes (not advanced)
+ *              bit offset (0-7) of the first code bit in that byte
+ *
+ * Outputs:     pairs of decoded coefficients in xy
+ *
+ * Return:      number of bits used, or -1 if out of bits
+ *
+ * Notes:       assumes that nVals is an even number
+ *              the cache is topped up once per codeword, which covers the longest
+ *                codeword (19 bits) plus both sign bits, and again before each linbits
+ *                escape (13 bits plus sign)
+ *              codewords up to huffFastBits[tabIdx] bits long take one lookup, longer
+ *                ones finish in the chained subtables of huffTable from the second level
+ **************************************************************************************/
+HELIX_FAST_CODE(static int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, const MainDataCursor *cursor, int bitOffset))
+{
+	MainDataCursor mc = *cursor;
+	int i, x, y;
+	int cachedBits, len, startBits, linBits, maxBits, fastBits, firstBits;
+	HuffTabType tabType;
+	const unsigned short *tBase, *tCurr, *tFast;
+	unsigned short cw;
+	unsigned int cache;
+
+	if(nVals <= 0) 
+		return 0;
+
+	if (bitsLeft < 0)
+		return -1;
+	startBits = bitsLeft;
+
+	tBase = huffTable + huffTabOffset[tabIdx];
+	linBits = huffTabLookup[tabIdx].linBits;
+	tabType = huffTabLookup[tabIdx].tabType;
+
+	ASSERT(!(nVals & 0x01));
+	ASSERT(tabIdx < HUFF_PAIRTABS);
+	ASSERT(tabIdx >= 0);
+	ASSERT(tabType != invalidTab);
+
+	if (tabType == noBits) {
+		/* table 0, no data, x = y = 0 */
+		for (i = 0; i < nVals; i+=2) {
+			xy[i+0] = 0;
+			xy[i+1] = 0;
+		}
+		return 0;
+	} else if (tabType == invalidTab) {
+		/* error in bitstream - trying to access unused Huffman table */
+		return -1;
+	}
+
+	tFast = 0;
+	fastBits = huffFastBits[tabIdx];
+	firstBits = GetMaxbits(tBase[0]);
+	if (huffFastOffset[tabIdx] >= 0)
+		tFast = huffFastTable + huffFastOffset[tabIdx];
+
+	/* initially fill cache with any partial byte */
+	cache = 0;
+	cachedBits = (8 - bitOffset) & 0x07;
+	if (cachedBits)
+		cache = (unsigned int)GetMainDataByte(&mc) << (32 - cachedBits);
+	bitsLeft -= cachedBits;
+
+	/* oneShot tables are chained tables with a single level, so one loop serves all types */
+	while (nVals > 0) {
+		RefillCache();
+
+		tCurr = tBase;
+		len = 0;
+		if (tFast) {
+			cw = tFast[cache >> (32 - fastBits)];
+			len = GetHLen(cw);
+			if (!len) {
+				/* longer codeword, continue in the second level of huffTable */
+				cachedBits -= firstBits;
+				cache <<= firstBits;
+				tCurr = tBase + cw;
+			}
+		}
+		while (!len) {
+			maxBits = GetMaxbits(tCurr[0]);
+			cw = tCurr[(cache >> (32 - maxBits)) + 1];
+			len = GetHLen(cw);
+			if (!len) {
+				cachedBits -= maxBits;
+				cache <<= maxBits;
+				tCurr += cw;
+			}
+		}
+		cachedBits -= len;
+		cache <<= len;
+
+		x = GetCWX(cw);
+		y = GetCWY(cw);
+
+		if (x == 15 && tabType == loopLinbits) {
+			RefillCache();
+			x += (int)(cache >> (32 - linBits));
+			cachedBits -= linBits;
+			cache <<= linBits;
+		}
+		if (x)	{ApplySign(x, cache); cache <<= 1; cachedBits--;}
+
+		if (y == 15 && tabType == loopLinbits) {
+			RefillCache();
+			y += (int)(cache >> (32 - linBits));
+			cachedBits -= linBits;
+			cache <<= linBits;
+		}
+		if (y)	{ApplySign(y, cache); cache <<= 1; cachedBits--;}
+
+		/* ran out of bits - codeword ran into the zero padding */
+		if (cachedBits < 0)
+			return -1;
+
+		*xy++ = x;
+		*xy++ = y;
+		nVals -= 2;
+	}
+
+	return (startBits - bitsLeft - cachedBits);
+}
+
+/**************************************************************************************
+ * Function:    DecodeHuffmanQuads
+ *
+ * Description: decode 4-way vector Huffman codes in the "count1" region of spectrum,
+ *                wide table version
+ *
+ * Inputs:      pointer to vwxy buffer to received decoded values
+ *              maximum number of codewords to decode
+ *              index of quadword table (0 = table A, 1 = table B)
+ *              number of bits remaining in bitstream
+ *              cursor pointing to the first byte of the codes (not advanced)
+ *              bit offset (0-7) of the first code bit in that byte
+ *
+ * Outputs:     quadruples of decoded coefficients in vwxy
+ *
+ * Return:      index of the first "zero_part" value (index of the first sample 
+ *                of the quad word after which all samples are 0)
+ * 
+ * Notes:       quad tables are at most 6 bits wide already, this version only shares
+ *                the full word cache of DecodeHuffmanPairs
+ **************************************************************************************/
+HELIX_FAST_CODE(static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, const MainDataCursor *cursor, int bitOffset))
+{
+	MainDataCursor mc = *cursor;
+	int i, v, w, x, y;
+	int len, maxBits, cachedBits;
+	unsigned int cache;
+	const unsigned char *tBase;
+	unsigned char cw;
+
+	if (bitsLeft <= 0)
+		return 0;
+
+	tBase = quadTable + quadTabOffset[tabIdx];
+	maxBits = quadTabMaxBits[tabIdx];
+
+	/* initially fill cache with any partial byte */
+	cache = 0;
+	cachedBits = (8 - bitOffset) & 0x07;
+	if (cachedBits)
+		cache = (unsigned int)GetMainDataByte(&mc) << (32 - cachedBits);
+	bitsLeft -= cachedBits;
+
+	i = 0;
+	while (i < (nVals - 3)) {
+		/* largest maxBits = 6, plus 4 for sign bits */
+		RefillCache();
+
+		cw = tBase[cache >> (32 - maxBits)];
+		len = GetHLenQ(cw);
+		cachedBits -= len;
+		cache <<= len;
+
+		v = GetCWVQ(cw);	if(v) {ApplySign(v, cache); cache <<= 1; cachedBits--;}
+		w = GetCWWQ(cw);	if(w) {ApplySign(w, cache); cache <<= 1; cachedBits--;}
+		x = GetCWXQ(cw);	if(x) {ApplySign(x, cache); cache <<= 1; cachedBits--;}
+		y = GetCWYQ(cw);	if(y) {ApplySign(y, cache); cache <<= 1; cachedBits--;}
+
+		/* ran out of bits - okay (means we're done) */
+		if (cachedBits < 0)
+			return i;
+
+		*vwxy++ = v;
+		*vwxy++ = w;
+		*vwxy++ = x;
+		*vwxy++ = y;
+		i += 4;
+	}
+
+	/* decoded max number of quad values */
+	return i;
+}
+
+#endif	/* HELIX_HUFF_FAST_BITS */
+
 /**************************************************************************************
  * Function:    DecodeHuffman
  *
@@ -359,8 +699,8 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
  *
  * Inputs:      MP3DecInfo structure filled by UnpackFrameHeader(), UnpackSideInfo(),
  *                and UnpackScaleFactors() (for this granule)
- *              buffer pointing to start of Huffman data in MP3 frame
- *              pointer to bit offset (0-7) indicating starting bit in buf[0]
+ *              cursor pointing to start of Huffman data in MP3 frame (not advanced)
+ *              pointer to bit offset (0-7) indicating starting bit in the first byte
  *              number of bits in the Huffman data section of the frame
  *                (could include padding bits)
  *              index of current granule and channel
@@ -370,15 +710,15 @@ static int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, un
  *
  * Return:      length (in bytes) of Huffman codes
  *              bitOffset also returned in parameter (0 = MSB, 7 = LSB of 
- *                byte located at buf + offset)
+ *                byte located offset bytes past the cursor)
  *              -1 if null input pointers, huffBlockBits < 0, or decoder runs 
  *                out of bits prematurely (invalid bitstream)
  **************************************************************************************/
-int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int huffBlockBits, int gr, int ch)
+HELIX_FAST_CODE(int DecodeHuffman(MP3DecInfo *mp3DecInfo, const MainDataCursor *mc, int *bitOffset, int huffBlockBits, int gr, int ch))
 {
 	int r1Start, r2Start, rEnd[4];	/* region boundaries */
-	int i, w, bitsUsed, bitsLeft;
-	unsigned char *startBuf = buf;
+	int i, w, bitsUsed, bitsLeft, nBytes;
+	MainDataCursor cursor = *mc;
 
 	FrameHeader *fh;
 	SideInfo *si;
@@ -429,19 +769,21 @@ int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, in
 
 	/* decode Huffman pairs (rEnd[i] are always even numbers) */
 	bitsLeft = huffBlockBits;
+	nBytes = 0;
 	for (i = 0; i < 3; i++) {
-		bitsUsed = DecodeHuffmanPairs(hi->huffDecBuf[ch] + rEnd[i], rEnd[i+1] - rEnd[i], sis->tableSelect[i], bitsLeft, buf, *bitOffset);
+		bitsUsed = DecodeHuffmanPairs(hi->huffDecBuf[ch] + rEnd[i], rEnd[i+1] - rEnd[i], sis->tableSelect[i], bitsLeft, &cursor, *bitOffset);
 		if (bitsUsed < 0 || bitsUsed > bitsLeft)	/* error - overran end of bitstream */
 			return -1;
 
 		/* update bitstream position */
-		buf += (bitsUsed + *bitOffset) >> 3;
+		SkipMainData(&cursor, (bitsUsed + *bitOffset) >> 3);
+		nBytes += (bitsUsed + *bitOffset) >> 3;
 		*bitOffset = (bitsUsed + *bitOffset) & 0x07;
 		bitsLeft -= bitsUsed;
 	}
 
 	/* decode Huffman quads (if any) */
-	hi->nonZeroBound[ch] += DecodeHuffmanQuads(hi->huffDecBuf[ch] + rEnd[3], MAX_NSAMP - rEnd[3], sis->count1TableSelect, bitsLeft, buf, *bitOffset);
+	hi->nonZeroBound[ch] += DecodeHuffmanQuads(hi->huffDecBuf[ch] + rEnd[3], MAX_NSAMP - rEnd[3], sis->count1TableSelect, bitsLeft, &cursor, *bitOffset);
 
 	ASSERT(hi->nonZeroBound[ch] <= MAX_NSAMP);
 	for (i = hi->nonZeroBound[ch]; i < MAX_NSAMP; i++)
@@ -450,9 +792,9 @@ int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, in
 	/* If bits used for 576 samples < huffBlockBits, then the extras are considered
 	 *  to be stuffing bits (throw away, but need to return correct bitstream position) 
 	 */
-	buf += (bitsLeft + *bitOffset) >> 3;
+	nBytes += (bitsLeft + *bitOffset) >> 3;
 	*bitOffset = (bitsLeft + *bitOffset) & 0x07;
 	
-	return (buf - startBuf);
+	return nBytes;
 }
 
@@ -40,11 +40,15 @@
  *
  * imdct.c - antialias, inverse transform (short/long/mixed), windowing, 
  *             overlap-add, frequency inversion
+ *
+ * Not built with HELIX_FLOAT_DSP, imdctf.c takes its place
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if !HELIX_FLOAT_DSP
+
 /**************************************************************************************
  * Function:    AntiAlias
  *
@@ -69,7 +73,7 @@
  *                (should be guaranteed from dequant, and max gain from stproc * max 
  *                 gain from AntiAlias < 2.0)
  **************************************************************************************/
-static void AntiAlias(int *x, int nBfly)
+HELIX_FAST_CODE(static void AntiAlias(int *x, int nBfly))
 {
 	int k, a0, b0, c0, c1;
 	const int *c;
@@ -129,7 +133,7 @@ static void AntiAlias(int *x, int nBfly)
  *              all blocks gain at least 1 guard bit via window (long blocks get extra
  *                sign bit, short blocks can have one addition but max gain < 1.0)
  **************************************************************************************/
-static void WinPrevious(int *xPrev, int *xPrevWin, int btPrev)
+HELIX_FAST_CODE(static void WinPrevious(int *xPrev, int *xPrevWin, int btPrev))
 {
 	int i, x, *xp, *xpwLo, *xpwHi, wLo, wHi;
 	const int *wpLo, *wpHi;
@@ -182,7 +186,7 @@ static void WinPrevious(int *xPrev, int *xPrevWin, int btPrev)
  *
  * Return:      updated mOut (from new outputs y)
  **************************************************************************************/
-static int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es)
+HELIX_FAST_CODE(static int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es))
 {
 	int i, d, mOut;
 	int y0, y1, y2, y3, y4, y5, y6, y7, y8;
@@ -252,7 +256,7 @@ static const int c9_4 = 0x7e0e2e32;
 /* format = Q31
  * cos(((0:8) + 0.5) * (pi/18)) 
  */
-static const int c18[9] = {
+HELIX_FAST_DATA(static const int c18[9]) = {
 	0x7f834ed0, 0x7ba3751d, 0x7401e4c1, 0x68d9f964, 0x5a82799a, 0x496af3e2, 0x36185aee, 0x2120fb83, 0x0b27eb5c, 
 };
 
@@ -327,7 +331,7 @@ static __inline void idct9(int *x)
  *      fastWin[2*j+1] = c(j)*(s(j) - c(j))
  * format = Q30
  */
-static const int fastWin36[18] = {
+HELIX_FAST_DATA(static const int fastWin36[18]) = {
 	0x42aace8b, 0xc2e92724, 0x47311c28, 0xc95f619a, 0x4a868feb, 0xd0859d8c,
 	0x4c913b51, 0xd8243ea0, 0x4d413ccc, 0xe0000000, 0x4c913b51, 0xe7dbc161,
 	0x4a868feb, 0xef7a6275, 0x47311c28, 0xf6a09e67, 0x42aace8b, 0xfd16d8dd,
@@ -365,7 +369,7 @@ static const int fastWin36[18] = {
  * TODO:        optimize for ARM (reorder window coefs, ARM-style pointers in C, 
  *                inline asm may or may not be helpful)
  **************************************************************************************/
-static int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb)
+HELIX_FAST_CODE(static int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb))
 {
 	int i, es, xBuf[18], xPrevWin[18];
 	int acc1, acc2, s, d, t, mOut;
@@ -463,7 +467,7 @@ static int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int b
 }
 
 static const int c3_0 = 0x6ed9eba1;	/* format = Q31, cos(pi/6) */
-static const int c6[3] = { 0x7ba3751d, 0x5a82799a, 0x2120fb83 };	/* format = Q31, cos(((0:2) + 0.5) * (pi/6)) */
+HELIX_FAST_DATA(static const int c6[3]) = { 0x7ba3751d, 0x5a82799a, 0x2120fb83 };	/* format = Q31, cos(((0:2) + 0.5) * (pi/6)) */
 
 /* 12-point inverse DCT, used in IMDCT12x3() 
  * 4 input guard bits will ensure no overflow
@@ -533,7 +537,7 @@ static __inline void imdct12 (int *x, int *out)
  *
  * TODO:        optimize for ARM
  **************************************************************************************/
-static int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, int gb)
+HELIX_FAST_CODE(static int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, int gb))
 {
 	int i, es, mOut, yLo, xBuf[18], xPrevWin[18];	/* need temp buffer for reordering short blocks */
 	const int *wp;
@@ -615,7 +619,7 @@ static int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, i
  *
  * TODO:        examine mixedBlock/winSwitch logic carefully (test he_mode.bit)
  **************************************************************************************/
-static int HybridTransform(int *xCurr, int *xPrev, int y[BLOCK_SIZE][NBANDS], SideInfoSub *sis, BlockCount *bc)
+HELIX_FAST_CODE(static int HybridTransform(int *xCurr, int *xPrev, int y[BLOCK_SIZE][NBANDS], SideInfoSub *sis, BlockCount *bc))
 {
 	int xPrevWin[18], currWinIdx, prevWinIdx;
 	int i, j, nBlocksOut, nonZero, mOut;
@@ -714,7 +718,7 @@ static int HybridTransform(int *xCurr, int *xPrev, int y[BLOCK_SIZE][NBANDS], Si
  *
  * Return:      0 on success,  -1 if null input pointers
  **************************************************************************************/
-int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch)
+HELIX_FAST_CODE(int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch))
 {
 	int nBfly, blockCutoff;
 	FrameHeader *fh;
@@ -777,3 +781,5 @@ int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch)
 	/* output has gained 2 int bits */
 	return 0;
 }
+
+#endif	/* !HELIX_FLOAT_DSP */
@@ -0,0 +1,655 @@
+/* ***** BEGIN LICENSE BLOCK ***** 
+ * Version: RCSL 1.0/RPSL 1.0 
+ *  
+ * Portions Copyright (c) 1995-2002 RealNetworks, Inc. All Rights Reserved. 
+ *      
+ * The contents of this file, and the files included with this file, are 
+ * subject to the current version of the RealNetworks Public Source License 
+ * Version 1.0 (the "RPSL") available at 
+ * http://www.helixcommunity.org/content/rpsl unless you have licensed 
+ * the file under the RealNetworks Community Source License Version 1.0 
+ * (the "RCSL") available at http://www.helixcommunity.org/content/rcsl, 
+ * in which case the RCSL will apply. You may also obtain the license terms 
+ * directly from RealNetworks.  You may not use this file except in 
+ * compliance with the RPSL or, if you have a valid RCSL with RealNetworks 
+ * applicable to this file, the RCSL.  Please see the applicable RPSL or 
+ * RCSL for the rights, obligations and limitations governing use of the 
+ * contents of the file.  
+ *  
+ * This file is part of the Helix DNA Technology. RealNetworks is the 
+ * developer of the Original Code and owns the copyrights in the portions 
+ * it created. 
+ *  
+ * This file, and the files included with this file, is distributed and made 
+ * available on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER 
+ * EXPRESS OR IMPLIED, AND REALNETWORKS HEREBY DISCLAIMS ALL SUCH WARRANTIES, 
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT. 
+ * 
+ * Technology Compatibility Kit Test Suite(s) Location: 
+ *    http://www.helixcommunity.org/content/tck 
+ * 
+ * Contributor(s): 
+ *  
+ * ***** END LICENSE BLOCK ***** */ 
+
+
+/**************************************************************************************
+ * Floating-point back end for the fixed-point MP3 decoder
+ *
+ * imdctf.c - antialias, inverse transform (short/long/mixed), windowing, 
+ *             overlap-add, frequency inversion in single precision
+ *
+ * Built only with HELIX_FLOAT_DSP, in place of imdct.c
+ * Same algorithm as imdct.c (Ken's fast IMDCT36, three 12-point IMDCTs for short blocks),
+ *   the constants keep the scaling of the Q-format tables so the output still matches
+ *   the fixed-point IMDCT times 2^-8
+ **************************************************************************************/
+
+#include "coder.h"
+#include "assembly.h"
+
+#if HELIX_FLOAT_DSP
+
+/* csa[i][0] = CSi, csa[i][1] = CAi (see trigtabs.c) */
+HELIX_FAST_DATA(static const float csaF[8][2]) = {
+	{0.857492924f, -0.51449573f},
+	{0.881742001f, -0.471731961f},
+	{0.949628651f, -0.31337744f},
+	{0.983314574f, -0.181913197f},
+	{0.99551779f, -0.0945741907f},
+	{0.999160588f, -0.0409655832f},
+	{0.999899209f, -0.0141985686f},
+	{0.999993145f, -0.00369997462f},
+};
+
+/* imdctWin (trigtabs.c) / 2^30, the window with the << 2 of the fixed-point overlap-add 
+ *   folded in
+ */
+HELIX_FAST_DATA(static const float imdctWinF[4][36]) = {
+	{
+	0.0416752212f, 0.112372436f, 0.164463028f, 0.196364239f, 0.207106784f, 0.196364239f,
+	0.164463028f, 0.112372436f, 0.0416752212f, -0.0454805233f, -0.146446615f, -0.258155227f,
+	-0.377212197f, -0.5f, -0.622787833f, -0.741844773f, -0.853553414f, -0.954519451f,
+	-1.04167521f, -1.1123724f, -1.16446304f, -1.19636428f, -1.20710683f, -1.19636428f,
+	-1.16446304f, -1.1123724f, -1.04167521f, -0.954519451f, -0.853553414f, -0.741844773f,
+	-0.622787833f, -0.5f, -0.377212197f, -0.258155227f, -0.146446615f, -0.0454805233f,
+	},
+	{
+	0.0416752212f, 0.112372436f, 0.164463028f, 0.196364239f, 0.207106784f, 0.196364239f,
+	0.164463028f, 0.112372436f, 0.0416752212f, -0.0454805233f, -0.146446615f, -0.258155227f,
+	-0.377212197f, -0.5f, -0.622787833f, -0.741844773f, -0.853553414f, -0.954519451f,
+	-1.04266763f, -1.12197101f, -1.19273567f, -1.25442278f, -1.30656302f, -1.34875941f,
+	-1.36887908f, -1.29538512f, -1.12090313f, -0.860099256f, -0.536566079f, -0.180216342f,
+	0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+	},
+	{
+	0.112372436f, 0.207106784f, 0.112372436f, -0.146446615f, -0.5f, -0.853553414f,
+	-1.1123724f, -1.20710683f, -1.1123724f, -0.853553414f, -0.5f, -0.146446615f,
+	0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+	},
+	{
+	0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+	0.0399530008f, 0.0706402659f, 0.0375527442f, -0.04893969f, -0.17054069f, -0.303473175f,
+	-0.425262213f, -0.541196108f, -0.653011143f, -0.759856403f, -0.860918641f, -0.955428839f,
+	-1.04167521f, -1.1123724f, -1.16446304f, -1.19636428f, -1.20710683f, -1.19636428f,
+	-1.16446304f, -1.1123724f, -1.04167521f, -0.954519451f, -0.853553414f, -0.741844773f,
+	-0.622787833f, -0.5f, -0.377212197f, -0.258155227f, -0.146446615f, -0.0454805233f,
+	},
+};
+
+/**************************************************************************************
+ * Function:    AntiAlias
+ *
+ * Description: smooth transition across DCT block boundaries (every 18 coefficients)
+ *
+ * Inputs:      vector of dequantized coefficients, length = (nBfly+1) * 18
+ *              number of "butterflies" to perform (one butterfly means one
+ *                inter-block smoothing operation)
+ *
+ * Outputs:     updated coefficient vector x
+ *
+ * Return:      none
+ *
+ * Notes:       weighted average of opposite bands (pairwise) from the 8 samples 
+ *                before and after each block boundary
+ **************************************************************************************/
+HELIX_FAST_CODE(static void AntiAlias(float *x, int nBfly))
+{
+	int i, k;
+	float a0, b0, c0, c1;
+
+	for (k = nBfly; k > 0; k--) {
+		x += 18;
+		for (i = 0; i < 8; i++) {
+			c0 = csaF[i][0];	c1 = csaF[i][1];
+			a0 = x[-1-i];		b0 = x[i];
+			x[-1-i] = c0*a0 - c1*b0;
+			x[i] =    c0*b0 + c1*a0;
+		}
+	}
+}
+
+/**************************************************************************************
+ * Function:    WinPrevious
+ *
+ * Description: apply specified window to second half of previous IMDCT (overlap part)
+ *
+ * Inputs:      vector of 9 coefficients (xPrev)
+ *
+ * Outputs:     18 windowed output coefficients
+ *              window type (0, 1, 2, 3)
+ *
+ * Return:      none
+ * 
+ * Notes:       produces 9 output samples from 18 input samples via symmetry
+ **************************************************************************************/
+HELIX_FAST_CODE(static void WinPrevious(float *xPrev, float *xPrevWin, int btPrev))
+{
+	int i;
+	float x, *xp, *xpwLo, *xpwHi;
+	const float *wpLo, *wpHi;
+
+	xp = xPrev;
+	/* mapping (see IMDCT12x3): xPrev[0-2] = sum[6-8], xPrev[3-8] = sum[12-17] */
+	if (btPrev == 2) {
+		wpLo = imdctWinF[btPrev];
+		xPrevWin[ 0] = wpLo[ 6] * xPrev[2] + wpLo[0] * xPrev[6];
+		xPrevWin[ 1] = wpLo[ 7] * xPrev[1] + wpLo[1] * xPrev[7];
+		xPrevWin[ 2] = wpLo[ 8] * xPrev[0] + wpLo[2] * xPrev[8];
+		xPrevWin[ 3] = wpLo[ 9] * xPrev[0] + wpLo[3] * xPrev[8];
+		xPrevWin[ 4] = wpLo[10] * xPrev[1] + wpLo[4] * xPrev[7];
+		xPrevWin[ 5] = wpLo[11] * xPrev[2] + wpLo[5] * xPrev[6];
+		xPrevWin[ 6] = wpLo[ 6] * xPrev[5];
+		xPrevWin[ 7] = wpLo[ 7] * xPrev[4];
+		xPrevWin[ 8] = wpLo[ 8] * xPrev[3];
+		xPrevWin[ 9] = wpLo[ 9] * xPrev[3];
+		xPrevWin[10] = wpLo[10] * xPrev[4];
+		xPrevWin[11] = wpLo[11] * xPrev[5];
+		xPrevWin[12] = xPrevWin[13] = xPrevWin[14] = xPrevWin[15] = xPrevWin[16] = xPrevWin[17] = 0.0f;
+	} else {
+		wpLo = imdctWinF[btPrev] + 18;
+		wpHi = wpLo + 17;
+		xpwLo = xPrevWin;
+		xpwHi = xPrevWin + 17;
+		for (i = 9; i > 0; i--) {
+			x = *xp++;
+			*xpwLo++ = *wpLo++ * x;
+			*xpwHi-- = *wpHi-- * x;
+		}
+	}
+}
+
+/**************************************************************************************
+ * Function:    FreqInvert
+ *
+ * Description: do frequency inversion (odd samples of odd blocks)
+ *
+ * Inputs:      output vector y (18 new samples, spaced NBANDS apart)
+ *              index of current block
+ *
+ * Outputs:     inverted outputs
+ *
+ * Return:      none
+ **************************************************************************************/
+HELIX_FAST_CODE(static void FreqInvert(float *y, int blockIdx))
+{
+	int i;
+
+	if (blockIdx & 0x01) {
+		y += NBANDS;
+		for (i = 0; i < 9; i++) {
+			*y = -*y;
+			y += 2*NBANDS;
+		}
+	}
+}
+
+/* u = 2*pi/9
+ * c0 = sqrt(3)/2, c1 = cos(u), c2 = cos(2*u), c3 = sin(u), c4 = sin(2*u)
+ */
+static const float c9_0 = 0.866025388f;
+static const float c9_1 = 0.766044438f;
+static const float c9_2 = 0.173648179f;
+static const float c9_3 = 0.642787635f;
+static const float c9_4 = 0.98480773f;
+
+/* 0.5 * cos(((0:8) + 0.5) * (pi/18)) */
+HELIX_FAST_DATA(static const float c18[9]) = {
+	0.49809736f, 0.482962906f, 0.453153908f, 0.409576029f, 0.353553385f, 0.286788225f, 0.211309135f, 0.129409522f, 0.0435778722f,
+};
+
+static __inline void idct9(float *x)
+{
+	float a1, a2, a3, a4, a5, a6, a7, a8, a9;
+	float a10, a11, a12, a13, a14, a15, a16, a17, a18;
+	float a19, a20, a21, a22, a23, a24, a25, a26, a27;
+	float m1, m3, m5, m6, m7, m8, m9, m10, m11, m12;
+	float x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = x[0]; x1 = x[1]; x2 = x[2]; x3 = x[3]; x4 = x[4];
+	x5 = x[5]; x6 = x[6]; x7 = x[7]; x8 = x[8];
+
+	a1 = x0 - x6;
+	a2 = x1 - x5;
+	a3 = x1 + x5;
+	a4 = x2 - x4;
+	a5 = x2 + x4;
+	a6 = x2 + x8;
+	a7 = x1 + x7;
+
+	a8 = a6 - a5;		/* ie x[8] - x[4] */
+	a9 = a3 - a7;		/* ie x[5] - x[7] */
+	a10 = a2 - x7;		/* ie x[1] - x[5] - x[7] */
+	a11 = a4 - x8;		/* ie x[2] - x[4] - x[8] */
+
+	m1 =  c9_0 * x3;
+	m3 =  c9_0 * a10;
+	m5 =  c9_1 * a5;
+	m6 =  c9_2 * a6;
+	m7 =  c9_1 * a8;
+	m8 =  c9_2 * a5;
+	m9 =  c9_3 * a9;
+	m10 = c9_4 * a7;
+	m11 = c9_3 * a3;
+	m12 = c9_4 * a9;
+
+	a12 = x0  + 0.5f * x6;
+	a13 = a12 + m1;
+	a14 = a12 - m1;
+	a15 = a1  + 0.5f * a11;
+	a16 = m5  + m6;
+	a17 = m7  - m8;
+	a18 = a16 + a17;
+	a19 = m9  + m10;
+	a20 = m11 - m12;
+
+	a21 = a20 - a19;
+	a22 = a13 + a16;
+	a23 = a14 + a16;
+	a24 = a14 + a17;
+	a25 = a13 + a17;
+	a26 = a14 - a18;
+	a27 = a13 - a18;
+
+	x[0] = a22 + a19;
+	x[1] = a15 + m3;
+	x[2] = a24 + a20;
+	x[3] = a26 - a21;
+	x[4] = a1 - a11;
+	x[5] = a27 + a21;
+	x[6] = a25 - a20;
+	x[7] = a15 - m3;
+	x[8] = a23 - a19;
+}
+
+/* let c(j) = cos(M_PI/36 * ((j)+0.5)), s(j) = sin(M_PI/36 * ((j)+0.5))
+ * then fastWin[2*j+0] = c(j)*(s(j) + c(j)), j = [0, 8]
+ *      fastWin[2*j+1] = c(j)*(s(j) - c(j))
+ */
+HELIX_FAST_DATA(static const float fastWin36[18]) = {
+	1.04167521f, -0.954519451f, 1.1123724f, -0.853553414f, 1.16446304f, -0.741844773f,
+	1.19636428f, -0.622787833f, 1.20710683f, -0.5f, 1.19636428f, -0.377212197f,
+	1.16446304f, -0.258155227f, 1.1123724f, -0.146446615f, 1.04167521f, -0.0454805233f,
+};
+
+/**************************************************************************************
+ * Function:    IMDCT36
+ *
+ * Description: 36-point modified DCT, with windowing and overlap-add (50% overlap)
+ *
+ * Inputs:      vector of 18 coefficients (N/2 inputs produces N outputs, by symmetry)
+ *              overlap part of last IMDCT (9 samples - see output comments)
+ *              window type (0,1,2,3) of current and previous block
+ *              current block index (for deciding whether to do frequency inversion)
+ *
+ * Outputs:     18 output samples, after windowing and overlap-add with last frame
+ *              second half of (unwindowed) 36-point IMDCT - save for next time
+ *                only save 9 xPrev samples, using symmetry (see WinPrevious())
+ *
+ * Return:      none
+ *
+ * Notes:       same steps as IMDCT36() in imdct.c, the fixed-point shifts become
+ *                multiplies by 0.5 and 0.25 or are folded into the constants
+ **************************************************************************************/
+HELIX_FAST_CODE(static void IMDCT36(float *xCurr, float *xPrev, float *y, int btCurr, int btPrev, int blockIdx))
+{
+	int i;
+	float xBuf[18], xPrevWin[18];
+	float acc1, acc2, s, d, t;
+	float xo, xe, *xp;
+	const float *cp, *wp;
+
+	acc1 = acc2 = 0.0f;
+	xCurr += 17;
+
+	for (i = 8; i >= 0; i--) {	
+		acc1 = (*xCurr--) - acc1;
+		acc2 = acc1 - acc2;
+		acc1 = (*xCurr--) - acc1;
+		xBuf[i+9] = acc2;	/* odd */
+		xBuf[i+0] = acc1;	/* even */
+	}
+	/* xEven[0] and xOdd[0] scaled by 0.5 */
+	xBuf[9] *= 0.5f;
+	xBuf[0] *= 0.5f;
+
+	/* do 9-point IDCT on even and odd */
+	idct9(xBuf+0);	/* even */
+	idct9(xBuf+9);	/* odd */
+
+	xp = xBuf + 8;
+	cp = c18 + 8;
+	if (btPrev == 0 && btCurr == 0) {
+		/* fast path - use symmetry of sin window to reduce windowing multiplies to 18 (N/2) */
+		wp = fastWin36;
+		for (i = 0; i < 9; i++) {
+			xo = *cp-- * *(xp + 9);
+			xe = *xp-- * 0.25f;
+
+			s = -(*xPrev);		/* sum from last block */
+			d = -(xe - xo);
+			(*xPrev++) = xe + xo;			/* symmetry - xPrev[i] = xPrev[17-i] for long blocks */
+			t = s - d;
+
+			y[(i)*NBANDS]    = d + t * wp[0];
+			y[(17-i)*NBANDS] = s + t * wp[1];
+			wp += 2;
+		}
+	} else {
+		/* slower method - either prev or curr is using window type != 0 so do full 36-point window */
+		WinPrevious(xPrev, xPrevWin, btPrev);
+
+		wp = imdctWinF[btCurr];
+		for (i = 0; i < 9; i++) {
+			xo = *cp-- * *(xp + 9);
+			xe = *xp-- * 0.25f;
+
+			d = xe - xo;
+			(*xPrev++) = xe + xo;	/* symmetry - xPrev[i] = xPrev[17-i] for long blocks */
+			
+			y[(i)*NBANDS]    = xPrevWin[i]    + d * wp[i];
+			y[(17-i)*NBANDS] = xPrevWin[17-i] + d * wp[17-i];
+		}
+	}
+
+	FreqInvert(y, blockIdx);
+}
+
+static const float c3_0 = 0.866025388f;	/* cos(pi/6) */
+HELIX_FAST_DATA(static const float c6[3]) = { 1.93185163f, 1.41421354f, 0.517638087f };	/* 2 * cos(((0:2) + 0.5) * (pi/6)) */
+
+/* 12-point inverse DCT, used in IMDCT12x3() 
+ * output is scaled by 0.25 (the >> 2 the fixed-point IMDCT12x3 applies to the window inputs)
+ */
+static __inline void imdct12 (float *x, float *out)
+{
+	float a0, a1, a2;
+	float x0, x1, x2, x3, x4, x5;
+
+	x0 = *x;	x+=3;	x1 = *x;	x+=3;
+	x2 = *x;	x+=3;	x3 = *x;	x+=3;
+	x4 = *x;	x+=3;	x5 = *x;	x+=3;
+
+	x0 *= 0.25f;	x1 *= 0.25f;	x2 *= 0.25f;
+	x3 *= 0.25f;	x4 *= 0.25f;	x5 *= 0.25f;
+
+	x4 -= x5;
+	x3 -= x4;
+	x2 -= x3;
+	x3 -= x5;
+	x1 -= x2;
+	x0 -= x1;
+	x1 -= x3;
+
+	x0 *= 0.5f;
+	x1 *= 0.5f;
+
+	a0 = c3_0 * x2;
+	a1 = x0 + 0.5f * x4;
+	a2 = x0 - x4;
+	x0 = a1 + a0;
+	x2 = a2;
+	x4 = a1 - a0;
+
+	a0 = c3_0 * x3;
+	a1 = x1 + 0.5f * x5;
+	a2 = x1 - x5;
+
+	/* cos window odd samples, mul by 2 */
+	x1 = c6[0] * (a1 + a0);			
+	x3 = c6[1] * a2;
+	x5 = c6[2] * (a1 - a0);
+
+	*out = x0 + x1;	out++;
+	*out = x2 + x3;	out++;
+	*out = x4 + x5;	out++;
+	*out = x4 - x5;	out++;
+	*out = x2 - x3;	out++;
+	*out = x0 - x1;
+}
+
+/**************************************************************************************
+ * Function:    IMDCT12x3
+ *
+ * Description: three 12-point modified DCT's for short blocks, with windowing,
+ *                short block concatenation, and overlap-add
+ *
+ * Inputs:      3 interleaved vectors of 6 samples each 
+ *                (block0[0], block1[0], block2[0], block0[1], block1[1]....)
+ *              overlap part of last IMDCT (9 samples - see output comments)
+ *              window type (0,1,2,3) of previous block
+ *              current block index (for deciding whether to do frequency inversion)
+ *
+ * Outputs:     18 output samples, after windowing and overlap-add with last frame
+ *              second half of (unwindowed) IMDCT's - save for next time
+ *                only save 9 xPrev samples, using symmetry (see WinPrevious())
+ *
+ * Return:      none
+ **************************************************************************************/
+HELIX_FAST_CODE(static void IMDCT12x3(float *xCurr, float *xPrev, float *y, int btPrev, int blockIdx))
+{
+	int i;
+	float xBuf[18], xPrevWin[18];	/* need temp buffer for reordering short blocks */
+	const float *wp;
+
+	imdct12(xCurr + 0, xBuf + 0);
+	imdct12(xCurr + 1, xBuf + 6);
+	imdct12(xCurr + 2, xBuf + 12);
+
+	/* window previous from last time */
+	WinPrevious(xPrev, xPrevWin, btPrev);
+
+	wp = imdctWinF[2];
+	for (i = 0; i < 3; i++) {
+		y[( 0+i)*NBANDS] = xPrevWin[ 0+i];
+		y[( 3+i)*NBANDS] = xPrevWin[ 3+i];
+		y[( 6+i)*NBANDS] = xPrevWin[ 6+i] + wp[0+i] * xBuf[3+i];
+		y[( 9+i)*NBANDS] = xPrevWin[ 9+i] + wp[3+i] * xBuf[5-i];
+		y[(12+i)*NBANDS] = xPrevWin[12+i] + wp[6+i] * xBuf[2-i] + wp[0+i] * xBuf[(6+3)+i];
+		y[(15+i)*NBANDS] = xPrevWin[15+i] + wp[9+i] * xBuf[0+i] + wp[3+i] * xBuf[(6+5)-i];
+	}
+
+	/* save previous (unwindowed) for overlap - only need samples 6-8, 12-17 */
+	for (i = 6; i < 9; i++)
+		*xPrev++ = xBuf[i];
+	for (i = 12; i < 18; i++)
+		*xPrev++ = xBuf[i];
+
+	FreqInvert(y, blockIdx);
+}
+
+/**************************************************************************************
+ * Function:    HybridTransform
+ *
+ * Description: IMDCT's, windowing, and overlap-add on long/short/mixed blocks
+ *
+ * Inputs:      vector of input coefficients, length = nBlocksTotal * 18)
+ *              vector of overlap samples from last time, length = nBlocksPrev * 9)
+ *              buffer for output samples, length = MAXNSAMP
+ *              SideInfoSub struct for this granule/channel
+ *              BlockCount struct with necessary info (see imdct.c)
+ *
+ * Outputs:     transformed, windowed, and overlapped sample buffer
+ *              does frequency inversion on odd blocks
+ *              updated buffer of samples for overlap
+ *
+ * Return:      number of non-zero IMDCT blocks calculated in this call
+ *                (including overlap-add)
+ **************************************************************************************/
+HELIX_FAST_CODE(static int HybridTransform(float *xCurr, float *xPrev, float y[BLOCK_SIZE][NBANDS], SideInfoSub *sis, BlockCount *bc))
+{
+	int i, j, nBlocksOut, nonZero;
+	int currWinIdx, prevWinIdx;
+	float xPrevWin[18], xp;
+
+	ASSERT(bc->nBlocksLong  <= NBANDS);
+	ASSERT(bc->nBlocksTotal <= NBANDS);
+	ASSERT(bc->nBlocksPrev  <= NBANDS);
+
+	/* do long blocks, if any */
+	for(i = 0; i < bc->nBlocksLong; i++) {
+		/* currWinIdx picks the right window for long blocks (if mixed, long blocks use window type 0) */
+		currWinIdx = sis->blockType;
+		if (sis->mixedBlock && i < bc->currWinSwitch) 
+			currWinIdx = 0;
+
+		prevWinIdx = bc->prevType;
+		if (i < bc->prevWinSwitch)
+			 prevWinIdx = 0;
+
+		/* do 36-point IMDCT, including windowing and overlap-add */
+		IMDCT36(xCurr, xPrev, &(y[0][i]), currWinIdx, prevWinIdx, i);
+		xCurr += 18;
+		xPrev += 9;
+	}
+
+	/* do short blocks (if any) */
+	for (   ; i < bc->nBlocksTotal; i++) {
+		ASSERT(sis->blockType == 2);
+
+		prevWinIdx = bc->prevType;
+		if (i < bc->prevWinSwitch)
+			 prevWinIdx = 0;
+		
+		IMDCT12x3(xCurr, xPrev, &(y[0][i]), prevWinIdx, i);
+		xCurr += 18;
+		xPrev += 9;
+	}
+	nBlocksOut = i;
+	
+	/* window and overlap prev if prev longer that current */
+	for (   ; i < bc->nBlocksPrev; i++) {
+		prevWinIdx = bc->prevType;
+		if (i < bc->prevWinSwitch)
+			 prevWinIdx = 0;
+		WinPrevious(xPrev, xPrevWin, prevWinIdx);
+
+		nonZero = 0;
+		for (j = 0; j < 9; j++) {
+			xp = xPrevWin[2*j+0];
+			nonZero |= (xp != 0.0f);
+			y[2*j+0][i] = xp;
+
+			/* frequency inversion on odd blocks/odd samples (flip sign if i odd, j odd) */
+			xp = xPrevWin[2*j+1];
+			nonZero |= (xp != 0.0f);
+			y[2*j+1][i] = (i & 0x01) ? -xp : xp;
+
+			xPrev[j] = 0.0f;
+		}
+		xPrev += 9;
+		if (nonZero)
+			nBlocksOut = i;
+	}
+	
+	/* clear rest of blocks */
+	for (   ; i < 32; i++) {
+		for (j = 0; j < 18; j++) 
+			y[j][i] = 0.0f;
+	}
+
+	return nBlocksOut;
+}
+
+/**************************************************************************************
+ * Function:    IMDCT
+ *
+ * Description: do alias reduction, inverse MDCT, overlap-add, and frequency inversion
+ *
+ * Inputs:      MP3DecInfo structure filled by UnpackFrameHeader(), UnpackSideInfo(),
+ *                UnpackScaleFactors(), DecodeHuffman() and Dequantize() (for this 
+ *                granule, channel)
+ *                includes samples in overBuf (from last call to IMDCT) for OLA
+ *              index of current granule and channel
+ *
+ * Outputs:     float samples in outBuf, for input to subband transform
+ *              float samples in overBuf, for OLA next time
+ *              updated hi->nonZeroBound index for this channel
+ *
+ * Return:      0 on success,  -1 if null input pointers
+ *
+ * Notes:       mi->gb is not used by the float back end and is left alone
+ **************************************************************************************/
+HELIX_FAST_CODE(int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch))
+{
+	int nBfly, blockCutoff;
+	FrameHeader *fh;
+	SideInfo *si;
+	HuffmanInfo *hi;
+	IMDCTInfo *mi;
+	BlockCount bc;
+	float *xr;
+
+	/* validate pointers */
+	if (!mp3DecInfo || !mp3DecInfo->FrameHeaderPS || !mp3DecInfo->SideInfoPS || 
+		!mp3DecInfo->HuffmanInfoPS || !mp3DecInfo->IMDCTInfoPS)
+		return -1;
+
+	/* si is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
+	fh = (FrameHeader *)(mp3DecInfo->FrameHeaderPS);
+	si = (SideInfo *)(mp3DecInfo->SideInfoPS);
+	hi = (HuffmanInfo*)(mp3DecInfo->HuffmanInfoPS);
+	mi = (IMDCTInfo *)(mp3DecInfo->IMDCTInfoPS);
+	xr = (float *)hi->huffDecBuf[ch];	/* written as float by Dequantize() */
+
+	/* anti-aliasing done on whole long blocks only (see imdct.c) */
+	blockCutoff = fh->sfBand->l[(fh->ver == MPEG1 ? 8 : 6)] / 18;	/* same as 3* num short sfb's in spec */
+	if (si->sis[gr][ch].blockType != 2) {
+		/* all long transforms */
+		bc.nBlocksLong = MIN((hi->nonZeroBound[ch] + 7) / 18 + 1, 32);	
+		nBfly = bc.nBlocksLong - 1;
+	} else if (si->sis[gr][ch].blockType == 2 && si->sis[gr][ch].mixedBlock) {
+		/* mixed block - long transforms until cutoff, then short transforms */
+		bc.nBlocksLong = blockCutoff;	
+		nBfly = bc.nBlocksLong - 1;
+	} else {
+		/* all short transforms */
+		bc.nBlocksLong = 0;
+		nBfly = 0;
+	}
+ 
+	AntiAlias(xr, nBfly);
+	hi->nonZeroBound[ch] = MAX(hi->nonZeroBound[ch], (nBfly * 18) + 8);
+
+	ASSERT(hi->nonZeroBound[ch] <= MAX_NSAMP);
+
+	bc.nBlocksTotal = (hi->nonZeroBound[ch] + 17) / 18;
+	bc.nBlocksPrev = mi->numPrevIMDCT[ch];
+	bc.prevType = mi->prevType[ch];
+	bc.prevWinSwitch = mi->prevWinSwitch[ch];
+	bc.currWinSwitch = (si->sis[gr][ch].mixedBlock ? blockCutoff : 0);	/* where WINDOW switches (not nec. transform) */
+
+	mi->numPrevIMDCT[ch] = HybridTransform(xr, mi->overBuf[ch], mi->outBuf[ch], &si->sis[gr][ch], &bc);
+	mi->prevType[ch] = si->sis[gr][ch].blockType;
+	mi->prevWinSwitch[ch] = bc.currWinSwitch;		/* 0 means not a mixed block (either all short or all long) */
+
+	ASSERT(mi->numPrevIMDCT[ch] <= NBANDS);
+
+	return 0;
+}
+
+#endif	/* HELIX_FLOAT_DSP */
@@ -0,0 +1,177 @@
+/* ***** BEGIN LICENSE BLOCK ***** 
+ * Version: RCSL 1.0/RPSL 1.0 
+ *  
+ * Portions Copyright (c) 1995-2002 RealNetworks, Inc. All Rights Reserved. 
+ *      
+ * The contents of this file, and the files included with this file, are 
+ * subject to the current version of the RealNetworks Public Source License 
+ * Version 1.0 (the "RPSL") available at 
+ * http://www.helixcommunity.org/content/rpsl unless you have licensed 
+ * the file under the RealNetworks Community Source License Version 1.0 
+ * (the "RCSL") available at http://www.helixcommunity.org/content/rcsl, 
+ * in which case the RCSL will apply. You may also obtain the license terms 
+ * directly from RealNetworks.  You may not use this file except in 
+ * compliance with the RPSL or, if you have a valid RCSL with RealNetworks 
+ * applicable to this file, the RCSL.  Please see the applicable RPSL or 
+ * RCSL for the rights, obligations and limitations governing use of the 
+ * contents of the file.  
+ *  
+ * This file is part of the Helix DNA Technology. RealNetworks is the 
+ * developer of the Original Code and owns the copyrights in the portions 
+ * it created. 
+ *  
+ * This file, and the files included with this file, is distributed and made 
+ * available on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER 
+ * EXPRESS OR IMPLIED, AND REALNETWORKS HEREBY DISCLAIMS ALL SUCH WARRANTIES, 
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT. 
+ * 
+ * Technology Compatibility Kit Test Suite(s) Location: 
+ *    http://www.helixcommunity.org/content/tck 
+ * 
+ * Contributor(s): 
+ *  
+ * ***** END LICENSE BLOCK ***** */ 
+
+
+/**************************************************************************************
+ * Level measurement for the fixed-point MP3 decoder
+ *
+ * levels.c - subband powers and output peak/power of every granule, for spectrum
+ *              and level meters (see MP3GetLevels)
+ *
+ * Built with HELIX_LEVELS, with both back ends (DSPSample is int, or float with 
+ *   HELIX_FLOAT_DSP)
+ **************************************************************************************/
+
+#include "coder.h"
+#include "assembly.h"
+
+#if HELIX_LEVELS
+
+/* power of one granule = sum of squares / 576, as ((sum >> 7) * round(2^39 / 576)) >> 32 */
+#define POWER_SCALE		954437177U
+
+/* the synthesis filterbank is orthogonal with a gain of 32: the squared output samples of a
+ *   granule add up to 32 times the squared IMDCT outputs (fixed point: 2^-11 times, the
+ *   IMDCT output is scaled up by 2^8), so each subband's share of the output power comes
+ *   straight from the IMDCT output
+ */
+#define BAND_SHIFT		5		/* fixed point: 2^-11 gain, less 2^6 for the squares of x >> 3 */
+
+/**************************************************************************************
+ * Function:    ScalePower
+ *
+ * Description: turn a sum of squares over one granule into mean square power
+ *
+ * Inputs:      sum of squares over the 576 samples of a granule, times 2^shift
+ *              shift
+ *
+ * Outputs:     none
+ *
+ * Return:      sum / 576 / 2^shift, saturated at about 2^29.8
+ **************************************************************************************/
+static __inline unsigned int ScalePower(Word64 sum, int shift)
+{
+	sum >>= (shift + 7);
+	if (sum > 0xffffffff)
+		sum = 0xffffffff;
+
+	return (unsigned int)(((unsigned long long)sum * POWER_SCALE) >> 32);
+}
+
+/**************************************************************************************
+ * Function:    MeasureBands
+ *
+ * Description: power of each subband in the granule about to be synthesized
+ *
+ * Inputs:      MP3DecInfo structure after IMDCT() (and DownmixIMDCT()) for this granule
+ *
+ * Outputs:     mp3DecInfo->bandPower, averaged over the output channels
+ *
+ * Return:      none
+ *
+ * Notes:       call before Subband(), FDCT32 rescales outBuf in place
+ **************************************************************************************/
+HELIX_FAST_CODE(void MeasureBands(MP3DecInfo *mp3DecInfo))
+{
+	int b, sb, ch, nChans;
+	IMDCTInfo *mi;
+#if HELIX_FLOAT_DSP
+	float sum, x;
+#else
+	Word64 sum;
+	int x;
+#endif
+
+	mi = (IMDCTInfo *)(mp3DecInfo->IMDCTInfoPS);
+	nChans = mp3DecInfo->nOutChans;
+	for (sb = 0; sb < NBANDS; sb++) {
+		sum = 0;
+		for (ch = 0; ch < nChans; ch++) {
+			for (b = 0; b < BLOCK_SIZE; b++) {
+#if HELIX_FLOAT_DSP
+				x = mi->outBuf[ch][b][sb];
+				sum += x * x;
+#else
+				x = mi->outBuf[ch][b][sb] >> 3;		/* |outBuf| < 2^30, 36 squares fit */
+				sum += (Word64)x * x;
+#endif
+			}
+		}
+#if HELIX_FLOAT_DSP
+		sum *= 32.0f / (MAX_NSAMP * nChans);
+		mp3DecInfo->bandPower[sb] = (sum < 4294967040.0f ? (unsigned int)sum : 0xffffffff);
+#else
+		mp3DecInfo->bandPower[sb] = ScalePower(sum, BAND_SHIFT + nChans - 1);
+#endif
+	}
+}
+
+/**************************************************************************************
+ * Function:    MeasureOutput
+ *
+ * Description: peak and power of the PCM of one granule, then publish the snapshot
+ *
+ * Inputs:      MP3DecInfo structure, after MeasureBands() and Subband() for this granule
+ *              PCM output of Subband(), interleaved LRLRLR... if stereo
+ *
+ * Outputs:     mp3DecInfo->levels, bracketed by two increments of levelSeq
+ *
+ * Return:      none
+ **************************************************************************************/
+HELIX_FAST_CODE(void MeasureOutput(MP3DecInfo *mp3DecInfo, short *pcmBuf))
+{
+	int i, ch, nChans, x, peak;
+	unsigned int power[MAX_NCHAN], peaks[MAX_NCHAN];
+	Word64 sum;
+
+	nChans = mp3DecInfo->nOutChans;
+	for (ch = 0; ch < nChans; ch++) {
+		sum = 0;
+		peak = 0;
+		for (i = ch; i < MAX_NSAMP * nChans; i += nChans) {
+			x = pcmBuf[i];
+			sum += (Word64)x * x;
+			x = FASTABS(x);
+			if (x > peak)
+				peak = x;
+		}
+		power[ch] = ScalePower(sum, 0);
+		peaks[ch] = (unsigned int)peak;
+	}
+
+	/* readers (MP3GetLevels) retry or give up if levelSeq is odd or moves while they copy */
+	mp3DecInfo->levelSeq++;
+	mp3DecInfo->levels.granule++;
+	mp3DecInfo->levels.nChans = nChans;
+	for (i = 0; i < MP3_LEVEL_BANDS; i++)
+		mp3DecInfo->levels.bandPower[i] = mp3DecInfo->bandPower[i];
+	for (ch = 0; ch < nChans; ch++) {
+		mp3DecInfo->levels.power[ch] = power[ch];
+		mp3DecInfo->levels.peak[ch] = peaks[ch];
+	}
+	mp3DecInfo->levelSeq++;
+}
+
+#endif	/* HELIX_LEVELS */
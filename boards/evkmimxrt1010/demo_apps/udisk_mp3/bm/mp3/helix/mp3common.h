@@ -60,6 +60,30 @@
  * #define	SYNCWORDL		0xf0
  */
 
+#define MAX_MAINDATABEGIN	511		/* 9-bit main_data_begin, how far back the bit reservoir reaches */
+
+/* main data runs remembered in ring input mode, must be a power of 2
+ * (a full bit reservoir spans at most 24 frames, 255 bytes of 11-byte payloads at 8 kbps MPEG2)
+ */
+#define MAX_MAINRUNS	32
+
+/* one contiguous piece of main data, in mainBuf or in the caller's ring */
+typedef struct _MainDataRun {
+	unsigned char *ptr;
+	int len;
+} MainDataRun;
+
+/* byte reader over a sequence of main data runs (reads 0 past the end of the last run) */
+typedef struct _MainDataCursor {
+	unsigned char *ptr;			/* next byte */
+	unsigned char *end;			/* end of the current run */
+	const MainDataRun *runs;	/* run FIFO, indexed modulo MAX_MAINRUNS */
+	int run;					/* index of the current run */
+	int lastRun;				/* index of the last run */
+} MainDataCursor;
+
+#define GetMainDataByte(mc)		((mc)->ptr != (mc)->end ? *(mc)->ptr++ : NextMainDataByte(mc))
+
 typedef struct _MP3DecInfo {
 	/* pointers to platform-specific data structures */
 	void *FrameHeaderPS;
@@ -69,17 +93,31 @@ typedef struct _MP3DecInfo {
 	void *DequantInfoPS;
 	void *IMDCTInfoPS;
 	void *SubbandInfoPS;
+	void *heapBlock;		/* block malloc'ed by AllocateBuffers, 0 if the memory is not ours to free */
 
 	/* buffer which must be large enough to hold largest possible main_data section */
 	unsigned char mainBuf[MAINBUF_SIZE];
 
+	/* ring input mode - main data is read in place from the caller's ring instead of mainBuf */
+	unsigned char *ringBuf;
+	int ringSize;
+	MainDataRun mainRuns[MAX_MAINRUNS];	/* oldest at firstRun, newest at firstRun + nRuns - 1 */
+	int firstRun;
+	int nRuns;
+	int runBytes;						/* total bytes in mainRuns */
+
 	/* special info for "free" bitrate files */
 	int freeBitrateFlag;
 	int freeBitrateSlots;
 
+	/* low-power decode options (see MP3SetDecodeConfig) */
+	int monoDownmix;
+	int nSubbands;			/* 0 = all 32 */
+
 	/* user-accessible info */
 	int bitrate;
 	int nChans;
+	int nOutChans;			/* channels in the PCM output: nChans, or 1 with monoDownmix */
 	int samprate;
 	int nGrans;				/* granules per frame */
 	int nGranSamps;			/* samples per granule */
@@ -92,8 +130,36 @@ typedef struct _MP3DecInfo {
 
 	int part23Length[MAX_NGRAN][MAX_NCHAN];
 
+	/* main data position between granules of one frame (see MP3DecodeGranule) */
+	MainDataRun linearRun;		/* the one run of main data with linear input */
+	MainDataCursor mainCursor;
+	int mainBitOffset;
+	int mainBitsLeft;
+	int granule;				/* next granule to decode */
+	int nGransLeft;				/* granules of the current frame not decoded yet, 0 = start a new frame */
+
+#if HELIX_LEVELS
+	unsigned int bandPower[MP3_LEVEL_BANDS];	/* of the granule being decoded, until it is published */
+	volatile MP3LevelInfo levels;				/* published snapshot */
+	volatile unsigned int levelSeq;				/* odd while levels is being written */
+#endif
+
+#if HELIX_PROFILE
+	MP3ProfileInfo profile;
+	unsigned int frameCycles;	/* cycles of the granules decoded so far in this frame */
+#endif
+
 } MP3DecInfo;
 
+#if HELIX_PROFILE
+/* bracket one decoder stage - caller declares "unsigned int profStart" */
+#define PROFILE_BEGIN()				(profStart = MP3ProfileGetCycles())
+#define PROFILE_END(info, stage)	((info)->profile.stageCycles[(stage)] += MP3ProfileGetCycles() - profStart)
+#else
+#define PROFILE_BEGIN()
+#define PROFILE_END(info, stage)
+#endif
+
 typedef struct _SFBandTable {
 	short l[23];
 	short s[14];
@@ -101,15 +167,28 @@ typedef struct _SFBandTable {
 
 /* decoder functions which must be implemented for each platform */
 MP3DecInfo *AllocateBuffers(void);
+MP3DecInfo *AllocateBuffersInPlace(void *arena, int size);
+int GetBufferSize(int headerOnly);
 void FreeBuffers(MP3DecInfo *mp3DecInfo);
+void ResetBuffers(MP3DecInfo *mp3DecInfo);
 int CheckPadBit(MP3DecInfo *mp3DecInfo);
 int UnpackFrameHeader(MP3DecInfo *mp3DecInfo, unsigned char *buf);
 int UnpackSideInfo(MP3DecInfo *mp3DecInfo, unsigned char *buf);
-int DecodeHuffman(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int huffBlockBits, int gr, int ch);
+int DecodeHuffman(MP3DecInfo *mp3DecInfo, const MainDataCursor *mc, int *bitOffset, int huffBlockBits, int gr, int ch);
+void InitHuffmanFastTables(void);
 int Dequantize(MP3DecInfo *mp3DecInfo, int gr);
 int IMDCT(MP3DecInfo *mp3DecInfo, int gr, int ch);
-int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int bitsAvail, int gr, int ch);
+int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, const MainDataCursor *mc, int *bitOffset, int bitsAvail, int gr, int ch);
+unsigned char NextMainDataByte(MainDataCursor *mc);
+void SkipMainData(MainDataCursor *mc, int nBytes);
 int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf);
+void LimitBandwidth(MP3DecInfo *mp3DecInfo);
+int DownmixSpectrum(MP3DecInfo *mp3DecInfo, int gr);
+void DownmixIMDCT(MP3DecInfo *mp3DecInfo);
+#if HELIX_LEVELS
+void MeasureBands(MP3DecInfo *mp3DecInfo);
+void MeasureOutput(MP3DecInfo *mp3DecInfo, short *pcmBuf);
+#endif
 
 /* mp3tabs.c - global ROM tables */
 extern const int samplerateTab[3][3];
@@ -62,6 +62,60 @@ HMP3Decoder MP3InitDecoder(void)
 	MP3DecInfo *mp3DecInfo;
 
 	mp3DecInfo = AllocateBuffers();
+#if HELIX_HUFF_FAST_BITS
+	InitHuffmanFastTables();
+#endif
+
+	return (HMP3Decoder)mp3DecInfo;
+}
+
+/**************************************************************************************
+ * Function:    MP3GetDecoderSize
+ *
+ * Description: memory needed by MP3InitDecoderInPlace
+ *
+ * Inputs:      0 for a decoder, 1 for a header-only instance (frame info only, see notes)
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes, valid for a block of any alignment
+ *
+ * Notes:       a header-only instance supports MP3GetNextFrameInfo and
+ *                MP3GetLastFrameInfo, MP3Decode returns ERR_MP3_NULL_POINTER
+ **************************************************************************************/
+int MP3GetDecoderSize(int headerOnly)
+{
+	return GetBufferSize(headerOnly);
+}
+
+/**************************************************************************************
+ * Function:    MP3InitDecoderInPlace
+ *
+ * Description: create a decoder instance in memory provided by the caller
+ *
+ * Inputs:      pointer to a block of memory (any alignment)
+ *              size of the block in bytes
+ *
+ * Outputs:     none
+ *
+ * Return:      handle to mp3 decoder instance, 0 if the block is too small
+ *
+ * Notes:       MP3GetDecoderSize(0) bytes give a full decoder, MP3GetDecoderSize(1)
+ *                bytes a header-only instance
+ *              instances in separate blocks are independent of each other and of the
+ *                one returned by MP3InitDecoder
+ *              the block belongs to the decoder until it is no longer used, 
+ *                MP3FreeDecoder does not release it
+ **************************************************************************************/
+HMP3Decoder MP3InitDecoderInPlace(void *arena, int arenaSize)
+{
+	MP3DecInfo *mp3DecInfo;
+
+	mp3DecInfo = AllocateBuffersInPlace(arena, arenaSize);
+#if HELIX_HUFF_FAST_BITS
+	if (mp3DecInfo && mp3DecInfo->SubbandInfoPS)
+		InitHuffmanFastTables();
+#endif
 
 	return (HMP3Decoder)mp3DecInfo;
 }
@@ -88,6 +142,90 @@ void MP3FreeDecoder(HMP3Decoder hMP3Decoder)
 	FreeBuffers(mp3DecInfo);
 }
 
+/**************************************************************************************
+ * Function:    MP3ResetDecoder
+ *
+ * Description: start a new stream in a decoder instance without freeing it
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       drops the bit reservoir, the free bitrate frame size, the IMDCT overlap
+ *                and the synthesis filter history, so the next stream decodes exactly
+ *                as in a new instance
+ *              keeps the ring input (see MP3SetRingInput), the decode options and the
+ *                profiler counts
+ *              much cheaper than MP3FreeDecoder and MP3InitDecoder: nothing is
+ *                allocated and only the state carried between granules is cleared
+ **************************************************************************************/
+int MP3ResetDecoder(HMP3Decoder hMP3Decoder)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo)
+		return ERR_MP3_NULL_POINTER;
+
+	mp3DecInfo->firstRun = 0;
+	mp3DecInfo->nRuns = 0;
+	mp3DecInfo->runBytes = 0;
+	mp3DecInfo->mainDataBytes = 0;
+	mp3DecInfo->nGransLeft = 0;
+	mp3DecInfo->freeBitrateFlag = 0;
+	mp3DecInfo->freeBitrateSlots = 0;
+	ResetBuffers(mp3DecInfo);
+
+	return ERR_MP3_NONE;
+}
+
+/**************************************************************************************
+ * Function:    CheckSyncHeader
+ *
+ * Description: check that a sync word starts a plausible layer 3 frame header
+ *
+ * Inputs:      pointer to the sync word
+ *              number of valid bytes from there on
+ *
+ * Outputs:     none
+ *
+ * Return:      1 if the header is valid and the header at the computed start of the
+ *                next frame repeats its version, layer and sample rate, or the next
+ *                header cannot be checked (free format, or it lies beyond nBytes)
+ *              0 if the header is valid but the next one does not match
+ *              -1 if the header is invalid
+ **************************************************************************************/
+static int CheckSyncHeader(unsigned char *buf, int nBytes)
+{
+	int verIdx, srIdx, brIdx, frameBytes;
+	unsigned char *next;
+	MPEGVersion ver;
+
+	if (nBytes < 3)
+		return 1;
+
+	verIdx = (buf[1] >> 3) & 0x03;
+	srIdx =  (buf[2] >> 2) & 0x03;
+	brIdx =  (buf[2] >> 4) & 0x0f;
+	if (verIdx == 1 || ((buf[1] >> 1) & 0x03) != 1 || srIdx == 3 || brIdx == 15)
+		return -1;		/* reserved version, not layer 3, bad sample rate or bitrate index */
+	if (brIdx == 0)
+		return 1;		/* free format, frame size is not known yet */
+
+	ver = (MPEGVersion)( verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2) );
+	frameBytes = (int)slotTab[ver][srIdx][brIdx] + ((buf[2] >> 1) & 0x01);
+	if (frameBytes + 3 > nBytes)
+		return 1;
+
+	/* sync, version and layer (CRC flag may differ), and sample rate */
+	next = buf + frameBytes;
+	if ((next[0] & SYNCWORDH) == SYNCWORDH && (next[1] & 0xfe) == (buf[1] & 0xfe) && (next[2] & 0x0c) == (buf[2] & 0x0c))
+		return 1;
+
+	return 0;
+}
+
 /**************************************************************************************
  * Function:    MP3FindSyncWord
  *
@@ -100,18 +238,46 @@ void MP3FreeDecoder(HMP3Decoder hMP3Decoder)
  *
  * Return:      offset to first sync word (bytes from start of buf)
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       a sync word is only taken if it starts a valid layer 3 header and the
+ *                header at the start of the next frame matches it (or lies beyond
+ *                nBytes), so sync patterns in tags or corrupt data are skipped
+ *              if no candidate passes, the first valid header whose next header did
+ *                not match is returned anyway (last frame followed by a tag, for example)
+ *              words without an 0xff byte are skipped 4 bytes at a time
  **************************************************************************************/
 int MP3FindSyncWord(unsigned char *buf, int nBytes)
 {
-	int i;
+	int i, check, firstValid;
+	unsigned int w;
+
+	firstValid = -1;
+	i = 0;
+	while (i < nBytes - 1) {
+		if (((unsigned long)(buf + i) & 0x03) == 0) {
+			/* no byte of w is 0xff <=> no byte of ~w is zero */
+			while (i + 4 <= nBytes) {
+				w = ~(*(unsigned int *)(buf + i));
+				if ((w - 0x01010101) & ~w & 0x80808080)
+					break;
+				i += 4;
+			}
+			if (i >= nBytes - 1)
+				break;
+		}
 
-	/* find byte-aligned syncword - need 12 (MPEG 1,2) or 11 (MPEG 2.5) matching bits */
-	for (i = 0; i < nBytes - 1; i++) {
-		if ( (buf[i+0] & SYNCWORDH) == SYNCWORDH && (buf[i+1] & SYNCWORDL) == SYNCWORDL )
-			return i;
+		/* find byte-aligned syncword - need 12 (MPEG 1,2) or 11 (MPEG 2.5) matching bits */
+		if ( (buf[i+0] & SYNCWORDH) == SYNCWORDH && (buf[i+1] & SYNCWORDL) == SYNCWORDL ) {
+			check = CheckSyncHeader(buf + i, nBytes - i);
+			if (check > 0)
+				return i;
+			if (check == 0 && firstValid < 0)
+				firstValid = i;
+		}
+		i++;
 	}
 	
-	return -1;
+	return firstValid;
 }
 
 /**************************************************************************************
@@ -166,6 +332,288 @@ static int MP3FindFreeSync(unsigned char *buf, unsigned char firstFH[4], int nBy
 	//	return -1;  Removed KJ
 }
 
+/**************************************************************************************
+ * Function:    MP3SetRingInput
+ *
+ * Description: switch the decoder between linear and ring input
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              pointer to ring storage of ringSize + MP3_RING_GUARD bytes, or 0 to go
+ *                back to linear input
+ *              ring size in bytes (not counting the guard)
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       in ring mode MP3Decode takes *inbuf anywhere in the ring and lets frames
+ *                wrap around the end; main data is read where it lies instead of being
+ *                copied into mainBuf, so the bit reservoir stays in the caller's ring
+ *              the caller must not overwrite ring bytes from MP3GetRingHold() onwards
+ *              drops the bit reservoir, call before the first frame of a stream
+ **************************************************************************************/
+int MP3SetRingInput(HMP3Decoder hMP3Decoder, unsigned char *ringBuf, int ringSize)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo || (ringBuf && ringSize <= 0))
+		return ERR_MP3_NULL_POINTER;
+
+	mp3DecInfo->ringBuf = ringBuf;
+	mp3DecInfo->ringSize = ringBuf ? ringSize : 0;
+	mp3DecInfo->firstRun = 0;
+	mp3DecInfo->nRuns = 0;
+	mp3DecInfo->runBytes = 0;
+	mp3DecInfo->mainDataBytes = 0;
+	mp3DecInfo->nGransLeft = 0;
+
+	return ERR_MP3_NONE;
+}
+
+/**************************************************************************************
+ * Function:    MP3SetDecodeConfig
+ *
+ * Description: set the low-power decode options of a decoder instance
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              pointer to MP3DecodeConfig struct
+ *
+ * Outputs:     none
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       with monoDownmix a stereo stream decodes to one channel of (L + R) / 2,
+ *                MP3GetLastFrameInfo reports nChans = 1 and the output holds half as
+ *                many samples; granules whose channels use the same block type are summed
+ *                before the IMDCT, the others are summed after it (exact either way)
+ *              nSubbands = 1 to 31 zeroes everything above the lowest nSubbands subbands
+ *                before the IMDCT, 0 (or 32) keeps the full bandwidth
+ *              monoDownmix takes effect with the next frame, nSubbands with the next granule
+ **************************************************************************************/
+int MP3SetDecodeConfig(HMP3Decoder hMP3Decoder, const MP3DecodeConfig *mp3DecodeConfig)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo || !mp3DecodeConfig || mp3DecodeConfig->nSubbands < 0)
+		return ERR_MP3_NULL_POINTER;
+
+	mp3DecInfo->monoDownmix = (mp3DecodeConfig->monoDownmix ? 1 : 0);
+	mp3DecInfo->nSubbands = (mp3DecodeConfig->nSubbands < 32 ? mp3DecodeConfig->nSubbands : 0);	/* 32 = NBANDS */
+
+	return ERR_MP3_NONE;
+}
+
+#if HELIX_LEVELS
+/**************************************************************************************
+ * Function:    MP3GetLevels
+ *
+ * Description: copy the levels of the most recently decoded granule
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              pointer to MP3LevelInfo struct
+ *
+ * Outputs:     filled-in MP3LevelInfo struct
+ *
+ * Return:      1 if a complete snapshot was copied, 0 if there is none yet or the decoder
+ *                updated it while it was being copied (keep showing the last one)
+ *
+ * Notes:       lock-free, may be called from another thread or interrupt than the one
+ *                decoding; the decoder never waits for the reader
+ *              the snapshot is of the granule just decoded, which plays out later by
+ *                however much PCM the caller has queued
+ **************************************************************************************/
+int MP3GetLevels(HMP3Decoder hMP3Decoder, MP3LevelInfo *mp3LevelInfo)
+{
+	int i;
+	unsigned int seq;
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo || !mp3LevelInfo)
+		return 0;
+
+	seq = mp3DecInfo->levelSeq;
+	if ((seq & 0x01) || mp3DecInfo->levels.granule == 0)
+		return 0;
+
+	mp3LevelInfo->granule = mp3DecInfo->levels.granule;
+	mp3LevelInfo->nChans = mp3DecInfo->levels.nChans;
+	for (i = 0; i < MP3_LEVEL_BANDS; i++)
+		mp3LevelInfo->bandPower[i] = mp3DecInfo->levels.bandPower[i];
+	for (i = 0; i < MAX_NCHAN; i++) {
+		mp3LevelInfo->power[i] = mp3DecInfo->levels.power[i];
+		mp3LevelInfo->peak[i] = mp3DecInfo->levels.peak[i];
+	}
+
+	return (mp3DecInfo->levelSeq == seq);
+}
+#endif
+
+/**************************************************************************************
+ * Function:    MP3GetRingHold
+ *
+ * Description: find the oldest ring byte the next frame may still read from its bit reservoir
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *
+ * Outputs:     none
+ *
+ * Return:      pointer into the ring, 0 if nothing before *inbuf is needed (or linear input)
+ *
+ * Notes:       call after MP3Decode or MP3DecodeGranule, the caller may refill the ring up
+ *                to (not including) this byte
+ *              while MP3DecodeGranule has granules left this also covers the main data
+ *                of the current frame
+ **************************************************************************************/
+unsigned char *MP3GetRingHold(HMP3Decoder hMP3Decoder)
+{
+	int run, nKeep, nMain;
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo || !mp3DecInfo->ringBuf || mp3DecInfo->nRuns == 0)
+		return 0;
+
+	nKeep = mp3DecInfo->mainDataBytes;
+	if (nKeep > MAX_MAINDATABEGIN)
+		nKeep = MAX_MAINDATABEGIN;
+
+	/* between granules of a frame, the rest of its main data is still to be read */
+	if (mp3DecInfo->nGransLeft > 0) {
+		nMain = (int)(mp3DecInfo->mainCursor.end - mp3DecInfo->mainCursor.ptr);
+		for (run = mp3DecInfo->mainCursor.run; run != mp3DecInfo->mainCursor.lastRun; ) {
+			run = (run + 1) & (MAX_MAINRUNS - 1);
+			nMain += mp3DecInfo->mainRuns[run].len;
+		}
+		if (nKeep < nMain)
+			nKeep = nMain;
+	}
+	if (nKeep <= 0)
+		return 0;
+
+	/* walk back from the newest run */
+	run = (mp3DecInfo->firstRun + mp3DecInfo->nRuns - 1) & (MAX_MAINRUNS - 1);
+	while (nKeep > mp3DecInfo->mainRuns[run].len && run != mp3DecInfo->firstRun) {
+		nKeep -= mp3DecInfo->mainRuns[run].len;
+		run = (run - 1) & (MAX_MAINRUNS - 1);
+	}
+	if (nKeep > mp3DecInfo->mainRuns[run].len)
+		return mp3DecInfo->mainRuns[run].ptr;
+
+	return mp3DecInfo->mainRuns[run].ptr + mp3DecInfo->mainRuns[run].len - nKeep;
+}
+
+/**************************************************************************************
+ * Function:    RingAdvance
+ *
+ * Description: move a pointer forward in the input ring
+ *
+ * Inputs:      MP3DecInfo struct in ring mode
+ *              pointer into the ring (or its guard)
+ *              number of bytes to move
+ *
+ * Outputs:     none
+ *
+ * Return:      the new pointer, wrapped back into the ring
+ **************************************************************************************/
+static unsigned char *RingAdvance(MP3DecInfo *mp3DecInfo, unsigned char *buf, int nBytes)
+{
+	buf += nBytes;
+	if (buf >= mp3DecInfo->ringBuf + mp3DecInfo->ringSize)
+		buf -= mp3DecInfo->ringSize;
+
+	return buf;
+}
+
+/**************************************************************************************
+ * Function:    TrimMainData
+ *
+ * Description: forget the oldest main data runs in ring mode
+ *
+ * Inputs:      MP3DecInfo struct in ring mode
+ *              number of newest bytes which must stay reachable
+ *
+ * Outputs:     updated run FIFO
+ *
+ * Return:      none
+ **************************************************************************************/
+static void TrimMainData(MP3DecInfo *mp3DecInfo, int nKeep)
+{
+	while (mp3DecInfo->nRuns > 0 && mp3DecInfo->runBytes - mp3DecInfo->mainRuns[mp3DecInfo->firstRun].len >= nKeep) {
+		mp3DecInfo->runBytes -= mp3DecInfo->mainRuns[mp3DecInfo->firstRun].len;
+		mp3DecInfo->firstRun = (mp3DecInfo->firstRun + 1) & (MAX_MAINRUNS - 1);
+		mp3DecInfo->nRuns--;
+	}
+}
+
+/**************************************************************************************
+ * Function:    AppendMainData
+ *
+ * Description: remember the main data of one frame in ring mode, without copying it
+ *
+ * Inputs:      MP3DecInfo struct in ring mode
+ *              pointer to the first main data byte in the ring
+ *              number of main data bytes (may wrap around the end of the ring)
+ *
+ * Outputs:     one or two runs added to the run FIFO (oldest run dropped if it is full)
+ *
+ * Return:      none
+ **************************************************************************************/
+static void AppendMainData(MP3DecInfo *mp3DecInfo, unsigned char *buf, int nBytes)
+{
+	int len;
+	MainDataRun *run;
+
+	while (nBytes > 0) {
+		len = (int)(mp3DecInfo->ringBuf + mp3DecInfo->ringSize - buf);
+		if (len > nBytes)
+			len = nBytes;
+		if (mp3DecInfo->nRuns == MAX_MAINRUNS)
+			TrimMainData(mp3DecInfo, mp3DecInfo->runBytes - mp3DecInfo->mainRuns[mp3DecInfo->firstRun].len);
+
+		run = &mp3DecInfo->mainRuns[(mp3DecInfo->firstRun + mp3DecInfo->nRuns) & (MAX_MAINRUNS - 1)];
+		run->ptr = buf;
+		run->len = len;
+		mp3DecInfo->nRuns++;
+		mp3DecInfo->runBytes += len;
+
+		buf = RingAdvance(mp3DecInfo, buf, len);
+		nBytes -= len;
+	}
+}
+
+/**************************************************************************************
+ * Function:    SeekMainData
+ *
+ * Description: point a cursor into the main data runs in ring mode
+ *
+ * Inputs:      MP3DecInfo struct in ring mode
+ *              number of bytes back from the end of the newest run (<= runBytes)
+ *
+ * Outputs:     cursor reading from that byte up to the end of the newest run
+ *
+ * Return:      none
+ **************************************************************************************/
+static void SeekMainData(MP3DecInfo *mp3DecInfo, MainDataCursor *mc, int nBytes)
+{
+	int run;
+
+	mc->runs = mp3DecInfo->mainRuns;
+	if (mp3DecInfo->nRuns == 0) {
+		mc->run = mc->lastRun = 0;
+		mc->ptr = mc->end = mp3DecInfo->ringBuf;
+		return;
+	}
+
+	mc->lastRun = (mp3DecInfo->firstRun + mp3DecInfo->nRuns - 1) & (MAX_MAINRUNS - 1);
+	run = mc->lastRun;
+	while (nBytes > mp3DecInfo->mainRuns[run].len && run != mp3DecInfo->firstRun) {
+		nBytes -= mp3DecInfo->mainRuns[run].len;
+		run = (run - 1) & (MAX_MAINRUNS - 1);
+	}
+	mc->run = run;
+	mc->end = mp3DecInfo->mainRuns[run].ptr + mp3DecInfo->mainRuns[run].len;
+	mc->ptr = mc->end - nBytes;
+}
+
 /**************************************************************************************
  * Function:    MP3GetLastFrameInfo
  *
@@ -195,10 +643,10 @@ void MP3GetLastFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo)
 		mp3FrameInfo->version = 0;
 	} else {
 		mp3FrameInfo->bitrate = mp3DecInfo->bitrate;
-		mp3FrameInfo->nChans = mp3DecInfo->nChans;
+		mp3FrameInfo->nChans = mp3DecInfo->nOutChans;
 		mp3FrameInfo->samprate = mp3DecInfo->samprate;
 		mp3FrameInfo->bitsPerSample = 16;
-		mp3FrameInfo->outputSamps = mp3DecInfo->nChans * (int)samplesPerFrameTab[mp3DecInfo->version][mp3DecInfo->layer - 1];
+		mp3FrameInfo->outputSamps = mp3DecInfo->nOutChans * (int)samplesPerFrameTab[mp3DecInfo->version][mp3DecInfo->layer - 1];
 		mp3FrameInfo->layer = mp3DecInfo->layer;
 		mp3FrameInfo->version = mp3DecInfo->version;
 	}
@@ -233,6 +681,54 @@ int MP3GetNextFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo, uns
 	return ERR_MP3_NONE;
 }
 
+#if HELIX_PROFILE
+/**************************************************************************************
+ * Function:    MP3GetProfileInfo
+ *
+ * Description: get accumulated per-stage cycle counts
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              pointer to MP3ProfileInfo struct
+ *
+ * Outputs:     filled-in MP3ProfileInfo struct
+ *
+ * Return:      none
+ *
+ * Notes:       stage counts include frames which failed partway through, nFrames,
+ *                totalCycles and maxFrameCycles only count frames decoded without error
+ **************************************************************************************/
+void MP3GetProfileInfo(HMP3Decoder hMP3Decoder, MP3ProfileInfo *mp3ProfileInfo)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo || !mp3ProfileInfo)
+		return;
+
+	*mp3ProfileInfo = mp3DecInfo->profile;
+}
+
+/**************************************************************************************
+ * Function:    MP3ClearProfileInfo
+ *
+ * Description: reset all profiling counters to 0
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **************************************************************************************/
+void MP3ClearProfileInfo(HMP3Decoder hMP3Decoder)
+{
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+
+	if (!mp3DecInfo)
+		return;
+
+	memset(&mp3DecInfo->profile, 0, sizeof(MP3ProfileInfo));
+}
+#endif
+
 /**************************************************************************************
  * Function:    MP3ClearBadFrame
  *
@@ -240,82 +736,98 @@ int MP3GetNextFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo, uns
  *
  * Inputs:      mp3DecInfo struct with correct frame size parameters filled in
  *              pointer pcm output buffer
+ *              number of granules the buffer holds
  *
  * Outputs:     zeroed out pcm buffer
  *
  * Return:      none
  **************************************************************************************/
-static void MP3ClearBadFrame(MP3DecInfo *mp3DecInfo, short *outbuf)
+static void MP3ClearBadFrame(MP3DecInfo *mp3DecInfo, short *outbuf, int nGrans)
 {
 	int i;
 
 	if (!mp3DecInfo)
 		return;
 
-	for (i = 0; i < mp3DecInfo->nGrans * mp3DecInfo->nGranSamps * mp3DecInfo->nChans; i++)
+	for (i = 0; i < nGrans * mp3DecInfo->nGranSamps * mp3DecInfo->nOutChans; i++)
 		outbuf[i] = 0;
 }
 
 /**************************************************************************************
- * Function:    MP3Decode
+ * Function:    DecodeFrameStart
  *
- * Description: decode one frame of MP3 data
+ * Description: unpack the header and side info of one frame and gather its main data
  *
- * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ * Inputs:      MP3DecInfo struct
  *              double pointer to buffer of MP3 data (containing headers + mainData)
  *              number of valid bytes remaining in inbuf
- *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
- *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
- *                or reformatted as "self-contained" frames (useSize = 1)
+ *              pointer to outbuf, cleared on error
+ *              number of granules outbuf holds (nGrans for MP3Decode, 1 for MP3DecodeGranule)
+ *              useSize flag (see MP3Decode)
  *
- * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
- *                number of output samples = nGrans * nGranSamps * nChans
- *              updated inbuf pointer, updated bytesLeft
+ * Outputs:     updated inbuf pointer, updated bytesLeft
+ *              main data cursor in mp3DecInfo, ready for DecodeGranule on every granule
  *
  * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
  *
- * Notes:       switching useSize on and off between frames in the same stream 
- *                is not supported (bit reservoir is not maintained if useSize on)
+ * Notes:       outbuf is left alone if the frame header is invalid (size not known)
  **************************************************************************************/
-int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize)
+static int DecodeFrameStart(MP3DecInfo *mp3DecInfo, unsigned char **inbuf, int *bytesLeft, short *outbuf, int outGrans, int useSize)
 {
-	int offset, bitOffset, mainBits, gr, ch, fhBytes, siBytes, freeFrameBytes;
-	int prevBitOffset, sfBlockBits, huffBlockBits;
-	unsigned char *mainPtr;
-	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+	int fhBytes, siBytes, freeFrameBytes, nFree, nClear;
+	unsigned char *frameStart;
+	MainDataCursor *mc = &mp3DecInfo->mainCursor;
+#if HELIX_PROFILE
+	unsigned int profStart;
+#endif
 
-	if (!mp3DecInfo)
-		return ERR_MP3_NULL_POINTER;
+	mp3DecInfo->nGransLeft = 0;
 
 	/* unpack frame header */
+	frameStart = *inbuf;
+	PROFILE_BEGIN();
 	fhBytes = UnpackFrameHeader(mp3DecInfo, *inbuf);
+	PROFILE_END(mp3DecInfo, MP3_STAGE_FRAMEHEADER);
 	if (fhBytes < 0)	
 		return ERR_MP3_INVALID_FRAMEHEADER;		/* don't clear outbuf since we don't know size (failed to parse header) */
 	*inbuf += fhBytes;
+	nClear = (outGrans < mp3DecInfo->nGrans ? outGrans : mp3DecInfo->nGrans);
 	
-	/* unpack side info */
+	/* unpack side info (in ring mode the guard makes header + side info contiguous) */
+	PROFILE_BEGIN();
 	siBytes = UnpackSideInfo(mp3DecInfo, *inbuf);
+	PROFILE_END(mp3DecInfo, MP3_STAGE_SIDEINFO);
 	if (siBytes < 0) {
-		MP3ClearBadFrame(mp3DecInfo, outbuf);
+		MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
 		return ERR_MP3_INVALID_SIDEINFO;
 	}
 	*inbuf += siBytes;
 	*bytesLeft -= (fhBytes + siBytes);
+	if (mp3DecInfo->ringBuf)
+		*inbuf = RingAdvance(mp3DecInfo, *inbuf, 0);
 	
-	/* if free mode, need to calculate bitrate and nSlots manually, based on frame size */
-	if (mp3DecInfo->bitrate == 0 || mp3DecInfo->freeBitrateFlag) {
+	/* if free mode, need to calculate bitrate and nSlots manually, based on frame size
+	 *  - decided by this frame's bitrate index, so a single corrupt header with index 0 in a
+	 *      normal stream does not leave the rest of the stream in free mode
+	 */
+	if ((frameStart[2] >> 4) == 0) {
 		if (!mp3DecInfo->freeBitrateFlag) {
 			/* first time through, need to scan for next sync word and figure out frame size */
-			mp3DecInfo->freeBitrateFlag = 1;
-			mp3DecInfo->freeBitrateSlots = MP3FindFreeSync(*inbuf, *inbuf - fhBytes - siBytes, *bytesLeft);
+			nFree = *bytesLeft;
+			if (mp3DecInfo->ringBuf && nFree > mp3DecInfo->ringBuf + mp3DecInfo->ringSize - *inbuf)
+				nFree = (int)(mp3DecInfo->ringBuf + mp3DecInfo->ringSize - *inbuf);	/* only search up to the end of the ring */
+			mp3DecInfo->freeBitrateSlots = MP3FindFreeSync(*inbuf, frameStart, nFree);
 			if (mp3DecInfo->freeBitrateSlots < 0) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
+				MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
 				return ERR_MP3_FREE_BITRATE_SYNC;
 			}
+			mp3DecInfo->freeBitrateFlag = 1;
 			freeFrameBytes = mp3DecInfo->freeBitrateSlots + fhBytes + siBytes;
 			mp3DecInfo->bitrate = (freeFrameBytes * mp3DecInfo->samprate * 8) / (mp3DecInfo->nGrans * mp3DecInfo->nGranSamps);
 		}
 		mp3DecInfo->nSlots = mp3DecInfo->freeBitrateSlots + CheckPadBit(mp3DecInfo);	/* add pad byte, if required */
+	} else {
+		mp3DecInfo->freeBitrateFlag = 0;
 	}
 
 	/* useSize != 0 means we're getting reformatted (RTP) packets (see RFC 3119)
@@ -328,19 +840,53 @@ int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, sh
 		mp3DecInfo->nSlots = *bytesLeft;
 		if (mp3DecInfo->mainDataBegin != 0 || mp3DecInfo->nSlots <= 0) {
 			/* error - non self-contained frame, or missing frame (size <= 0), could do loss concealment here */
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
+			MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
 			return ERR_MP3_INVALID_FRAMEHEADER;
 		}
 
 		/* can operate in-place on reformatted frames */
 		mp3DecInfo->mainDataBytes = mp3DecInfo->nSlots;
-		mainPtr = *inbuf;
-		*inbuf += mp3DecInfo->nSlots;
+		if (mp3DecInfo->ringBuf) {
+			TrimMainData(mp3DecInfo, 0);
+			AppendMainData(mp3DecInfo, *inbuf, mp3DecInfo->nSlots);
+			SeekMainData(mp3DecInfo, mc, mp3DecInfo->nSlots);
+			*inbuf = RingAdvance(mp3DecInfo, *inbuf, mp3DecInfo->nSlots);
+		} else {
+			mp3DecInfo->linearRun.ptr = *inbuf;
+			mp3DecInfo->linearRun.len = *bytesLeft;
+			mc->runs = &mp3DecInfo->linearRun;
+			mc->run = mc->lastRun = 0;
+			mc->ptr = mp3DecInfo->linearRun.ptr;
+			mc->end = mp3DecInfo->linearRun.ptr + mp3DecInfo->linearRun.len;
+			*inbuf += mp3DecInfo->nSlots;
+		}
+		*bytesLeft -= (mp3DecInfo->nSlots);
+	} else if (mp3DecInfo->ringBuf) {
+		/* out of data - assume last or truncated frame */
+		if (mp3DecInfo->nSlots > *bytesLeft) {
+			MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
+			return ERR_MP3_INDATA_UNDERFLOW;	
+		}
+		/* leave main data in the ring, only keep track of where the bit reservoir lies */
+		TrimMainData(mp3DecInfo, mp3DecInfo->mainDataBytes < MAX_MAINDATABEGIN ? mp3DecInfo->mainDataBytes : MAX_MAINDATABEGIN);
+		AppendMainData(mp3DecInfo, *inbuf, mp3DecInfo->nSlots);
+		*inbuf = RingAdvance(mp3DecInfo, *inbuf, mp3DecInfo->nSlots);
 		*bytesLeft -= (mp3DecInfo->nSlots);
+		if (mp3DecInfo->mainDataBytes >= mp3DecInfo->mainDataBegin && 
+			mp3DecInfo->runBytes - mp3DecInfo->nSlots >= mp3DecInfo->mainDataBegin) {
+			/* adequate "old" main data available (i.e. bit reservoir) */
+			mp3DecInfo->mainDataBytes = mp3DecInfo->mainDataBegin + mp3DecInfo->nSlots;
+			SeekMainData(mp3DecInfo, mc, mp3DecInfo->mainDataBytes);
+		} else {
+			/* not enough data in bit reservoir from previous frames (perhaps starting in middle of file) */
+			mp3DecInfo->mainDataBytes += mp3DecInfo->nSlots;
+			MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
+			return ERR_MP3_MAINDATA_UNDERFLOW;
+		}
 	} else {
 		/* out of data - assume last or truncated frame */
 		if (mp3DecInfo->nSlots > *bytesLeft) {
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
+			MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
 			return ERR_MP3_INDATA_UNDERFLOW;	
 		}
 		/* fill main data buffer with enough new data for this frame */
@@ -352,66 +898,264 @@ int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, sh
 			mp3DecInfo->mainDataBytes = mp3DecInfo->mainDataBegin + mp3DecInfo->nSlots;
 			*inbuf += mp3DecInfo->nSlots;
 			*bytesLeft -= (mp3DecInfo->nSlots);
-			mainPtr = mp3DecInfo->mainBuf;
+			mp3DecInfo->linearRun.ptr = mp3DecInfo->mainBuf;
+			mp3DecInfo->linearRun.len = MAINBUF_SIZE;
+			mc->runs = &mp3DecInfo->linearRun;
+			mc->run = mc->lastRun = 0;
+			mc->ptr = mp3DecInfo->linearRun.ptr;
+			mc->end = mp3DecInfo->linearRun.ptr + mp3DecInfo->linearRun.len;
 		} else {
 			/* not enough data in bit reservoir from previous frames (perhaps starting in middle of file) */
 			memcpy(mp3DecInfo->mainBuf + mp3DecInfo->mainDataBytes, *inbuf, mp3DecInfo->nSlots);
 			mp3DecInfo->mainDataBytes += mp3DecInfo->nSlots;
 			*inbuf += mp3DecInfo->nSlots;
 			*bytesLeft -= (mp3DecInfo->nSlots);
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
+			MP3ClearBadFrame(mp3DecInfo, outbuf, nClear);
 			return ERR_MP3_MAINDATA_UNDERFLOW;
 		}
 	}
-	bitOffset = 0;
-	mainBits = mp3DecInfo->mainDataBytes * 8;
+	mp3DecInfo->mainBitOffset = 0;
+	mp3DecInfo->mainBitsLeft = mp3DecInfo->mainDataBytes * 8;
+	mp3DecInfo->granule = 0;
+	mp3DecInfo->nGransLeft = mp3DecInfo->nGrans;
+
+	return ERR_MP3_NONE;
+}
+
+/**************************************************************************************
+ * Function:    DecodeGranule
+ *
+ * Description: decode the next granule of the frame set up by DecodeFrameStart
+ *
+ * Inputs:      MP3DecInfo struct with a granule left to decode
+ *              pointer to outbuf, big enough to hold one granule of decoded PCM samples
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *                number of output samples = nGranSamps * nOutChans
+ *              main data cursor moved on to the next granule
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       on error the rest of the frame is dropped, outbuf is not cleared
+ **************************************************************************************/
+static int DecodeGranule(MP3DecInfo *mp3DecInfo, short *outbuf)
+{
+	int offset, bitOffset, mainBits, gr, ch, nChansIMDCT;
+	int prevBitOffset, sfBlockBits, huffBlockBits;
+	MainDataCursor *mc = &mp3DecInfo->mainCursor;
+#if HELIX_PROFILE
+	unsigned int profStart;
+#endif
+
+	gr = mp3DecInfo->granule;
+	bitOffset = mp3DecInfo->mainBitOffset;
+	mainBits = mp3DecInfo->mainBitsLeft;
+	mp3DecInfo->nGransLeft = 0;		/* until this granule has made it */
+
+	for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
+		/* unpack scale factors and compute size of scale factor block */
+		prevBitOffset = bitOffset;
+		PROFILE_BEGIN();
+		offset = UnpackScaleFactors(mp3DecInfo, mc, &bitOffset, mainBits, gr, ch);
+		PROFILE_END(mp3DecInfo, MP3_STAGE_SCALEFACT);
+
+		sfBlockBits = 8*offset - prevBitOffset + bitOffset;
+		huffBlockBits = mp3DecInfo->part23Length[gr][ch] - sfBlockBits;
+		mainBits -= sfBlockBits;
+
+		if (offset < 0 || mainBits < huffBlockBits)
+			return ERR_MP3_INVALID_SCALEFACT;
+		SkipMainData(mc, offset);
+
+		/* decode Huffman code words */
+		prevBitOffset = bitOffset;
+		PROFILE_BEGIN();
+		offset = DecodeHuffman(mp3DecInfo, mc, &bitOffset, huffBlockBits, gr, ch);
+		PROFILE_END(mp3DecInfo, MP3_STAGE_HUFFMAN);
+		if (offset < 0)
+			return ERR_MP3_INVALID_HUFFCODES;
+
+		SkipMainData(mc, offset);
+		mainBits -= (8*offset - prevBitOffset + bitOffset);
+	}
+	/* dequantize coefficients, decode stereo, reorder short blocks */
+	PROFILE_BEGIN();
+	if (Dequantize(mp3DecInfo, gr) < 0)
+		return ERR_MP3_INVALID_DEQUANTIZE;			
+	PROFILE_END(mp3DecInfo, MP3_STAGE_DEQUANT);
+
+	/* alias reduction, inverse MDCT, overlap-add, frequency inversion
+	 *   (low-power options: drop the upper subbands, transform the mono downmix where possible)
+	 */
+	PROFILE_BEGIN();
+	LimitBandwidth(mp3DecInfo);
+	nChansIMDCT = DownmixSpectrum(mp3DecInfo, gr);
+	for (ch = 0; ch < nChansIMDCT; ch++)
+		if (IMDCT(mp3DecInfo, gr, ch) < 0)
+			return ERR_MP3_INVALID_IMDCT;			
+	if (nChansIMDCT > mp3DecInfo->nOutChans)
+		DownmixIMDCT(mp3DecInfo);
+	PROFILE_END(mp3DecInfo, MP3_STAGE_IMDCT);
+
+	/* subband transform - if stereo, interleaves pcm LRLRLR */
+	PROFILE_BEGIN();
+#if HELIX_LEVELS
+	MeasureBands(mp3DecInfo);
+#endif
+	if (Subband(mp3DecInfo, outbuf) < 0)
+		return ERR_MP3_INVALID_SUBBAND;			
+#if HELIX_LEVELS
+	MeasureOutput(mp3DecInfo, outbuf);
+#endif
+	PROFILE_END(mp3DecInfo, MP3_STAGE_SUBBAND);
+
+	mp3DecInfo->mainBitOffset = bitOffset;
+	mp3DecInfo->mainBitsLeft = mainBits;
+	mp3DecInfo->granule = gr + 1;
+	mp3DecInfo->nGransLeft = mp3DecInfo->nGrans - (gr + 1);
+
+	return ERR_MP3_NONE;
+}
+
+/**************************************************************************************
+ * Function:    MP3Decode
+ *
+ * Description: decode one frame of MP3 data
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              double pointer to buffer of MP3 data (containing headers + mainData)
+ *              number of valid bytes remaining in inbuf
+ *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
+ *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
+ *                or reformatted as "self-contained" frames (useSize = 1)
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *                number of output samples = nGrans * nGranSamps * nOutChans
+ *              updated inbuf pointer, updated bytesLeft
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       switching useSize on and off between frames in the same stream 
+ *                is not supported (bit reservoir is not maintained if useSize on)
+ *              with ring input (see MP3SetRingInput) *inbuf wraps around the ring and
+ *                main data is decoded in place, otherwise it is copied into mainBuf
+ *              drops what is left of a frame MP3DecodeGranule was working on
+ **************************************************************************************/
+int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize)
+{
+	int gr, err;
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+#if HELIX_PROFILE
+	unsigned int decodeStart, frameCycles;
+
+	decodeStart = MP3ProfileGetCycles();
+#endif
+
+	if (!mp3DecInfo || !mp3DecInfo->SubbandInfoPS)
+		return ERR_MP3_NULL_POINTER;
+
+	err = DecodeFrameStart(mp3DecInfo, inbuf, bytesLeft, outbuf, MAX_NGRAN, useSize);
+	if (err)
+		return err;
 
 	/* decode one complete frame */
 	for (gr = 0; gr < mp3DecInfo->nGrans; gr++) {
-		for (ch = 0; ch < mp3DecInfo->nChans; ch++) {
-			/* unpack scale factors and compute size of scale factor block */
-			prevBitOffset = bitOffset;
-			offset = UnpackScaleFactors(mp3DecInfo, mainPtr, &bitOffset, mainBits, gr, ch);
-
-			sfBlockBits = 8*offset - prevBitOffset + bitOffset;
-			huffBlockBits = mp3DecInfo->part23Length[gr][ch] - sfBlockBits;
-			mainPtr += offset;
-			mainBits -= sfBlockBits;
-
-			if (offset < 0 || mainBits < huffBlockBits) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
-				return ERR_MP3_INVALID_SCALEFACT;
-			}
+		err = DecodeGranule(mp3DecInfo, outbuf + gr*mp3DecInfo->nGranSamps*mp3DecInfo->nOutChans);
+		if (err) {
+			MP3ClearBadFrame(mp3DecInfo, outbuf, mp3DecInfo->nGrans);
+			return err;
+		}
+	}
 
-			/* decode Huffman code words */
-			prevBitOffset = bitOffset;
-			offset = DecodeHuffman(mp3DecInfo, mainPtr, &bitOffset, huffBlockBits, gr, ch);
-			if (offset < 0) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
-				return ERR_MP3_INVALID_HUFFCODES;
-			}
+#if HELIX_PROFILE
+	frameCycles = MP3ProfileGetCycles() - decodeStart;
+	mp3DecInfo->profile.nFrames++;
+	mp3DecInfo->profile.totalCycles += frameCycles;
+	mp3DecInfo->profile.lastFrameCycles = frameCycles;
+	if (frameCycles > mp3DecInfo->profile.maxFrameCycles)
+		mp3DecInfo->profile.maxFrameCycles = frameCycles;
+#endif
 
-			mainPtr += offset;
-			mainBits -= (8*offset - prevBitOffset + bitOffset);
-		}
-		/* dequantize coefficients, decode stereo, reorder short blocks */
-		if (Dequantize(mp3DecInfo, gr) < 0) {
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
-			return ERR_MP3_INVALID_DEQUANTIZE;			
-		}
+	return ERR_MP3_NONE;
+}
 
-		/* alias reduction, inverse MDCT, overlap-add, frequency inversion */
-		for (ch = 0; ch < mp3DecInfo->nChans; ch++)
-			if (IMDCT(mp3DecInfo, gr, ch) < 0) {
-				MP3ClearBadFrame(mp3DecInfo, outbuf);
-				return ERR_MP3_INVALID_IMDCT;			
-			}
+/**************************************************************************************
+ * Function:    MP3DecodeGranule
+ *
+ * Description: decode MP3 data one granule (576 samples per channel) at a time
+ *
+ * Inputs:      valid MP3 decoder instance pointer (HMP3Decoder)
+ *              double pointer to buffer of MP3 data (containing headers + mainData)
+ *              number of valid bytes remaining in inbuf
+ *              pointer to outbuf, big enough to hold one granule of decoded PCM samples
+ *                (MAX_NSAMP * MAX_NCHAN)
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *              number of output samples in outbuf (nGranSamps * nOutChans, 0 if the frame
+ *                header is invalid)
+ *              number of granules of the current frame still to decode
+ *              updated inbuf pointer, updated bytesLeft
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       with no granules left, takes the frame at *inbuf (as MP3Decode) and
+ *                decodes its first granule
+ *              while granules are left, decodes the next one of the same frame and
+ *                leaves inbuf and bytesLeft alone
+ *              the main data of the frame stays in use until its last granule: with ring
+ *                input MP3GetRingHold covers it, with linear input it has been copied
+ *              on error outbuf is zeroed and the rest of the frame is dropped
+ *              an MPEG-1 frame has 2 granules, MPEG-2 and MPEG-2.5 frames have 1
+ **************************************************************************************/
+int MP3DecodeGranule(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int *outputSamps, int *granulesLeft)
+{
+	int err;
+	MP3DecInfo *mp3DecInfo = (MP3DecInfo *)hMP3Decoder;
+#if HELIX_PROFILE
+	unsigned int decodeStart, granCycles;
+
+	decodeStart = MP3ProfileGetCycles();
+#endif
+
+	*outputSamps = 0;
+	*granulesLeft = 0;
+	if (!mp3DecInfo || !mp3DecInfo->SubbandInfoPS)
+		return ERR_MP3_NULL_POINTER;
 
-		/* subband transform - if stereo, interleaves pcm LRLRLR */
-		if (Subband(mp3DecInfo, outbuf + gr*mp3DecInfo->nGranSamps*mp3DecInfo->nChans) < 0) {
-			MP3ClearBadFrame(mp3DecInfo, outbuf);
-			return ERR_MP3_INVALID_SUBBAND;			
+	if (mp3DecInfo->nGransLeft == 0) {
+#if HELIX_PROFILE
+		mp3DecInfo->frameCycles = 0;
+#endif
+		err = DecodeFrameStart(mp3DecInfo, inbuf, bytesLeft, outbuf, 1, 0);
+		if (err == ERR_MP3_INVALID_FRAMEHEADER)
+			return err;
+		if (err) {
+			*outputSamps = mp3DecInfo->nGranSamps * mp3DecInfo->nOutChans;
+			return err;
 		}
 	}
+
+	err = DecodeGranule(mp3DecInfo, outbuf);
+	*outputSamps = mp3DecInfo->nGranSamps * mp3DecInfo->nOutChans;
+	if (err) {
+		MP3ClearBadFrame(mp3DecInfo, outbuf, 1);
+		return err;
+	}
+	*granulesLeft = mp3DecInfo->nGransLeft;
+
+#if HELIX_PROFILE
+	granCycles = MP3ProfileGetCycles() - decodeStart;
+	mp3DecInfo->frameCycles += granCycles;
+	if (granCycles > mp3DecInfo->profile.maxGranuleCycles)
+		mp3DecInfo->profile.maxGranuleCycles = granCycles;
+	if (mp3DecInfo->nGransLeft == 0) {
+		mp3DecInfo->profile.nFrames++;
+		mp3DecInfo->profile.totalCycles += mp3DecInfo->frameCycles;
+		mp3DecInfo->profile.lastFrameCycles = mp3DecInfo->frameCycles;
+		if (mp3DecInfo->frameCycles > mp3DecInfo->profile.maxFrameCycles)
+			mp3DecInfo->profile.maxFrameCycles = mp3DecInfo->frameCycles;
+	}
+#endif
+
 	return ERR_MP3_NONE;
 }
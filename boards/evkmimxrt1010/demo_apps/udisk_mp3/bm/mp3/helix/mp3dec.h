@@ -46,8 +46,10 @@
 
 // Must be moved KJ
 //#define __GNUC__
+#if defined(__arm__) || defined(__ICCARM__) || defined(__CC_ARM) || defined(__ARM_ARCH)
 #define ARM
 #define ARM_ADS
+#endif
 
 #if defined(_WIN32) && !defined(_WIN32_WCE)
 #
@@ -63,12 +65,74 @@
 #
 #elif defined(__GNUC__) && defined(__i386__)
 #
+#elif defined(__GNUC__)		/* host builds, e.g. x86-64 Linux (see ../host) */
+#
 #elif defined(_OPENWAVE_SIMULATOR) || defined(_OPENWAVE_ARMULATOR)
 #
 #else
 #error No platform defined. See valid options in mp3dec.h
 #endif
 
+/* build options (override on the compiler command line if desired)
+ *   HELIX_PROFILE - accumulate per-stage cycle counts in MP3Decode and MP3DecodeGranule
+ *                   (see MP3GetProfileInfo)
+ *   HELIX_DSP_KERNELS - 1 = inline Cortex-M DSP kernels (SMULL, SMLAL, SSAT, CLZ) for the
+ *                         assembly.h helpers and the polyphase filter in polyphase.c, through
+ *                         the CMSIS-Core intrinsics; default where the core has the DSP extension
+ *                       0 = reference build, on ARM the helpers and polyphase filter come from
+ *                         arm/hylix_mp3_asm.a as out-of-line calls, elsewhere from the portable C
+ *                         in assembly.h and polyphase.c
+ *   HELIX_DQ_KERNELS - 1 = dequantizer and joint stereo loops take coefficients in pairs, skip
+ *                        all-zero pairs and stop at nonZeroBound (same output, bit for bit)
+ *                      0 = reference loops, one coefficient per pass over whole bands
+ *   HELIX_HUFF_FAST_BITS - 0 = Huffman pairs walk the chained tables of hufftabs.c, cache
+ *                            refilled 16 bits at a time
+ *                          7 to 12 = first HELIX_HUFF_FAST_BITS bits of the chained pair tables
+ *                            expanded into single lookup tables in RAM at MP3InitDecoder, cache
+ *                            kept topped up to a full word (RAM used: 7 = 768 bytes,
+ *                            8 = 2 KB, 9 = 9 KB, 10 = 19 KB, 11 = 33 KB, 12 = 49 KB)
+ *   HELIX_TCM_PLACEMENT - 1 = hot code, lookup tables and decoder state are tagged with the
+ *                           CodeQuickAccess, DataQuickAccess and StateQuickAccess sections
+ *                           (see HELIX_FAST_CODE in coder.h) so the linker file can pin them
+ *                           to ITCM/DTCM
+ *                         0 = everything goes where the toolchain puts it by default
+ *   HELIX_FLOAT_DSP - 0 = fixed-point back end: dequant.c, dqchan.c, stproc.c, imdct.c,
+ *                       dct32.c, subband.c and polyphase.c
+ *                     1 = single-precision float back end for dequantization, stereo
+ *                       processing, IMDCT and synthesis: dequantf.c, imdctf.c and subbandf.c,
+ *                       needs a hardware FPU; bitstream, side info, scale factors and Huffman
+ *                       decoding are shared with the fixed-point build
+ *   HELIX_LEVELS - 1 = every granule also leaves its subband powers and output peak/power
+ *                    in a snapshot for spectrum and level meters (see MP3GetLevels), from
+ *                    data the synthesis has at hand anyway
+ */
+#ifndef HELIX_PROFILE
+#define HELIX_PROFILE	0
+#endif
+#ifndef HELIX_DSP_KERNELS
+/* older IAR compilers only tell the core through __CORE__ */
+#if (defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP) || (defined(__ICCARM__) && defined(__ARM7EM__) && (__CORE__ == __ARM7EM__))
+#define HELIX_DSP_KERNELS	1
+#else
+#define HELIX_DSP_KERNELS	0
+#endif
+#endif
+#ifndef HELIX_DQ_KERNELS
+#define HELIX_DQ_KERNELS	1
+#endif
+#ifndef HELIX_HUFF_FAST_BITS
+#define HELIX_HUFF_FAST_BITS	8
+#endif
+#ifndef HELIX_TCM_PLACEMENT
+#define HELIX_TCM_PLACEMENT	1
+#endif
+#ifndef HELIX_FLOAT_DSP
+#define HELIX_FLOAT_DSP	0
+#endif
+#ifndef HELIX_LEVELS
+#define HELIX_LEVELS	0
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -80,6 +144,13 @@ extern "C" {
  */
 #define MAINBUF_SIZE	1940
 
+/* ring input (see MP3SetRingInput):
+ *   the ring storage must be ringSize + MP3_RING_GUARD bytes, and the caller mirrors the first
+ *   MP3_RING_GUARD bytes of the ring into the guard after the end, so a frame header and side info
+ *   (at most 4 + 2 + 32 = 38 bytes) starting anywhere in the ring can be parsed without wrapping
+ */
+#define MP3_RING_GUARD	64
+
 #define MAX_NGRAN		2		/* max granules */
 #define MAX_NCHAN		2		/* max channels */
 #define MAX_NSAMP		576		/* max samples per channel, per granule */
@@ -121,15 +192,77 @@ typedef struct _MP3FrameInfo {
 	int version;
 } MP3FrameInfo;
 
+/* low-power decode options (see MP3SetDecodeConfig) */
+typedef struct _MP3DecodeConfig {
+	int monoDownmix;	/* 1 = sum stereo to one channel ahead of the IMDCT, PCM output is mono */
+	int nSubbands;		/* transform only the lowest nSubbands of 32 (fs/64 wide each), 0 = all */
+} MP3DecodeConfig;
+
 /* public API */
 HMP3Decoder MP3InitDecoder(void);
+HMP3Decoder MP3InitDecoderInPlace(void *arena, int arenaSize);
+int MP3GetDecoderSize(int headerOnly);
 void MP3FreeDecoder(HMP3Decoder hMP3Decoder);
+int MP3ResetDecoder(HMP3Decoder hMP3Decoder);
 int MP3Decode(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int useSize);
+int MP3DecodeGranule(HMP3Decoder hMP3Decoder, unsigned char **inbuf, int *bytesLeft, short *outbuf, int *outputSamps, int *granulesLeft);
 
 void MP3GetLastFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo);
 int MP3GetNextFrameInfo(HMP3Decoder hMP3Decoder, MP3FrameInfo *mp3FrameInfo, unsigned char *buf);
 int MP3FindSyncWord(unsigned char *buf, int nBytes);
 
+int MP3SetRingInput(HMP3Decoder hMP3Decoder, unsigned char *ringBuf, int ringSize);
+unsigned char *MP3GetRingHold(HMP3Decoder hMP3Decoder);
+
+int MP3SetDecodeConfig(HMP3Decoder hMP3Decoder, const MP3DecodeConfig *mp3DecodeConfig);
+
+#if HELIX_LEVELS
+#define MP3_LEVEL_BANDS	32		/* one per subband, samprate / 64 wide each */
+
+/* levels of the most recent granule, in the units of the 16-bit output (full scale sine:
+ *   power = 2^29, peak = 32767)
+ */
+typedef struct _MP3LevelInfo {
+	unsigned int granule;						/* granules measured so far (0 = none yet) */
+	int nChans;									/* output channels measured */
+	unsigned int bandPower[MP3_LEVEL_BANDS];	/* mean square output from each subband before clipping, channels averaged */
+	unsigned int power[MAX_NCHAN];				/* mean square output of each channel */
+	unsigned int peak[MAX_NCHAN];				/* largest absolute output sample of each channel */
+} MP3LevelInfo;
+
+int MP3GetLevels(HMP3Decoder hMP3Decoder, MP3LevelInfo *mp3LevelInfo);
+#endif
+
+#if HELIX_PROFILE
+/* decoder stages timed by the profiler, in the order MP3Decode runs them */
+enum {
+	MP3_STAGE_FRAMEHEADER = 0,
+	MP3_STAGE_SIDEINFO,
+	MP3_STAGE_SCALEFACT,
+	MP3_STAGE_HUFFMAN,
+	MP3_STAGE_DEQUANT,
+	MP3_STAGE_IMDCT,
+	MP3_STAGE_SUBBAND,
+
+	MP3_NSTAGES
+};
+
+typedef struct _MP3ProfileInfo {
+	unsigned int nFrames;							/* frames decoded without error */
+	unsigned long long stageCycles[MP3_NSTAGES];	/* total cycles spent in each stage */
+	unsigned long long totalCycles;					/* total cycles in MP3Decode (stages + overhead) */
+	unsigned int lastFrameCycles;					/* cycles in MP3Decode for the most recent frame */
+	unsigned int maxFrameCycles;					/* worst-case frame */
+	unsigned int maxGranuleCycles;					/* worst-case MP3DecodeGranule call */
+} MP3ProfileInfo;
+
+void MP3GetProfileInfo(HMP3Decoder hMP3Decoder, MP3ProfileInfo *mp3ProfileInfo);
+void MP3ClearProfileInfo(HMP3Decoder hMP3Decoder);
+
+/* must be supplied by the platform - free-running 32-bit cycle counter (wraparound is ok) */
+unsigned int MP3ProfileGetCycles(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,11 +43,18 @@
  * This is the C reference version using __int64
  * Look in the appropriate subdirectories for optimized asm implementations 
  *   (e.g. arm/asmpoly.s)
+ *
+ * Built with HELIX_DSP_KERNELS, where MADD64 is an inline SMLAL and the output clip
+ *   is SSAT, and on hosts without the ARM assembly. Otherwise (ARM_ADS reference build)
+ *   PolyphaseMono/Stereo come from arm/hylix_mp3_asm.a
+ * Not built with HELIX_FLOAT_DSP, subbandf.c has its own float filter
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if (HELIX_DSP_KERNELS || !defined(ARM_ADS)) && !HELIX_FLOAT_DSP
+
 /* input to Polyphase = Q(DQ_FRACBITS_OUT-2), gain 2 bits in convolution
  *  we also have the implicit bias of 2^15 to add back, so net fraction bits = 
  *    DQ_FRACBITS_OUT - 2 - 2 - 15
@@ -58,6 +65,10 @@
 
 static __inline short ClipToShort(int x, int fracBits)
 {
+#ifdef SSAT16
+	/* assumes you've already rounded (x += (1 << (fracBits-1))), SSAT clips to [-32768, 32767] */
+	return (short)SSAT16(x >> fracBits);
+#else
 	int sign;
 	
 	/* assumes you've already rounded (x += (1 << (fracBits-1))) */
@@ -69,6 +80,7 @@ static __inline short ClipToShort(int x, int fracBits)
 		x = sign ^ ((1 << 15) - 1);
 
 	return (short)x;
+#endif
 }
 
 #define MC0M(x)	{ \
@@ -109,7 +121,7 @@ static __inline short ClipToShort(int x, int fracBits)
  * TODO:        add 32-bit version for platforms where 64-bit mul-acc is not supported
  *                (note max filter gain - see polyCoef[] comments)
  **************************************************************************************/
-void PolyphaseMono(short *pcm, int *vbuf, const int *coefBase)
+HELIX_FAST_CODE(void PolyphaseMono(short *pcm, int *vbuf, const int *coefBase))
 {	
 	int i;
 	const int *coef;
@@ -222,7 +234,7 @@ void PolyphaseMono(short *pcm, int *vbuf, const int *coefBase)
  *
  * TODO:        add 32-bit version for platforms where 64-bit mul-acc is not supported
  **************************************************************************************/
-void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase)
+HELIX_FAST_CODE(void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase))
 {
 	int i;
 	const int *coef;
@@ -293,3 +305,5 @@ void PolyphaseStereo(short *pcm, int *vbuf, const int *coefBase)
 		pcm += 2;
 	}
 }
+
+#endif	/* (HELIX_DSP_KERNELS || !defined(ARM_ADS)) && !HELIX_FLOAT_DSP */
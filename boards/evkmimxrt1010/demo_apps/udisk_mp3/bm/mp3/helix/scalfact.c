@@ -342,8 +342,8 @@ static void UnpackSFMPEG2(BitStreamInfo *bsi, SideInfoSub *sis, ScaleFactorInfoS
  * Description: parse the fields of the MP3 scale factor data section
  *
  * Inputs:      MP3DecInfo structure filled by UnpackFrameHeader() and UnpackSideInfo()
- *              buffer pointing to the MP3 scale factor data
- *              pointer to bit offset (0-7) indicating starting bit in buf[0]
+ *              cursor pointing to the MP3 scale factor data (not advanced)
+ *              pointer to bit offset (0-7) indicating starting bit in the first byte
  *              number of bits available in data buffer
  *              index of current granule and channel
  *
@@ -352,10 +352,10 @@ static void UnpackSFMPEG2(BitStreamInfo *bsi, SideInfoSub *sis, ScaleFactorInfoS
  *
  * Return:      length (in bytes) of scale factor data, -1 if null input pointers
  **************************************************************************************/
-int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffset, int bitsAvail, int gr, int ch)
+int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, const MainDataCursor *mc, int *bitOffset, int bitsAvail, int gr, int ch)
 {
-	int bitsUsed;
-	unsigned char *startBuf;
+	int bitsUsed, nBytes;
+	MainDataCursor cursor;
 	BitStreamInfo bitStreamInfo, *bsi;
 	FrameHeader *fh;
 	SideInfo *si;
@@ -368,10 +368,11 @@ int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffse
 	si = ((SideInfo *)(mp3DecInfo->SideInfoPS));
 	sfi = ((ScaleFactorInfo *)(mp3DecInfo->ScaleFactorInfoPS));
 
-	/* init GetBits reader */
-	startBuf = buf;
+	/* init GetBits reader on a private copy of the cursor */
+	cursor = *mc;
+	nBytes = (bitsAvail + *bitOffset + 7) / 8;
 	bsi = &bitStreamInfo;
-	SetBitstreamPointer(bsi, (bitsAvail + *bitOffset + 7) / 8, buf);
+	SetBitstreamCursor(bsi, nBytes, &cursor);
 	if (*bitOffset)
 		GetBits(bsi, *bitOffset);
 
@@ -382,10 +383,10 @@ int UnpackScaleFactors(MP3DecInfo *mp3DecInfo, unsigned char *buf, int *bitOffse
 
 	mp3DecInfo->part23Length[gr][ch] = si->sis[gr][ch].part23Length;
 
-	bitsUsed = CalcBitsUsed(bsi, buf, *bitOffset);
-	buf += (bitsUsed + *bitOffset) >> 3;
+	bitsUsed = (nBytes - bsi->nBytes) * 8 - bsi->cachedBits - *bitOffset;
+	nBytes = (bitsUsed + *bitOffset) >> 3;
 	*bitOffset = (bitsUsed + *bitOffset) & 0x07;
 
-	return (buf - startBuf);
+	return nBytes;
 }
 
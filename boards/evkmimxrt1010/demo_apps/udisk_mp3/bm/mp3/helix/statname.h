@@ -64,11 +64,16 @@
 #define	UnpackFrameHeader	STATNAME(UnpackFrameHeader)
 #define	UnpackSideInfo		STATNAME(UnpackSideInfo)
 #define	AllocateBuffers		STATNAME(AllocateBuffers)
+#define	AllocateBuffersInPlace	STATNAME(AllocateBuffersInPlace)
+#define	GetBufferSize		STATNAME(GetBufferSize)
 #define	FreeBuffers			STATNAME(FreeBuffers)
 #define	DecodeHuffman		STATNAME(DecodeHuffman)
+#define	InitHuffmanFastTables	STATNAME(InitHuffmanFastTables)
 #define	Dequantize			STATNAME(Dequantize)
 #define	IMDCT				STATNAME(IMDCT)
 #define	UnpackScaleFactors	STATNAME(UnpackScaleFactors)
+#define	NextMainDataByte	STATNAME(NextMainDataByte)
+#define	SkipMainData		STATNAME(SkipMainData)
 #define	Subband				STATNAME(Subband)
 
 #define	samplerateTab		STATNAME(samplerateTab)
@@ -39,11 +39,15 @@
  * June 2003
  *
  * stproc.c - mid-side and intensity (MPEG1 and MPEG2) stereo processing
+ *
+ * Not built with HELIX_FLOAT_DSP, dequantf.c takes its place
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if !HELIX_FLOAT_DSP
+
 /**************************************************************************************
  * Function:    MidSideProc
  *
@@ -61,15 +65,32 @@
  *
  * Notes:       assume at least 1 GB in input
  **************************************************************************************/
-void MidSideProc(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, int mOut[2])  
+HELIX_FAST_CODE(void MidSideProc(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, int mOut[2]))
 {
 	int i, xr, xl, mOutL, mOutR;
+#if HELIX_DQ_KERNELS
+	int xr1, xl1;
+#endif
 	
 	/* L = (M+S)/sqrt(2), R = (M-S)/sqrt(2) 
 	 * NOTE: 1/sqrt(2) done in DequantChannel() - see comments there
 	 */
 	mOutL = mOutR = 0;
-	for(i = 0; i < nSamps; i++) {
+	i = 0;
+#if HELIX_DQ_KERNELS
+	/* two lines per pass, the four loads issue back to back */
+	for ( ; i < nSamps - 1; i += 2) {
+		xl = x[0][i];
+		xr = x[1][i];
+		xl1 = x[0][i+1];
+		xr1 = x[1][i+1];
+		x[0][i] =   xl + xr;	mOutL |= FASTABS(xl + xr);
+		x[1][i] =   xl - xr;	mOutR |= FASTABS(xl - xr);
+		x[0][i+1] = xl1 + xr1;	mOutL |= FASTABS(xl1 + xr1);
+		x[1][i+1] = xl1 - xr1;	mOutR |= FASTABS(xl1 - xr1);
+	}
+#endif
+	for( ; i < nSamps; i++) {
 		xl = x[0][i];
 		xr = x[1][i];
 		x[0][i] = xl + xr;
@@ -81,6 +102,56 @@ void MidSideProc(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, int mOut[2])
 	mOut[1] |= mOutR;
 }
 
+#if HELIX_DQ_KERNELS
+/**************************************************************************************
+ * Function:    IntensityRun
+ *
+ * Description: intensity stereo on n consecutive lines with one pair of gains
+ *
+ * Inputs:      left and right channel, starting at the first line of the run
+ *              number of lines
+ *              left and right gain (Q30)
+ *              guard bit masks (left and right channels)
+ *
+ * Outputs:     right = fr * left, left = fl * left
+ *              updated guard bit masks
+ *
+ * Return:      none
+ *
+ * Notes:       same arithmetic as the reference loops, two lines per pass and an 
+ *                all-zero left pair just zeroes the right pair (the upper bands of 
+ *                an intensity region are mostly empty)
+ **************************************************************************************/
+static __inline void IntensityRun(int *xl, int *xr, int n, int fl, int fr, int *mOutL, int *mOutR)
+{
+	int a0, a1, r0, r1, l0, l1, mL, mR;
+
+	mL = *mOutL;
+	mR = *mOutR;
+	for ( ; n > 1; n -= 2) {
+		a0 = xl[0];
+		a1 = xl[1];
+		if ((a0 | a1) == 0) {
+			xr[0] = 0;
+			xr[1] = 0;
+		} else {
+			r0 = MULSHIFT32(fr, a0) << 2;	r1 = MULSHIFT32(fr, a1) << 2;
+			l0 = MULSHIFT32(fl, a0) << 2;	l1 = MULSHIFT32(fl, a1) << 2;
+			xr[0] = r0;		xr[1] = r1;		mR |= FASTABS(r0) | FASTABS(r1);
+			xl[0] = l0;		xl[1] = l1;		mL |= FASTABS(l0) | FASTABS(l1);
+		}
+		xl += 2;
+		xr += 2;
+	}
+	if (n == 1) {
+		r0 = MULSHIFT32(fr, *xl) << 2;	*xr = r0;	mR |= FASTABS(r0);
+		l0 = MULSHIFT32(fl, *xl) << 2;	*xl = l0;	mL |= FASTABS(l0);
+	}
+	*mOutL = mL;
+	*mOutR = mR;
+}
+#endif
+
 /**************************************************************************************
  * Function:    IntensityProcMPEG1
  *
@@ -103,8 +174,8 @@ void MidSideProc(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, int mOut[2])
  * TODO:        combine MPEG1/2 into one function (maybe)
  *              make sure all the mixed-block and IIP logic is right
  **************************************************************************************/
-void IntensityProcMPEG1(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh, ScaleFactorInfoSub *sfis, 
-						CriticalBandInfo *cbi, int midSideFlag, int mixFlag, int mOut[2])
+HELIX_FAST_CODE(void IntensityProcMPEG1(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh, ScaleFactorInfoSub *sfis, 
+						CriticalBandInfo *cbi, int midSideFlag, int mixFlag, int mOut[2]))
 {
 	int i=0, j=0, n=0, cb=0, w=0;
 	int sampsLeft, isf, mOutL, mOutR, xl, xr;
@@ -148,11 +219,18 @@ void IntensityProcMPEG1(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh
 		}
 
 		n = fh->sfBand->l[cb + 1] - fh->sfBand->l[cb];
+#if HELIX_DQ_KERNELS
+		n = MIN(n, sampsLeft);
+		IntensityRun(x[0] + i, x[1] + i, n, fl, fr, &mOutL, &mOutR);
+		i += n;
+		sampsLeft -= n;
+#else
 		for (j = 0; j < n && sampsLeft > 0; j++, i++) {
 			xr = MULSHIFT32(fr, x[0][i]) << 2;	x[1][i] = xr; mOutR |= FASTABS(xr);
 			xl = MULSHIFT32(fl, x[0][i]) << 2;	x[0][i] = xl; mOutL |= FASTABS(xl);
 			sampsLeft--;
 		}
+#endif
 	}
 
 	/* short blocks */
@@ -209,8 +287,8 @@ void IntensityProcMPEG1(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh
  *              make sure all the mixed-block and IIP logic is right
  *                probably redo IIP logic to be simpler
  **************************************************************************************/
-void IntensityProcMPEG2(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh, ScaleFactorInfoSub *sfis, 
-						CriticalBandInfo *cbi, ScaleFactorJS *sfjs, int midSideFlag, int mixFlag, int mOut[2])
+HELIX_FAST_CODE(void IntensityProcMPEG2(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh, ScaleFactorInfoSub *sfis, 
+						CriticalBandInfo *cbi, ScaleFactorJS *sfjs, int midSideFlag, int mixFlag, int mOut[2]))
 {
 	int i, j, k, n, r, cb, w;
 	int fl, fr, mOutL, mOutR, xl, xr;
@@ -249,10 +327,15 @@ void IntensityProcMPEG2(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh
 			}
 			n = MIN(fh->sfBand->l[cb + 1] - fh->sfBand->l[cb], sampsLeft);
 
+#if HELIX_DQ_KERNELS
+			IntensityRun(x[0] + i, x[1] + i, n, fl, fr, &mOutL, &mOutR);
+			i += n;
+#else
 			for(j = 0; j < n; j++, i++) {
 				xr = MULSHIFT32(fr, x[0][i]) << 2;	x[1][i] = xr;	mOutR |= FASTABS(xr);
 				xl = MULSHIFT32(fl, x[0][i]) << 2;	x[0][i] = xl;	mOutL |= FASTABS(xl);
 			}
+#endif
 
 			/* early exit once we've used all the non-zero samples */
 			sampsLeft -= n;
@@ -294,3 +377,4 @@ void IntensityProcMPEG2(int x[MAX_NCHAN][MAX_NSAMP], int nSamps, FrameHeader *fh
 	return;
 }
 
+#endif	/* !HELIX_FLOAT_DSP */
@@ -40,11 +40,15 @@
  *
  * subband.c - subband transform (synthesis filterbank implemented via 32-point DCT
  *               followed by polyphase filter)
+ *
+ * Not built with HELIX_FLOAT_DSP, subbandf.c takes its place
  **************************************************************************************/
 
 #include "coder.h"
 #include "assembly.h"
 
+#if !HELIX_FLOAT_DSP
+
 /**************************************************************************************
  * Function:    Subband
  *
@@ -57,7 +61,7 @@
  *
  * Return:      0 on success,  -1 if null input pointers
  **************************************************************************************/
-int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf)
+HELIX_FAST_CODE(int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf))
 {
 	int b;
 	//HuffmanInfo *hi;
@@ -72,7 +76,7 @@ int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf)
 	mi = (IMDCTInfo *)(mp3DecInfo->IMDCTInfoPS);
 	sbi = (SubbandInfo*)(mp3DecInfo->SubbandInfoPS);
 
-	if (mp3DecInfo->nChans == 2) {
+	if (mp3DecInfo->nOutChans == 2) {
 		/* stereo */
 		for (b = 0; b < BLOCK_SIZE; b++) {
 			FDCT32(mi->outBuf[0][b], sbi->vbuf + 0*32, sbi->vindex, (b & 0x01), mi->gb[0]);
@@ -94,3 +98,4 @@ int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf)
 	return 0;
 }
 
+#endif	/* !HELIX_FLOAT_DSP */
@@ -0,0 +1,551 @@
+/* ***** BEGIN LICENSE BLOCK ***** 
+ * Version: RCSL 1.0/RPSL 1.0 
+ *  
+ * Portions Copyright (c) 1995-2002 RealNetworks, Inc. All Rights Reserved. 
+ *      
+ * The contents of this file, and the files included with this file, are 
+ * subject to the current version of the RealNetworks Public Source License 
+ * Version 1.0 (the "RPSL") available at 
+ * http://www.helixcommunity.org/content/rpsl unless you have licensed 
+ * the file under the RealNetworks Community Source License Version 1.0 
+ * (the "RCSL") available at http://www.helixcommunity.org/content/rcsl, 
+ * in which case the RCSL will apply. You may also obtain the license terms 
+ * directly from RealNetworks.  You may not use this file except in 
+ * compliance with the RPSL or, if you have a valid RCSL with RealNetworks 
+ * applicable to this file, the RCSL.  Please see the applicable RPSL or 
+ * RCSL for the rights, obligations and limitations governing use of the 
+ * contents of the file.  
+ *  
+ * This file is part of the Helix DNA Technology. RealNetworks is the 
+ * developer of the Original Code and owns the copyrights in the portions 
+ * it created. 
+ *  
+ * This file, and the files included with this file, is distributed and made 
+ * available on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER 
+ * EXPRESS OR IMPLIED, AND REALNETWORKS HEREBY DISCLAIMS ALL SUCH WARRANTIES, 
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT. 
+ * 
+ * Technology Compatibility Kit Test Suite(s) Location: 
+ *    http://www.helixcommunity.org/content/tck 
+ * 
+ * Contributor(s): 
+ *  
+ * ***** END LICENSE BLOCK ***** */ 
+
+
+/**************************************************************************************
+ * Floating-point back end for the fixed-point MP3 decoder
+ *
+ * subbandf.c - subband transform (synthesis filterbank implemented via 32-point DCT
+ *               followed by polyphase filter) in single precision
+ *
+ * Built only with HELIX_FLOAT_DSP, in place of subband.c, dct32.c and polyphase.c
+ *   (or the PolyphaseMono/Stereo of the prebuilt assembly library)
+ * FDCT32F is Ken's radix-4 + radix-8 DCT from dct32.c with the 1/cos() factors at full
+ *   scale, PolyphaseMonoF/StereoF walk the same shuffled vbuf and coefficient order as
+ *   polyphase.c
+ **************************************************************************************/
+
+#include "coder.h"
+#include "assembly.h"
+
+#if HELIX_FLOAT_DSP
+
+/* 1/(2*cos((2*i+1)*pi/(2*N))) for N = 32, 16, 8, 4, 2 */
+#define COS0_0  0.50060302f
+#define COS0_1  0.505470932f
+#define COS0_2  0.515447319f
+#define COS0_3  0.531042576f
+#define COS0_4  0.553103924f
+#define COS0_5  0.582934976f
+#define COS0_6  0.622504115f
+#define COS0_7  0.674808323f
+#define COS0_8  0.744536281f
+#define COS0_9  0.839349627f
+#define COS0_10 0.972568214f
+#define COS0_11 1.16943991f
+#define COS0_12 1.4841646f
+#define COS0_13 2.05778098f
+#define COS0_14 3.40760851f
+#define COS0_15 10.1900082f
+
+#define COS1_0  0.502419293f
+#define COS1_1  0.522498608f
+#define COS1_2  0.566944063f
+#define COS1_3  0.646821797f
+#define COS1_4  0.788154602f
+#define COS1_5  1.06067765f
+#define COS1_6  1.72244716f
+#define COS1_7  5.10114861f
+
+#define COS2_0  0.509795606f
+#define COS2_1  0.601344883f
+#define COS2_2  0.899976194f
+#define COS2_3  2.56291556f
+
+#define COS3_0  0.541196108f
+#define COS3_1  1.30656302f
+
+#define COS4_0  0.707106769f
+
+HELIX_FAST_DATA(static const float dcttab[48]) = {
+	/* first pass */
+	COS0_0, COS0_15, COS1_0,
+	COS0_1, COS0_14, COS1_1,
+	COS0_2, COS0_13, COS1_2,
+	COS0_3, COS0_12, COS1_3,
+	COS0_4, COS0_11, COS1_4,
+	COS0_5, COS0_10, COS1_5,
+	COS0_6, COS0_9,  COS1_6,
+	COS0_7, COS0_8,  COS1_7,
+	/* second pass */
+	 COS2_0,  COS2_3, COS3_0,
+	 COS2_1,  COS2_2, COS3_1,
+	-COS2_0, -COS2_3, COS3_0,
+	-COS2_1, -COS2_2, COS3_1,
+	 COS2_0,  COS2_3, COS3_0,
+	 COS2_1,  COS2_2, COS3_1,
+	-COS2_0, -COS2_3, COS3_0,
+	-COS2_1, -COS2_2, COS3_1,
+};
+
+/* polyCoef (trigtabs.c) / 2^18, i.e. the synthesis window D[] of the spec in the 
+ *   shuffled order the polyphase filter reads it
+ */
+HELIX_FAST_DATA(static const float polyCoefF[264]) = {
+	0.0f, 0.000442504883f, 0.00325012207f, 0.00700378418f, 0.0310821533f, 0.07862854f, 0.100311279f, 0.572036743f,
+	1.14498901f, -0.572036743f, 0.100311279f, -0.07862854f, 0.0310821533f, -0.00700378418f, 0.00325012207f, -0.000442504883f,
+	-1.52587891e-05f, 0.000396728516f, 0.00332641602f, 0.00611877441f, 0.0305175781f, 0.073059082f, 0.090927124f, 0.543823242f,
+	1.14428711f, -0.600219727f, 0.108856201f, -0.0841827393f, 0.0314788818f, -0.00791931152f, 0.00317382812f, -0.000473022461f,
+	-1.52587891e-05f, 0.000366210938f, 0.00338745117f, 0.0052947998f, 0.0297851562f, 0.0675201416f, 0.0806884766f, 0.515609741f,
+	1.14221191f, -0.628295898f, 0.116577148f, -0.0897064209f, 0.0317382812f, -0.00886535645f, 0.00308227539f, -0.000534057617f,
+	-1.52587891e-05f, 0.00032043457f, 0.00343322754f, 0.00448608398f, 0.0288848877f, 0.06199646f, 0.0695953369f, 0.487472534f,
+	1.13876343f, -0.656219482f, 0.123474121f, -0.0951690674f, 0.0318450928f, -0.00984191895f, 0.00299072266f, -0.000579833984f,
+	-1.52587891e-05f, 0.000289916992f, 0.00346374512f, 0.00372314453f, 0.0278015137f, 0.0565338135f, 0.0576171875f, 0.459472656f,
+	1.13392639f, -0.683914185f, 0.129577637f, -0.100540161f, 0.0318145752f, -0.010848999f, 0.00289916992f, -0.000625610352f,
+	-1.52587891e-05f, 0.000259399414f, 0.00347900391f, 0.00300598145f, 0.0265350342f, 0.0511322021f, 0.0447845459f, 0.431655884f,
+	1.12774658f, -0.71131897f, 0.134887695f, -0.105819702f, 0.0316619873f, -0.0118865967f, 0.0027923584f, -0.000686645508f,
+	-1.52587891e-05f, 0.000244140625f, 0.00347900391f, 0.00233459473f, 0.0250854492f, 0.0458374023f, 0.0310821533f, 0.404083252f,
+	1.120224f, -0.738372803f, 0.139450073f, -0.110946655f, 0.0313873291f, -0.0129394531f, 0.00268554688f, -0.000747680664f,
+	-3.05175781e-05f, 0.000213623047f, 0.00346374512f, 0.00169372559f, 0.0234222412f, 0.0406341553f, 0.0165100098f, 0.376800537f,
+	1.1113739f, -0.765029907f, 0.143264771f, -0.115921021f, 0.0310058594f, -0.0140228271f, 0.00257873535f, -0.00080871582f,
+	-3.05175781e-05f, 0.000198364258f, 0.00341796875f, 0.00109863281f, 0.0215759277f, 0.0355529785f, 0.00106811523f, 0.349868774f,
+	1.10121155f, -0.791213989f, 0.146362305f, -0.120697021f, 0.0305328369f, -0.01512146f, 0.00245666504f, -0.000885009766f,
+	-3.05175781e-05f, 0.00016784668f, 0.00337219238f, 0.000549316406f, 0.01953125f, 0.0306091309f, -0.0152282715f, 0.323318481f,
+	1.08978271f, -0.816864014f, 0.148773193f, -0.125259399f, 0.0299377441f, -0.0162353516f, 0.00234985352f, -0.000961303711f,
+	-3.05175781e-05f, 0.000152587891f, 0.00328063965f, 3.05175781e-05f, 0.0172576904f, 0.0258178711f, -0.0323791504f, 0.297210693f,
+	1.07711792f, -0.841949463f, 0.150497437f, -0.129562378f, 0.0292816162f, -0.0173492432f, 0.00224304199f, -0.00103759766f,
+	-4.57763672e-05f, 0.000137329102f, 0.00317382812f, -0.000442504883f, 0.0148010254f, 0.0211791992f, -0.0503540039f, 0.271591187f,
+	1.06321716f, -0.866363525f, 0.151596069f, -0.133590698f, 0.0285339355f, -0.0184631348f, 0.00212097168f, -0.0011138916f,
+	-4.57763672e-05f, 0.000122070312f, 0.00305175781f, -0.000869750977f, 0.0121154785f, 0.016708374f, -0.0691680908f, 0.246505737f,
+	1.04815674f, -0.890090942f, 0.152069092f, -0.137298584f, 0.0277252197f, -0.0195770264f, 0.00201416016f, -0.00120544434f,
+	-6.10351562e-05f, 0.000106811523f, 0.00288391113f, -0.00126647949f, 0.00923156738f, 0.0124206543f, -0.0887756348f, 0.221984863f,
+	1.03193665f, -0.91305542f, 0.15196228f, -0.140670776f, 0.02684021f, -0.020690918f, 0.00190734863f, -0.00129699707f,
+	-6.10351562e-05f, 0.000106811523f, 0.00270080566f, -0.00161743164f, 0.0061340332f, 0.00831604004f, -0.109161377f, 0.198059082f,
+	1.01461792f, -0.935195923f, 0.151306152f, -0.143676758f, 0.0259094238f, -0.0217895508f, 0.00178527832f, -0.0013885498f,
+	-7.62939453e-05f, 9.15527344e-05f, 0.00248718262f, -0.00193786621f, 0.00282287598f, 0.00439453125f, -0.130310059f, 0.174789429f,
+	0.996246338f, -0.956481934f, 0.150115967f, -0.146255493f, 0.0249328613f, -0.022857666f, 0.00169372559f, -0.00148010254f,
+	0.00158691406f, 0.0239105225f, 0.148422241f, 0.976852417f, -0.152206421f, -0.000686645508f, 0.0022277832f, -7.62939453e-05f,
+};
+
+#define D32FP(i) { \
+	a0 = buf[i];			a3 = buf[31-i]; \
+	a1 = buf[15-i];			a2 = buf[16+i]; \
+	b0 = a0 + a3;			b3 = *cptr++ * (a0 - a3);	\
+	b1 = a1 + a2;			b2 = *cptr++ * (a1 - a2);	\
+	buf[i] = b0 + b1;		buf[15-i] = *cptr   * (b0 - b1); \
+	buf[16+i] = b2 + b3;	buf[31-i] = *cptr++ * (b3 - b2); \
+}
+
+/**************************************************************************************
+ * Function:    FDCT32F
+ *
+ * Description: 32-point DCT (radix-4 + radix-8), see FDCT32() in dct32.c
+ *
+ * Inputs:      input buffer, length = 32 samples
+ *              buffer offset and oddblock flag for polyphase filter input buffer
+ *
+ * Outputs:     output buffer, data copied and interleaved for polyphase filter
+ *
+ * Return:      none
+ *
+ * Notes:       number of muls = 4*8 + 12*4 = 80
+ *              final stage of DCT is hardcoded to shuffle data into the proper order
+ *                for the polyphase filterbank
+ **************************************************************************************/
+HELIX_FAST_CODE(static void FDCT32F(float *buf, float *dest, int offset, int oddBlock))
+{
+	int i;
+	const float *cptr = dcttab;
+	float a0, a1, a2, a3, a4, a5, a6, a7;
+	float b0, b1, b2, b3, b4, b5, b6, b7;
+	float s, tmp, *d;
+
+	/* first pass */    
+	D32FP(0);
+	D32FP(1);
+	D32FP(2);
+	D32FP(3);
+	D32FP(4);
+	D32FP(5);
+	D32FP(6);
+	D32FP(7);
+
+	/* second pass */
+	for (i = 4; i > 0; i--) {
+		a0 = buf[0]; 	    a7 = buf[7];		a3 = buf[3];	    a4 = buf[4];
+		b0 = a0 + a7;	    b7 = *cptr++ * (a0 - a7);
+		b3 = a3 + a4;	    b4 = *cptr++ * (a3 - a4);
+		a0 = b0 + b3;	    a3 = *cptr   * (b0 - b3);
+		a4 = b4 + b7;		a7 = *cptr++ * (b7 - b4);
+
+		a1 = buf[1];	    a6 = buf[6];	    a2 = buf[2];	    a5 = buf[5];
+		b1 = a1 + a6;	    b6 = *cptr++ * (a1 - a6);
+		b2 = a2 + a5;	    b5 = *cptr++ * (a2 - a5);
+		a1 = b1 + b2;		a2 = *cptr   * (b1 - b2);
+		a5 = b5 + b6;	    a6 = *cptr++ * (b6 - b5);
+
+		b0 = a0 + a1;	    b1 = COS4_0 * (a0 - a1);
+		b2 = a2 + a3;	    b3 = COS4_0 * (a3 - a2);
+		buf[0] = b0;	    buf[1] = b1;
+		buf[2] = b2 + b3;	buf[3] = b3;
+
+		b4 = a4 + a5;	    b5 = COS4_0 * (a4 - a5);
+		b6 = a6 + a7;	    b7 = COS4_0 * (a7 - a6);
+		b6 += b7;
+		buf[4] = b4 + b6;	buf[5] = b5 + b7;
+		buf[6] = b5 + b6;	buf[7] = b7;
+
+		buf += 8;
+	}
+	buf -= 32;	/* reset */
+
+	/* sample 0 - always delayed one block */
+	d = dest + 64*16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : VBUF_LENGTH);
+	s = buf[ 0];				d[0] = d[8] = s;
+    
+	/* samples 16 to 31 */
+	d = dest + offset + (oddBlock ? VBUF_LENGTH  : 0);
+
+	s = buf[ 1];				d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[25] + buf[29];
+	s = buf[17] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[ 9] + buf[13];		d[0] = d[8] = s;	d += 64;
+	s = buf[21] + tmp;			d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[29] + buf[27];
+	s = buf[ 5];				d[0] = d[8] = s;	d += 64;
+	s = buf[21] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[13] + buf[11];		d[0] = d[8] = s;	d += 64;
+	s = buf[19] + tmp;			d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[27] + buf[31];
+	s = buf[ 3];				d[0] = d[8] = s;	d += 64;
+	s = buf[19] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[11] + buf[15];		d[0] = d[8] = s;	d += 64;
+	s = buf[23] + tmp;			d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[31];
+	s = buf[ 7];				d[0] = d[8] = s;	d += 64;
+	s = buf[23] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[15];				d[0] = d[8] = s;	d += 64;
+	s = tmp;					d[0] = d[8] = s;
+
+	/* samples 16 to 1 (sample 16 used again) */
+	d = dest + 16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : VBUF_LENGTH);
+
+	s = buf[ 1];				d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[30] + buf[25];
+	s = buf[17] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[14] + buf[ 9];		d[0] = d[8] = s;	d += 64;
+	s = buf[22] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[ 6];				d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[26] + buf[30];
+	s = buf[22] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[10] + buf[14];		d[0] = d[8] = s;	d += 64;
+	s = buf[18] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[ 2];				d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[28] + buf[26];
+	s = buf[18] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[12] + buf[10];		d[0] = d[8] = s;	d += 64;
+	s = buf[20] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[ 4];				d[0] = d[8] = s;	d += 64;
+
+	tmp = buf[24] + buf[28];
+	s = buf[20] + tmp;			d[0] = d[8] = s;	d += 64;
+	s = buf[ 8] + buf[12];		d[0] = d[8] = s;	d += 64;
+	s = buf[16] + tmp;			d[0] = d[8] = s;
+}
+
+/* round to nearest and clip to [-32768, 32767] (the bias keeps the cast truncating
+ *   a positive number, so it rounds the same way as the fixed-point filter)
+ */
+static __inline short ClipToShortF(float x)
+{
+	if (x < -32768.0f)
+		x = -32768.0f;
+	else if (x > 32767.0f)
+		x = 32767.0f;
+
+	return (short)((int)(x + 32768.5f) - 32768);
+}
+
+#define MC0M(x)	{ \
+	c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+	vLo = *(vb1+(x));			vHi = *(vb1+(23-(x))); \
+	sum1L += vLo * c1;	sum1L -= vHi * c2; \
+}
+
+#define MC1M(x)	{ \
+	c1 = *coef;		coef++; \
+	vLo = *(vb1+(x)); \
+	sum1L += vLo * c1; \
+}
+
+#define MC2M(x)	{ \
+		c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+		vLo = *(vb1+(x));	vHi = *(vb1+(23-(x))); \
+		sum1L += vLo * c1;	sum2L += vLo * c2; \
+		sum1L -= vHi * c2;	sum2L += vHi * c1; \
+}
+
+/**************************************************************************************
+ * Function:    PolyphaseMonoF
+ *
+ * Description: filter one subband and produce 32 output PCM samples for one channel
+ *
+ * Inputs:      pointer to PCM output buffer
+ *              pointer to start of vbuf (preserved from last call)
+ *              start of filter coefficient table (in proper, shuffled order)
+ *
+ * Outputs:     32 samples of one channel of decoded PCM data
+ *
+ * Return:      none
+ **************************************************************************************/
+HELIX_FAST_CODE(static void PolyphaseMonoF(short *pcm, float *vbuf, const float *coefBase))
+{	
+	int i;
+	const float *coef;
+	float *vb1;
+	float vLo, vHi, c1, c2;
+	float sum1L, sum2L;
+
+	/* special case, output sample 0 */
+	coef = coefBase;
+	vb1 = vbuf;
+	sum1L = 0.0f;
+
+	MC0M(0)
+	MC0M(1)
+	MC0M(2)
+	MC0M(3)
+	MC0M(4)
+	MC0M(5)
+	MC0M(6)
+	MC0M(7)
+
+	*(pcm + 0) = ClipToShortF(sum1L);
+
+	/* special case, output sample 16 */
+	coef = coefBase + 256;
+	vb1 = vbuf + 64*16;
+	sum1L = 0.0f;
+
+	MC1M(0)
+	MC1M(1)
+	MC1M(2)
+	MC1M(3)
+	MC1M(4)
+	MC1M(5)
+	MC1M(6)
+	MC1M(7)
+
+	*(pcm + 16) = ClipToShortF(sum1L);
+
+	/* main convolution loop: sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
+	coef = coefBase + 16;
+	vb1 = vbuf + 64;
+	pcm++;
+
+	for (i = 15; i > 0; i--) {
+		sum1L = sum2L = 0.0f;
+
+		MC2M(0)
+		MC2M(1)
+		MC2M(2)
+		MC2M(3)
+		MC2M(4)
+		MC2M(5)
+		MC2M(6)
+		MC2M(7)
+
+		vb1 += 64;
+		*(pcm)       = ClipToShortF(sum1L);
+		*(pcm + 2*i) = ClipToShortF(sum2L);
+		pcm++;
+	}
+}
+
+#define MC0S(x)	{ \
+	c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+	vLo = *(vb1+(x));		vHi = *(vb1+(23-(x))); \
+	sum1L += vLo * c1;	sum1L -= vHi * c2; \
+	vLo = *(vb1+32+(x));	vHi = *(vb1+32+(23-(x))); \
+	sum1R += vLo * c1;	sum1R -= vHi * c2; \
+}
+
+#define MC1S(x)	{ \
+	c1 = *coef;		coef++; \
+	vLo = *(vb1+(x)); \
+	sum1L += vLo * c1; \
+	vLo = *(vb1+32+(x)); \
+	sum1R += vLo * c1; \
+}
+
+#define MC2S(x)	{ \
+		c1 = *coef;		coef++;		c2 = *coef;		coef++; \
+		vLo = *(vb1+(x));	vHi = *(vb1+(23-(x))); \
+		sum1L += vLo * c1;	sum2L += vLo * c2; \
+		sum1L -= vHi * c2;	sum2L += vHi * c1; \
+		vLo = *(vb1+32+(x));	vHi = *(vb1+32+(23-(x))); \
+		sum1R += vLo * c1;	sum2R += vLo * c2; \
+		sum1R -= vHi * c2;	sum2R += vHi * c1; \
+}
+
+/**************************************************************************************
+ * Function:    PolyphaseStereoF
+ *
+ * Description: filter one subband and produce 32 output PCM samples for each channel
+ *
+ * Inputs:      pointer to PCM output buffer
+ *              pointer to start of vbuf (preserved from last call)
+ *              start of filter coefficient table (in proper, shuffled order)
+ *
+ * Outputs:     32 samples of two channels of decoded PCM data
+ *
+ * Return:      none
+ *
+ * Notes:       interleaves PCM samples LRLRLR...
+ **************************************************************************************/
+HELIX_FAST_CODE(static void PolyphaseStereoF(short *pcm, float *vbuf, const float *coefBase))
+{
+	int i;
+	const float *coef;
+	float *vb1;
+	float vLo, vHi, c1, c2;
+	float sum1L, sum2L, sum1R, sum2R;
+
+	/* special case, output sample 0 */
+	coef = coefBase;
+	vb1 = vbuf;
+	sum1L = sum1R = 0.0f;
+
+	MC0S(0)
+	MC0S(1)
+	MC0S(2)
+	MC0S(3)
+	MC0S(4)
+	MC0S(5)
+	MC0S(6)
+	MC0S(7)
+
+	*(pcm + 0) = ClipToShortF(sum1L);
+	*(pcm + 1) = ClipToShortF(sum1R);
+
+	/* special case, output sample 16 */
+	coef = coefBase + 256;
+	vb1 = vbuf + 64*16;
+	sum1L = sum1R = 0.0f;
+
+	MC1S(0)
+	MC1S(1)
+	MC1S(2)
+	MC1S(3)
+	MC1S(4)
+	MC1S(5)
+	MC1S(6)
+	MC1S(7)
+
+	*(pcm + 2*16 + 0) = ClipToShortF(sum1L);
+	*(pcm + 2*16 + 1) = ClipToShortF(sum1R);
+
+	/* main convolution loop: sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
+	coef = coefBase + 16;
+	vb1 = vbuf + 64;
+	pcm += 2;
+
+	for (i = 15; i > 0; i--) {
+		sum1L = sum2L = 0.0f;
+		sum1R = sum2R = 0.0f;
+
+		MC2S(0)
+		MC2S(1)
+		MC2S(2)
+		MC2S(3)
+		MC2S(4)
+		MC2S(5)
+		MC2S(6)
+		MC2S(7)
+
+		vb1 += 64;
+		*(pcm + 0)         = ClipToShortF(sum1L);
+		*(pcm + 1)         = ClipToShortF(sum1R);
+		*(pcm + 2*2*i + 0) = ClipToShortF(sum2L);
+		*(pcm + 2*2*i + 1) = ClipToShortF(sum2R);
+		pcm += 2;
+	}
+}
+
+/**************************************************************************************
+ * Function:    Subband
+ *
+ * Description: do subband transform on all the blocks in one granule, all channels
+ *
+ * Inputs:      filled MP3DecInfo structure, after calling IMDCT for all channels
+ *              vbuf[ch] and vindex[ch] must be preserved between calls
+ *
+ * Outputs:     decoded PCM data, interleaved LRLRLR... if stereo
+ *
+ * Return:      0 on success,  -1 if null input pointers
+ **************************************************************************************/
+HELIX_FAST_CODE(int Subband(MP3DecInfo *mp3DecInfo, short *pcmBuf))
+{
+	int b;
+	IMDCTInfo *mi;
+	SubbandInfo *sbi;
+
+	/* validate pointers */
+	if (!mp3DecInfo || !mp3DecInfo->HuffmanInfoPS || !mp3DecInfo->IMDCTInfoPS || !mp3DecInfo->SubbandInfoPS)
+		return -1;
+
+	mi = (IMDCTInfo *)(mp3DecInfo->IMDCTInfoPS);
+	sbi = (SubbandInfo*)(mp3DecInfo->SubbandInfoPS);
+
+	if (mp3DecInfo->nOutChans == 2) {
+		/* stereo */
+		for (b = 0; b < BLOCK_SIZE; b++) {
+			FDCT32F(mi->outBuf[0][b], sbi->vbuf + 0*32, sbi->vindex, (b & 0x01));
+			FDCT32F(mi->outBuf[1][b], sbi->vbuf + 1*32, sbi->vindex, (b & 0x01));
+			PolyphaseStereoF(pcmBuf, sbi->vbuf + sbi->vindex + VBUF_LENGTH * (b & 0x01), polyCoefF);
+			sbi->vindex = (sbi->vindex - (b & 0x01)) & 7;
+			pcmBuf += (2 * NBANDS);
+		}
+	} else {
+		/* mono */
+		for (b = 0; b < BLOCK_SIZE; b++) {
+			FDCT32F(mi->outBuf[0][b], sbi->vbuf + 0*32, sbi->vindex, (b & 0x01));
+			PolyphaseMonoF(pcmBuf, sbi->vbuf + sbi->vindex + VBUF_LENGTH * (b & 0x01), polyCoefF);
+			sbi->vindex = (sbi->vindex - (b & 0x01)) & 7;
+			pcmBuf += NBANDS;
+		}
+	}
+
+	return 0;
+}
+
+#endif	/* HELIX_FLOAT_DSP */
@@ -0,0 +1,25 @@
+#ifndef __CMSIS_COMPILER_HOST_H
+#define __CMSIS_COMPILER_HOST_H
+
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////////////////
+// Host stand-in for the two CMSIS-Core intrinsics the HELIX_DSP_KERNELS build of
+// assembly.h uses, so that build runs on the host with the results of CLZ and
+// SSAT on the target (see mp3test.sh)
+//////////////////////////////////////////////////////////////////////////////////
+
+static inline uint8_t __CLZ(uint32_t value)
+{
+    return value ? (uint8_t)__builtin_clz(value) : 32U;
+}
+
+static inline int32_t __SSAT(int32_t value, uint32_t sat)
+{
+    const int32_t max = (int32_t)((1U << (sat - 1U)) - 1U);
+    const int32_t min = -max - 1;
+
+    return value > max ? max : (value < min ? min : value);
+}
+
+#endif /* __CMSIS_COMPILER_HOST_H */
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mp3dec.h"
+
+#if !HELIX_PROFILE
+#error "mp3bench_host needs the decoder built with HELIX_PROFILE=1"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////
+// Helix decoder benchmark, host build (see Makefile)
+// The decode loop of ../mp3bench.c on whole files read from the command line.
+// Every stage is timed with clock_gettime, so the numbers are nanoseconds of
+// host time: good for comparing builds and changes, not for the target load.
+//////////////////////////////////////////////////////////////////////////////////
+
+static const char *const bench_stage_name[MP3_NSTAGES] = {
+    "header", "sideinfo", "scalefact", "huffman", "dequant", "imdct", "subband",
+};
+
+static short bench_pcm[MAX_NCHAN * MAX_NGRAN * MAX_NSAMP];
+
+unsigned int MP3ProfileGetCycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)((unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec);
+}
+
+// Size of an ID3v2 tag at the start of the file, 0 if there is none
+static long bench_id3v2_size(const unsigned char *buf, long len)
+{
+    long size;
+
+    if (len < 10 || memcmp(buf, "ID3", 3) != 0)
+    {
+        return 0;
+    }
+    size = ((long)(buf[6] & 0x7F) << 21) | ((long)(buf[7] & 0x7F) << 14) | ((long)(buf[8] & 0x7F) << 7) |
+           (long)(buf[9] & 0x7F);
+    size += (buf[5] & 0x10) ? 20 : 10; // header, and footer if present
+    return size < len ? size : len;
+}
+
+static void bench_report(const char *path, HMP3Decoder decoder, unsigned int errors, double *load)
+{
+    MP3FrameInfo info;
+    MP3ProfileInfo prof;
+    unsigned int i, n;
+    double avg, frame_ns;
+
+    MP3GetLastFrameInfo(decoder, &info);
+    MP3GetProfileInfo(decoder, &prof);
+    n = prof.nFrames ? prof.nFrames : 1;
+
+    printf("\n== %s ==\n", path);
+    printf("frames:%u errors:%u  %dHz %dch %dkbps MPEG%s\n", prof.nFrames, errors, info.samprate, info.nChans,
+           info.bitrate / 1000, info.version == MPEG1 ? "1" : (info.version == MPEG2 ? "2" : "2.5"));
+    printf("%-10s %12s %6s\n", "stage", "ns/frm", "%");
+    for (i = 0; i < MP3_NSTAGES; i++)
+    {
+        printf("%-10s %12llu %6llu\n", bench_stage_name[i], prof.stageCycles[i] / n,
+               prof.totalCycles ? prof.stageCycles[i] * 100 / prof.totalCycles : 0);
+    }
+    avg = (double)prof.totalCycles / n;
+    printf("%-10s %12.0f\n", "total", avg);
+    printf("%-10s %12u\n", "worst", prof.maxFrameCycles);
+    printf("%-10s %12u\n", "worst gr", prof.maxGranuleCycles);
+
+    // share of real time spent decoding
+    *load = 0.0;
+    if (info.nChans && info.outputSamps && info.samprate)
+    {
+        frame_ns = (double)(info.outputSamps / info.nChans) * 1e9 / info.samprate;
+        *load = avg / frame_ns;
+        printf("realtime load: %.3f%% (worst %.3f%%)\n", *load * 100.0, prof.maxFrameCycles * 100.0 / frame_ns);
+    }
+}
+
+// Decode one file as fast as possible and print the profile
+// return:0,ok
+//    other,failed to read the file
+static int bench_file(const char *path, double *load)
+{
+    HMP3Decoder decoder;
+    FILE *fp;
+    unsigned char *data;
+    unsigned char *readptr;
+    unsigned char *framestart;
+    long len;
+    int bytesleft;
+    int framebytes;
+    int offset;
+    int err;
+    int nsamps;
+    int granules;
+    unsigned int errors = 0;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        printf("bench: cannot open %s\n", path);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = malloc(len > 0 ? len : 1);
+    if (data == NULL || len <= 0 || fread(data, 1, len, fp) != (size_t)len)
+    {
+        printf("bench: cannot read %s\n", path);
+        free(data);
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+
+    decoder = MP3InitDecoder();
+    if (decoder == 0)
+    {
+        free(data);
+        return 1;
+    }
+
+    offset = (int)bench_id3v2_size(data, len);
+    readptr = data + offset;
+    bytesleft = (int)(len - offset);
+    while (bytesleft > 0)
+    {
+        offset = MP3FindSyncWord(readptr, bytesleft);
+        if (offset < 0)
+        {
+            break;
+        }
+        readptr += offset;
+        bytesleft -= offset;
+        framestart = readptr;
+        framebytes = bytesleft;
+
+        // decode granule by granule like the player does
+        err = MP3DecodeGranule(decoder, &readptr, &bytesleft, bench_pcm, &nsamps, &granules);
+        while (err == ERR_MP3_NONE && granules)
+        {
+            err = MP3DecodeGranule(decoder, &readptr, &bytesleft, bench_pcm, &nsamps, &granules);
+            if (err != ERR_MP3_NONE)
+            {
+                // the frame is already consumed, only count it
+                errors++;
+                err = ERR_MP3_NONE;
+            }
+        }
+        if (err == ERR_MP3_INDATA_UNDERFLOW)
+        {
+            break;
+        }
+        else if (err == ERR_MP3_INVALID_FRAMEHEADER || err == ERR_MP3_INVALID_SIDEINFO ||
+                 err == ERR_MP3_FREE_BITRATE_SYNC)
+        {
+            // not a frame after all, the decoder may have stepped over the header:
+            // search on from the byte behind its sync word
+            errors++;
+            readptr = framestart + 1;
+            bytesleft = framebytes - 1;
+        }
+        else if (err != ERR_MP3_NONE && err != ERR_MP3_MAINDATA_UNDERFLOW)
+        {
+            // frame consumed with corrupt main data, go on from where the decoder left off
+            errors++;
+        }
+    }
+
+    bench_report(path, decoder, errors, load);
+    MP3FreeDecoder(decoder);
+    free(data);
+    return 0;
+}
+
+// Run every file on the command line, then the corpus average
+int main(int argc, char **argv)
+{
+    double load, sum = 0.0;
+    int i, n = 0, failed = 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file.mp3...\n", argv[0]);
+        return 2;
+    }
+    printf("Helix MP3 benchmark, host build\n");
+    for (i = 1; i < argc; i++)
+    {
+        if (bench_file(argv[i], &load) != 0)
+        {
+            failed = 1;
+            continue;
+        }
+        sum += load;
+        n++;
+    }
+    if (n > 1)
+    {
+        printf("\ncorpus: %d files, mean realtime load %.3f%%\n", n, sum * 100.0 / n);
+    }
+    return failed;
+}
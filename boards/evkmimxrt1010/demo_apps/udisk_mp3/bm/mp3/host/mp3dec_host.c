@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mp3dec.h"
+
+//////////////////////////////////////////////////////////////////////////////////
+// Decode driver for the host tests (see mp3test.sh)
+// Decodes a whole file the way the player can: frame or granule calls, linear
+// or ring input, a decoder in a caller arena, the low-power decode options.
+// Writes the PCM of every good frame to the output file and one summary line
+// to stdout, so builds and modes can be compared with cmp or pcmcmp.
+//////////////////////////////////////////////////////////////////////////////////
+
+typedef struct _dec_opts
+{
+    int granule;    // -g: MP3DecodeGranule instead of MP3Decode
+    int ringSize;   // -r: feed the decoder through a ring of this many bytes
+    int arena;      // -a: decoder in a caller arena (MP3InitDecoderInPlace)
+    const char *other; // -i: a second arena decoder runs this file in between our frames
+    int twice;      // -t: decode the file again after MP3ResetDecoder, as the player starts the next track
+    MP3DecodeConfig config; // -d, -s
+} dec_opts_t;
+
+typedef struct _dec_input
+{
+    unsigned char *data;
+    long len;
+    long fed;               // bytes of data given to the decoder so far
+    unsigned char *ring;    // ring mode: ringSize + MP3_RING_GUARD bytes
+    unsigned char *flat;    // ring mode: ringSize bytes to unwrap the ring into
+    int ringSize;
+    unsigned char *readptr;
+    int bytesleft;
+} dec_input_t;
+
+typedef struct _dec_stats
+{
+    long frames;
+    long errors;
+    long samples;
+    int nChans;
+    int samprate;
+} dec_stats_t;
+
+static short dec_pcm[MAX_NCHAN * MAX_NGRAN * MAX_NSAMP];
+static unsigned int dec_seed = 1;
+
+static unsigned int dec_rand(void)
+{
+    dec_seed = dec_seed * 1103515245U + 12345U;
+    return dec_seed >> 16;
+}
+
+static unsigned char *dec_load(const char *path, long *len)
+{
+    FILE *fp = fopen(path, "rb");
+    unsigned char *data;
+
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = malloc(*len + 1);
+    if (data == NULL || fread(data, 1, *len, fp) != (size_t)*len)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+// Ring mode: top the ring up in chunks of random size, the way USB reads land,
+// without overwriting what the decoder still holds for its bit reservoir
+static void dec_ring_fill(HMP3Decoder decoder, dec_input_t *in)
+{
+    unsigned char *hold = MP3GetRingHold(decoder);
+    unsigned char *w;
+    int held, room, n, g;
+
+    if (hold == NULL)
+    {
+        hold = in->readptr;
+    }
+    held = (int)(in->readptr - hold);
+    if (held < 0)
+    {
+        held += in->ringSize;
+    }
+    room = in->ringSize - held - in->bytesleft;
+    w = in->readptr + in->bytesleft;
+    if (w >= in->ring + in->ringSize)
+    {
+        w -= in->ringSize;
+    }
+    while (room > 0 && in->fed < in->len)
+    {
+        n = (int)(in->ring + in->ringSize - w);
+        n = n < room ? n : room;
+        n = n < (int)(in->len - in->fed) ? n : (int)(in->len - in->fed);
+        n = 1 + (int)(dec_rand() % (unsigned int)n);
+        memcpy(w, in->data + in->fed, n);
+        // mirror the start of the ring into the guard
+        if (w < in->ring + MP3_RING_GUARD)
+        {
+            g = (int)(in->ring + MP3_RING_GUARD - w);
+            memcpy(w + in->ringSize, w, n < g ? n : g);
+        }
+        in->fed += n;
+        in->bytesleft += n;
+        room -= n;
+        w += n;
+        if (w >= in->ring + in->ringSize)
+        {
+            w -= in->ringSize;
+        }
+    }
+}
+
+static void dec_skip(dec_input_t *in, int n)
+{
+    in->readptr += n;
+    in->bytesleft -= n;
+    if (in->ring && in->readptr >= in->ring + in->ringSize)
+    {
+        in->readptr -= in->ringSize;
+    }
+}
+
+// Offset of the next sync word in what is buffered, -1 if there is none. In ring
+// mode the search runs on an unwrapped copy, so it looks as far ahead as on linear
+// input wherever the ring wraps, and takes the same frames.
+static int dec_find_sync(const dec_input_t *in)
+{
+    int n;
+
+    if (!in->ring)
+    {
+        return MP3FindSyncWord(in->readptr, in->bytesleft);
+    }
+    n = (int)(in->ring + in->ringSize - in->readptr);
+    n = n < in->bytesleft ? n : in->bytesleft;
+    memcpy(in->flat, in->readptr, n);
+    memcpy(in->flat + n, in->ring, in->bytesleft - n);
+    return MP3FindSyncWord(in->flat, in->bytesleft);
+}
+
+// Decode the next frame of in, 0 at the end of the stream
+static int dec_frame(HMP3Decoder decoder, dec_input_t *in, const dec_opts_t *opts, dec_stats_t *stats, FILE *out)
+{
+    MP3FrameInfo info;
+    unsigned char *framestart;
+    int framebytes, offset, err, nsamps, granules, used;
+
+    while (1)
+    {
+        if (in->ring && in->bytesleft < MAINBUF_SIZE * 2)
+        {
+            dec_ring_fill(decoder, in);
+        }
+        offset = dec_find_sync(in);
+        if (offset < 0)
+        {
+            if (in->bytesleft <= 1)
+            {
+                if (!in->ring || in->fed >= in->len)
+                {
+                    return 0;
+                }
+                continue;
+            }
+            dec_skip(in, in->bytesleft - 1);
+            continue;
+        }
+        dec_skip(in, offset);
+        if (in->ring && in->bytesleft < MAINBUF_SIZE * 2)
+        {
+            dec_ring_fill(decoder, in);
+        }
+        framestart = in->readptr;
+        framebytes = in->bytesleft;
+
+        MP3SetDecodeConfig(decoder, &opts->config);
+        if (opts->granule)
+        {
+            err = MP3DecodeGranule(decoder, &in->readptr, &in->bytesleft, dec_pcm, &nsamps, &granules);
+            used = nsamps;
+            while (err == ERR_MP3_NONE && granules)
+            {
+                err = MP3DecodeGranule(decoder, &in->readptr, &in->bytesleft, dec_pcm + used, &nsamps, &granules);
+                used += nsamps;
+            }
+        }
+        else
+        {
+            err = MP3Decode(decoder, &in->readptr, &in->bytesleft, dec_pcm, 0);
+        }
+
+        if (err == ERR_MP3_INDATA_UNDERFLOW)
+        {
+            return 0;
+        }
+        if (err == ERR_MP3_INVALID_FRAMEHEADER || err == ERR_MP3_INVALID_SIDEINFO ||
+            err == ERR_MP3_FREE_BITRATE_SYNC)
+        {
+            // not a frame after all: search on from the byte behind its sync word
+            stats->errors++;
+            in->readptr = framestart;
+            in->bytesleft = framebytes;
+            dec_skip(in, 1);
+            continue;
+        }
+        if (in->ring && in->readptr >= in->ring + in->ringSize)
+        {
+            in->readptr -= in->ringSize;
+        }
+        if (err != ERR_MP3_NONE)
+        {
+            // frame consumed, its main data missing or corrupt
+            stats->errors++;
+            return 1;
+        }
+
+        MP3GetLastFrameInfo(decoder, &info);
+        stats->frames++;
+        stats->samples += info.outputSamps;
+        stats->nChans = info.nChans;
+        stats->samprate = info.samprate;
+        if (out)
+        {
+            fwrite(dec_pcm, sizeof(short), info.outputSamps, out);
+        }
+        return 1;
+    }
+}
+
+static int dec_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options] in.mp3 out.pcm\n"
+            "  -g        decode granule by granule\n"
+            "  -r size   ring input of size bytes, filled in random chunks\n"
+            "  -a        decoder in a caller arena\n"
+            "  -i other  a second arena decoder decodes other between our frames,\n"
+            "            and a header-only instance reads our frame headers\n"
+            "  -t        decode the file twice, resetting the decoder in between\n"
+            "  -d        mono downmix\n"
+            "  -s n      keep the lowest n subbands\n",
+            name);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    static unsigned char arena[2][96 * 1024];
+    static unsigned char probeArena[4096];
+    dec_opts_t opts;
+    dec_input_t in, other;
+    dec_stats_t stats, otherStats;
+    HMP3Decoder decoder, otherDecoder = 0, probe = 0;
+    MP3FrameInfo info;
+    FILE *out;
+    int i;
+
+    memset(&opts, 0, sizeof(opts));
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-g") == 0)
+            opts.granule = 1;
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            opts.ringSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-a") == 0)
+            opts.arena = 1;
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            opts.other = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0)
+            opts.twice = 1;
+        else if (strcmp(argv[i], "-d") == 0)
+            opts.config.monoDownmix = 1;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            opts.config.nSubbands = atoi(argv[++i]);
+        else
+            return dec_usage(argv[0]);
+    }
+    if (argc - i != 2)
+    {
+        return dec_usage(argv[0]);
+    }
+
+    memset(&in, 0, sizeof(in));
+    memset(&stats, 0, sizeof(stats));
+    in.data = dec_load(argv[i], &in.len);
+    out = fopen(argv[i + 1], "wb");
+    if (in.data == NULL || out == NULL)
+    {
+        fprintf(stderr, "mp3dec: cannot open %s or %s\n", argv[i], argv[i + 1]);
+        return 1;
+    }
+
+    if (opts.arena || opts.other)
+    {
+        if (MP3GetDecoderSize(0) > (int)sizeof(arena[0]) || MP3GetDecoderSize(1) > (int)sizeof(probeArena))
+        {
+            fprintf(stderr, "mp3dec: arenas too small\n");
+            return 1;
+        }
+        // poison the arena, the decoder has to set up everything it uses
+        memset(arena[0], 0xA5, sizeof(arena[0]));
+        decoder = MP3InitDecoderInPlace(arena[0], MP3GetDecoderSize(0));
+    }
+    else
+    {
+        decoder = MP3InitDecoder();
+    }
+    if (decoder == 0)
+    {
+        fprintf(stderr, "mp3dec: no decoder\n");
+        return 1;
+    }
+
+    if (opts.other)
+    {
+        memset(&other, 0, sizeof(other));
+        memset(&otherStats, 0, sizeof(otherStats));
+        other.data = dec_load(opts.other, &other.len);
+        memset(arena[1], 0x5A, sizeof(arena[1]));
+        otherDecoder = MP3InitDecoderInPlace(arena[1], MP3GetDecoderSize(0));
+        probe = MP3InitDecoderInPlace(probeArena, MP3GetDecoderSize(1));
+        if (other.data == NULL || otherDecoder == 0 || probe == 0)
+        {
+            fprintf(stderr, "mp3dec: cannot set up %s\n", opts.other);
+            return 1;
+        }
+        other.readptr = other.data;
+        other.bytesleft = (int)other.len;
+    }
+
+    if (opts.ringSize)
+    {
+        in.ringSize = opts.ringSize;
+        in.ring = malloc(opts.ringSize + MP3_RING_GUARD);
+        in.flat = malloc(opts.ringSize);
+        memset(in.ring, 0xA5, opts.ringSize + MP3_RING_GUARD);
+        MP3SetRingInput(decoder, in.ring, in.ringSize);
+        in.readptr = in.ring;
+    }
+    else
+    {
+        in.readptr = in.data;
+        in.bytesleft = (int)in.len;
+        in.fed = in.len;
+    }
+
+    while (1)
+    {
+        if (probe)
+        {
+            // what a track probe does to the next file while this one plays
+            i = dec_find_sync(&in);
+            if (i >= 0)
+            {
+                MP3GetNextFrameInfo(probe, &info, in.ring ? in.flat + i : in.readptr + i);
+            }
+        }
+        if (!dec_frame(decoder, &in, &opts, &stats, out))
+        {
+            if (!opts.twice)
+            {
+                break;
+            }
+            // the same decoder and ring take the file again from its start
+            opts.twice = 0;
+            MP3ResetDecoder(decoder);
+            in.readptr = in.ring ? in.ring : in.data;
+            in.bytesleft = in.ring ? 0 : (int)in.len;
+            in.fed = in.ring ? 0 : in.len;
+            continue;
+        }
+        if (otherDecoder && !dec_frame(otherDecoder, &other, &opts, &otherStats, NULL))
+        {
+            // start the other file over
+            other.readptr = other.data;
+            other.bytesleft = (int)other.len;
+        }
+    }
+
+    printf("frames %ld errors %ld samples %ld nchans %d samprate %d\n", stats.frames, stats.errors, stats.samples,
+           stats.nChans, stats.samprate);
+    fclose(out);
+    MP3FreeDecoder(decoder);
+    if (otherDecoder)
+    {
+        MP3FreeDecoder(otherDecoder);
+        MP3FreeDecoder(probe);
+    }
+    return 0;
+}
@@ -0,0 +1,707 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coder.h"
+
+//////////////////////////////////////////////////////////////////////////////////
+// Synthetic MPEG audio layer 3 streams for the host tests (see mp3test.sh)
+// Every frame is legal: header and side info, bit reservoir, scale factors and
+// Huffman coded spectra written with the code tables of hufftabs.c. The stream
+// picks MPEG1/2/2.5, sample rate, channel mode and CRC from the seed, every
+// granule its block type, tables, gains and spectrum. With -c some frames get
+// random main data, junk between frames breaks the reservoir now and then,
+// and the file starts and ends with junk, to drive the error paths. With -q the
+// gains stay low enough that the output never clips.
+//
+// usage: mp3gen [-c] [-q] seed nframes > out.mp3
+//////////////////////////////////////////////////////////////////////////////////
+
+#define GEN_MAX_FRAME   2900                // 320 kbps at 32 kHz, padded
+#define GEN_MAX_CODELEN 19                  // longest Huffman pair code
+
+typedef struct _gen_code
+{
+    unsigned int code;
+    int len;
+} gen_code_t;
+
+typedef struct _gen_bits
+{
+    unsigned char *buf;
+    long bits;
+} gen_bits_t;
+
+// where the main data slots of a frame sit in the file and in the main data stream
+typedef struct _gen_slots
+{
+    long at;
+    long start;
+    int len;
+} gen_slots_t;
+
+typedef struct _gen_granule
+{
+    int part23;
+    int bigVals;
+    int globalGain;
+    int sfCompress;
+    int winSwitch;
+    int blockType;
+    int mixed;
+    int tableSelect[3];
+    int subBlockGain[3];
+    int region0;
+    int region1;
+    int preFlag;
+    int sfScale;
+    int count1Table;
+} gen_granule_t;
+
+static gen_code_t gen_pair_code[HUFF_PAIRTABS][16][16];
+static gen_code_t gen_quad_code[2][16];
+static int gen_pair_max[HUFF_PAIRTABS];    // largest value each pair table codes
+
+static unsigned int gen_state;
+static int gen_gain_base = 110;             // global gain, base + 0 to span - 1
+static int gen_gain_span = 45;
+
+static const int gen_bitrate[2][15] = {
+    {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+    {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+};
+static const int gen_samprate[3][3] = {
+    {44100, 48000, 32000}, {22050, 24000, 16000}, {11025, 12000, 8000},
+};
+static const unsigned char gen_sflen[16][2] = {
+    {0, 0}, {0, 1}, {0, 2}, {0, 3}, {3, 0}, {1, 1}, {1, 2}, {1, 3},
+    {2, 1}, {2, 2}, {2, 3}, {3, 1}, {3, 2}, {3, 3}, {4, 2}, {4, 3},
+};
+
+// xorshift32, the same streams on every host
+static unsigned int gen_rand(void)
+{
+    gen_state ^= gen_state << 13;
+    gen_state ^= gen_state >> 17;
+    gen_state ^= gen_state << 5;
+    return gen_state;
+}
+
+static int gen_range(int n)
+{
+    return (int)(gen_rand() % (unsigned int)n);
+}
+
+// 1 with probability pct / 100
+static int gen_chance(int pct)
+{
+    return gen_range(100) < pct;
+}
+
+static void gen_put(gen_bits_t *bw, unsigned int v, int n)
+{
+    while (n-- > 0)
+    {
+        if ((bw->bits & 7) == 0)
+        {
+            bw->buf[bw->bits >> 3] = 0;
+        }
+        if ((v >> n) & 1U)
+        {
+            bw->buf[bw->bits >> 3] |= (unsigned char)(0x80 >> (bw->bits & 7));
+        }
+        bw->bits++;
+    }
+}
+
+// Walk the pair table t of hufftabs.c for the code at the top of word
+static int gen_pair_walk(int t, unsigned int word, int *x, int *y)
+{
+    const unsigned short *tCurr = huffTable + huffTabOffset[t];
+    unsigned short cw;
+    int used = 0, maxBits;
+
+    if (huffTabLookup[t].tabType == oneShot)
+    {
+        maxBits = tCurr[0] & 0x0f;
+        cw = tCurr[1 + (word >> (32 - maxBits))];
+    }
+    else
+    {
+        while (1)
+        {
+            maxBits = tCurr[0] & 0x0f;
+            cw = tCurr[1 + (word >> (32 - maxBits))];
+            if (cw >> 12)
+            {
+                break;
+            }
+            used += maxBits;
+            word <<= maxBits;
+            tCurr += cw;
+        }
+    }
+    *x = (cw >> 4) & 0x0f;
+    *y = (cw >> 8) & 0x0f;
+    return used + (cw >> 12);
+}
+
+// Turn the decoder tables into code books by decoding every 19-bit word
+static void gen_build_codes(void)
+{
+    unsigned int v, word;
+    int t, q, i, x, y, len, maxBits;
+    unsigned char e;
+
+    for (t = 0; t < HUFF_PAIRTABS; t++)
+    {
+        if (huffTabLookup[t].tabType != oneShot && huffTabLookup[t].tabType != loopNoLinbits &&
+            huffTabLookup[t].tabType != loopLinbits)
+        {
+            continue;
+        }
+        for (v = 0; v < (1U << GEN_MAX_CODELEN); v++)
+        {
+            word = v << (32 - GEN_MAX_CODELEN);
+            len = gen_pair_walk(t, word, &x, &y);
+            if (gen_pair_code[t][x][y].len == 0)
+            {
+                gen_pair_code[t][x][y].code = v >> (GEN_MAX_CODELEN - len);
+                gen_pair_code[t][x][y].len = len;
+            }
+            if (x > gen_pair_max[t])
+            {
+                gen_pair_max[t] = x;
+            }
+        }
+        if (huffTabLookup[t].tabType == loopLinbits)
+        {
+            gen_pair_max[t] = 15 + (1 << huffTabLookup[t].linBits) - 1;
+        }
+    }
+
+    for (q = 0; q < 2; q++)
+    {
+        maxBits = quadTabMaxBits[q];
+        for (i = 0; i < (1 << maxBits); i++)
+        {
+            e = quadTable[quadTabOffset[q] + i];
+            len = e >> 4;
+            if (gen_quad_code[q][e & 0x0f].len == 0)
+            {
+                gen_quad_code[q][e & 0x0f].code = (unsigned int)i >> (maxBits - len);
+                gen_quad_code[q][e & 0x0f].len = len;
+            }
+        }
+    }
+}
+
+// Pair table for a region whose largest value is vmax, not always the cheapest one
+static int gen_pick_table(int vmax)
+{
+    int t, n = 0, cand[HUFF_PAIRTABS];
+
+    if (vmax == 0 && gen_chance(70))
+    {
+        return 0;
+    }
+    for (t = 1; t < HUFF_PAIRTABS; t++)
+    {
+        if (gen_pair_max[t] >= vmax && gen_pair_max[t] != 0 &&
+            (vmax > 15 || huffTabLookup[t].tabType != loopLinbits || gen_chance(10)))
+        {
+            cand[n++] = t;
+        }
+    }
+    // mostly one of the smallest that fit
+    return cand[gen_chance(70) ? gen_range(n < 3 ? n : 3) : gen_range(n)];
+}
+
+// Scale factor bits of a granule, as UnpackScaleFactors reads them
+static int gen_part2_bits(int mpeg1, const gen_granule_t *g, int gr, const int *scfsi)
+{
+    int slen0, slen1, s[4], bits;
+
+    if (mpeg1)
+    {
+        slen0 = gen_sflen[g->sfCompress][0];
+        slen1 = gen_sflen[g->sfCompress][1];
+        if (g->blockType == 2)
+        {
+            return (g->mixed ? 17 : 18) * slen0 + 18 * slen1;
+        }
+        if (gr == 0)
+        {
+            return 11 * slen0 + 10 * slen1;
+        }
+        return (scfsi[0] ? 0 : 6 * slen0) + (scfsi[1] ? 0 : 5 * slen0) + (scfsi[2] ? 0 : 5 * slen1) +
+               (scfsi[3] ? 0 : 5 * slen1);
+    }
+
+    // MPEG2 without intensity stereo, scalefac_compress < 400
+    s[0] = (g->sfCompress >> 4) / 5;
+    s[1] = (g->sfCompress >> 4) % 5;
+    s[2] = (g->sfCompress & 0x0f) >> 2;
+    s[3] = g->sfCompress & 0x03;
+    if (g->blockType != 2)
+    {
+        bits = 6 * s[0] + 5 * (s[1] + s[2] + s[3]);
+    }
+    else
+    {
+        bits = (g->mixed ? 6 : 9) * s[0] + 9 * (s[1] + s[2] + s[3]);
+    }
+    return bits;
+}
+
+// Region boundaries of the big values, as DecodeHuffman finds them
+static void gen_regions(const SFBandTable *sfBand, int mpeg1, const gen_granule_t *g, int *r1, int *r2)
+{
+    if (g->winSwitch && g->blockType == 2)
+    {
+        if (g->mixed == 0)
+        {
+            *r1 = sfBand->s[(g->region0 + 1) / 3] * 3;
+        }
+        else if (mpeg1)
+        {
+            *r1 = sfBand->l[g->region0 + 1];
+        }
+        else
+        {
+            *r1 = sfBand->l[6] + 2 * (sfBand->s[4] - sfBand->s[3]);
+        }
+        *r2 = MAX_NSAMP;
+    }
+    else
+    {
+        *r1 = sfBand->l[g->region0 + 1];
+        *r2 = sfBand->l[g->region0 + 1 + g->region1 + 1];
+    }
+}
+
+static void gen_put_pair_value(gen_bits_t *bw, int t, int v)
+{
+    int a = v < 0 ? -v : v;
+
+    if (huffTabLookup[t].tabType == loopLinbits && a >= 15)
+    {
+        gen_put(bw, (unsigned int)(a - 15), huffTabLookup[t].linBits);
+    }
+    if (a)
+    {
+        gen_put(bw, v < 0, 1);
+    }
+}
+
+// Huffman code one granule of spectrum q into bw, return 0 if the tables cannot code it
+static int gen_huffman(gen_bits_t *bw, const SFBandTable *sfBand, int mpeg1, gen_granule_t *g, const int *q, int nz)
+{
+    int i, r, t, a, b, vmax, rEnd[4], r1, r2, nQuads, idx;
+
+    // big values up to the last |value| > 1, count1 quads after them up to nz
+    for (i = nz - 1; i >= 0 && q[i] >= -1 && q[i] <= 1; i--)
+        ;
+    g->bigVals = (i + 2) / 2;
+    nQuads = (nz - 2 * g->bigVals + 3) / 4;
+    if (2 * g->bigVals + 4 * nQuads > MAX_NSAMP)
+    {
+        nQuads = (MAX_NSAMP - 2 * g->bigVals) / 4;
+    }
+
+    gen_regions(sfBand, mpeg1, g, &r1, &r2);
+    rEnd[3] = 2 * g->bigVals;
+    rEnd[2] = r2 < rEnd[3] ? r2 : rEnd[3];
+    rEnd[1] = r1 < rEnd[3] ? r1 : rEnd[3];
+    rEnd[0] = 0;
+    for (r = 0; r < 3; r++)
+    {
+        vmax = 0;
+        for (i = rEnd[r]; i < rEnd[r + 1]; i++)
+        {
+            a = q[i] < 0 ? -q[i] : q[i];
+            vmax = a > vmax ? a : vmax;
+        }
+        if (vmax > gen_pair_max[HUFF_PAIRTABS - 1])
+        {
+            return 0;
+        }
+        g->tableSelect[r] = gen_pick_table(vmax);
+        t = g->tableSelect[r];
+        for (i = rEnd[r]; t != 0 && i < rEnd[r + 1]; i += 2)
+        {
+            a = q[i] < 0 ? -q[i] : q[i];
+            b = q[i + 1] < 0 ? -q[i + 1] : q[i + 1];
+            a = a > 15 ? 15 : a;
+            b = b > 15 ? 15 : b;
+            gen_put(bw, gen_pair_code[t][a][b].code, gen_pair_code[t][a][b].len);
+            gen_put_pair_value(bw, t, q[i]);
+            gen_put_pair_value(bw, t, q[i + 1]);
+        }
+    }
+    if (g->winSwitch)
+    {
+        // no region 2, and no table sent for it
+        g->tableSelect[2] = 0;
+    }
+
+    for (i = rEnd[3]; i < rEnd[3] + 4 * nQuads; i += 4)
+    {
+        idx = ((q[i] != 0) << 3) | ((q[i + 1] != 0) << 2) | ((q[i + 2] != 0) << 1) | (q[i + 3] != 0);
+        gen_put(bw, gen_quad_code[g->count1Table][idx].code, gen_quad_code[g->count1Table][idx].len);
+        for (r = 0; r < 4; r++)
+        {
+            if (q[i + r])
+            {
+                gen_put(bw, q[i + r] < 0, 1);
+            }
+        }
+    }
+    return 1;
+}
+
+// Spectrum of one granule: a peak level falling off to a cutoff, then a +-1 tail
+static int gen_spectrum(int *q, int amp)
+{
+    int i, nz, cut, v;
+
+    memset(q, 0, MAX_NSAMP * sizeof(int));
+    cut = 32 + gen_range(MAX_NSAMP - 32);
+    nz = cut + gen_range(MAX_NSAMP - cut + 1);
+    for (i = 0; i < nz; i++)
+    {
+        if (i < cut)
+        {
+            // a few strong lines over a falling floor
+            v = gen_range(amp * (cut - i) / cut + 1);
+            if (gen_chance(3))
+            {
+                v = v * 8 + gen_range(amp + 1);
+            }
+        }
+        else
+        {
+            v = gen_chance(30);
+        }
+        q[i] = (v && gen_chance(50)) ? -v : v;
+    }
+    return nz;
+}
+
+// Side info and main data of one granule, at most budget bits
+static void gen_granule(gen_bits_t *md, const SFBandTable *sfBand, int mpeg1, gen_granule_t *g, int gr,
+                        const int *scfsi, int budget)
+{
+    static const int amps[] = {1, 2, 4, 8, 16, 40, 120, 600};
+    int q[MAX_NSAMP];
+    int nz, part2, i;
+    long start = md->bits;
+
+    g->globalGain = gen_gain_base + gen_range(gen_gain_span);
+    g->sfScale = gen_range(2);
+    g->count1Table = gen_range(2);
+    g->preFlag = mpeg1 ? gen_range(2) : 0;
+    g->sfCompress = mpeg1 ? gen_range(16) : gen_range(400);
+    part2 = gen_part2_bits(mpeg1, g, gr, scfsi);
+    if (part2 > budget / 2)
+    {
+        g->sfCompress = 0;
+        part2 = 0;
+    }
+    if (!g->winSwitch)
+    {
+        g->region0 = gen_range(16);
+        g->region1 = gen_range(8);
+        if (g->region0 + g->region1 > 20)
+        {
+            g->region1 = 20 - g->region0;
+        }
+    }
+    else
+    {
+        g->region0 = (g->blockType == 2 && g->mixed == 0) ? 8 : 7;
+        g->region1 = 20 - g->region0;
+    }
+    for (i = 0; i < 3; i++)
+    {
+        g->subBlockGain[i] = gen_chance(30) ? gen_range(8) : 0;
+        g->tableSelect[i] = 0;
+    }
+
+    // scale factors are any values of their lengths
+    for (i = 0; i < part2; i++)
+    {
+        gen_put(md, gen_range(2), 1);
+    }
+
+    nz = gen_spectrum(q, amps[gen_range(sizeof(amps) / sizeof(amps[0]))]);
+    while (1)
+    {
+        if (gen_huffman(md, sfBand, mpeg1, g, q, nz) && md->bits - start <= budget && md->bits - start <= 4095)
+        {
+            break;
+        }
+        // too big: fewer lines, down to none at all
+        md->bits = start + part2;
+        md->buf[md->bits >> 3] &= (unsigned char)~(0xff >> (md->bits & 7));
+        nz /= 2;
+        for (i = nz; i < MAX_NSAMP; i++)
+        {
+            q[i] = 0;
+        }
+        if (nz < 2)
+        {
+            nz = 0;
+        }
+    }
+    g->part23 = (int)(md->bits - start);
+}
+
+static void gen_side_granule(gen_bits_t *bw, int mpeg1, const gen_granule_t *g)
+{
+    gen_put(bw, (unsigned int)g->part23, 12);
+    gen_put(bw, (unsigned int)g->bigVals, 9);
+    gen_put(bw, (unsigned int)g->globalGain, 8);
+    gen_put(bw, (unsigned int)g->sfCompress, mpeg1 ? 4 : 9);
+    gen_put(bw, (unsigned int)g->winSwitch, 1);
+    if (g->winSwitch)
+    {
+        gen_put(bw, (unsigned int)g->blockType, 2);
+        gen_put(bw, (unsigned int)g->mixed, 1);
+        gen_put(bw, (unsigned int)g->tableSelect[0], 5);
+        gen_put(bw, (unsigned int)g->tableSelect[1], 5);
+        gen_put(bw, (unsigned int)g->subBlockGain[0], 3);
+        gen_put(bw, (unsigned int)g->subBlockGain[1], 3);
+        gen_put(bw, (unsigned int)g->subBlockGain[2], 3);
+    }
+    else
+    {
+        gen_put(bw, (unsigned int)g->tableSelect[0], 5);
+        gen_put(bw, (unsigned int)g->tableSelect[1], 5);
+        gen_put(bw, (unsigned int)g->tableSelect[2], 5);
+        gen_put(bw, (unsigned int)g->region0, 4);
+        gen_put(bw, (unsigned int)g->region1, 3);
+    }
+    if (mpeg1)
+    {
+        gen_put(bw, (unsigned int)g->preFlag, 1);
+    }
+    gen_put(bw, (unsigned int)g->sfScale, 1);
+    gen_put(bw, (unsigned int)g->count1Table, 1);
+}
+
+int main(int argc, char **argv)
+{
+    static unsigned char payload[1 << 24];  // main data stream, every frame's slots in a row
+    static unsigned char stream[1 << 25];   // the file, slots filled in once all main data is placed
+    gen_slots_t *slots;
+    static unsigned char mdbuf[GEN_MAX_FRAME + 1024];
+    gen_granule_t g[MAX_NGRAN][MAX_NCHAN];
+    gen_bits_t bw, md;
+    const SFBandTable *sfBand;
+    int corrupt = 0, arg = 1;
+    int ver, mpeg1, sr, mode, modeExt, crc, nch, ngr, maxresv, vbr, bri, pad;
+    int f, nframes, gr, ch, fsize, si, hdr, nslots, budget, mdb, i, scfsi[MAX_NCHAN][4];
+    long S = 0, P = 0, L, pos = 0;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++)
+    {
+        if (strcmp(argv[arg], "-c") == 0)
+        {
+            corrupt = 1;
+        }
+        else if (strcmp(argv[arg], "-q") == 0)
+        {
+            gen_gain_base = 124;
+            gen_gain_span = 5;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (argc - arg != 2)
+    {
+        fprintf(stderr, "usage: %s [-c] [-q] seed nframes > out.mp3\n", argv[0]);
+        return 2;
+    }
+    gen_state = 2463534242U ^ (unsigned int)strtoul(argv[arg], NULL, 0) * 2654435761U;
+    if (gen_state == 0)
+    {
+        gen_state = 1;
+    }
+    nframes = atoi(argv[arg + 1]);
+    slots = calloc(nframes > 0 ? nframes : 1, sizeof(gen_slots_t));
+    if (slots == NULL)
+    {
+        return 1;
+    }
+    gen_build_codes();
+
+    // one format for the whole stream
+    ver = gen_chance(60) ? MPEG1 : (gen_chance(60) ? MPEG2 : MPEG25);
+    mpeg1 = (ver == MPEG1);
+    sr = gen_range(3);
+    mode = gen_range(4);   // stereo, joint stereo, dual channel, mono
+    crc = gen_chance(20);
+    nch = mode == 3 ? 1 : 2;
+    ngr = mpeg1 ? 2 : 1;
+    maxresv = mpeg1 ? 511 : 255;
+    vbr = gen_chance(50);
+    bri = 1 + gen_range(14);
+    sfBand = &sfBandTable[ver][sr];
+
+    // junk in front of the first frame
+    for (i = corrupt ? gen_range(300) : 0; i > 0; i--)
+    {
+        stream[pos++] = (unsigned char)gen_range(256);
+    }
+
+    for (f = 0; f < nframes && S + GEN_MAX_FRAME <= (long)sizeof(payload) &&
+                pos + GEN_MAX_FRAME + 100 <= (long)sizeof(stream);
+         f++)
+    {
+        if (vbr)
+        {
+            bri = 1 + gen_range(14);
+        }
+        pad = gen_range(2);
+        fsize = (mpeg1 ? 144 : 72) * gen_bitrate[!mpeg1][bri] * 1000 / gen_samprate[ver][sr] + pad;
+        si = mpeg1 ? (nch == 1 ? 17 : 32) : (nch == 1 ? 9 : 17);
+        hdr = crc ? 6 : 4;
+        nslots = fsize - hdr - si;
+        // intensity stereo only in MPEG1, the MPEG2 scale factors here are the plain kind
+        modeExt = mode == 1 ? (mpeg1 ? gen_range(4) : gen_range(2) * 2) : 0;
+
+        // the main data may start up to maxresv bytes back, in what earlier frames left over
+        if (S - P > maxresv)
+        {
+            P = S - maxresv;
+        }
+        if (gen_chance(3))
+        {
+            P = S;
+        }
+        mdb = (int)(S - P);
+        budget = (int)(S + nslots - P) * 8;
+        if (gen_chance(40))
+        {
+            // leave some for the reservoir
+            budget = budget * (50 + gen_range(50)) / 100;
+        }
+
+        for (ch = 0; ch < nch; ch++)
+        {
+            for (gr = 0; gr < ngr; gr++)
+            {
+                g[gr][ch].winSwitch = gen_chance(20);
+                g[gr][ch].blockType = g[gr][ch].winSwitch ? 1 + gen_range(3) : 0;
+                g[gr][ch].mixed = g[gr][ch].blockType == 2 ? gen_chance(30) : 0;
+            }
+            // scfsi only between two long block granules
+            for (i = 0; i < 4; i++)
+            {
+                scfsi[ch][i] = (mpeg1 && g[0][ch].blockType != 2 && g[1][ch].blockType != 2) ? gen_range(2) : 0;
+            }
+        }
+
+        md.buf = mdbuf;
+        md.bits = 0;
+        for (gr = 0; gr < ngr; gr++)
+        {
+            for (ch = 0; ch < nch; ch++)
+            {
+                gen_granule(&md, sfBand, mpeg1, &g[gr][ch], gr, scfsi[ch],
+                            (int)(budget - md.bits) / (ngr * nch - gr * nch - ch));
+            }
+        }
+        L = (md.bits + 7) / 8;
+        if (md.bits & 7)
+        {
+            gen_put(&md, 0, 8 - (int)(md.bits & 7));
+        }
+
+        // header and side info
+        bw.buf = stream + pos;
+        bw.bits = 0;
+        gen_put(&bw, 0x7ff, 11);
+        gen_put(&bw, ver == MPEG1 ? 3 : (ver == MPEG2 ? 2 : 0), 2);
+        gen_put(&bw, 1, 2); // layer 3
+        gen_put(&bw, crc ? 0 : 1, 1);
+        gen_put(&bw, (unsigned int)bri, 4);
+        gen_put(&bw, (unsigned int)sr, 2);
+        gen_put(&bw, (unsigned int)pad, 1);
+        gen_put(&bw, 0, 1);
+        gen_put(&bw, (unsigned int)mode, 2);
+        gen_put(&bw, (unsigned int)modeExt, 2);
+        gen_put(&bw, 0, 1);
+        gen_put(&bw, 1, 1);
+        gen_put(&bw, 0, 2);
+        if (crc)
+        {
+            gen_put(&bw, gen_rand() & 0xffff, 16); // not checked by Helix
+        }
+        gen_put(&bw, (unsigned int)mdb, mpeg1 ? 9 : 8);
+        gen_put(&bw, 0, mpeg1 ? (nch == 1 ? 5 : 3) : (nch == 1 ? 1 : 2));
+        for (ch = 0; mpeg1 && ch < nch; ch++)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                gen_put(&bw, (unsigned int)scfsi[ch][i], 1);
+            }
+        }
+        for (gr = 0; gr < ngr; gr++)
+        {
+            for (ch = 0; ch < nch; ch++)
+            {
+                gen_side_granule(&bw, mpeg1, &g[gr][ch]);
+            }
+        }
+        if (bw.bits != (hdr + si) * 8)
+        {
+            fprintf(stderr, "mp3gen: side info is %ld bits\n", bw.bits);
+            return 1;
+        }
+
+        // main data at [P, P + L) of the payload, ancillary junk in the gaps
+        for (i = 0; P + i < S + nslots; i++)
+        {
+            payload[P + i] = (unsigned char)(i < L ? mdbuf[i] : gen_range(256));
+        }
+        if (corrupt && gen_chance(10))
+        {
+            for (i = 0; i < L; i++)
+            {
+                payload[P + i] = (unsigned char)gen_range(256);
+            }
+        }
+        P += L;
+        pos += hdr + si;
+        slots[f].at = pos;
+        slots[f].start = S;
+        slots[f].len = nslots;
+        pos += nslots;
+        S += nslots;
+
+        // junk between frames, the next frames lose their reservoir
+        if (corrupt && gen_chance(2))
+        {
+            for (i = 1 + gen_range(100); i > 0; i--)
+            {
+                stream[pos++] = (unsigned char)gen_range(256);
+            }
+        }
+    }
+    nframes = f;
+
+    for (i = corrupt ? gen_range(50) : 0; i > 0; i--)
+    {
+        stream[pos++] = (unsigned char)gen_range(256);
+    }
+    for (f = 0; f < nframes; f++)
+    {
+        memcpy(stream + slots[f].at, payload + slots[f].start, (size_t)slots[f].len);
+    }
+    fwrite(stream, 1, (size_t)pos, stdout);
+    free(slots);
+    return 0;
+}
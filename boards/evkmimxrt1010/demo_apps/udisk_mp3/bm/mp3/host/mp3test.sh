@@ -0,0 +1,143 @@
+#!/bin/sh
+#
+# Host comparison tests of the Helix decoder (make test)
+#
+# Decodes synthetic streams from mp3gen with the decoder builds of the Makefile and in the
+# decode modes of mp3dec, and checks every output against the reference build:
+#   - bit exact: HELIX_DSP_KERNELS, HELIX_DQ_KERNELS, HELIX_HUFF_FAST_BITS, ring input,
+#     granule calls, decoders in caller arenas and interleaved with a second decoder,
+#     a decoder reset between two runs of a stream against two fresh decodes
+#   - HELIX_FLOAT_DSP within an SNR limit
+#   - mono downmix against (L + R) / 2, band limiting against the full spectrum
+# Valid streams must decode without errors. Streams with corrupt frames must give the
+# same output and error count as the reference, except that the chained Huffman tables
+# and the fast tables read a corrupt pair differently, so the HELIX_HUFF_FAST_BITS
+# builds are checked against each other there.
+#
+# usage: mp3test.sh [build dir]
+
+BUILD=${1:-build}
+WORK=$BUILD/test
+SEEDS="1 2 3 4 5 6 7 8 9 10 11 12"
+QUIET_SEEDS="1 2 4 5 7 13"
+NFRAMES=200
+FLOAT_SNR=70
+MONO_LSB=8
+
+failed=0
+checks=0
+
+mkdir -p "$WORK" || exit 1
+
+fail()
+{
+    echo "FAIL: $*"
+    failed=$((failed + 1))
+}
+
+# decode build name [mp3dec options] -> $WORK/name.pcm, summary line in $WORK/name.txt
+decode()
+{
+    variant=$1
+    out=$2
+    shift 2
+    "$BUILD/mp3dec_$variant" "$@" "$WORK/$out.pcm" > "$WORK/$out.txt" || fail "mp3dec_$variant $*"
+}
+
+# same output and summary line
+same()
+{
+    checks=$((checks + 1))
+    if ! cmp -s "$WORK/$1.txt" "$WORK/$2.txt"; then
+        fail "$3: $(cat "$WORK/$2.txt") against $(cat "$WORK/$1.txt")"
+    elif ! "$BUILD/pcmcmp" "$WORK/$1.pcm" "$WORK/$2.pcm" > "$WORK/$2.cmp"; then
+        fail "$3: $(cat "$WORK/$2.cmp")"
+    fi
+}
+
+# value of a field of the summary line
+field()
+{
+    sed -n "s/.*$2 \([0-9]*\).*/\1/p" "$WORK/$1.txt"
+}
+
+for seed in $SEEDS; do
+    # valid streams
+    s=v$seed
+    "$BUILD/mp3gen" $seed $NFRAMES > "$WORK/$s.mp3" || fail "mp3gen $seed"
+    decode ref $s.ref "$WORK/$s.mp3"
+    checks=$((checks + 1))
+    [ "$(field $s.ref errors)" = 0 ] && [ "$(field $s.ref frames)" = $NFRAMES ] || \
+        fail "$s: reference decode $(cat "$WORK/$s.ref.txt")"
+    for variant in dsp dq h7 h8 h12 fast; do
+        decode $variant $s.$variant "$WORK/$s.mp3"
+        same $s.ref $s.$variant "$s $variant"
+    done
+    decode fast $s.ring -r 8192 "$WORK/$s.mp3"
+    same $s.fast $s.ring "$s ring input"
+    decode fast $s.ring2 -r 6007 -g "$WORK/$s.mp3"
+    same $s.fast $s.ring2 "$s ring input, granules"
+    decode fast $s.gran -g "$WORK/$s.mp3"
+    same $s.fast $s.gran "$s granules"
+    decode fast $s.arena -a "$WORK/$s.mp3"
+    same $s.fast $s.arena "$s arena"
+    decode fast $s.reset -t -r 6007 -g "$WORK/$s.mp3"
+    cat "$WORK/$s.fast.pcm" "$WORK/$s.fast.pcm" > "$WORK/$s.twice.pcm"
+    checks=$((checks + 1))
+    [ "$(field $s.reset frames)" = $((2 * NFRAMES)) ] && \
+        "$BUILD/pcmcmp" "$WORK/$s.twice.pcm" "$WORK/$s.reset.pcm" > "$WORK/$s.reset.cmp" || \
+        fail "$s reset: $(cat "$WORK/$s.reset.txt") $(cat "$WORK/$s.reset.cmp")"
+    decode float $s.float "$WORK/$s.mp3"
+    checks=$((checks + 1))
+    "$BUILD/pcmcmp" -snr $FLOAT_SNR "$WORK/$s.fast.pcm" "$WORK/$s.float.pcm" > "$WORK/$s.float.cmp" || \
+        fail "$s float: $(cat "$WORK/$s.float.cmp")"
+
+    # streams with corrupt frames
+    s=c$seed
+    "$BUILD/mp3gen" -c $seed $NFRAMES > "$WORK/$s.mp3" || fail "mp3gen -c $seed"
+    for variant in ref dsp dq h7 h8 h12 fast; do
+        decode $variant $s.$variant "$WORK/$s.mp3"
+    done
+    same $s.ref $s.dsp "$s dsp"
+    same $s.ref $s.dq "$s dq"
+    same $s.h8 $s.h7 "$s h7"
+    same $s.h8 $s.h12 "$s h12"
+    decode fast $s.ring -r 8192 "$WORK/$s.mp3"
+    same $s.fast $s.ring "$s ring input"
+    decode fast $s.gran -g "$WORK/$s.mp3"
+    same $s.fast $s.gran "$s granules"
+    decode fast $s.inter -a -i "$WORK/v$seed.mp3" "$WORK/$s.mp3"
+    same $s.fast $s.inter "$s interleaved with v$seed"
+    decode fast $s.reset -t "$WORK/$s.mp3"
+    cat "$WORK/$s.fast.pcm" "$WORK/$s.fast.pcm" > "$WORK/$s.twice.pcm"
+    checks=$((checks + 1))
+    "$BUILD/pcmcmp" "$WORK/$s.twice.pcm" "$WORK/$s.reset.pcm" > "$WORK/$s.reset.cmp" || \
+        fail "$s reset: $(cat "$WORK/$s.reset.cmp")"
+done
+
+# low-power options on streams that do not clip
+for seed in $QUIET_SEEDS; do
+    s=q$seed
+    "$BUILD/mp3gen" -q $seed $NFRAMES > "$WORK/$s.mp3" || fail "mp3gen -q $seed"
+    decode fast $s.fast "$WORK/$s.mp3"
+    nchans=$(field $s.fast nchans)
+    if [ "$nchans" = 2 ]; then
+        decode fast $s.mono -d "$WORK/$s.mp3"
+        checks=$((checks + 1))
+        "$BUILD/pcmcmp" -mono $MONO_LSB "$WORK/$s.fast.pcm" "$WORK/$s.mono.pcm" > "$WORK/$s.mono.cmp" || \
+            fail "$s downmix: $(cat "$WORK/$s.mono.cmp")"
+    fi
+    for nsb in 4 8 16; do
+        decode fast $s.sb$nsb -s $nsb "$WORK/$s.mp3"
+        checks=$((checks + 1))
+        "$BUILD/pcmcmp" -band $nsb $nchans "$WORK/$s.fast.pcm" "$WORK/$s.sb$nsb.pcm" > "$WORK/$s.sb$nsb.cmp" || \
+            fail "$s $nsb subbands: $(cat "$WORK/$s.sb$nsb.cmp")"
+    done
+done
+
+if [ $failed -ne 0 ]; then
+    echo "$failed of $checks checks failed"
+    exit 1
+fi
+echo "all $checks checks passed"
+exit 0
@@ -0,0 +1,245 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////////
+// PCM comparison for the host tests (see mp3test.sh), 16-bit native endian
+//
+// pcmcmp a.pcm b.pcm                    bit exact
+// pcmcmp -snr db a.pcm b.pcm            b within db of SNR of reference a
+// pcmcmp -mono lsb st.pcm mono.pcm      mono within lsb of (L + R) / 2 of st,
+//                                       samples where st clips are left out
+// pcmcmp -band nsb nch full.pcm part.pcm
+//                                       part keeps the spectrum of full below
+//                                       subband nsb and has nothing but output
+//                                       rounding noise above it (full must not clip)
+//////////////////////////////////////////////////////////////////////////////////
+
+#define CMP_FFT_N 1024
+
+static short *cmp_load(const char *path, long *n)
+{
+    FILE *fp = fopen(path, "rb");
+    short *pcm;
+    long len;
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "pcmcmp: cannot open %s\n", path);
+        exit(2);
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    pcm = malloc(len + sizeof(short));
+    if (pcm == NULL || fread(pcm, 1, len, fp) != (size_t)len)
+    {
+        fprintf(stderr, "pcmcmp: cannot read %s\n", path);
+        exit(2);
+    }
+    fclose(fp);
+    *n = len / (long)sizeof(short);
+    return pcm;
+}
+
+static int cmp_exact(const short *a, long na, const short *b, long nb)
+{
+    long i, n = na < nb ? na : nb;
+
+    for (i = 0; i < n && a[i] == b[i]; i++)
+        ;
+    if (i < n || na != nb)
+    {
+        printf("differ at sample %ld of %ld/%ld\n", i, na, nb);
+        return 1;
+    }
+    printf("identical, %ld samples\n", na);
+    return 0;
+}
+
+static int cmp_snr(double limit, const short *a, long na, const short *b, long nb)
+{
+    double sig = 0.0, err = 0.0, d, snr;
+    long i, maxd = 0;
+
+    if (na != nb)
+    {
+        printf("lengths differ: %ld/%ld\n", na, nb);
+        return 1;
+    }
+    for (i = 0; i < na; i++)
+    {
+        d = (double)b[i] - a[i];
+        sig += (double)a[i] * a[i];
+        err += d * d;
+        maxd = labs((long)d) > maxd ? labs((long)d) : maxd;
+    }
+    snr = err > 0.0 ? 10.0 * log10(sig / err) : INFINITY;
+    printf("SNR %.1f dB, largest difference %ld lsb, %ld samples\n", snr, maxd, na);
+    return snr < limit;
+}
+
+static int cmp_mono(long limit, const short *st, long nst, const short *mono, long nmono)
+{
+    long i, d, maxd = 0, clipped = 0;
+
+    if (nst != 2 * nmono)
+    {
+        printf("lengths differ: %ld stereo/%ld mono\n", nst, nmono);
+        return 1;
+    }
+    for (i = 0; i < nmono; i++)
+    {
+        if (st[2 * i] == 32767 || st[2 * i] == -32768 || st[2 * i + 1] == 32767 || st[2 * i + 1] == -32768)
+        {
+            clipped++;
+            continue;
+        }
+        d = labs((long)mono[i] - ((long)st[2 * i] + st[2 * i + 1]) / 2);
+        maxd = d > maxd ? d : maxd;
+    }
+    printf("largest difference %ld lsb, %ld samples, %ld clipped left out\n", maxd, nmono, clipped);
+    return maxd > limit;
+}
+
+// in-place radix 2 FFT
+static void cmp_fft(double *re, double *im, int n)
+{
+    int i, j, k, m;
+    double wr, wi, tr, ti, a;
+
+    for (i = 1, j = 0; i < n; i++)
+    {
+        for (k = n >> 1; j & k; k >>= 1)
+            j ^= k;
+        j |= k;
+        if (i < j)
+        {
+            tr = re[i], re[i] = re[j], re[j] = tr;
+            ti = im[i], im[i] = im[j], im[j] = ti;
+        }
+    }
+    for (m = 2; m <= n; m <<= 1)
+    {
+        a = -2.0 * M_PI / m;
+        for (i = 0; i < n; i += m)
+        {
+            for (k = 0; k < m / 2; k++)
+            {
+                wr = cos(a * k);
+                wi = sin(a * k);
+                tr = wr * re[i + k + m / 2] - wi * im[i + k + m / 2];
+                ti = wr * im[i + k + m / 2] + wi * re[i + k + m / 2];
+                re[i + k + m / 2] = re[i + k] - tr;
+                im[i + k + m / 2] = im[i + k] - ti;
+                re[i + k] += tr;
+                im[i + k] += ti;
+            }
+        }
+    }
+}
+
+// Power spectrum of channel 0, summed over windowed blocks
+// return:the number of blocks
+static long cmp_spectrum(const short *pcm, long n, int nch, double *power)
+{
+    static double re[CMP_FFT_N], im[CMP_FFT_N];
+    long pos, blocks = 0;
+    int i;
+
+    memset(power, 0, sizeof(double) * (CMP_FFT_N / 2));
+    for (pos = 0; pos + (long)CMP_FFT_N * nch <= n; pos += (long)CMP_FFT_N * nch)
+    {
+        for (i = 0; i < CMP_FFT_N; i++)
+        {
+            re[i] = pcm[pos + (long)i * nch] * (0.5 - 0.5 * cos(2.0 * M_PI * i / CMP_FFT_N));
+            im[i] = 0.0;
+        }
+        cmp_fft(re, im, CMP_FFT_N);
+        for (i = 0; i < CMP_FFT_N / 2; i++)
+        {
+            power[i] += re[i] * re[i] + im[i] * im[i];
+        }
+        blocks++;
+    }
+    return blocks;
+}
+
+static int cmp_band(int nsb, int nch, const short *full, long nfull, const short *part, long npart)
+{
+    static double pf[CMP_FFT_N / 2], pp[CMP_FFT_N / 2];
+    double inFull = 0.0, inPart = 0.0, outFull = 0.0, outPart = 0.0, floor, inDb;
+    long blocks;
+    int bin, lo, hi;
+
+    if (nfull != npart)
+    {
+        printf("lengths differ: %ld/%ld\n", nfull, npart);
+        return 1;
+    }
+    cmp_spectrum(full, nfull, nch, pf);
+    blocks = cmp_spectrum(part, npart, nch, pp);
+
+    // subband k covers bins k * N / 64 to (k + 1) * N / 64, one subband either side of
+    // the edge is left to the synthesis filter slopes
+    lo = (nsb - 1) * CMP_FFT_N / 64;
+    hi = (nsb + 1) * CMP_FFT_N / 64;
+    for (bin = 1; bin < CMP_FFT_N / 2; bin++)
+    {
+        if (bin < lo)
+        {
+            inFull += pf[bin];
+            inPart += pp[bin];
+        }
+        else if (bin >= hi)
+        {
+            outFull += pf[bin];
+            outPart += pp[bin];
+        }
+    }
+    // rounding to 16 bits leaves white noise of 1/12 lsb^2 per sample, the Hann
+    // window passes 3/8 of it into every bin
+    floor = blocks * (CMP_FFT_N / 2 - hi) * (CMP_FFT_N * 0.375 / 12.0);
+    inDb = inFull > 0.0 && inPart > 0.0 ? 10.0 * log10(inPart / inFull) : 0.0;
+    printf("passband %+.2f dB against the full decode, stopband %+.1f dB (full %+.1f dB) over rounding noise\n",
+           inDb, 10.0 * log10(outPart / floor + 1e-9), 10.0 * log10(outFull / floor + 1e-9));
+    return fabs(inDb) > 0.5 || outPart > 2.0 * floor + outFull * 1e-4;
+}
+
+int main(int argc, char **argv)
+{
+    short *a, *b;
+    long na, nb;
+
+    if (argc == 3)
+    {
+        a = cmp_load(argv[1], &na);
+        b = cmp_load(argv[2], &nb);
+        return cmp_exact(a, na, b, nb);
+    }
+    if (argc == 5 && strcmp(argv[1], "-snr") == 0)
+    {
+        a = cmp_load(argv[3], &na);
+        b = cmp_load(argv[4], &nb);
+        return cmp_snr(atof(argv[2]), a, na, b, nb);
+    }
+    if (argc == 5 && strcmp(argv[1], "-mono") == 0)
+    {
+        a = cmp_load(argv[3], &na);
+        b = cmp_load(argv[4], &nb);
+        return cmp_mono(atol(argv[2]), a, na, b, nb);
+    }
+    if (argc == 6 && strcmp(argv[1], "-band") == 0)
+    {
+        a = cmp_load(argv[4], &na);
+        b = cmp_load(argv[5], &nb);
+        return cmp_band(atoi(argv[2]), atoi(argv[3]), a, na, b, nb);
+    }
+    fprintf(stderr,
+            "usage: pcmcmp a.pcm b.pcm\n"
+            "       pcmcmp -snr db ref.pcm test.pcm\n"
+            "       pcmcmp -mono lsb stereo.pcm mono.pcm\n"
+            "       pcmcmp -band nsb nch full.pcm part.pcm\n");
+    return 2;
+}
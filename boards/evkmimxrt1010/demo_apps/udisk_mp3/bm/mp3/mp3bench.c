@@ -0,0 +1,207 @@
+#include "mp3bench.h"
+#include "mp3_config.h"
+#include "ff.h"
+#include "string.h"
+#include "fsl_device_registers.h"
+#include "FSL_DEBUG_CONSOLE.h"
+
+#define printf PRINTF
+
+#if MP3_BENCHMARK
+
+#if !HELIX_PROFILE
+#error "MP3_BENCHMARK needs the decoder built with HELIX_PROFILE=1"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////
+// Helix decoder benchmark
+// Every stage is timed with the DWT cycle counter, so the numbers are core
+// cycles and do not depend on the GPT setup in gpt.c.
+//////////////////////////////////////////////////////////////////////////////////
+
+static const char *const bench_stage_name[MP3_NSTAGES] = {
+    "header", "sideinfo", "scalefact", "huffman", "dequant", "imdct", "subband",
+};
+
+static const char *const bench_corpus[] = MP3_BENCH_CORPUS;
+
+static u8 bench_buf[MP3_FILE_BUF_SZ];
+static short bench_pcm[MAX_NCHAN * MAX_NGRAN * MAX_NSAMP];
+static FIL bench_file;
+
+unsigned int MP3ProfileGetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+static void bench_cycle_counter_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static void bench_report(const char *path, HMP3Decoder decoder, u32 io_cycles, u32 errors)
+{
+    MP3FrameInfo info;
+    MP3ProfileInfo prof;
+    u32 i, n, fps_x100, stage;
+    u32 avg;
+
+    MP3GetLastFrameInfo(decoder, &info);
+    MP3GetProfileInfo(decoder, &prof);
+    n = prof.nFrames ? prof.nFrames : 1;
+
+    printf("\r\n== %s ==\r\n", path);
+    printf("frames:%d errors:%d  %dHz %dch %dkbps MPEG%s\r\n", prof.nFrames, errors, info.samprate, info.nChans,
+           info.bitrate / 1000, info.version == MPEG1 ? "1" : (info.version == MPEG2 ? "2" : "2.5"));
+    printf("%-10s %12s %6s\r\n", "stage", "cycles/frm", "%");
+    for (i = 0; i < MP3_NSTAGES; i++)
+    {
+        stage = (u32)(prof.stageCycles[i] / n);
+        printf("%-10s %12d %6d\r\n", bench_stage_name[i], stage,
+               prof.totalCycles ? (u32)(prof.stageCycles[i] * 100 / prof.totalCycles) : 0);
+    }
+    avg = (u32)(prof.totalCycles / n);
+    printf("%-10s %12d\r\n", "total", avg);
+    printf("%-10s %12d\r\n", "worst", prof.maxFrameCycles);
+    printf("%-10s %12d\r\n", "worst gr", prof.maxGranuleCycles);
+    printf("%-10s %12d\r\n", "f_read", io_cycles / n);
+
+    /* frames per second of real-time playback, x100 to keep MPEG2 rates exact */
+    if (info.nChans && info.outputSamps)
+    {
+        fps_x100 = (u32)info.samprate * 100 / (info.outputSamps / info.nChans);
+        printf("realtime load: %d.%02d MHz (worst %d.%02d MHz) of %d MHz\r\n",
+               (u32)((uint64_t)avg * fps_x100 / 100000000), (u32)((uint64_t)avg * fps_x100 / 1000000 % 100),
+               (u32)((uint64_t)prof.maxFrameCycles * fps_x100 / 100000000),
+               (u32)((uint64_t)prof.maxFrameCycles * fps_x100 / 1000000 % 100), SystemCoreClock / 1000000);
+    }
+}
+
+// Decode one file as fast as possible and print the profile
+// path:full FatFs path of the MP3 file
+// return:0,ok
+//    other,failed to open or read the file
+u8 mp3_bench_file(const char *path)
+{
+    HMP3Decoder decoder;
+    __mp3ctrl ctrl;
+    u8 *readptr;
+    u8 *framestart;
+    int bytesleft;
+    int framebytes;
+    int offset;
+    int err;
+    int nsamps;
+    int granules;
+    u32 br;
+    u32 t0;
+    u32 io_cycles = 0;
+    u32 errors = 0;
+    u8 res;
+
+    memset(&ctrl, 0, sizeof(ctrl));
+    res = f_open(&bench_file, path, FA_READ);
+    if (res)
+    {
+        printf("bench: cannot open %s\r\n", path);
+        return res;
+    }
+
+    res = f_read(&bench_file, bench_buf, MP3_FILE_BUF_SZ, &br);
+    if (res == 0)
+    {
+        mp3_id3v2_decode(bench_buf, br, &ctrl);
+        res = f_lseek(&bench_file, ctrl.datastart);
+    }
+    decoder = MP3InitDecoder();
+    if (res || decoder == 0)
+    {
+        f_close(&bench_file);
+        return 1;
+    }
+
+    readptr = bench_buf;
+    bytesleft = 0;
+    while (1)
+    {
+        // keep at least two main data buffers worth of stream in bench_buf
+        if (bytesleft < MAINBUF_SIZE * 2)
+        {
+            memmove(bench_buf, readptr, bytesleft);
+            t0 = MP3ProfileGetCycles();
+            res = f_read(&bench_file, bench_buf + bytesleft, MP3_FILE_BUF_SZ - bytesleft, &br);
+            io_cycles += MP3ProfileGetCycles() - t0;
+            readptr = bench_buf;
+            if (res || (br == 0 && bytesleft == 0))
+            {
+                break;
+            }
+            bytesleft += br;
+        }
+
+        offset = MP3FindSyncWord(readptr, bytesleft);
+        if (offset < 0)
+        {
+            bytesleft = 0;
+            continue;
+        }
+        readptr += offset;
+        bytesleft -= offset;
+        framestart = readptr;
+        framebytes = bytesleft;
+
+        // decode granule by granule like the player does
+        err = MP3DecodeGranule(decoder, &readptr, &bytesleft, bench_pcm, &nsamps, &granules);
+        while (err == ERR_MP3_NONE && granules)
+        {
+            err = MP3DecodeGranule(decoder, &readptr, &bytesleft, bench_pcm, &nsamps, &granules);
+            if (err != ERR_MP3_NONE)
+            {
+                // the frame is already consumed, only count it
+                errors++;
+                err = ERR_MP3_NONE;
+            }
+        }
+        if (err == ERR_MP3_INDATA_UNDERFLOW)
+        {
+            break;
+        }
+        else if (err == ERR_MP3_INVALID_FRAMEHEADER || err == ERR_MP3_INVALID_SIDEINFO ||
+                 err == ERR_MP3_FREE_BITRATE_SYNC)
+        {
+            // not a frame after all, the decoder may have stepped over the header:
+            // search on from the byte behind its sync word
+            errors++;
+            readptr = framestart + 1;
+            bytesleft = framebytes - 1;
+        }
+        else if (err != ERR_MP3_NONE && err != ERR_MP3_MAINDATA_UNDERFLOW)
+        {
+            // frame consumed with corrupt main data, go on from where the decoder left off
+            errors++;
+        }
+    }
+
+    bench_report(path, decoder, io_cycles, errors);
+    MP3FreeDecoder(decoder);
+    f_close(&bench_file);
+    return 0;
+}
+
+// Run every file listed in MP3_BENCH_CORPUS
+void mp3_bench_corpus(void)
+{
+    u32 i;
+
+    bench_cycle_counter_init();
+    printf("\r\nHelix MP3 benchmark, core %d MHz\r\n", SystemCoreClock / 1000000);
+    for (i = 0; i < sizeof(bench_corpus) / sizeof(bench_corpus[0]); i++)
+    {
+        mp3_bench_file(bench_corpus[i]);
+    }
+}
+
+#endif /* MP3_BENCHMARK */
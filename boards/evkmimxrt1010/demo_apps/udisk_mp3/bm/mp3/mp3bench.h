@@ -0,0 +1,16 @@
+#ifndef __MP3BENCH_H__
+#define __MP3BENCH_H__
+
+#include "mp3play.h"
+
+//////////////////////////////////////////////////////////////////////////////////
+// Helix decoder benchmark
+// Decodes files flat out (no SAI output) and prints the per-stage cycle cost
+// collected by the decoder profiler. Needs HELIX_PROFILE=1 in the compiler
+// defines and MP3_BENCHMARK=1 in mp3_config.h.
+//////////////////////////////////////////////////////////////////////////////////
+
+u8 mp3_bench_file(const char *path);
+void mp3_bench_corpus(void);
+
+#endif
@@ -1,6 +1,10 @@
 #include "mp3play.h"
 #include "mp3_config.h"
 #include "ff.h"
+#include "stream_prefetch.h"
+#include "fast_seek.h"
+#include "audio_source.h"
+#include "fsl_common.h"
 #include "string.h"
 #include "FSL_DEBUG_CONSOLE.h"
 
@@ -123,6 +127,82 @@ u8 mp3_id3v2_decode(u8* buf,u32 size,__mp3ctrl *pctrl)
 	return 0;
 } 
 
+//Seek table and gapless information from the Xing/Info frame and the LAME tag behind it.
+//The info frame itself decodes to silence and is always dropped. With a LAME tag the
+//encoder delay plus the decoder delay are dropped too, and playback stops before the padding.
+//buf:start of the Xing/Info frame id
+//size:valid bytes from buf on
+//spf:samples per frame
+//pctrl:MP3 control block
+static void mp3_xing_decode(u8* buf,u32 size,u32 spf,__mp3ctrl *pctrl)
+{
+	MP3_FrameXing* fxing=(MP3_FrameXing*)buf;
+	u32 t=8;	//id + flags
+	u32 delay,padding;
+	pctrl->skipsamples=spf;
+	if(fxing->flags[3]&0X01)
+	{
+		pctrl->totframes=((u32)buf[t]<<24)|((u32)buf[t+1]<<16)|((u32)buf[t+2]<<8)|buf[t+3];
+		t+=4;
+	}
+	if(fxing->flags[3]&0X02)	//file size
+	{
+		if(t+4<=size)pctrl->databytes=((u32)buf[t]<<24)|((u32)buf[t+1]<<16)|((u32)buf[t+2]<<8)|buf[t+3];
+		t+=4;
+	}
+	if(fxing->flags[3]&0X04)	//TOC
+	{
+		if(t+MP3_TOC_SIZE<=size&&pctrl->totframes)
+		{
+			memcpy(pctrl->toc,buf+t,MP3_TOC_SIZE);
+			pctrl->hastoc=1;
+		}
+		t+=MP3_TOC_SIZE;
+	}
+	if(fxing->flags[3]&0X08)t+=4;	//quality
+	if(t+24>size)return;
+	if(strncmp("LAME",(char*)buf+t,4)&&strncmp("Lavf",(char*)buf+t,4)&&strncmp("Lavc",(char*)buf+t,4))return;
+	delay=((u32)buf[t+21]<<4)|(buf[t+22]>>4);
+	padding=((u32)(buf[t+22]&0X0F)<<8)|buf[t+23];
+	pctrl->skipsamples+=delay+MP3_DECODER_DELAY;
+	if(pctrl->totframes&&pctrl->totframes*spf>delay+padding)pctrl->playsamples=pctrl->totframes*spf-delay-padding;
+}
+
+//Turn the VBRI seek table (bytes taken by every framesperentry frames) into a Xing style TOC
+//buf:start of the VBRI frame id
+//size:valid bytes from buf on
+//pctrl:MP3 control block, totframes and databytes already set
+static void mp3_vbri_decode(u8* buf,u32 size,__mp3ctrl *pctrl)
+{
+	MP3_FrameVBRI* fvbri=(MP3_FrameVBRI*)buf;
+	u32 entries=((u32)fvbri->tocentries[0]<<8)|fvbri->tocentries[1];
+	u32 scale=((u32)fvbri->scale[0]<<8)|fvbri->scale[1];
+	u32 esize=((u32)fvbri->entrysize[0]<<8)|fvbri->entrysize[1];
+	u32 fpe=((u32)fvbri->framesperentry[0]<<8)|fvbri->framesperentry[1];
+	u32 i,k,e=0,frame,pos=0,v;
+	u8 *entry=buf+sizeof(MP3_FrameVBRI);
+
+	if(esize<1||esize>4||fpe==0||entries==0||sizeof(MP3_FrameVBRI)+entries*esize>size)return;
+	if(pctrl->totframes==0||pctrl->databytes==0)return;
+	for(i=0;i<MP3_TOC_SIZE;i++)
+	{
+		frame=pctrl->totframes*i/MP3_TOC_SIZE;
+		while(e<entries&&(e+1)*fpe<=frame)	//add up the entries that end before this frame
+		{
+			for(v=0,k=0;k<esize;k++)v=(v<<8)|entry[e*esize+k];
+			pos+=v*scale;
+			e++;
+		}
+		v=(u32)((unsigned long long)pos*256/pctrl->databytes);
+		pctrl->toc[i]=v>255?255:v;
+	}
+	pctrl->hastoc=1;
+}
+
+//header-only decoder instance for mp3_get_info: probing a file never touches mp3decoder
+//(needs MP3GetDecoderSize(1) bytes, about 2.4K)
+static u8 mp3_probe_arena[2560];
+
 //ȡMP3Ϣ
 //pname:MP3ļ·
 //pctrl:MP3Ϣṹ 
@@ -151,7 +231,8 @@ u8 mp3_get_info(u8 *pname,__mp3ctrl* pctrl)
 
 	if(fmp3&&buf)//ڴɹ
 	{ 		
-		res = f_open(fmp3,(MP3_FILEPATH),FA_READ);//ļ
+		res = FAST_SeekOpen(fmp3,(const TCHAR*)pname);//ļ
+		if(res)return res;	//not opened, nothing to close
 		res=f_read(fmp3,(char*)buf,5*1024,&br);
 		if(res==0)//ȡļɹ,ʼID3V2/ID3V1ԼȡMP3Ϣ
 		{  
@@ -161,12 +242,13 @@ u8 mp3_get_info(u8 *pname,__mp3ctrl* pctrl)
             
 			f_read(fmp3,(char*)buf,128,&br);//ȡ128ֽ
 			mp3_id3v1_decode(buf,pctrl);	//ID3V1  
-			decoder=MP3InitDecoder(); 		//MP3ڴ
+			decoder=MP3InitDecoderInPlace(mp3_probe_arena,sizeof(mp3_probe_arena));	//frame info only
 			f_lseek(fmp3,pctrl->datastart);	//ƫƵݿʼĵط
 			f_read(fmp3,(char*)buf,5*1024,&br);	//ȡ5Kֽmp3
  			offset=MP3FindSyncWord(buf,br);	//֡ͬϢ
 			if(offset>=0&&MP3GetNextFrameInfo(decoder,&frame_info,&buf[offset])==0)//ҵ֡ͬϢ,һϢȡ	
 			{ 
+				pctrl->databytes=f_size(fmp3)-pctrl->datastart;	//unless the Xing/VBRI header says otherwise
 				p=offset+4+32;
 				fvbri=(MP3_FrameVBRI*)(buf+p);
 				if(strncmp("VBRI",(char*)fvbri->id,4)==0)//VBRI֡(VBRʽ)
@@ -175,6 +257,11 @@ u8 mp3_get_info(u8 *pname,__mp3ctrl* pctrl)
 					else samples_per_frame=576;//MPEG2/MPEG2.5,layer3ÿ֡576 
  					totframes=((u32)fvbri->frames[0]<<24)|((u32)fvbri->frames[1]<<16)|((u16)fvbri->frames[2]<<8)|fvbri->frames[3];//õ֡
 					pctrl->totsec=totframes*samples_per_frame/frame_info.samprate;//õļܳ
+					pctrl->skipsamples=samples_per_frame;	//the VBRI frame plays as silence
+					pctrl->totframes=totframes;
+					if(fvbri->fsize[0]|fvbri->fsize[1]|fvbri->fsize[2]|fvbri->fsize[3])
+						pctrl->databytes=((u32)fvbri->fsize[0]<<24)|((u32)fvbri->fsize[1]<<16)|((u32)fvbri->fsize[2]<<8)|fvbri->fsize[3];
+					if(br>p)mp3_vbri_decode(buf+p,br-p,pctrl);
 				}else	//VBRI֡,ǲXing֡(VBRʽ)
 				{  
 					if (frame_info.version==MPEG1)	//MPEG1 
@@ -200,6 +287,7 @@ u8 mp3_get_info(u8 *pname,__mp3ctrl* pctrl)
 							//pctrl->totsec=fmp3->fsize/(frame_info.bitrate/8);
                             pctrl->totsec=f_size(fmp3)/(frame_info.bitrate/8);
 						} 
+						if(br>p)mp3_xing_decode(buf+p,br-p,samples_per_frame,pctrl);
 					}
                     else 		//CBRʽ,ֱӼܲʱ
 					{
@@ -214,7 +302,7 @@ u8 mp3_get_info(u8 *pname,__mp3ctrl* pctrl)
 			}else res=0XFE;//δҵͬ֡	
 			MP3FreeDecoder(decoder);//ͷڴ		
 		} 
-		f_close(fmp3);
+		FAST_SeekClose(fmp3);
 	}
     else 
         res=0XFF;
@@ -229,108 +317,517 @@ u8 mp3_get_info(u8 *pname,__mp3ctrl* pctrl)
 
 FIL audioFile;
 
-#include "gpt.h"
 static u8* readptr;	//MP3ָ
 static int offset=0;	//ƫ
 static int bytesleft=0;//bufferʣЧ
-u8 mp3_buf[MP3_FILE_BUF_SZ];
+//compressed data ring, MP3Decode reads frames and the bit reservoir in place.
+//The first MP3_RING_GUARD bytes are mirrored after the end so headers never wrap.
+u8 mp3_buf[MP3_FILE_BUF_SZ+MP3_RING_GUARD];
+static u8 mp3_stream_end;	//the file has no more data
+static const char *mp3_path;	//file being played
+static u32 mp3_file_pos;	//file offset of the next byte mp3_ring_fill reads
+static u32 mp3_frame_count;	//frames decoded in this track, the info frame included
+static u8 mp3_frame_exact;	//mp3_frame_count is exact, not estimated from the TOC after a seek
+//sparse seek index of the current track: mp3_index[i] is the file offset of frame i*mp3_index_stride
+static u32 mp3_index[MP3_SEEK_INDEX_SIZE];
+static u32 mp3_index_count;
+static u32 mp3_index_stride;
+//compressed data read ahead of mp3_buf, filled by asynchronous READ(10)
+SDK_L1DCACHE_ALIGN(static u8 mp3_prefetch_buf[MP3_PREFETCH_BLOCK_SIZE*MP3_PREFETCH_BLOCK_NUM]);
+static stream_prefetch_t mp3_prefetch;
 //u8 buft[2304*2];
 HMP3Decoder mp3decoder;
+static const MP3DecodeConfig mp3_decode_config={MP3_MONO_DOWNMIX,MP3_SYNTH_SUBBANDS};	//low-power decode, see mp3_config.h
 __mp3ctrl my_mp3_ctrl;
+static u32 mp3_skip_samples;	//samples still to drop at the start of the track
+static u32 mp3_play_samples;	//samples still to play before the encoder padding
+//error concealment: the last good granule, repeated over a corrupt frame
+static short mp3_conceal_buf[MAX_NSAMP*MAX_NCHAN];
+static u8 mp3_conceal_nch;	//channels in mp3_conceal_buf, 0 if there is nothing to repeat
+static u8 mp3_decoded;		//a frame has decoded since the decoder (re)started
+static u32 mp3_bad_run;		//failed decode attempts in a row
+static int mp3_gran_left;	//granules of the current frame still to decode
+static u8 mp3_lost_total;	//granules of a failed frame to fill in, from the one that failed on
+static u8 mp3_lost_done;	//of which already filled
+__mp3errstat mp3_errstat;
+//next track, its read-ahead started while the tail of the current one is decoded.
+//Probed in mp3_play_song: the demo plays its one file over and over.
+static __mp3ctrl mp3_next_ctrl;
+static u8 mp3_next_state;
 
 #define DECODE_END 0
 #define DECODE_OK  1
 
-u8 mp3_decode_one_frame(u8 * buf_out)
+#define NEXT_NONE   0	//nothing prepared yet
+#define NEXT_READY  1	//read-ahead started at its first frame
+#define NEXT_FAILED 2	//no next track, playback ends with the current one
+
+//what a Helix error leaves behind, see mp3_error_class
+#define MP3_ERR_NONE		0	//frame decoded
+#define MP3_ERR_RESYNC		1	//header or side info broken, the frame is not consumed
+#define MP3_ERR_FRAME		2	//frame consumed, its main data is corrupt
+#define MP3_ERR_RESERVOIR	3	//frame consumed, its bit reservoir is missing
+#define MP3_ERR_TRUNCATED	4	//frame runs past the data in mp3_buf
+#define MP3_ERR_FATAL		5	//the decoder itself is broken
+
+//Point the read-ahead at the first frame of the next track, once the read in flight
+//has landed. Never waits: the next track is audioFile again, already open and probed,
+//and its fast seek map makes the cluster lookup a table walk.
+//The current file has been read to its end (or cut short by the padding),
+//so the read-ahead can move on while mp3_buf still holds the current tail.
+//The decoder itself is only reset at the boundary, see mp3_restart.
+static void mp3_prepare_next(void)
 {
-    u8 res; 
-    u32 br=0; 
-    int err=0; 
-    MP3FrameInfo mp3frameinfo;
-    
-    // PRINTF("mp3_decode_one_frame");
-
-    offset=MP3FindSyncWord(readptr,bytesleft);//readptrλ,ʼַͬ
-    if(offset<0)
-    { 
-        //ûҵַͬloadݿ
-        readptr=mp3_buf;	// MP3ָָbuffer
-        offset=0;		    // ƫΪ0
-        bytesleft=0;
-        
-        res=f_read(&audioFile,mp3_buf,MP3_FILE_BUF_SZ,&br);//һζȡMP3_FILE_BUF_SZֽ
-        if(res)  //ݳ
+    if(mp3_prefetch.inFlight)return;	//try again on the next call
+    mp3_next_state=NEXT_FAILED;
+    if(STREAM_PrefetchStart(&mp3_prefetch,&audioFile,mp3_next_ctrl.datastart)!=FR_OK)return;
+    mp3_next_state=NEXT_READY;
+}
+
+//Keep the read-ahead going: collect a finished READ(10) and start the next one.
+//Never waits, call it from the main loop even while the decoder is paused.
+void mp3_stream_service(void)
+{
+    if(mp3_prefetch.file)STREAM_PrefetchService(&mp3_prefetch);
+    if(mp3_stream_end&&mp3_next_state==NEXT_NONE)mp3_prepare_next();	//current file fully read
+}
+
+//Move the decoder read pointer forward in the ring
+static void mp3_ring_skip(int n)
+{
+    readptr+=n;
+    if(readptr>=mp3_buf+MP3_FILE_BUF_SZ)readptr-=MP3_FILE_BUF_SZ;
+    bytesleft-=n;
+}
+
+//Top up the ring behind the unread data. Bytes from MP3GetRingHold() up to readptr
+//are the bit reservoir of the next frame and must stay, everything before them is free.
+static void mp3_ring_fill(void)
+{
+    u8 *hold,*wr;
+    int room;
+    u32 br,n;
+
+    hold=MP3GetRingHold(mp3decoder);
+    if(hold==0)hold=readptr;
+    room=readptr-hold;
+    if(room<0)room+=MP3_FILE_BUF_SZ;
+    room=MP3_FILE_BUF_SZ-room-bytesleft;
+    wr=readptr+bytesleft;
+    if(wr>=mp3_buf+MP3_FILE_BUF_SZ)wr-=MP3_FILE_BUF_SZ;
+    while(room>0&&!mp3_stream_end)
+    {
+        n=AUDIO_MIN(mp3_buf+MP3_FILE_BUF_SZ-wr,room);
+        br=STREAM_PrefetchRead(&mp3_prefetch,wr,n);
+        if(wr<mp3_buf+MP3_RING_GUARD)
         {
-            return DECODE_END;
+            memcpy(mp3_buf+MP3_FILE_BUF_SZ+(wr-mp3_buf),wr,AUDIO_MIN(br,mp3_buf+MP3_RING_GUARD-wr));
         }
-        if(br==0) //Ϊ0,˵.
+        if(br<n)mp3_stream_end=1;
+        mp3_file_pos+=br;
+        bytesleft+=br;
+        room-=br;
+        wr+=br;
+        if(wr>=mp3_buf+MP3_FILE_BUF_SZ)wr-=MP3_FILE_BUF_SZ;
+    }
+}
+
+//Restart the decoder and mp3_buf on file offset pos, the read-ahead already points there
+static void mp3_restart(u32 pos)
+{
+    if(mp3decoder)MP3ResetDecoder(mp3decoder);	//same instance: nothing allocated, only the stream state cleared
+    else
+    {
+        mp3decoder=MP3InitDecoder();
+        MP3SetRingInput(mp3decoder,mp3_buf,MP3_FILE_BUF_SZ);	//decode in place out of mp3_buf
+        MP3SetDecodeConfig(mp3decoder,&mp3_decode_config);
+    }
+    readptr=mp3_buf;	// MP3ָָbuffer
+    offset=0;		    // ƫΪ0
+    bytesleft=0;
+    mp3_stream_end=0;
+    mp3_file_pos=pos;
+    mp3_next_state=NEXT_NONE;
+    mp3_conceal_nch=0;
+    mp3_decoded=0;
+    mp3_bad_run=0;
+    mp3_gran_left=0;
+    mp3_lost_total=0;
+    mp3_lost_done=0;
+}
+
+//Start decoding my_mp3_ctrl's file from its first frame, the read-ahead already points there
+static void mp3_start_track(void)
+{
+    mp3_restart(my_mp3_ctrl.datastart);
+    mp3_skip_samples=my_mp3_ctrl.skipsamples;
+    mp3_play_samples=my_mp3_ctrl.playsamples?my_mp3_ctrl.playsamples:0XFFFFFFFF;
+    mp3_frame_count=0;
+    mp3_frame_exact=1;
+    mp3_index[0]=my_mp3_ctrl.datastart;
+    mp3_index_count=1;
+    mp3_index_stride=MP3_SEEK_INDEX_STRIDE;
+    memset(&mp3_errstat,0,sizeof(mp3_errstat));
+}
+
+//Note the file offset of frame if it is the next one the seek index wants.
+//A full index keeps every other entry and doubles its stride.
+static void mp3_index_add(u32 pos,u32 frame)
+{
+    u32 i;
+    if(frame!=mp3_index_count*mp3_index_stride)return;
+    if(mp3_index_count==MP3_SEEK_INDEX_SIZE)
+    {
+        for(i=1;i<MP3_SEEK_INDEX_SIZE/2;i++)mp3_index[i]=mp3_index[i*2];
+        mp3_index_count=MP3_SEEK_INDEX_SIZE/2;
+        mp3_index_stride*=2;
+        if(frame!=mp3_index_count*mp3_index_stride)return;
+    }
+    mp3_index[mp3_index_count++]=pos;
+}
+
+//Find frame by walking frame headers from the closest indexed frame before it,
+//reading one header per frame and decoding nothing. Frames passed are indexed on the way.
+//Stops early where the headers end.
+//frame:frame wanted, returns the frame reached
+//ֵ:file offset of the frame reached
+static u32 mp3_seek_walk(u32 *frame)
+{
+    HMP3Decoder decoder;
+    MP3FrameInfo info;
+    u8 hdr[6];	//header + CRC
+    UINT br;
+    u32 n,pos,target=*frame;
+
+    n=AUDIO_MIN(target/mp3_index_stride,mp3_index_count-1);
+    pos=mp3_index[n];
+    *frame=n*mp3_index_stride;
+    decoder=MP3InitDecoderInPlace(mp3_probe_arena,sizeof(mp3_probe_arena));	//frame info only
+    while(*frame<target)
+    {
+        if(f_lseek(&audioFile,pos)!=FR_OK||f_read(&audioFile,hdr,6,&br)!=FR_OK||br<4)break;
+        if(MP3GetNextFrameInfo(decoder,&info,hdr)!=0||info.layer!=3||info.bitrate==0)break;	//lost sync, or free format
+        pos+=(info.version==MPEG1?144:72)*info.bitrate/info.samprate+((hdr[2]>>1)&0X01);
+        (*frame)++;
+        mp3_index_add(pos,*frame);
+    }
+    MP3FreeDecoder(decoder);
+    return pos;
+}
+
+//Print what went wrong in the track that just ended, if anything did
+static void mp3_error_report(void)
+{
+    if(mp3_errstat.resyncs+mp3_errstat.concealed+mp3_errstat.muted==0)return;
+    printf("decode errors: %d resyncs, %d concealed, %d muted, last error %d\r\n",mp3_errstat.resyncs,
+           mp3_errstat.concealed,mp3_errstat.muted,mp3_errstat.lasterr);
+}
+
+//Carry on with the next track without a gap: only the decoder and mp3_buf start over,
+//PCM already decoded keeps playing. Returns 0 on success.
+static u8 mp3_next_track(void)
+{
+    mp3_error_report();
+    if(mp3_next_state==NEXT_NONE)	//the padding ended the track before its last read
+    {
+        STREAM_PrefetchStop(&mp3_prefetch);	//the decoder may wait here, the PCM ring covers it
+        mp3_prepare_next();
+    }
+    if(mp3_next_state!=NEXT_READY)return 1;
+    my_mp3_ctrl=mp3_next_ctrl;
+    mp3_start_track();
+    return 0;
+}
+
+//Sort a Helix error by what it leaves behind in mp3_buf and the decoder
+static u8 mp3_error_class(int err)
+{
+    switch(err)
+    {
+        case ERR_MP3_NONE:
+            return MP3_ERR_NONE;
+        case ERR_MP3_INVALID_FRAMEHEADER:
+        case ERR_MP3_INVALID_SIDEINFO:
+        case ERR_MP3_FREE_BITRATE_SYNC:
+            return MP3_ERR_RESYNC;
+        case ERR_MP3_MAINDATA_UNDERFLOW:
+            return MP3_ERR_RESERVOIR;
+        case ERR_MP3_INDATA_UNDERFLOW:
+            return MP3_ERR_TRUNCATED;
+        case ERR_MP3_INVALID_SCALEFACT:
+        case ERR_MP3_INVALID_HUFFCODES:
+        case ERR_MP3_INVALID_DEQUANTIZE:
+        case ERR_MP3_INVALID_IMDCT:
+        case ERR_MP3_INVALID_SUBBAND:
+            return MP3_ERR_FRAME;
+        default:
+            return MP3_ERR_FATAL;
+    }
+}
+
+//Fill one granule of a frame that could not be decoded. The first frame lost after a good
+//one repeats that frame's last granule, fading out over the granules lost; any further
+//one stays silent.
+//buf:granule output, nch:channels
+static void mp3_conceal(short *buf,int nch)
+{
+    int i,n,s,s0,total=mp3_lost_total*MAX_NSAMP;	//samples per channel to fade over
+
+    s0=mp3_lost_done*MAX_NSAMP;
+    if(mp3_lost_done==0)
+    {
+        if(mp3_conceal_nch==nch)mp3_errstat.concealed++;
+        else mp3_errstat.muted++;
+    }
+    if(mp3_conceal_nch!=nch)memset(buf,0,MAX_NSAMP*nch*sizeof(short));
+    else
+    {
+        for(s=0;s<MAX_NSAMP;s++)
         {
-            return DECODE_END;
+            n=((total-s0-s)<<15)/total;	//gain, 1.0 down to 0 in Q15
+            for(i=0;i<nch;i++)buf[s*nch+i]=(short)((mp3_conceal_buf[s*nch+i]*n)>>15);
         }
+    }
+    if(++mp3_lost_done==mp3_lost_total)mp3_conceal_nch=0;	//used up, the rest of the run is silence
+}
+
+//Spread a mono granule over both SAI channels, in place from the back
+//buf:granule output, nsamp:samples in the mono granule
+static void mp3_mono_to_stereo(short *buf,int nsamp)
+{
+    int i;
 
-        bytesleft+=br;	//bufferжЧMP3?
-        err=0;                  
+    for(i=nsamp-1;i>=0;i--)buf[2*i]=buf[2*i+1]=buf[i];
+}
+
+//Decode the next granule (576 samples per channel) into buf_out, up to 1152 stereo samples.
+//An MPEG-1 frame comes out in two calls, MPEG-2 frames in one.
+//Encoder delay and padding are trimmed here: only pcm_size bytes from buf_out+pcm_offset
+//are audio, pcm_size may be 0. At the end of a track the next one follows on directly.
+//A broken frame costs one frame: a bad header is skipped and the search goes on from the
+//next byte, the granules of a corrupt frame are concealed. Only MP3_ERROR_LIMIT failures in
+//a row, or an error in the tail of the file, end the track.
+//ֵ:DECODE_OK,DECODE_END
+u8 mp3_decode_one_granule(u8 * buf_out,u32 *pcm_offset,u32 *pcm_size)
+{
+    int n,nsamps,left; 
+    u32 skip,framepos=0;
+    int err=0; 
+    u8 errclass=MP3_ERR_NONE;
+    u8 newframe=0,drop=0;
+    u8 *framestart;
+    int framebytes;
+    MP3FrameInfo mp3frameinfo;
+
+    if(mp3_play_samples==0&&mp3_next_track()!=0)return DECODE_END;	//what is left of the file is padding
+    if(mp3_lost_done<mp3_lost_total)
+    {
+        errclass=MP3_ERR_FRAME;	//rest of a frame that failed, nothing to decode
     }
-    else	
+    else if(mp3_gran_left)
     {
-        //ҵַͬ
-        readptr+=offset;		//MP3ָƫƵַͬ.
-        bytesleft-=offset;		//bufferЧݸ,ȥƫ
-        
-        //gp_timer_measure_begin();
-        err=MP3Decode(mp3decoder,&readptr,&bytesleft,(short*)buf_out,0);//һ֡MP3
-        //int us = gp_timer_measure_end();
-        
-        // PRINTF("CPU loading: %d\r\n", us/(2304/48000));
-        // PRINTF("CPU loading: %d\r\n", us*48000*100/(2304*1000*1000) );
-        // PRINTF("CPU loading: %d\r\n", us*48*100/(2304*1000) );
-
-        if(err!=0)
+        left=mp3_gran_left;
+        err=MP3DecodeGranule(mp3decoder,&readptr,&bytesleft,(short*)buf_out,&nsamps,&mp3_gran_left);//second granule of the frame
+        errclass=mp3_error_class(err);
+        if(errclass!=MP3_ERR_NONE)
         {
-            printf("decode error:%d\r\n",err);
-            return DECODE_END;
+            mp3_errstat.lasterr=err;
+            mp3_bad_run++;
+            mp3_lost_total=left;
+            mp3_lost_done=0;
         }
-        else
+    }
+    else while(1)
+    {
+        if(bytesleft<MAINBUF_SIZE*2)mp3_ring_fill();//С2MAINBUF_SIZEʱ,벹µݽ.
+        //search the contiguous data, the guard carries it on past the end of the ring
+        n=AUDIO_MIN(mp3_buf+MP3_FILE_BUF_SZ+MP3_RING_GUARD-readptr,bytesleft);
+        //a layer 3 header right where a good frame ended is taken as it is: MP3FindSyncWord
+        //would also want the header after it, and a corrupt one would cost this frame too
+        if(mp3_decoded&&mp3_bad_run==0&&n>1&&readptr[0]==0XFF&&(readptr[1]&0XE6)==0XE2)offset=0;
+        else offset=MP3FindSyncWord(readptr,n);//readptrλ,ʼַͬ
+        if(offset<0)
         {
-            MP3GetLastFrameInfo(mp3decoder,&mp3frameinfo);	//õոսMP3֡Ϣ
-            if(my_mp3_ctrl.bitrate!=mp3frameinfo.bitrate)	//
+            if(n<=1)
             {
-                my_mp3_ctrl.bitrate = mp3frameinfo.bitrate;
+                if(mp3_stream_end)
+                {
+                    if(mp3_next_track()==0)continue;	//gapless: on to the next track
+                    mp3_error_report();
+                    return DECODE_END;//Ϊ0,˵.
+                }
+                continue;
             }
-            
-            
-            // ********************************************
-            // fill decoded buffer.
-            // ********************************************                        
-            //mp3_fill_buffer((u16*)buft,mp3frameinfo.outputSamps,mp3frameinfo.nChans);//pcm 
+            mp3_ring_skip(n-1);	//no sync word, keep the last byte in case it starts one
+            continue;
         }
+
+        //ҵַͬ
+        mp3_ring_skip(offset);	//MP3ָƫƵַͬ.
+        framepos=mp3_file_pos-bytesleft;
+        newframe=1;
+        framestart=readptr;
+        framebytes=bytesleft;
         
-        
-        // read new data
-        if(bytesleft<MAINBUF_SIZE*2)//С2MAINBUF_SIZEʱ,벹µݽ.
-        { 
-            memmove(mp3_buf,readptr,bytesleft);//ƶreadptrָݵbuffer,СΪ:bytesleft
-            f_read(&audioFile,mp3_buf+bytesleft,MP3_FILE_BUF_SZ-bytesleft,&br);//µ
-            if(br<MP3_FILE_BUF_SZ-bytesleft)
+        err=MP3DecodeGranule(mp3decoder,&readptr,&bytesleft,(short*)buf_out,&nsamps,&mp3_gran_left);//һ֡MP3ݵĵһgranule
+        errclass=mp3_error_class(err);
+        if(errclass==MP3_ERR_NONE||errclass==MP3_ERR_RESERVOIR)break;
+        mp3_errstat.lasterr=err;
+        if(errclass==MP3_ERR_FATAL||++mp3_bad_run>MP3_ERROR_LIMIT||(mp3_stream_end&&errclass!=MP3_ERR_RESYNC))
+        {
+            //cut off a broken last frame or trailing tag, or give up on the track
+            if(mp3_next_track()!=0)
             {
-                memset(mp3_buf+bytesleft+br,0,MP3_FILE_BUF_SZ-bytesleft-br); 
+                mp3_error_report();
+                return DECODE_END;
             }
-            bytesleft=MP3_FILE_BUF_SZ;  
-            readptr=mp3_buf; 
+            *pcm_offset=0;	//the next track takes over
+            *pcm_size=0;
+            return DECODE_OK;
         }
+        if(errclass==MP3_ERR_FRAME)break;
+        //not a frame after all: search on behind its sync word, nothing was consumed
+        readptr=framestart;
+        bytesleft=framebytes;
+        mp3_ring_skip(1);
+        mp3_errstat.resyncs++;
+        mp3_frame_exact=0;	//the header may have been a real frame, the count can be off from here on
     }
+
+    MP3GetLastFrameInfo(mp3decoder,&mp3frameinfo);	//õոսMP3֡Ϣ
+    if(newframe)
+    {
+        if(errclass!=MP3_ERR_NONE)
+        {
+            if(errclass==MP3_ERR_RESERVOIR&&mp3_decoded)mp3_errstat.lasterr=err;
+            mp3_lost_total=mp3frameinfo.version==MPEG1?2:1;	//the whole frame is lost
+            mp3_lost_done=0;
+        }
+        if(my_mp3_ctrl.bitrate!=mp3frameinfo.bitrate)	//
+        {
+            my_mp3_ctrl.bitrate = mp3frameinfo.bitrate;
+        }
+    }
+    n=mp3frameinfo.nChans?MAX_NSAMP:0;	//0: not layer 3
+    if(errclass==MP3_ERR_NONE)
+    {
+        //keep the granule for concealment
+        memcpy(mp3_conceal_buf,buf_out,nsamps*sizeof(short));
+        mp3_conceal_nch=mp3frameinfo.nChans;
+        mp3_decoded=1;
+        mp3_bad_run=0;
+        if(mp3_gran_left==0)mp3_errstat.frames++;
+    }
+    else if(mp3_decoded)
+    {
+        mp3_conceal((short*)buf_out,mp3frameinfo.nChans);	//keep the time line, the frame is not dropped
+    }
+    else
+    {
+        //nothing decoded since the start or a seek (bit reservoir not there yet): the frame is dropped
+        if(mp3_lost_done==0&&errclass==MP3_ERR_FRAME)mp3_errstat.muted++;
+        mp3_lost_done++;
+        drop=1;
+    }
+    if(mp3frameinfo.nChans==1&&!drop)mp3_mono_to_stereo((short*)buf_out,n);	//mono streams and MP3_MONO_DOWNMIX, the SAI runs in stereo
+    //drop the info frame and delay at the start, stop before the padding at the end
+    skip=AUDIO_MIN(mp3_skip_samples,n);
+    mp3_skip_samples-=skip;
+    n-=skip;
+    if(n>mp3_play_samples)n=mp3_play_samples;
+    mp3_play_samples-=n;
+    *pcm_offset=skip*2*2;
+    *pcm_size=n*2*2;
+    if(drop)*pcm_size=0;
+    if(newframe)
+    {
+        if(mp3_frame_exact)mp3_index_add(framepos,mp3_frame_count);
+        mp3_frame_count++;
+        if(mp3frameinfo.samprate)my_mp3_ctrl.cursec=mp3_frame_count*(mp3frameinfo.outputSamps/mp3frameinfo.nChans)/mp3frameinfo.samprate;
+    }
+    
+    
+    // ********************************************
+    // fill decoded buffer.
+    // ********************************************                        
+    //mp3_fill_buffer((u16*)buft,mp3frameinfo.outputSamps,mp3frameinfo.nChans);//pcm 
     
     return DECODE_OK;
 }
 
+#if HELIX_LEVELS
+//Levels of the granule decoded last, for spectrum and VU meters. Safe to call from the GUI
+//while the decoder runs: it never waits, a snapshot torn by a decode in between is refused.
+//The levels run ahead of what is heard by the PCM queued in the ring.
+//li:filled in on success, see MP3LevelInfo
+//ֵ:1,li holds a complete snapshot
+//    0,nothing decoded yet or the snapshot was being updated, keep showing the last one
+u8 mp3_get_levels(MP3LevelInfo *li)
+{
+    if(mp3decoder==0)return 0;
+    return MP3GetLevels(mp3decoder,li);
+}
+#endif
+
+//Jump to ms into the current track.
+//Frames up to the last indexed one are found exactly through the seek index. Further on the
+//Xing/VBRI TOC is used when the file has one, otherwise the frame headers are walked from the
+//last indexed frame, which indexes them for the next seek.
+//PCM already decoded still plays out. The first frames after the jump stay silent until the
+//bit reservoir has filled up again.
+//ms:position in milliseconds
+//ֵ:0,ɹ
+//    ,ʧ
+u8 mp3_seek(u32 ms)
+{
+    u32 spf=my_mp3_ctrl.outsamples/2;	//outsamples counts both channels
+    u32 frame,pos,x,end;
+    int a,b;
+    u8 exact;
+
+    if(mp3decoder==0||spf==0||my_mp3_ctrl.samplerate==0)return 1;
+    frame=(u32)((unsigned long long)ms*my_mp3_ctrl.samplerate/1000/spf);
+    if(my_mp3_ctrl.totframes&&frame>=my_mp3_ctrl.totframes)frame=my_mp3_ctrl.totframes-1;
+    STREAM_PrefetchStop(&mp3_prefetch);	//the disk is needed for the header walk
+    if(frame<mp3_index_count*mp3_index_stride||!my_mp3_ctrl.hastoc)
+    {
+        pos=mp3_seek_walk(&frame);
+        exact=1;
+    }
+    else
+    {
+        x=(u32)((unsigned long long)frame*MP3_TOC_SIZE*256/my_mp3_ctrl.totframes);	//percent of the play time, 8 fraction bits
+        a=my_mp3_ctrl.toc[x>>8];
+        b=(x>>8)<MP3_TOC_SIZE-1?my_mp3_ctrl.toc[(x>>8)+1]:256;
+        pos=my_mp3_ctrl.datastart+(u32)((unsigned long long)(a*256+(b-a)*(int)(x&0XFF))*my_mp3_ctrl.databytes/65536);
+        exact=0;
+    }
+    if(STREAM_PrefetchStart(&mp3_prefetch,&audioFile,pos)!=FR_OK)return 1;
+    mp3_restart(pos);
+    mp3_frame_count=frame;
+    mp3_frame_exact=exact;
+    x=frame*spf;
+    my_mp3_ctrl.cursec=x/my_mp3_ctrl.samplerate;
+    //carry the gapless trim over to the new position
+    mp3_skip_samples=my_mp3_ctrl.skipsamples>x?my_mp3_ctrl.skipsamples-x:0;
+    mp3_play_samples=0XFFFFFFFF;
+    if(my_mp3_ctrl.playsamples)
+    {
+        end=my_mp3_ctrl.skipsamples+my_mp3_ctrl.playsamples;
+        if(x<my_mp3_ctrl.skipsamples)x=my_mp3_ctrl.skipsamples;
+        mp3_play_samples=end>x?end-x:0;
+    }
+    return 0;
+}
+
 void mp3_play_clean(void);
 
 u8 mp3_play_song(u8* fname)
 { 
 
 	u8 res;
-	u32 br=0; 
     
+	mp3_path=(const char*)fname;
 	memset(&my_mp3_ctrl,0,sizeof(__mp3ctrl));// 
         open_wave_file();
 	res=mp3_get_info(fname,&my_mp3_ctrl);  
@@ -341,39 +838,32 @@ u8 mp3_play_song(u8* fname)
 		printf("   bitrate:%dbps\r\n",my_mp3_ctrl.bitrate);	
 		printf("samplerate:%d\r\n",   my_mp3_ctrl.samplerate);	
 		printf("  totalsec:%d\r\n",   my_mp3_ctrl.totsec); 		
-		mp3decoder=MP3InitDecoder(); 					//MP3ڴ
-		res=f_open(&audioFile,(MP3_FILEPATH),FA_READ);	//ļ
+		mp3_next_ctrl=my_mp3_ctrl;	//the next track is this file again, probe it here where the disk may be waited for
+		if(mp3_prefetch.buffer==0)STREAM_PrefetchInit(&mp3_prefetch,mp3_prefetch_buf,MP3_PREFETCH_BLOCK_SIZE,MP3_PREFETCH_BLOCK_NUM);
+		res=FAST_SeekOpen(&audioFile,mp3_path);	//ļ
 	}
     else
     {
         printf("get mp3 information error\r\n");
-        while(1)
-            ;
+        close_wave_file();
+        return 1;
     }
-	if(res==0&&mp3decoder!=0)//ļɹ
+	if(res==0)//ļɹ
 	{ 
-		f_lseek(&audioFile,my_mp3_ctrl.datastart);	//ļͷtagϢ							//ʼ 
+		STREAM_PrefetchStart(&mp3_prefetch,&audioFile,my_mp3_ctrl.datastart);	//ļͷtagϢ							//ʼ 
 		//while(1) 
 		{
           
             // *** now begin to decode MP3 file ***
           
-			readptr=mp3_buf;	// MP3ָָbuffer
-			offset=0;		    // ƫΪ0
-			bytesleft=0;
+			mp3_start_track();
             
-			res=f_read(&audioFile,mp3_buf,MP3_FILE_BUF_SZ,&br);//һζȡMP3_FILE_BUF_SZֽ
-			if(res)  //ݳ
-			{
-				return 0;
-			}
-			if(br==0) //Ϊ0,˵.
+			mp3_ring_fill();
+			if(bytesleft==0) //Ϊ0,˵.
 			{
 				return 0;
 			}
 
-			bytesleft+=br;	//bufferжЧMP3?
-
 /*            
 			while(1)//ûг쳣(ɷҵַ֡ͬ)
 			{
@@ -386,17 +876,47 @@ u8 mp3_play_song(u8* fname)
 */
 		}
 	}
-    return 0;
+    return res;
 }
 
 
 void mp3_play_clean(void)
 {
-	f_close(&audioFile);
+    STREAM_PrefetchStop(&mp3_prefetch);	//wait for the read in flight, it uses the file
+	FAST_SeekClose(&audioFile);
     close_wave_file();
 	MP3FreeDecoder(mp3decoder);		//ͷڴ	
+    mp3decoder=0;
 }
 
+//The MP3 decoder as a source of the player, see audio_source.h.
+//It takes a file that starts with an ID3v2 tag, or with a layer 3 frame header the sync
+//search accepts within the probe bytes (a few bytes of junk may come first).
+static u8 mp3_source_probe(const u8 *header,u32 size)
+{
+    if(size>=3&&strncmp("ID3",(const char*)header,3)==0)return 1;
+    return MP3FindSyncWord((unsigned char*)header,size)>=0;	//only reads the header
+}
+
+static u8 mp3_source_open(const char *path,audio_source_format_t *format)
+{
+    if(mp3_play_song((u8*)path)!=0)return 1;
+    format->sampleRate_Hz=my_mp3_ctrl.samplerate;
+    format->bitWidth=16;
+    format->blockSize=MAX_NSAMP*2*2;	//one granule of 16-bit stereo
+    return 0;
+}
+
+const audio_source_t g_mp3Source=
+{
+    "mp3",
+    mp3_source_probe,
+    mp3_source_open,
+    mp3_decode_one_granule,
+    mp3_stream_service,
+    mp3_play_clean,
+};
+
 
 
 
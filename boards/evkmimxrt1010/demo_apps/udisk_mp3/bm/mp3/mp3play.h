@@ -25,6 +25,8 @@
 #define MP3_TITSIZE_MAX		40		//󳤶
 #define MP3_ARTSIZE_MAX		40		//󳤶
 #define MP3_FILE_BUF_SZ    5*1024	//MP3ʱ,ļbufС
+#define MP3_TOC_SIZE		100		//entries of the Xing seek table, one per percent of play time
+#define MP3_DECODER_DELAY	529		//decoder delay in samples added on top of the LAME encoder delay
  
 
 typedef uint32_t  u32;
@@ -83,6 +85,10 @@ typedef __packed struct
 	u8 quality[2];		//Ƶ,0~100,ԽԽ
 	u8 fsize[4];		//ļܴС
 	u8 frames[4];		//ļ֡ 
+	u8 tocentries[2];	//number of seek table entries
+	u8 scale[2];		//scale factor of the entries
+	u8 entrysize[2];	//bytes per entry, 1~4
+	u8 framesperentry[2];	//frames covered by one entry
 }MP3_FrameVBRI;
 
 
@@ -99,14 +105,38 @@ typedef __packed struct
 	u16 outsamples;				//PCMС(16λΪλ),MP3,ʵ*2(DAC)
 	
 	u32 datastart;				//֡ʼλ(ļƫ)
+	u32 skipsamples;			//samples dropped at the start: info frame, plus encoder and decoder delay with a LAME tag
+	u32 playsamples;			//samples played before the encoder padding, 0 if unknown (no LAME tag)
+	u32 totframes;				//frames in the file from the Xing/VBRI header, 0 if unknown
+	u32 databytes;				//bytes of frame data from datastart on, the TOC scales to this
+	u8 toc[MP3_TOC_SIZE];		//toc[i]*databytes/256: offset of i% of the play time, valid if hastoc
+	u8 hastoc;					//Xing TOC present, or one built from the VBRI seek table
 }__mp3ctrl;
 
+//decode error counters of the current track
+typedef struct 
+{
+	u32 frames;					//frames decoded without error
+	u32 resyncs;				//broken headers skipped, the sync search went on behind them
+	u32 concealed;				//corrupt frames replaced by the last good granule, fading out
+	u32 muted;					//corrupt frames played as silence
+	int lasterr;				//last Helix error, ERR_MP3_xxx
+}__mp3errstat;
+
+extern __mp3errstat mp3_errstat;
+
 
 void mp3_i2s_dma_tx_callback(void) ;
 void mp3_fill_buffer(u16* buf,u16 size,u8 nch);
 u8 mp3_id3v1_decode(u8* buf,__mp3ctrl *pctrl);
 u8 mp3_id3v2_decode(u8* buf,u32 size,__mp3ctrl *pctrl);
 u8 mp3_play_song(u8* fname);
+u8 mp3_decode_one_granule(u8* buf_out,u32* pcm_offset,u32* pcm_size);
+void mp3_stream_service(void);
+u8 mp3_seek(u32 ms);
+#if HELIX_LEVELS
+u8 mp3_get_levels(MP3LevelInfo *li);
+#endif
 #endif
 
 
@@ -13,11 +13,64 @@
  * Definitions
  ******************************************************************************/
 
-#define MP3_FILENAME      "vitas.mp3"
-#define MP3_FILEPATH      "1:/vitas.mp3"
+// Track the demo plays over and over. Its header picks the source, not its name: a RIFF/WAVE
+// file streams its PCM straight to the SAI, anything else goes to the MP3 decoder.
+#define AUDIO_FILEPATH    "1:/vitas.mp3"
    
 #define PCM_FILEPATH      "1:/vitas.pcm"
 
+// PCM ring between the decoder and the SAI EDMA, counted in decoded granules (576 stereo
+// samples, 2304 bytes each). The decoder pauses at the high watermark and resumes at the low
+// one; output (re)starts once the ring has been filled to the high watermark. The high
+// watermark stays one block below the ring size: after gapless trimming granules no longer
+// line up with blocks, and the block after a partly filled one is needed as decode scratch.
+#define PCM_RING_BLOCK_NUM       (4)
+#define PCM_RING_LOW_WATERMARK   (2)
+#define PCM_RING_HIGH_WATERMARK  (3)
+
+// SAI output: 1 has the EDMA cycle over the PCM ring by itself through a circular chain of
+// scatter/gather TCDs, one per block, with an interrupt only to recycle each played block;
+// 0 queues every block through the fsl_sai_edma transfer API.
+#define AUDIO_TX_LOOP            1
+
+// Output sample rate. 0 follows every track: the audio PLL is reprogrammed between tracks for
+// the 44.1 kHz or the 48 kHz family, which gives the codec 8 to 48 kHz exactly, and only other
+// rates go through the resampler, to 44.1 or 48 kHz. A rate here is for sinks that must keep
+// one clock: the PLL is set once and every track at another rate is resampled to it.
+#define AUDIO_FIXED_RATE         (0)
+
+// Compressed-stream read-ahead in front of the USB disk: each block is one asynchronous
+// READ(10) that never crosses a cluster, so the disk works while the decoder runs.
+// The blocks live in cacheable OCRAM next to mp3_buf.
+#define MP3_PREFETCH_BLOCK_SIZE  (4096)
+#define MP3_PREFETCH_BLOCK_NUM   (2)
+
+// Seek index: the file offset of every n-th frame, recorded while a track plays and while
+// mp3_seek walks frame headers, so a later seek lands on its frame without reading the disk.
+// n starts at MP3_SEEK_INDEX_STRIDE and doubles whenever the table fills up.
+#define MP3_SEEK_INDEX_SIZE      (256)
+#define MP3_SEEK_INDEX_STRIDE    (16)
+
+// Decode errors: a bad frame header is skipped and a corrupt frame concealed in place.
+// This many failures in a row give up on the track.
+#define MP3_ERROR_LIMIT          (32)
+
+// Low-power decode for mono speaker products: MP3_MONO_DOWNMIX sums stereo streams to mono
+// ahead of the IMDCT, which halves the IMDCT and synthesis work; the mono PCM is played on
+// both SAI channels. MP3_SYNTH_SUBBANDS below 32 keeps only the lowest subbands, each 1/64 of
+// the sample rate wide (16 at 44.1 kHz leaves 11 kHz of audio bandwidth), so fewer blocks go
+// through the IMDCT.
+#define MP3_MONO_DOWNMIX         0
+#define MP3_SYNTH_SUBBANDS       (32)
+
+// Decoder benchmark: decode every file below flat out before playback starts
+// and print per-stage cycles/frame (needs HELIX_PROFILE=1 in the compiler defines)
+#define MP3_BENCHMARK     0
+#define MP3_BENCH_CORPUS  { "1:/bench/cbr128.mp3",   \
+                            "1:/bench/vbr_v0.mp3",   \
+                            "1:/bench/js320.mp3",    \
+                            "1:/bench/mpeg2_22k.mp3" }
+
 
 ////////////////////////////////////////////////////////////////////////////////
 
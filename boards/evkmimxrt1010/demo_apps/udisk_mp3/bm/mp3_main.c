@@ -30,9 +30,19 @@
 #include "clock_config.h"
 
 #include "sai.h"
+#include "pcm_ring.h"
+#include "audio_source.h"
+#include "audio_resampler.h"
+#include "sai_tx_loop.h"
+#include "event_sched.h"
+#include "fast_seek.h"
+#include "fsl_cache.h"
 #include "diskio.h"
 #include "fsl_wm8960.h"
 #include "ff.h"
+#ifdef USB_DISK_CACHE_ENABLE
+#include "disk_cache.h"
+#endif
 
 /* SAI instance and clock */
 #define DEMO_CODEC_WM8960
@@ -54,7 +64,7 @@
 #define EXAMPLE_SAI_TX_SOURCE kDmaRequestMuxSai1Tx
 #define EXAMPLE_SAI_RX_SOURCE kDmaRequestMuxSai1Rx
 
-/* Select Audio/Video PLL (786.48 MHz) as sai1 clock source */
+/* Select Audio/Video PLL (722.5344 or 786.432 MHz) as sai1 clock source */
 #define DEMO_SAI1_CLOCK_SOURCE_SELECT (2U)
 /* Clock pre divider for sai1 clock source */
 #define DEMO_SAI1_CLOCK_SOURCE_PRE_DIVIDER (0U)
@@ -65,6 +75,13 @@
     (CLOCK_GetFreq(kCLOCK_AudioPllClk) / (DEMO_SAI1_CLOCK_SOURCE_DIVIDER + 1U) / \
      (DEMO_SAI1_CLOCK_SOURCE_PRE_DIVIDER + 1U))
 
+/* Rate the SAI and the codec start at */
+#if AUDIO_FIXED_RATE
+#define DEMO_SAMPLE_RATE (AUDIO_FIXED_RATE)
+#else
+#define DEMO_SAMPLE_RATE (SAMPLE_RATE)
+#endif
+
 /* I2C instance and clock */
 #define DEMO_I2C LPI2C1
 
@@ -77,6 +94,9 @@
 
       
 AT_NONCACHEABLE_SECTION_INIT(sai_edma_handle_t txHandle) = {0};
+#if AUDIO_TX_LOOP
+AT_NONCACHEABLE_SECTION_ALIGN(sai_tx_loop_t txLoop, 32);
+#endif
 edma_handle_t dmaTxHandle = {0};
 AT_NONCACHEABLE_SECTION_INIT(sai_edma_handle_t rxHandle) = {0};
 edma_handle_t dmaRxHandle = {0};
@@ -176,16 +196,32 @@ usb_host_handle g_HostHandle;
  * Code
  ******************************************************************************/
 /*
- * AUDIO PLL setting: Frequency = Fref * (DIV_SELECT + NUM / DENOM)
- *                              = 24 * (32 + 77/100)
- *                              = 786.48 MHz
+ * AUDIO PLL settings: Frequency = Fref * (DIV_SELECT + NUM / DENOM), divided by 64 into the
+ * sai1 clock, which is the master clock of the SAI and the codec
+ *   24 * (30 + 1056/10000) = 722.5344 MHz, 11.2896 MHz = 256 * 44.1 kHz
+ *   24 * (32 + 768/1000)   = 786.432 MHz,  12.288 MHz  = 256 * 48 kHz
  */
-const clock_audio_pll_config_t audioPllConfig = {
-    .loopDivider = 32,  /* PLL loop divider. Valid range for DIV_SELECT divider value: 27~54. */
-    .postDivider = 1,   /* Divider after the PLL, should only be 1, 2, 4, 8, 16. */
-    .numerator = 77,    /* 30 bit numerator of fractional loop divider. */
-    .denominator = 100, /* 30 bit denominator of fractional loop divider */
+const clock_audio_pll_config_t audioPllConfig[] = {
+    {
+        .loopDivider = 30,    /* PLL loop divider. Valid range for DIV_SELECT divider value: 27~54. */
+        .postDivider = 1,     /* Divider after the PLL, should only be 1, 2, 4, 8, 16. */
+        .numerator = 1056,    /* 30 bit numerator of fractional loop divider. */
+        .denominator = 10000, /* 30 bit denominator of fractional loop divider */
+    },
+    {
+        .loopDivider = 32,
+        .postDivider = 1,
+        .numerator = 768,
+        .denominator = 1000,
+    },
 };
+/* sai1 clock each audioPllConfig entry makes */
+static const uint32_t audioPllSaiClock_Hz[] = {11289600U, 12288000U};
+/* master clock to sample rate ratios the WM8960 takes at every word width: above 1024 its
+ * bit clock divider table has no entry for 16-bit words, so 8 kHz is resampled */
+static const uint16_t codecClockRatio[] = {256U, 384U, 512U, 768U, 1024U};
+/* setting the audio PLL runs with */
+static const clock_audio_pll_config_t *audioPll;
 
 
 void BOARD_EnableSaiMclkOutput(bool enable)
@@ -200,57 +236,300 @@ void BOARD_EnableSaiMclkOutput(bool enable)
     }
 }
 //uint8_t buf_decode[2304*2];
-uint8_t mp3_decode_one_frame(uint8_t * buf_out);
-#define BLOCK_SIZE (2304*2)
-#define BLOCK_NUM (2)
+/* one granule: 576 samples of 16-bit stereo; other sources cut the ring into their own blocks */
+#define BLOCK_SIZE (576*2*2)
+/* task_audio_tx result when the PCM ring had no room and nothing was read, next to the AUDIO_SOURCE_ codes */
+#define AUDIO_TX_RING_FULL (2U)
 
-uint8_t audio_buf[BLOCK_SIZE*BLOCK_NUM];
-int buf_index = 0;
-uint8_t audio_buf_dummy[BLOCK_SIZE] = {0};
+SDK_L1DCACHE_ALIGN(uint8_t audio_buf[BLOCK_SIZE * PCM_RING_BLOCK_NUM]);
+pcm_ring_t pcmRing;
+static uint32_t pcmFill; /* bytes already packed into the write block, committed once it is full */
+static const audio_source_t *audioSource; /* plays the current track */
+static audio_source_format_t audioFormat; /* what the SAI, the codec and pcmRing are set up for */
 
 void SAI_send_audio(uint8_t * buf, uint32_t size)
 {
 
 }
-static void tx_send_dummy(void)
+
+#if AUDIO_TX_LOOP
+/* Arm every decoded block in the EDMA loop, and start the loop if it stands still.
+ * Runs from the main loop and from txCallback, so it must not be interrupted by the callback. */
+static void audio_submit_pending(void)
 {
-    sai_transfer_t xfer = {0};
-    xfer.data           = audio_buf_dummy;
-    xfer.dataSize       = BLOCK_SIZE;
-    SAI_TransferSendEDMA(DEMO_SAI, &txHandle, &xfer);
-    SAI_TransferSendEDMA(DEMO_SAI, &txHandle, &xfer);
-    SAI_TransferSendEDMA(DEMO_SAI, &txHandle, &xfer);
-    SAI_TransferSendEDMA(DEMO_SAI, &txHandle, &xfer);
+    uint8_t *buf;
+    uint32_t primask = DisableGlobalIRQ();
+
+    while ((buf = PCM_RingGetSendBlock(&pcmRing, pcmRing.blockNum)) != NULL)
+    {
+        /* audio_buf is cacheable OCRAM, push the decoded block out before the EDMA reads it */
+        DCACHE_CleanByRange((uint32_t)buf, pcmRing.blockSize);
+        SAI_TxLoopArm(&txLoop, pcmRing.submitted % pcmRing.blockNum);
+        PCM_RingCommitSend(&pcmRing);
+    }
+    if (!txLoop.running && (pcmRing.submitted != pcmRing.completed))
+    {
+        SAI_TxLoopStart(&txLoop, pcmRing.completed % pcmRing.blockNum);
+    }
+    EnableGlobalIRQ(primask);
 }
+#else
+/* Queue every decoded block the SAI EDMA queue has room for.
+ * Runs from the main loop and from txCallback, so it must not be interrupted by the callback. */
+static void audio_submit_pending(void)
+{
+    sai_transfer_t xfer;
+    uint8_t *buf;
+    uint32_t primask = DisableGlobalIRQ();
 
-static int flag_sai_tx = 0;
+    while ((buf = PCM_RingGetSendBlock(&pcmRing, SAI_XFER_QUEUE_SIZE)) != NULL)
+    {
+        /* audio_buf is cacheable OCRAM, push the decoded block out before the EDMA reads it */
+        DCACHE_CleanByRange((uint32_t)buf, pcmRing.blockSize);
+        xfer.data     = buf;
+        xfer.dataSize = pcmRing.blockSize;
+        if (SAI_TransferSendEDMA(DEMO_SAI, &txHandle, &xfer) != kStatus_Success)
+        {
+            break;
+        }
+        PCM_RingCommitSend(&pcmRing);
+    }
+    EnableGlobalIRQ(primask);
+}
+#endif
+
+/* Read ahead into the PCM ring while the watermarks allow it, one source read per pass.
+ * The MP3 decoder trims encoder delay and padding, so a granule hands back any number of
+ * samples; they are packed into whole blocks because the SAI EDMA only moves full blocks.
+ * A read that fills its block in place, as the WAV source does, is committed without a copy. */
 static uint8_t task_audio_tx(void)
 {
-    uint8_t RES = 0;
-    if(flag_sai_tx)
+    uint8_t RES = AUDIO_TX_RING_FULL;
+    uint8_t *buf;
+    uint8_t *dst;
+    uint32_t pcmOffset;
+    uint32_t pcmSize;
+    uint32_t n;
+    uint32_t blockSize = pcmRing.blockSize;
+
+    /* keep the USB read-ahead moving whether or not the source runs this pass */
+    if (audioSource->service != NULL)
+    {
+        audioSource->service();
+    }
+    buf = PCM_RingGetWriteBlock(&pcmRing);
+    /* a partly filled block takes the next read through the block after it */
+    dst = (pcmFill == 0U) ? buf : PCM_RingGetScratchBlock(&pcmRing);
+    if ((buf != NULL) && (dst != NULL))
     {
-        flag_sai_tx = 0;
-        uint8_t * buf;
-        buf = audio_buf + buf_index*BLOCK_SIZE;
-        buf_index ^= 1;
         //GPIO_PinWrite(GPIO3, 21U, 0U);
-        RES = mp3_decode_one_frame(buf);
+        RES = audioSource->read(dst, &pcmOffset, &pcmSize);
         //GPIO_PinWrite(GPIO3, 21U, 1U);
-        if(0 == RES)
-          return RES;
-        sai_transfer_t xfer;
-        xfer.data           = buf;
-        xfer.dataSize       = BLOCK_SIZE;
-        SAI_TransferSendEDMA(DEMO_SAI, &txHandle, &xfer);
+        if (RES != AUDIO_SOURCE_END)
+        {
+            n = MIN(blockSize - pcmFill, pcmSize);
+            if (dst + pcmOffset != buf + pcmFill)
+            {
+                memmove(buf + pcmFill, dst + pcmOffset, n);
+            }
+            pcmFill += n;
+            if (pcmFill == blockSize)
+            {
+                PCM_RingCommitWrite(&pcmRing);
+                /* the rest of the granule opens the next block, which is dst */
+                pcmFill = pcmSize - n;
+                memmove(dst, dst + pcmOffset + n, pcmFill);
+            }
+        }
+        else if (pcmFill != 0U)
+        {
+            /* playback stops here, pad the last block with silence */
+            memset(buf + pcmFill, 0, blockSize - pcmFill);
+            PCM_RingCommitWrite(&pcmRing);
+            pcmFill = 0U;
+        }
+    }
+    audio_submit_pending();
+    return RES;
+}
+
+/* Play out everything left in the PCM ring, even below the start watermark. */
+static void audio_drain(void)
+{
+    PCM_RingFlush(&pcmRing);
+    audio_submit_pending();
+    while (PCM_RingGetFill(&pcmRing) != 0U)
+    {
+        EVENT_SchedRun();
+        if (PCM_RingGetFill(&pcmRing) != 0U)
+        {
+            EVENT_SchedIdle();
+        }
+    }
+}
+
+/* Audio PLL setting whose master clock both the codec and the SAI bit clock divide exactly
+ * down to sampleRate_Hz, NULL if neither does. */
+static const clock_audio_pll_config_t *audio_pll_for_rate(uint32_t sampleRate_Hz)
+{
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < ARRAY_SIZE(audioPllConfig); i++)
+    {
+        for (j = 0U; j < ARRAY_SIZE(codecClockRatio); j++)
+        {
+            if (sampleRate_Hz * codecClockRatio[j] == audioPllSaiClock_Hz[i])
+            {
+                return &audioPllConfig[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Base rate of the family of sampleRate_Hz, which the codec takes at any word width */
+static uint32_t audio_base_rate(uint32_t sampleRate_Hz)
+{
+    return ((sampleRate_Hz % 11025U) == 0U) ? 44100U : 48000U;
+}
+
+/* Rate a track at sampleRate_Hz plays at. Without AUDIO_FIXED_RATE that is its own rate
+ * whenever the PLL can make it, otherwise the family base rate it converts best to. */
+static uint32_t audio_output_rate(uint32_t sampleRate_Hz)
+{
+#if AUDIO_FIXED_RATE
+    return AUDIO_FIXED_RATE;
+#else
+    if (audio_pll_for_rate(sampleRate_Hz) != NULL)
+    {
+        return sampleRate_Hz;
+    }
+    return audio_base_rate(sampleRate_Hz);
+#endif
+}
+
+/* Switch the SAI and the codec to the format of the next track, with the ring drained.
+ * The audio PLL is reprogrammed when the rate is of the other family, while the SAI is
+ * stopped; the codec then sees its master clock change between two tracks only.
+ * Returns the codec status, which is an error when it has no clock dividers for the format. */
+static status_t audio_set_format(const audio_source_format_t *newFormat)
+{
+    const clock_audio_pll_config_t *pll = audio_pll_for_rate(newFormat->sampleRate_Hz);
+    uint32_t masterClockHz;
+
+#if AUDIO_TX_LOOP
+    SAI_TxLoopStop(&txLoop);
+#else
+    SAI_TransferTerminateSendEDMA(DEMO_SAI, &txHandle);
+#endif
+    assert(pll != NULL);
+    if (pll != audioPll)
+    {
+        CLOCK_InitAudioPll(pll);
+        audioPll = pll;
     }
-    return 1;
+    format.bitWidth      = newFormat->bitWidth;
+    format.sampleRate_Hz = newFormat->sampleRate_Hz;
+#if (defined FSL_FEATURE_SAI_HAS_MCLKDIV_REGISTER && FSL_FEATURE_SAI_HAS_MCLKDIV_REGISTER) || \
+    (defined FSL_FEATURE_PCC_HAS_SAI_DIVIDER && FSL_FEATURE_PCC_HAS_SAI_DIVIDER)
+    masterClockHz = OVER_SAMPLE_RATE * format.sampleRate_Hz;
+#else
+    masterClockHz = DEMO_SAI_CLK_FREQ;
+#endif
+#if AUDIO_TX_LOOP
+    SAI_TxLoopSetFormat(&txLoop, &format, DEMO_SAI_CLK_FREQ, masterClockHz);
+#else
+    SAI_TransferTxSetFormatEDMA(DEMO_SAI, &txHandle, &format, DEMO_SAI_CLK_FREQ, masterClockHz);
+#endif
+    return CODEC_SetFormat(&codecHandle, masterClockHz, format.sampleRate_Hz, format.bitWidth);
 }
 
+/* Open path with the source its header calls for, through the resampler if the output
+ * cannot run at its rate. A track that needs the SAI in another format or the ring cut into
+ * other blocks waits for the previous one to play out. */
+static bool audio_start_track(const char *path)
+{
+    audio_source_format_t newFormat;
+    const audio_source_t *source = AUDIO_SourceOpen(path, &newFormat);
+    uint32_t rate;
+    bool resampled;
 
+    if (source == NULL)
+    {
+        return false;
+    }
+    rate      = audio_output_rate(newFormat.sampleRate_Hz);
+    resampled = (rate != newFormat.sampleRate_Hz);
+    if (resampled)
+    {
+        source = AUDIO_ResamplerOpen(source, &newFormat, rate);
+        if (source == NULL)
+        {
+            PRINTF("%s: cannot resample\r\n", path);
+            return false;
+        }
+    }
+    if (memcmp(&newFormat, &audioFormat, sizeof(audioFormat)) != 0)
+    {
+        audio_drain();
+        if (audio_set_format(&newFormat) != kStatus_Success)
+        {
+            /* no bit clock divider for the rate at this word width, play it at the base rate */
+            if (!resampled && (rate != audio_base_rate(rate)))
+            {
+                source = AUDIO_ResamplerOpen(source, &newFormat, audio_base_rate(rate));
+            }
+            else
+            {
+                source->close();
+                source = NULL;
+            }
+            if ((source != NULL) && (audio_set_format(&newFormat) != kStatus_Success))
+            {
+                source->close();
+                source = NULL;
+            }
+        }
+        if (source == NULL)
+        {
+            PRINTF("%s: codec rejects %d Hz\r\n", path, newFormat.sampleRate_Hz);
+            /* the codec is half set up, the next track must set it again */
+            memset(&audioFormat, 0, sizeof(audioFormat));
+            return false;
+        }
+        audioFormat = newFormat;
+        PCM_RingInit(&pcmRing, audio_buf, audioFormat.blockSize,
+                     MIN(sizeof(audio_buf) / audioFormat.blockSize, PCM_RING_BLOCK_NUM), PCM_RING_LOW_WATERMARK,
+                     PCM_RING_HIGH_WATERMARK);
+#if AUDIO_TX_LOOP
+        SAI_TxLoopSetBuffer(&txLoop, audio_buf, pcmRing.blockSize, pcmRing.blockNum);
+#endif
+    }
+    audioSource = source;
+    return true;
+}
+
+#if AUDIO_TX_LOOP
+static void txLoopCallback(sai_tx_loop_t *loop, uint32_t block, bool nextArmed, void *userData)
+{
+    PCM_RingCompleteBlock(&pcmRing);
+    EVENT_SchedPost(EVENT_SCHED_AUDIO);
+    if (!nextArmed)
+    {
+        /* The ring ran dry, or the next block was armed just after the EDMA loaded its TCD.
+         * Stop in the silence; the blocks not played yet start the loop again. */
+        SAI_TxLoopStop(loop);
+        PCM_RingCancelSend(&pcmRing);
+    }
+    audio_submit_pending();
+}
+#else
 static void txCallback(I2S_Type *base, sai_edma_handle_t *handle, status_t status, void *userData)
 {
-    flag_sai_tx = 1;   
-    //task_audio_tx();
+    PCM_RingCompleteBlock(&pcmRing);
+    EVENT_SchedPost(EVENT_SCHED_AUDIO);
+    audio_submit_pending();
 /*
     sendCount++;
     emptyBlock++;
@@ -263,6 +542,7 @@ static void txCallback(I2S_Type *base, sai_edma_handle_t *handle, status_t statu
     }
 */
 }
+#endif
 
 
 static void rxCallback(I2S_Type *base, sai_edma_handle_t *handle, status_t status, void *userData)
@@ -282,6 +562,8 @@ static void rxCallback(I2S_Type *base, sai_edma_handle_t *handle, status_t statu
 void USB_OTG1_IRQHandler(void)
 {
     USB_HostEhciIsrFunction(g_HostHandle);
+    /* the host task runs from the main loop, see USB_HostTaskFn */
+    EVENT_SchedPost(EVENT_SCHED_USB);
 }
 
 void USB_HostClockInit(void)
@@ -314,9 +596,14 @@ void USB_HostIsrEnable(void)
     EnableIRQ((IRQn_Type)irqNumber);
 }
 
+/* EVENT_SCHED_USB handler. The task posts itself messages too (attach after a port change), those are
+ * handled here as well, so nothing is left for the core to sleep on. */
 void USB_HostTaskFn(void *param)
 {
-    USB_HostEhciTaskFunction(param);
+    do
+    {
+        USB_HostEhciTaskFunction(param);
+    } while (USB_HostEhciTaskPending(param));
 }
 
 /*!
@@ -394,6 +681,10 @@ static usb_status_t USB_HostEvent(usb_device_handle deviceHandle,
             break;
 
         case kUSB_HostEventDetach:
+#ifdef USB_DISK_CACHE_ENABLE
+            /* the medium is gone, nothing cached may reach the next one */
+            DISK_CacheInvalidate(USBDISK);
+#endif
 #if ((defined USB_HOST_CONFIG_COMPLIANCE_TEST) && (USB_HOST_CONFIG_COMPLIANCE_TEST))
             status1 = USB_HostTestEvent(deviceHandle, configurationHandle, eventCode);
             status2 = USB_HostMsdEvent(deviceHandle, configurationHandle, eventCode);
@@ -428,6 +719,7 @@ static void USB_HostApplicationInit(void)
         usb_echo("host init error\r\n");
         return;
     }
+    EVENT_SchedSetHandler(EVENT_SCHED_USB, USB_HostTaskFn, g_HostHandle);
     USB_HostIsrEnable();
 
     usb_echo("host init done\r\n");
@@ -639,7 +931,9 @@ int main(void)
     sai_config_t config;
     uint32_t mclkSourceClockHz = 0U, masterClockHz = 0U;
     edma_config_t dmaConfig = {0};
-    CLOCK_InitAudioPll(&audioPllConfig);
+    audioPll = audio_pll_for_rate(DEMO_SAMPLE_RATE);
+    assert(audioPll != NULL);
+    CLOCK_InitAudioPll(audioPll);
         /*Clock setting for LPI2C*/
     CLOCK_SetMux(kCLOCK_Lpi2cMux, DEMO_LPI2C_CLOCK_SOURCE_SELECT);
     CLOCK_SetDiv(kCLOCK_Lpi2cDiv, DEMO_LPI2C_CLOCK_SOURCE_DIVIDER);
@@ -692,7 +986,7 @@ int main(void)
     /* Configure the audio format */
     format.bitWidth = kSAI_WordWidth16bits;
     format.channel = 0U;
-    format.sampleRate_Hz = SAMPLE_RATE;
+    format.sampleRate_Hz = DEMO_SAMPLE_RATE;
 #if (defined FSL_FEATURE_SAI_HAS_MCLKDIV_REGISTER && FSL_FEATURE_SAI_HAS_MCLKDIV_REGISTER) || \
     (defined FSL_FEATURE_PCC_HAS_SAI_DIVIDER && FSL_FEATURE_PCC_HAS_SAI_DIVIDER)
     masterClockHz = OVER_SAMPLE_RATE * format.sampleRate_Hz;
@@ -708,16 +1002,27 @@ int main(void)
 
     /* Use default setting to init codec */
     CODEC_Init(&codecHandle, &boardCodecConfig);
-    CODEC_SetFormat(&codecHandle, masterClockHz, format.sampleRate_Hz, format.bitWidth);
+    if (CODEC_SetFormat(&codecHandle, masterClockHz, format.sampleRate_Hz, format.bitWidth) != kStatus_Success)
+    {
+        PRINTF("codec rejects %d Hz\r\n", format.sampleRate_Hz);
+    }
 #if defined CODEC_USER_CONFIG
     BOARD_Codec_Config(&codecHandle);
 #endif
 
+#if AUDIO_TX_LOOP
+    SAI_TxLoopCreateHandle(DEMO_SAI, &txLoop, txLoopCallback, NULL, &dmaTxHandle);
+#else
     SAI_TransferTxCreateHandleEDMA(DEMO_SAI, &txHandle, txCallback, NULL, &dmaTxHandle);
+#endif
     SAI_TransferRxCreateHandleEDMA(DEMO_SAI, &rxHandle, rxCallback, NULL, &dmaRxHandle);
 
     mclkSourceClockHz = DEMO_SAI_CLK_FREQ;
+#if AUDIO_TX_LOOP
+    SAI_TxLoopSetFormat(&txLoop, &format, mclkSourceClockHz, masterClockHz);
+#else
     SAI_TransferTxSetFormatEDMA(DEMO_SAI, &txHandle, &format, mclkSourceClockHz, masterClockHz);
+#endif
     SAI_TransferRxSetFormatEDMA(DEMO_SAI, &rxHandle, &format, mclkSourceClockHz, masterClockHz);
 
     /* Enable interrupt to handle FIFO error */
@@ -791,10 +1096,12 @@ int main(void)
     WM_SetDesktopColor(GUI_WHITE);//GUI_YELLOW GUI_WHITE
     WM_Exec();
     
+    /* the msd task only moves on from the callbacks the host task runs */
     while (1)
     {
-        USB_HostTaskFn(g_HostHandle);
+        EVENT_SchedRun();
         USB_HostMsdTask(&g_MsdFatfsInstance);
+        EVENT_SchedIdle();
     }
 }
 
@@ -810,27 +1117,75 @@ int USBDISK_FatFsInit()
         PRINTF("Mount volume failed.\r\n");
         return -1;
     }
+#ifdef USB_DISK_CACHE_ENABLE
+    DISK_CacheAttach(&g_fileSystem);
+#endif
 }
 
 void Audio_task()
 {
     uint8_t RES = 0;
-    char mp3_play_song(char* fname);
+#if MP3_BENCHMARK
+    void mp3_bench_corpus(void);
+#endif
     /* time delay */
     for (uint32_t freeClusterNumber = 0; freeClusterNumber < 10000; ++freeClusterNumber)
     {
         __ASM("nop");
     }
     USBDISK_FatFsInit();
-    mp3_play_song(MP3_FILENAME);
-    tx_send_dummy();
+#if MP3_BENCHMARK
+    mp3_bench_corpus();
+#endif
+    if (!audio_start_track(AUDIO_FILEPATH))
+    {
+        while (1)
+            ;
+    }
     while (1)
     {
+        EVENT_SchedRun();
         RES = task_audio_tx();
-        if(RES == 0)
+        if (RES == AUDIO_TX_RING_FULL)
         {
-          mp3_play_song(MP3_FILENAME);
-          tx_send_dummy();
+            /* sleep until the SAI plays out a block or the disk completes a read */
+            EVENT_SchedIdle();
+        }
+        else if(RES == AUDIO_SOURCE_END)
+        {
+          PRINTF("pcm ring: fill %d/%d, min fill %d, underruns %d\r\n", PCM_RingGetFill(&pcmRing),
+                 pcmRing.blockNum, pcmRing.minFill, pcmRing.underruns);
+#ifdef USB_DISK_CACHE_ENABLE
+          {
+              disk_cache_stats_t cacheStats;
+
+              DISK_CacheGetStats(&cacheStats);
+              PRINTF("disk cache: fat %d/%d, dir %d/%d, data %d/%d hit/miss, %d written back, %d bypassed\r\n",
+                     cacheStats.hits[kDISK_CacheFat], cacheStats.misses[kDISK_CacheFat],
+                     cacheStats.hits[kDISK_CacheDir], cacheStats.misses[kDISK_CacheDir],
+                     cacheStats.hits[kDISK_CacheData], cacheStats.misses[kDISK_CacheData],
+                     cacheStats.writeBacks[kDISK_CacheFat] + cacheStats.writeBacks[kDISK_CacheDir] +
+                         cacheStats.writeBacks[kDISK_CacheData],
+                     cacheStats.bypassed);
+              DISK_CacheResetStats();
+          }
+#endif
+          {
+              fast_seek_stats_t seekStats;
+
+              FAST_SeekGetStats(&seekStats);
+              PRINTF("fast seek: %d maps built, %d reused, %d files without a map\r\n", seekStats.built,
+                     seekStats.reused, seekStats.unmapped);
+              FAST_SeekResetStats();
+          }
+          audioSource->close();
+          if (!audio_start_track(AUDIO_FILEPATH))
+          {
+              /* nothing left to play */
+              audio_drain();
+              while (1)
+                  ;
+          }
         }
         
 #if 0
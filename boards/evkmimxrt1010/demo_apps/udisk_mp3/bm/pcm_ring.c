@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include "pcm_ring.h"
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void PCM_RingInit(pcm_ring_t *ring,
+                  uint8_t *buffer,
+                  uint32_t blockSize,
+                  uint32_t blockNum,
+                  uint32_t lowWatermark,
+                  uint32_t highWatermark)
+{
+    if (highWatermark > blockNum)
+    {
+        highWatermark = blockNum;
+    }
+    if (lowWatermark >= highWatermark)
+    {
+        lowWatermark = highWatermark - 1U;
+    }
+
+    ring->buffer         = buffer;
+    ring->blockSize      = blockSize;
+    ring->blockNum       = blockNum;
+    ring->lowWatermark   = lowWatermark;
+    ring->highWatermark  = highWatermark;
+    ring->produced       = 0U;
+    ring->submitted      = 0U;
+    ring->completed      = 0U;
+    ring->running        = false;
+    ring->producerPaused = false;
+    ring->underruns      = 0U;
+    ring->minFill        = blockNum;
+}
+
+uint8_t *PCM_RingGetWriteBlock(pcm_ring_t *ring)
+{
+    uint32_t fill = PCM_RingGetFill(ring);
+
+    if (ring->producerPaused)
+    {
+        if (fill > ring->lowWatermark)
+        {
+            return NULL;
+        }
+        ring->producerPaused = false;
+    }
+    if (fill >= ring->highWatermark)
+    {
+        ring->producerPaused = true;
+        return NULL;
+    }
+
+    return ring->buffer + (ring->produced % ring->blockNum) * ring->blockSize;
+}
+
+void PCM_RingCommitWrite(pcm_ring_t *ring)
+{
+    ring->produced++;
+}
+
+uint8_t *PCM_RingGetScratchBlock(pcm_ring_t *ring)
+{
+    if ((PCM_RingGetFill(ring) + 1U) >= ring->blockNum)
+    {
+        return NULL;
+    }
+
+    return ring->buffer + ((ring->produced + 1U) % ring->blockNum) * ring->blockSize;
+}
+
+uint8_t *PCM_RingGetSendBlock(pcm_ring_t *ring, uint32_t maxQueue)
+{
+    if (!ring->running)
+    {
+        /* (re)start only once the decoder has built up a full cushion */
+        if (PCM_RingGetFill(ring) < ring->highWatermark)
+        {
+            return NULL;
+        }
+        ring->running = true;
+    }
+    if ((ring->submitted == ring->produced) || ((ring->submitted - ring->completed) >= maxQueue))
+    {
+        return NULL;
+    }
+
+    return ring->buffer + (ring->submitted % ring->blockNum) * ring->blockSize;
+}
+
+void PCM_RingCommitSend(pcm_ring_t *ring)
+{
+    ring->submitted++;
+}
+
+void PCM_RingCancelSend(pcm_ring_t *ring)
+{
+    ring->submitted = ring->completed;
+}
+
+void PCM_RingFlush(pcm_ring_t *ring)
+{
+    if (PCM_RingGetFill(ring) != 0U)
+    {
+        ring->running = true;
+    }
+}
+
+void PCM_RingCompleteBlock(pcm_ring_t *ring)
+{
+    uint32_t fill;
+
+    ring->completed++;
+    fill = PCM_RingGetFill(ring);
+    if (fill < ring->minFill)
+    {
+        ring->minFill = fill;
+    }
+    if (ring->running && (fill == 0U))
+    {
+        /* the DAC has nothing left to play, rebuffer before restarting */
+        ring->underruns++;
+        ring->running = false;
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _PCM_RING_H_
+#define _PCM_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*!
+ * @brief PCM block ring between the MP3 decoder (producer) and the SAI EDMA (consumer).
+ *
+ * The ring holds blockNum blocks of blockSize bytes. Three free running counters
+ * track the blocks: produced (decoded by the main loop), submitted (queued to the
+ * SAI EDMA) and completed (played out, advanced from the SAI callback). Each counter
+ * has exactly one writer so no locking is needed on the counters themselves.
+ *
+ * The fill level (produced - completed) is kept between the two watermarks: the
+ * decoder runs until the fill level reaches highWatermark, then pauses until it
+ * has drained to lowWatermark. Output starts once the ring is filled to
+ * highWatermark and restarts the same way after an underrun.
+ */
+typedef struct _pcm_ring
+{
+    uint8_t *buffer;              /*!< blockNum * blockSize bytes of PCM storage */
+    uint32_t blockSize;           /*!< bytes per block, one decoded MP3 granule */
+    uint32_t blockNum;            /*!< number of blocks in the ring */
+    uint32_t lowWatermark;        /*!< decoder resumes when the fill level drops to this */
+    uint32_t highWatermark;       /*!< decoder pauses when the fill level reaches this */
+    volatile uint32_t produced;   /*!< blocks written by the decoder */
+    volatile uint32_t submitted;  /*!< blocks handed to the SAI EDMA */
+    volatile uint32_t completed;  /*!< blocks played out by the SAI EDMA */
+    volatile bool running;        /*!< output is started, cleared on underrun */
+    bool producerPaused;          /*!< decoder hit the high watermark and waits for low */
+    volatile uint32_t underruns;  /*!< times the EDMA queue ran dry while running */
+    volatile uint32_t minFill;    /*!< lowest fill level seen at a block completion */
+} pcm_ring_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Initialize the ring over a caller provided buffer.
+ *
+ * @param ring          ring handle.
+ * @param buffer        storage, at least blockSize * blockNum bytes.
+ * @param blockSize     bytes per block.
+ * @param blockNum      number of blocks.
+ * @param lowWatermark  fill level at which a paused decoder resumes.
+ * @param highWatermark fill level at which the decoder pauses and output starts.
+ */
+void PCM_RingInit(pcm_ring_t *ring,
+                  uint8_t *buffer,
+                  uint32_t blockSize,
+                  uint32_t blockNum,
+                  uint32_t lowWatermark,
+                  uint32_t highWatermark);
+
+/*!
+ * @brief Get the block the decoder should fill next.
+ *
+ * @param ring ring handle.
+ *
+ * @return block pointer, or NULL if the ring is full or the decoder is paused by the watermarks.
+ */
+uint8_t *PCM_RingGetWriteBlock(pcm_ring_t *ring);
+
+/*!
+ * @brief Mark the block returned by PCM_RingGetWriteBlock as holding valid PCM.
+ *
+ * @param ring ring handle.
+ */
+void PCM_RingCommitWrite(pcm_ring_t *ring);
+
+/*!
+ * @brief Get the block after the write block, if it is free, as decode scratch space.
+ *
+ * A granule that does not fit into what is left of a partly filled write block is decoded
+ * here; its head is copied into the write block and its tail stays for the next block.
+ *
+ * @param ring ring handle.
+ *
+ * @return block pointer, or NULL if that block still holds PCM waiting to be played.
+ */
+uint8_t *PCM_RingGetScratchBlock(pcm_ring_t *ring);
+
+/*!
+ * @brief Get the next decoded block to queue to the SAI EDMA.
+ *
+ * @param ring     ring handle.
+ * @param maxQueue maximum number of blocks the EDMA driver may hold at once.
+ *
+ * @return block pointer, or NULL if nothing is ready, output is not started or the queue is full.
+ */
+uint8_t *PCM_RingGetSendBlock(pcm_ring_t *ring, uint32_t maxQueue);
+
+/*!
+ * @brief Mark the block returned by PCM_RingGetSendBlock as queued to the EDMA.
+ *
+ * @param ring ring handle.
+ */
+void PCM_RingCommitSend(pcm_ring_t *ring);
+
+/*!
+ * @brief Release the oldest queued block, call from the SAI EDMA completion callback.
+ *
+ * @param ring ring handle.
+ */
+void PCM_RingCompleteBlock(pcm_ring_t *ring);
+
+/*!
+ * @brief Take back the blocks queued to the consumer but not played, after it stopped early.
+ *
+ * PCM_RingGetSendBlock hands them out again, oldest first.
+ *
+ * @param ring ring handle.
+ */
+void PCM_RingCancelSend(pcm_ring_t *ring);
+
+/*!
+ * @brief Start output even below the high watermark, so the blocks left at the end of a stream play out.
+ *
+ * @param ring ring handle.
+ */
+void PCM_RingFlush(pcm_ring_t *ring);
+
+/*!
+ * @brief Get the number of blocks holding PCM, including the ones owned by the EDMA.
+ *
+ * @param ring ring handle.
+ */
+static inline uint32_t PCM_RingGetFill(pcm_ring_t *ring)
+{
+    return ring->produced - ring->completed;
+}
+
+#endif /* _PCM_RING_H_ */
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+#include "sai_tx_loop.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* what a TCD reads while its block is not armed */
+AT_NONCACHEABLE_SECTION_ALIGN(static uint8_t s_silence[SAI_TX_LOOP_MAX_BLOCK_SIZE], 4);
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void SAI_TxLoopEDMACallback(edma_handle_t *handle, void *userData, bool transferDone, uint32_t tcds)
+{
+    sai_tx_loop_t *loop = (sai_tx_loop_t *)userData;
+    uint32_t block      = loop->block;
+    bool nextArmed;
+
+    if (transferDone)
+    {
+        /* keep a stale DONE from blocking the next scatter/gather load */
+        handle->base->CDNE = handle->channel;
+    }
+    if (!loop->running)
+    {
+        return;
+    }
+
+    /* The interrupt comes once the EDMA has loaded the next TCD, so the block just played can be
+     * silenced, and the source address the EDMA is now reading tells whether the next block
+     * was armed in time. */
+    loop->tcd[block].SADDR = (uint32_t)s_silence;
+    loop->block            = (block + 1U) % loop->blockNum;
+    nextArmed              = (handle->base->TCD[handle->channel].SADDR - (uint32_t)s_silence) >= loop->blockSize;
+
+    loop->callback(loop, block, nextArmed, loop->userData);
+}
+
+void SAI_TxLoopCreateHandle(
+    I2S_Type *base, sai_tx_loop_t *loop, sai_tx_loop_callback_t callback, void *userData, edma_handle_t *dmaHandle)
+{
+    assert(loop && dmaHandle && (dmaHandle->tcdPool == NULL));
+    assert(((uint32_t)loop->tcd & 0x1FU) == 0U);
+
+    memset(loop, 0, sizeof(*loop));
+    loop->base      = base;
+    loop->dmaHandle = dmaHandle;
+    loop->callback  = callback;
+    loop->userData  = userData;
+
+    EDMA_SetCallback(dmaHandle, SAI_TxLoopEDMACallback, loop);
+}
+
+void SAI_TxLoopSetFormat(sai_tx_loop_t *loop,
+                         sai_transfer_format_t *format,
+                         uint32_t mclkSourceClockHz,
+                         uint32_t bclkSourceClockHz)
+{
+    SAI_TxSetFormat(loop->base, format, mclkSourceClockHz, bclkSourceClockHz);
+
+    /* the same EDMA geometry fsl_sai_edma uses */
+    loop->bytesPerFrame = (format->bitWidth == 24U) ? 4U : (format->bitWidth / 8U);
+    loop->channel       = format->channel;
+    loop->base->TCR3 &= ~I2S_TCR3_TCE_MASK;
+#if defined(FSL_FEATURE_SAI_FIFO_COUNT) && (FSL_FEATURE_SAI_FIFO_COUNT > 1)
+    loop->count = FSL_FEATURE_SAI_FIFO_COUNT - format->watermark;
+#else
+    loop->count = 1U;
+#endif /* FSL_FEATURE_SAI_FIFO_COUNT */
+}
+
+void SAI_TxLoopSetBuffer(sai_tx_loop_t *loop, uint8_t *buffer, uint32_t blockSize, uint32_t blockNum)
+{
+    edma_transfer_config_t config;
+    uint32_t destAddr = SAI_TxGetDataRegisterAddress(loop->base, loop->channel);
+    uint32_t i;
+
+    assert((blockSize <= SAI_TX_LOOP_MAX_BLOCK_SIZE) && (blockNum <= SAI_TX_LOOP_MAX_BLOCKS));
+    assert((blockSize % (loop->count * loop->bytesPerFrame)) == 0U);
+
+    memset(s_silence, 0, sizeof(s_silence));
+    loop->buffer    = buffer;
+    loop->blockSize = blockSize;
+    loop->blockNum  = blockNum;
+
+    EDMA_PrepareTransfer(&config, s_silence, loop->bytesPerFrame, (void *)destAddr, loop->bytesPerFrame,
+                         loop->count * loop->bytesPerFrame, blockSize, kEDMA_MemoryToPeripheral);
+    for (i = 0U; i < blockNum; i++)
+    {
+        EDMA_TcdReset(&loop->tcd[i]);
+        EDMA_TcdSetTransferConfig(&loop->tcd[i], &config, &loop->tcd[(i + 1U) % blockNum]);
+        EDMA_TcdEnableInterrupts(&loop->tcd[i], kEDMA_MajorInterruptEnable);
+    }
+}
+
+void SAI_TxLoopStart(sai_tx_loop_t *loop, uint32_t block)
+{
+    loop->block   = block;
+    loop->running = true;
+
+    EDMA_InstallTCD(loop->dmaHandle->base, loop->dmaHandle->channel, &loop->tcd[block]);
+    EDMA_StartTransfer(loop->dmaHandle);
+
+    SAI_TxEnableDMA(loop->base, kSAI_FIFORequestDMAEnable, true);
+    SAI_TxEnable(loop->base, true);
+    loop->base->TCR3 |= I2S_TCR3_TCE(1U << loop->channel);
+}
+
+void SAI_TxLoopStop(sai_tx_loop_t *loop)
+{
+    uint32_t i;
+
+    loop->running = false;
+    EDMA_AbortTransfer(loop->dmaHandle);
+    EDMA_ClearChannelStatusFlags(loop->dmaHandle->base, loop->dmaHandle->channel,
+                                 kEDMA_DoneFlag | kEDMA_InterruptFlag);
+
+    /* as SAI_TransferAbortSendEDMA leaves the transmitter */
+    loop->base->TCR3 &= ~I2S_TCR3_TCE_MASK;
+    SAI_TxEnableDMA(loop->base, kSAI_FIFORequestDMAEnable, false);
+    SAI_TxEnable(loop->base, false);
+    loop->base->TCSR |= (I2S_TCSR_FR_MASK | I2S_TCSR_SR_MASK);
+    loop->base->TCSR &= ~I2S_TCSR_SR_MASK;
+
+    for (i = 0U; i < loop->blockNum; i++)
+    {
+        loop->tcd[i].SADDR = (uint32_t)s_silence;
+    }
+}
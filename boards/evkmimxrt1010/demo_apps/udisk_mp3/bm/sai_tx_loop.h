@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _SAI_TX_LOOP_H_
+#define _SAI_TX_LOOP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_edma.h"
+#include "fsl_sai.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief maximum number of blocks a loop can cycle over */
+#define SAI_TX_LOOP_MAX_BLOCKS (4U)
+/*! @brief largest block, one MP3 granule of 16-bit stereo */
+#define SAI_TX_LOOP_MAX_BLOCK_SIZE (2304U)
+
+struct _sai_tx_loop;
+
+/*!
+ * @brief Called from the EDMA interrupt each time a block has been played.
+ *
+ * @param loop      loop handle.
+ * @param block     index of the block played, now silent until it is armed again.
+ * @param nextArmed false if the EDMA went on into silence, the loop should then be stopped.
+ * @param userData  as passed to SAI_TxLoopCreateHandle.
+ */
+typedef void (*sai_tx_loop_callback_t)(struct _sai_tx_loop *loop, uint32_t block, bool nextArmed, void *userData);
+
+/*!
+ * @brief Continuous SAI transmit: the EDMA cycles over a buffer of blocks on its own.
+ *
+ * Every block has a TCD, each linked to the next by scatter/gather and the last back to the
+ * first, so once started the EDMA keeps the SAI FIFO fed without the CPU ever submitting a
+ * transfer. A TCD reads either its block or a silent block: SAI_TxLoopArm points it at the
+ * block once the block holds PCM, and the interrupt at the end of the block points it back
+ * at silence, so a block is never played twice. Only the source address changes, so arming
+ * is a single store the EDMA cannot see half done.
+ *
+ * The structure holds the TCDs, so it must sit in non-cacheable memory aligned to 32 bytes.
+ */
+typedef struct _sai_tx_loop
+{
+    edma_tcd_t tcd[SAI_TX_LOOP_MAX_BLOCKS]; /*!< one per block, first so they share the structure alignment */
+    I2S_Type *base;                         /*!< SAI peripheral */
+    edma_handle_t *dmaHandle;               /*!< EDMA channel serving the SAI Tx FIFO */
+    sai_tx_loop_callback_t callback;        /*!< block completion callback */
+    void *userData;                         /*!< callback parameter */
+    uint8_t *buffer;                        /*!< blockNum * blockSize bytes of PCM */
+    uint32_t blockSize;                     /*!< bytes per block */
+    uint32_t blockNum;                      /*!< number of blocks */
+    uint32_t channel;                       /*!< SAI data channel */
+    uint32_t bytesPerFrame;                 /*!< bytes per EDMA access, one SAI word */
+    uint32_t count;                         /*!< words moved per SAI FIFO request */
+    volatile uint32_t block;                /*!< block the EDMA is playing */
+    volatile bool running;                  /*!< the EDMA is cycling */
+} sai_tx_loop_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Take over an EDMA channel for continuous SAI transmit.
+ *
+ * Use instead of SAI_TransferTxCreateHandleEDMA; the channel must not have a TCD pool installed.
+ *
+ * @param base      SAI peripheral.
+ * @param loop      loop handle.
+ * @param callback  block completion callback, runs in the EDMA interrupt.
+ * @param userData  callback parameter.
+ * @param dmaHandle EDMA handle created for the SAI Tx channel.
+ */
+void SAI_TxLoopCreateHandle(
+    I2S_Type *base, sai_tx_loop_t *loop, sai_tx_loop_callback_t callback, void *userData, edma_handle_t *dmaHandle);
+
+/*!
+ * @brief Configure the SAI Tx audio format, with the loop stopped.
+ *
+ * @param loop              loop handle.
+ * @param format            audio format.
+ * @param mclkSourceClockHz SAI master clock source frequency.
+ * @param bclkSourceClockHz SAI bit clock source frequency.
+ */
+void SAI_TxLoopSetFormat(sai_tx_loop_t *loop,
+                         sai_transfer_format_t *format,
+                         uint32_t mclkSourceClockHz,
+                         uint32_t bclkSourceClockHz);
+
+/*!
+ * @brief Build the TCD chain over a buffer, with every block silent. Call with the loop stopped,
+ * after SAI_TxLoopSetFormat.
+ *
+ * @param loop      loop handle.
+ * @param buffer    blockSize * blockNum bytes.
+ * @param blockSize bytes per block, at most SAI_TX_LOOP_MAX_BLOCK_SIZE and a whole number of FIFO requests.
+ * @param blockNum  number of blocks, at most SAI_TX_LOOP_MAX_BLOCKS.
+ */
+void SAI_TxLoopSetBuffer(sai_tx_loop_t *loop, uint8_t *buffer, uint32_t blockSize, uint32_t blockNum);
+
+/*!
+ * @brief Let the EDMA play a block the next time it comes round.
+ *
+ * The block must already be in memory, cleaned out of the D-cache. Arming the block right
+ * after the one playing races with the EDMA loading its TCD; the completion callback reports
+ * whether the EDMA saw it in time.
+ *
+ * @param loop  loop handle.
+ * @param block block index.
+ */
+static inline void SAI_TxLoopArm(sai_tx_loop_t *loop, uint32_t block)
+{
+    loop->tcd[block].SADDR = (uint32_t)(loop->buffer + block * loop->blockSize);
+}
+
+/*!
+ * @brief Start cycling at an armed block.
+ *
+ * @param loop  loop handle.
+ * @param block block index.
+ */
+void SAI_TxLoopStart(sai_tx_loop_t *loop, uint32_t block);
+
+/*!
+ * @brief Stop the EDMA and the SAI transmitter and make every block silent again.
+ *
+ * @param loop loop handle.
+ */
+void SAI_TxLoopStop(sai_tx_loop_t *loop);
+
+#endif /* _SAI_TX_LOOP_H_ */
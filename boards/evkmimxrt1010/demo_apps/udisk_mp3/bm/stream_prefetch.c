@@ -0,0 +1,288 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+#include "stream_prefetch.h"
+#include "fsl_usb_disk.h"
+#include "fsl_cache.h"
+#include "event_sched.h"
+#ifdef USB_DISK_CACHE_ENABLE
+#include "disk_cache.h"
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if FF_MAX_SS == FF_MIN_SS
+#define PREFETCH_SECTOR_SIZE(fs) ((uint32_t)FF_MAX_SS)
+#else
+#define PREFETCH_SECTOR_SIZE(fs) ((uint32_t)(fs)->ssize)
+#endif
+
+/*! @brief times a failed READ(10) is issued again before the stream is ended */
+#define STREAM_PREFETCH_RETRY_TIMES (2U)
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Find the first sector of the cluster holding fileOffset.
+ * Seeking to the end of that cluster leaves FIL.clust on it without loading any data sector,
+ * and without reading the FAT either when the file has a cluster link map (fast_seek.h). */
+static FRESULT STREAM_PrefetchMapCluster(stream_prefetch_t *prefetch)
+{
+    FIL *file      = prefetch->file;
+    FATFS *fs      = file->obj.fs;
+    uint32_t bcs   = (uint32_t)fs->csize * PREFETCH_SECTOR_SIZE(fs);
+    FSIZE_t seekTo;
+    FRESULT res;
+
+    prefetch->clusterOffset = prefetch->fileOffset & ~(FSIZE_t)(bcs - 1U);
+    seekTo                  = prefetch->clusterOffset + bcs;
+    if (seekTo > f_size(file))
+    {
+        seekTo = f_size(file);
+    }
+    res = f_lseek(file, seekTo);
+    if (res != FR_OK)
+    {
+        return res;
+    }
+    if (file->clust < 2U)
+    {
+        return FR_INT_ERR;
+    }
+    prefetch->clusterSector = fs->database + fs->csize * (file->clust - 2U);
+
+    return FR_OK;
+}
+
+/* Completion of the read in flight, from the USB host task. Only recorded here, STREAM_PrefetchService
+ * takes the block and issues the next read from the main loop. */
+static void STREAM_PrefetchReadCallback(void *param, DRESULT result)
+{
+    stream_prefetch_t *prefetch = (stream_prefetch_t *)param;
+
+    prefetch->result  = result;
+    prefetch->reading = 0U;
+}
+
+static void STREAM_PrefetchIssue(stream_prefetch_t *prefetch)
+{
+    FATFS *fs = prefetch->file->obj.fs;
+    uint32_t sectorSize = PREFETCH_SECTOR_SIZE(fs);
+    uint32_t bcs        = (uint32_t)fs->csize * sectorSize;
+    uint32_t align;
+    uint32_t length;
+    uint8_t *slot;
+
+    if (prefetch->inFlight || prefetch->error || ((prefetch->filled - prefetch->consumed) >= prefetch->blockNum) ||
+        (prefetch->fileOffset >= f_size(prefetch->file)))
+    {
+        return;
+    }
+
+    if ((prefetch->clusterSector == 0U) || (prefetch->fileOffset >= prefetch->clusterOffset + bcs))
+    {
+        if (STREAM_PrefetchMapCluster(prefetch) != FR_OK)
+        {
+            prefetch->error = 1U;
+            return;
+        }
+    }
+
+    /* run up to the next block or cluster boundary, whichever comes first */
+    align  = (prefetch->blockSize < bcs) ? prefetch->blockSize : bcs;
+    length = align - (uint32_t)(prefetch->fileOffset & (align - 1U));
+    if (length > f_size(prefetch->file) - prefetch->fileOffset)
+    {
+        prefetch->pendingLength = (uint32_t)(f_size(prefetch->file) - prefetch->fileOffset);
+    }
+    else
+    {
+        prefetch->pendingLength = length;
+    }
+    prefetch->pendingSector = prefetch->clusterSector +
+                              (DWORD)((prefetch->fileOffset - prefetch->clusterOffset) / sectorSize);
+    prefetch->pendingCount = (prefetch->pendingLength + sectorSize - 1U) / sectorSize;
+    prefetch->fileOffset += length;
+    prefetch->retry = STREAM_PREFETCH_RETRY_TIMES;
+
+    slot = prefetch->buffer + (prefetch->filled % prefetch->blockNum) * prefetch->blockSize;
+    /* drop any dirty line so an eviction cannot land on top of the incoming data */
+    DCACHE_InvalidateByRange((uint32_t)slot, prefetch->pendingCount * sectorSize);
+    prefetch->reading = 1U;
+    if (USB_HostMsdReadDiskAsync(fs->pdrv, slot, prefetch->pendingSector, prefetch->pendingCount,
+                                 STREAM_PrefetchReadCallback, prefetch) != RES_OK)
+    {
+        prefetch->reading = 0U;
+        prefetch->error   = 1U;
+        return;
+    }
+    prefetch->inFlight = 1U;
+    prefetch->reads++;
+}
+
+void STREAM_PrefetchInit(stream_prefetch_t *prefetch, uint8_t *buffer, uint32_t blockSize, uint32_t blockNum)
+{
+    memset(prefetch, 0, sizeof(*prefetch));
+    if (blockNum > STREAM_PREFETCH_MAX_BLOCKS)
+    {
+        blockNum = STREAM_PREFETCH_MAX_BLOCKS;
+    }
+    prefetch->buffer    = buffer;
+    prefetch->blockSize = blockSize;
+    prefetch->blockNum  = blockNum;
+}
+
+FRESULT STREAM_PrefetchStart(stream_prefetch_t *prefetch, FIL *file, FSIZE_t offset)
+{
+    uint32_t sectorSize;
+
+    if (prefetch->inFlight)
+    {
+        EVENT_SchedWait(&prefetch->reading);
+        prefetch->inFlight = 0U;
+    }
+
+    if (offset > f_size(file))
+    {
+        offset = f_size(file);
+    }
+    sectorSize              = PREFETCH_SECTOR_SIZE(file->obj.fs);
+    prefetch->file          = file;
+    prefetch->filled        = 0U;
+    prefetch->consumed      = 0U;
+    prefetch->fileOffset    = offset & ~(FSIZE_t)(sectorSize - 1U);
+    prefetch->readOffset    = (uint32_t)(offset - prefetch->fileOffset);
+    prefetch->clusterOffset = 0U;
+    prefetch->clusterSector = 0U;
+    prefetch->error         = 0U;
+    prefetch->reads         = 0U;
+    prefetch->stalls        = 0U;
+
+    if (prefetch->fileOffset < f_size(file))
+    {
+        if (STREAM_PrefetchMapCluster(prefetch) != FR_OK)
+        {
+            prefetch->error = 1U;
+            return FR_DISK_ERR;
+        }
+    }
+    STREAM_PrefetchIssue(prefetch);
+
+    return FR_OK;
+}
+
+void STREAM_PrefetchStop(stream_prefetch_t *prefetch)
+{
+    if (prefetch->file == NULL)
+    {
+        return;
+    }
+    /* request nothing more, a read already in flight still lands in the queue */
+    prefetch->fileOffset = f_size(prefetch->file);
+    while (prefetch->inFlight)
+    {
+        EVENT_SchedWait(&prefetch->reading);
+        STREAM_PrefetchService(prefetch);
+    }
+}
+
+void STREAM_PrefetchService(stream_prefetch_t *prefetch)
+{
+    FATFS *fs;
+    uint8_t *slot;
+
+    if (prefetch->inFlight)
+    {
+        if (prefetch->reading)
+        {
+            return;
+        }
+        fs = prefetch->file->obj.fs;
+        prefetch->inFlight = 0U;
+        slot = prefetch->buffer + (prefetch->filled % prefetch->blockNum) * prefetch->blockSize;
+        if (prefetch->result != RES_OK)
+        {
+            prefetch->reading = 1U;
+            if ((prefetch->retry == 0U) ||
+                (USB_HostMsdReadDiskAsync(fs->pdrv, slot, prefetch->pendingSector, prefetch->pendingCount,
+                                          STREAM_PrefetchReadCallback, prefetch) != RES_OK))
+            {
+                prefetch->reading = 0U;
+                prefetch->error   = 1U;
+                return;
+            }
+            prefetch->retry--;
+            prefetch->inFlight = 1U;
+            return;
+        }
+        /* lines may have been speculatively refetched while the transfer ran */
+        DCACHE_InvalidateByRange((uint32_t)slot, prefetch->pendingCount * PREFETCH_SECTOR_SIZE(fs));
+#ifdef USB_DISK_CACHE_ENABLE
+        /* the read went past the sector cache, take what FatFs has not written back yet */
+        DISK_CacheOverlay(fs->pdrv, slot, prefetch->pendingSector, prefetch->pendingCount);
+#endif
+        prefetch->blockLength[prefetch->filled % prefetch->blockNum] = prefetch->pendingLength;
+        prefetch->filled++;
+    }
+    STREAM_PrefetchIssue(prefetch);
+}
+
+uint32_t STREAM_PrefetchRead(stream_prefetch_t *prefetch, uint8_t *data, uint32_t size)
+{
+    uint32_t copied = 0U;
+    uint32_t index;
+    uint32_t count;
+    uint8_t waiting = 0U;
+
+    while (copied < size)
+    {
+        STREAM_PrefetchService(prefetch);
+        if (prefetch->filled == prefetch->consumed)
+        {
+            if (!prefetch->inFlight)
+            {
+                /* end of file, or the disk failed */
+                break;
+            }
+            if (!waiting)
+            {
+                prefetch->stalls++;
+                waiting = 1U;
+            }
+            /* sleep until the completion instead of spinning on it */
+            EVENT_SchedWait(&prefetch->reading);
+            continue;
+        }
+        waiting = 0U;
+
+        index = prefetch->consumed % prefetch->blockNum;
+        count = 0U;
+        if (prefetch->blockLength[index] > prefetch->readOffset)
+        {
+            count = prefetch->blockLength[index] - prefetch->readOffset;
+            if (count > size - copied)
+            {
+                count = size - copied;
+            }
+            memcpy(data + copied, prefetch->buffer + index * prefetch->blockSize + prefetch->readOffset, count);
+            copied += count;
+            prefetch->readOffset += count;
+        }
+        if (prefetch->readOffset >= prefetch->blockLength[index])
+        {
+            prefetch->readOffset = 0U;
+            prefetch->consumed++;
+        }
+    }
+
+    return copied;
+}
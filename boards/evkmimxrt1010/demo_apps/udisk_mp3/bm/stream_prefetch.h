@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _STREAM_PREFETCH_H_
+#define _STREAM_PREFETCH_H_
+
+#include <stdint.h>
+#include "ff.h"
+#include "diskio.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief maximum number of blocks a prefetcher can queue */
+#define STREAM_PREFETCH_MAX_BLOCKS (4U)
+
+/*!
+ * @brief Read-ahead queue of compressed file data in front of the USB mass storage driver.
+ *
+ * The file is read in blocks of up to blockSize bytes. Every block is one READ(10)
+ * issued asynchronously straight into the queue, starts on a multiple of
+ * min(blockSize, cluster size) and therefore never crosses a cluster. While a block
+ * is in flight the caller keeps decoding; the read's completion callback runs from
+ * the USB host task and only clears reading, STREAM_PrefetchService then collects
+ * the block and starts the next read whenever a queue slot is free.
+ *
+ * Blocks move through two free running counters: filled (read completed) and
+ * consumed (fully copied out by STREAM_PrefetchRead). At most one read is in
+ * flight, into slot filled % blockNum.
+ */
+typedef struct _stream_prefetch
+{
+    FIL *file;                                         /*!< open file, only its cluster chain is used */
+    uint8_t *buffer;                                   /*!< blockNum * blockSize bytes, cache line aligned */
+    uint32_t blockSize;                                /*!< bytes per block, a multiple of the sector size */
+    uint32_t blockNum;                                 /*!< number of blocks in the queue */
+    uint32_t blockLength[STREAM_PREFETCH_MAX_BLOCKS];  /*!< valid bytes in each filled block */
+    uint32_t filled;                                   /*!< blocks read from the disk */
+    uint32_t consumed;                                 /*!< blocks handed out to the reader */
+    uint32_t readOffset;                               /*!< bytes already taken from block consumed */
+    FSIZE_t fileOffset;                                /*!< file offset of the next block to request */
+    FSIZE_t clusterOffset;                             /*!< file offset of the first byte in clusterSector */
+    DWORD clusterSector;                               /*!< first sector of the cluster holding fileOffset */
+    DWORD pendingSector;                               /*!< first sector of the read in flight */
+    uint32_t pendingCount;                             /*!< sectors in the read in flight */
+    uint32_t pendingLength;                            /*!< valid bytes of the read in flight */
+    uint8_t inFlight;                                  /*!< a READ(10) is issued and not collected yet */
+    volatile uint8_t reading;                          /*!< the READ(10) has not completed, cleared by its callback */
+    DRESULT result;                                    /*!< result the completion callback reported */
+    uint8_t retry;                                     /*!< retries left for the read in flight */
+    uint8_t error;                                     /*!< a read failed, the stream ends here */
+    uint32_t reads;                                    /*!< READ(10) commands issued */
+    uint32_t stalls;                                   /*!< times the reader had to wait for the disk */
+} stream_prefetch_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Initialize the prefetcher over a caller provided buffer.
+ *
+ * @param prefetch  prefetcher handle.
+ * @param buffer    storage, blockSize * blockNum bytes aligned to the D-cache line.
+ * @param blockSize bytes per block, a multiple of the sector size.
+ * @param blockNum  number of blocks, at most STREAM_PREFETCH_MAX_BLOCKS.
+ */
+void STREAM_PrefetchInit(stream_prefetch_t *prefetch, uint8_t *buffer, uint32_t blockSize, uint32_t blockNum);
+
+/*!
+ * @brief Drop any queued data and start reading file at offset.
+ *
+ * Waits for a read still in flight from a previous stream before it returns.
+ *
+ * @param prefetch prefetcher handle.
+ * @param file     file opened for reading.
+ * @param offset   file offset of the first byte STREAM_PrefetchRead returns.
+ *
+ * @return FR_OK or the FatFs error seen while mapping the first cluster.
+ */
+FRESULT STREAM_PrefetchStart(stream_prefetch_t *prefetch, FIL *file, FSIZE_t offset);
+
+/*!
+ * @brief Stop reading ahead and wait until the disk is idle.
+ *
+ * Other FatFs calls may use the disk afterwards. STREAM_PrefetchRead still returns the
+ * data read so far and then reports the end of the file, until STREAM_PrefetchStart.
+ *
+ * @param prefetch prefetcher handle.
+ */
+void STREAM_PrefetchStop(stream_prefetch_t *prefetch);
+
+/*!
+ * @brief Collect a finished read and issue the next one, never waits.
+ *
+ * Call it from the main loop after the event scheduler has run, so the disk works while the decoder runs.
+ *
+ * @param prefetch prefetcher handle.
+ */
+void STREAM_PrefetchService(stream_prefetch_t *prefetch);
+
+/*!
+ * @brief Copy the next bytes of the stream.
+ *
+ * Only waits on the disk when the queue has run dry, and sleeps in the event scheduler meanwhile.
+ *
+ * @param prefetch prefetcher handle.
+ * @param data     destination.
+ * @param size     bytes wanted.
+ *
+ * @return bytes copied, less than size only at the end of the file or after a read error.
+ */
+uint32_t STREAM_PrefetchRead(stream_prefetch_t *prefetch, uint8_t *data, uint32_t size);
+
+#endif /* _STREAM_PREFETCH_H_ */
@@ -131,8 +131,12 @@
 
 /*!
  * @brief ehci QTD max count.
+ * a bulk qtd carries up to 20KB, at least 16KB when the buffer is not page aligned (see USB_HostEhciQtdDataLength),
+ * so the data phase of a 64KB mass storage command takes up to 4 qtds, its CBW and CSW one each. the next
+ * command's CBW is only sent in the CSW phase of the one in progress, so the disk holds at most 4 bulk qtds at
+ * once; with 3 for a control transfer and 1 for the hub interrupt pipe that is 8, the rest is headroom.
  */
-#define USB_HOST_CONFIG_EHCI_MAX_QTD (8U)
+#define USB_HOST_CONFIG_EHCI_MAX_QTD (16U)
 
 /*!
  * @brief ehci ITD max count.
@@ -0,0 +1,316 @@
+/*
+ * Copyright 2020 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+#include "audio_source.h"
+#include "ff.h"
+#include "fast_seek.h"
+#include "fsl_common.h"
+#include "fsl_cache.h"
+#include "fsl_debug_console.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define WAV_SECTOR_SIZE ((uint32_t)FF_MAX_SS)
+
+/*! @brief PCM ring block, 512 frames in any format. No bigger than an MP3 granule, so the ring
+ *  keeps the block above its high watermark that a short last block needs as scratch. */
+#define WAV_BLOCK_SIZE (2048U)
+
+#define WAV_FORMAT_PCM        (0x0001U)
+#define WAV_FORMAT_EXTENSIBLE (0xFFFEU)
+
+#define WAV_GET16(p) ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8))
+#define WAV_GET32(p) (WAV_GET16(p) | (WAV_GET16((p) + 2) << 16))
+
+/*! @brief the track being played */
+typedef struct _wav_source
+{
+    FSIZE_t dataEnd;      /*!< file offset behind the last byte of the data chunk */
+    uint32_t readLength;  /*!< file bytes read per block */
+    uint32_t pad;         /*!< bytes in front of the data chunk read into the first block, played as silence */
+    uint8_t channels;     /*!< 1 or 2 */
+    uint8_t sampleBytes;  /*!< 2 or 3 */
+    uint8_t frameBytes;   /*!< channels * sampleBytes */
+    uint8_t outFrameBytes; /*!< bytes of a stereo frame in the ring, 4 or 8 */
+    uint32_t reads;       /*!< f_read calls */
+    uint64_t bytes;       /*!< bytes read */
+    uint64_t cycles;      /*!< core cycles spent waiting for the disk */
+} wav_source_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static wav_source_t s_wav;
+/* partial sectors are copied out of the FIL sector buffer, which the disk fills by DMA */
+AT_NONCACHEABLE_SECTION(static FIL s_wavFile);
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static uint8_t WAV_SourceProbe(const uint8_t *header, uint32_t size)
+{
+    return (size >= 12U) && (memcmp(header, "RIFF", 4) == 0) && (memcmp(header + 8, "WAVE", 4) == 0);
+}
+
+/* Walk the chunks up to the data chunk and check that the fmt chunk in front of it is
+ * 16 or 24-bit PCM, mono or stereo. Leaves the file pointer on the first data byte. */
+static uint8_t WAV_SourceParse(uint32_t *sampleRate_Hz)
+{
+    uint8_t buf[40];
+    uint32_t size;
+    uint32_t tag;
+    uint32_t bits = 0U;
+    UINT br;
+    FSIZE_t pos = 12U;
+
+    while (1)
+    {
+        if ((f_lseek(&s_wavFile, pos) != FR_OK) || (f_read(&s_wavFile, buf, 8U, &br) != FR_OK) || (br < 8U))
+        {
+            return 1U;
+        }
+        size = WAV_GET32(buf + 4);
+        pos += 8U;
+        if (memcmp(buf, "data", 4) == 0)
+        {
+            break;
+        }
+        if (memcmp(buf, "fmt ", 4) == 0)
+        {
+            if ((size < 16U) || (f_read(&s_wavFile, buf, MIN(size, sizeof(buf)), &br) != FR_OK) ||
+                (br < MIN(size, sizeof(buf))))
+            {
+                return 1U;
+            }
+            tag = WAV_GET16(buf);
+            if ((tag == WAV_FORMAT_EXTENSIBLE) && (size >= 40U))
+            {
+                tag = WAV_GET16(buf + 24); /* first two bytes of the sub format GUID */
+            }
+            if (tag != WAV_FORMAT_PCM)
+            {
+                return 1U;
+            }
+            s_wav.channels = (uint8_t)WAV_GET16(buf + 2);
+            *sampleRate_Hz = WAV_GET32(buf + 4);
+            s_wav.frameBytes = (uint8_t)WAV_GET16(buf + 12);
+            bits = WAV_GET16(buf + 14);
+        }
+        pos += size + (size & 1U); /* chunks are word aligned */
+    }
+
+    if (((s_wav.channels != 1U) && (s_wav.channels != 2U)) || ((bits != 16U) && (bits != 24U)) ||
+        (*sampleRate_Hz == 0U) || (s_wav.frameBytes != s_wav.channels * bits / 8U))
+    {
+        return 1U;
+    }
+    s_wav.sampleBytes = (uint8_t)(bits / 8U);
+    /* a data chunk still being written says 0 or 0xFFFFFFFF bytes, it runs to the end of the file then */
+    if ((size == 0U) || (size > f_size(&s_wavFile) - pos))
+    {
+        size = (uint32_t)(f_size(&s_wavFile) - pos);
+    }
+    s_wav.dataEnd = pos + size;
+
+    return 0U;
+}
+
+static uint8_t WAV_SourceOpen(const char *path, audio_source_format_t *format)
+{
+    FSIZE_t dataStart;
+    uint32_t i;
+
+    memset(&s_wav, 0, sizeof(s_wav));
+    if (FAST_SeekOpen(&s_wavFile, path) != FR_OK)
+    {
+        return 1U;
+    }
+    if (WAV_SourceParse(&format->sampleRate_Hz) != 0U)
+    {
+        FAST_SeekClose(&s_wavFile);
+        return 1U;
+    }
+    dataStart = f_tell(&s_wavFile);
+
+    /* 24-bit samples play MSB aligned in 32-bit SAI words, mono plays on both channels */
+    s_wav.outFrameBytes = (s_wav.sampleBytes == 2U) ? 4U : 8U;
+    format->bitWidth    = (s_wav.sampleBytes == 2U) ? 16U : 32U;
+    format->blockSize   = WAV_BLOCK_SIZE;
+    /* whole sectors for every format but 24-bit mono, whose reads end on a half sector */
+    s_wav.readLength = WAV_BLOCK_SIZE / s_wav.outFrameBytes * s_wav.frameBytes;
+
+    /* Start on a sector boundary in front of the data chunk where that keeps frames whole, so
+     * the reads are whole sectors and go from the disk straight into the block. Otherwise
+     * the reads stay on the frames and most sectors are copied out of the FIL buffer. */
+    s_wav.pad = (uint32_t)(dataStart % WAV_SECTOR_SIZE);
+    for (i = 0U; ((s_wav.pad % s_wav.frameBytes) != 0U) && (i < s_wav.frameBytes); i++)
+    {
+        s_wav.pad += WAV_SECTOR_SIZE;
+    }
+    if (((s_wav.pad % s_wav.frameBytes) != 0U) || (s_wav.pad > dataStart) || (s_wav.pad >= s_wav.readLength))
+    {
+        s_wav.pad = 0U;
+    }
+    if (f_lseek(&s_wavFile, dataStart - s_wav.pad) != FR_OK)
+    {
+        FAST_SeekClose(&s_wavFile);
+        return 1U;
+    }
+
+    /* cycles spent in f_read, for the disk throughput printed at the end of the track */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    PRINTF("wav: %d Hz, %d bit, %d ch, %s reads\r\n", format->sampleRate_Hz, s_wav.sampleBytes * 8U,
+           s_wav.channels, ((dataStart - s_wav.pad) % WAV_SECTOR_SIZE) ? "copied" : "direct");
+
+    return 0U;
+}
+
+/* Read length bytes from the file pointer into block. Whole sectors landing on whole cache
+ * lines go from the disk straight into block; anything else is copied out of the FIL
+ * sector buffer, so the cache never holds lines the disk also writes. */
+static uint32_t WAV_SourceReadFile(uint8_t *block, uint32_t length)
+{
+    uint32_t done = 0U;
+    uint32_t n;
+    uint32_t start;
+    UINT br;
+    FRESULT res;
+
+    while (done < length)
+    {
+        n = length - done;
+        if (((f_tell(&s_wavFile) % WAV_SECTOR_SIZE) == 0U) && (n >= WAV_SECTOR_SIZE) &&
+            (((uint32_t)(block + done) % FSL_FEATURE_L1DCACHE_LINESIZE_BYTE) == 0U))
+        {
+            n &= ~(WAV_SECTOR_SIZE - 1U);
+            /* drop any dirty line so an eviction cannot land on top of the incoming data */
+            DCACHE_InvalidateByRange((uint32_t)(block + done), n);
+            start = DWT->CYCCNT;
+            res   = f_read(&s_wavFile, block + done, n, &br);
+            s_wav.cycles += DWT->CYCCNT - start;
+            /* lines may have been speculatively refetched while the transfer ran */
+            DCACHE_InvalidateByRange((uint32_t)(block + done), n);
+        }
+        else
+        {
+            n     = MIN(n, WAV_SECTOR_SIZE - (uint32_t)(f_tell(&s_wavFile) % WAV_SECTOR_SIZE));
+            start = DWT->CYCCNT;
+            res   = f_read(&s_wavFile, block + done, n, &br);
+            s_wav.cycles += DWT->CYCCNT - start;
+        }
+        s_wav.reads++;
+        if (res != FR_OK)
+        {
+            break;
+        }
+        done += br;
+        if (br < n)
+        {
+            break;
+        }
+    }
+    s_wav.bytes += done;
+
+    return done;
+}
+
+/* Widen the frames read into the head of block to what the SAI plays, in place from the
+ * back: no output frame is shorter than its input frame, so none is overwritten unread. */
+static void WAV_SourceUnpack(uint8_t *block, uint32_t frames)
+{
+    int16_t *pcm16   = (int16_t *)block;
+    uint32_t *pcm32  = (uint32_t *)block;
+    const uint8_t *p;
+    uint32_t sample;
+    int32_t i;
+
+    if (s_wav.sampleBytes == 2U)
+    {
+        if (s_wav.channels == 1U)
+        {
+            for (i = (int32_t)frames - 1; i >= 0; i--)
+            {
+                pcm16[2 * i] = pcm16[2 * i + 1] = pcm16[i];
+            }
+        }
+        return;
+    }
+
+    for (i = (int32_t)(frames * s_wav.channels) - 1; i >= 0; i--)
+    {
+        p      = block + 3 * i;
+        sample = ((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24);
+        if (s_wav.channels == 1U)
+        {
+            pcm32[2 * i] = pcm32[2 * i + 1] = sample;
+        }
+        else
+        {
+            pcm32[i] = sample;
+        }
+    }
+}
+
+static uint8_t WAV_SourceRead(uint8_t *block, uint32_t *pcmOffset, uint32_t *pcmSize)
+{
+    FSIZE_t pos = f_tell(&s_wavFile);
+    uint32_t want;
+    uint32_t length;
+    uint32_t frames;
+
+    if (pos >= s_wav.dataEnd)
+    {
+        return AUDIO_SOURCE_END;
+    }
+    want   = (uint32_t)MIN((FSIZE_t)s_wav.readLength, s_wav.dataEnd - pos);
+    length = WAV_SourceReadFile(block, want);
+    if (length == 0U)
+    {
+        PRINTF("wav: read error\r\n");
+        return AUDIO_SOURCE_END;
+    }
+    if (s_wav.pad != 0U)
+    {
+        memset(block, 0, MIN(s_wav.pad, length));
+        s_wav.pad = 0U;
+    }
+    frames = length / s_wav.frameBytes;
+    WAV_SourceUnpack(block, frames);
+    *pcmOffset = 0U;
+    *pcmSize   = frames * s_wav.outFrameBytes;
+    if (length < want)
+    {
+        s_wav.dataEnd = pos; /* the disk failed or the file is shorter than its header says */
+    }
+
+    return AUDIO_SOURCE_OK;
+}
+
+static void WAV_SourceClose(void)
+{
+    uint32_t ms = (uint32_t)(s_wav.cycles / (SystemCoreClock / 1000U));
+
+    FAST_SeekClose(&s_wavFile);
+    PRINTF("wav: %d KB in %d reads, %d ms on the disk", (uint32_t)(s_wav.bytes / 1024U), s_wav.reads, ms);
+    if (ms != 0U)
+    {
+        PRINTF(" (%d KB/s)", (uint32_t)(s_wav.bytes * 1000U / 1024U / ms));
+    }
+    PRINTF("\r\n");
+}
+
+const audio_source_t g_wavSource = {
+    "wav", WAV_SourceProbe, WAV_SourceOpen, WAV_SourceRead, NULL, WAV_SourceClose,
+};
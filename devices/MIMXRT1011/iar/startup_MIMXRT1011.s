@@ -37,6 +37,9 @@
 
         EXTERN  __iar_program_start
         EXTERN  SystemInit
+        EXTWEAK __FLEXRAM_BANK_CFG
+        EXTWEAK __FLEXRAM_TCM_CFG
+        EXTWEAK __FLEXRAM_TCM_EN
         PUBLIC  __vector_table
         PUBLIC  __vector_table_0x1c
         PUBLIC  __Vectors
@@ -322,6 +325,26 @@ __Vectors_Size  EQU   __Vectors_End - __Vectors
         SECTION .text:CODE:REORDER:NOROOT(2)
 Reset_Handler
         CPSID   I               ; Mask interrupts
+        ; FlexRAM bank split exported by the linker file (0 = keep the fuse setting).
+        ; Done here because the banks being reassigned hold the stack.
+        LDR     R0, =__FLEXRAM_BANK_CFG
+        CBZ     R0, FlexRAM_Done
+        LDR     R1, =0x400AC000 ; IOMUXC_GPR
+        STR     R0, [R1, #0x44] ; GPR17 FLEXRAM_BANK_CFG
+        LDR     R2, [R1, #0x38] ; GPR14 CM7_CFGITCMSZ, CM7_CFGDTCMSZ
+        BIC     R2, R2, #0xFF0000
+        LDR     R3, =__FLEXRAM_TCM_CFG
+        ORR     R2, R2, R3
+        STR     R2, [R1, #0x38]
+        LDR     R2, [R1, #0x40] ; GPR16 INIT_ITCM_EN, INIT_DTCM_EN
+        BIC     R2, R2, #0x3
+        LDR     R3, =__FLEXRAM_TCM_EN
+        ORR     R2, R2, R3
+        ORR     R2, R2, #0x4    ; FLEXRAM_BANK_CFG_SEL, use GPR17 instead of the fuse
+        STR     R2, [R1, #0x40]
+        DSB
+        ISB
+FlexRAM_Done
         LDR     R0, =0xE000ED08
         LDR     R1, =__vector_table
         STR     R1, [R0]
@@ -24,6 +24,9 @@
 
 #ifdef USB_DISK_ENABLE
 #include "fsl_usb_disk.h"
+#ifdef USB_DISK_CACHE_ENABLE
+#include "disk_cache.h"
+#endif
 #endif
 
 #ifdef SD_DISK_ENABLE
@@ -109,6 +112,11 @@ DSTATUS disk_initialize (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#ifdef USB_DISK_CACHE_ENABLE
+            /* a remount of the same medium (a detach drops the lines): write back what is dirty first */
+            (void)DISK_CacheSync(pdrv);
+            DISK_CacheInvalidate(pdrv);
+#endif
             stat = USB_HostMsdInitializeDisk(pdrv);
             return stat;
 #endif
@@ -162,7 +170,11 @@ DRESULT disk_read (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#ifdef USB_DISK_CACHE_ENABLE
+            res = DISK_CacheRead(pdrv, buff, sector, count);
+#else
             res = USB_HostMsdReadDisk(pdrv, buff, sector, count);
+#endif
             return res;
 #endif
 #ifdef SD_DISK_ENABLE
@@ -216,7 +228,11 @@ DRESULT disk_write (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#ifdef USB_DISK_CACHE_ENABLE
+            res = DISK_CacheWrite(pdrv, buff, sector, count);
+#else
             res = USB_HostMsdWriteDisk(pdrv, buff, sector, count);
+#endif
             return res;
 #endif
 #ifdef SD_DISK_ENABLE
@@ -267,6 +283,16 @@ DRESULT disk_ioctl (
 #endif
 #ifdef USB_DISK_ENABLE
         case USBDISK:
+#ifdef USB_DISK_CACHE_ENABLE
+            if (cmd == CTRL_SYNC)
+            {
+                res = DISK_CacheSync(pdrv);
+                if (res != RES_OK)
+                {
+                    return res;
+                }
+            }
+#endif
             res = USB_HostMsdIoctlDisk(pdrv, cmd, buff);
             return res;
 #endif
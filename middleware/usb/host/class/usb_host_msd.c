@@ -120,6 +120,37 @@ static void USB_HostMsdCbwCallback(void *param, usb_host_transfer_t *transfer, u
  */
 static void USB_HostMsdDataCallback(void *param, usb_host_transfer_t *transfer, usb_status_t status);
 
+/*!
+ * @brief queued command's cbw transfer callback.
+ *
+ * @param msdInstance   msd instance pointer.
+ * @param transfer       transfer
+ * @param status         result status.
+ */
+static void USB_HostMsdQueuedCbwCallback(void *param, usb_host_transfer_t *transfer, usb_status_t status);
+
+/*!
+ * @brief send the queued command's cbw once the ongoing command has entered its csw phase.
+ *
+ * @param msdInstance     msd instance pointer.
+ */
+static void USB_HostMsdSendQueuedCbw(usb_host_msd_instance_t *msdInstance);
+
+/*!
+ * @brief make the queued command the ongoing one, or cancel it.
+ *
+ * @param msdInstance     msd instance pointer.
+ * @param status          result status of the command that was ongoing.
+ */
+static void USB_HostMsdStartQueued(usb_host_msd_instance_t *msdInstance, usb_status_t status);
+
+/*!
+ * @brief end the ongoing ufi command with a mass storage reset recovery.
+ *
+ * @param msdInstance     msd instance pointer.
+ */
+static void USB_HostMsdResetRecovery(usb_host_msd_instance_t *msdInstance);
+
 /*!
  * @brief msd open interface.
  *
@@ -184,9 +215,12 @@ static void USB_HostMsdClearHaltCallback(void *param, usb_host_transfer_t *trans
 {
     usb_host_msd_instance_t *msdInstance = (usb_host_msd_instance_t *)param;
 
+    msdInstance->controlTransfer = NULL;
+    USB_HostFreeTransfer(msdInstance->hostHandle, transfer);
     if (status != kStatus_USB_Success)
     {
         USB_HostMsdCommandDone(msdInstance, kStatus_USB_TransferCancel);
+        return;
     }
 
     if (msdInstance->commandStatus == kMSD_CommandErrorDone)
@@ -341,6 +375,147 @@ static void USB_HostMsdCommandDone(usb_host_msd_instance_t *msdInstance, usb_sta
                                        msdInstance->msdCommand.dataSofar, status);
     }
     msdInstance->commandStatus = kMSD_CommandIdle;
+    USB_HostMsdStartQueued(msdInstance, status); /* the queued command goes on */
+}
+
+static void USB_HostMsdResetRecovery(usb_host_msd_instance_t *msdInstance)
+{
+    usb_host_transfer_t *transfer = msdInstance->queuedCommand.transfer;
+
+    msdInstance->internalResetRecovery = 1;
+    msdInstance->commandStatus = kMSD_CommandErrorDone;
+    /* the reset drops whatever CBW the device took, the queued command sends its CBW again afterwards */
+    if (msdInstance->queueStatus == kMSD_QueueTransferCBW)
+    {
+        msdInstance->queueStatus = kMSD_QueueWaiting;
+        USB_HostCancelTransfer(msdInstance->hostHandle, msdInstance->outPipe, transfer);
+    }
+    else if (msdInstance->queueStatus == kMSD_QueueCBWDone)
+    {
+        msdInstance->queueStatus = kMSD_QueueWaiting;
+    }
+    else
+    {
+    }
+    if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
+    {
+        USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
+    }
+}
+
+static void USB_HostMsdStartQueued(usb_host_msd_instance_t *msdInstance, usb_status_t status)
+{
+    usb_host_transfer_t *transfer = msdInstance->msdCommand.transfer;
+    uint8_t queueStatus = msdInstance->queueStatus;
+
+    if ((queueStatus == kMSD_QueueIdle) || (queueStatus == kMSD_QueueCBWInUse))
+    {
+        return;
+    }
+
+    if (status == kStatus_USB_TransferCancel) /* the pipes are being cancelled, the queued command goes too */
+    {
+        msdInstance->queueStatus = kMSD_QueueIdle;
+        if (queueStatus == kMSD_QueueTransferCBW)
+        {
+            USB_HostCancelTransfer(msdInstance->hostHandle, msdInstance->outPipe,
+                                   msdInstance->queuedCommand.transfer);
+        }
+        if (msdInstance->queuedCallbackFn != NULL)
+        {
+            msdInstance->queuedCallbackFn(msdInstance->queuedCallbackParam, msdInstance->queuedCommand.dataBuffer, 0,
+                                          kStatus_USB_TransferCancel);
+        }
+        return;
+    }
+
+    /* the two commands swap transfers, the queued CBW may still be sent from queuedCommand */
+    msdInstance->msdCommand = msdInstance->queuedCommand;
+    msdInstance->queuedCommand.transfer = transfer;
+    msdInstance->commandCallbackFn = msdInstance->queuedCallbackFn;
+    msdInstance->commandCallbackParam = msdInstance->queuedCallbackParam;
+    msdInstance->commandStatus = kMSD_CommandTransferCBW;
+
+    switch (queueStatus)
+    {
+        case kMSD_QueueWaiting:
+            msdInstance->queueStatus = kMSD_QueueIdle;
+            if (USB_HostMsdProcessCommand(msdInstance) != kStatus_USB_Success)
+            {
+                USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
+            }
+            break;
+
+        case kMSD_QueueTransferCBW:
+            /* USB_HostMsdQueuedCbwCallback hands the result to USB_HostMsdCbwCallback */
+            msdInstance->queueStatus = kMSD_QueueCBWInUse;
+            break;
+
+        case kMSD_QueueCBWDone:
+            msdInstance->queueStatus = kMSD_QueueIdle;
+            USB_HostMsdCbwCallback(msdInstance, msdInstance->msdCommand.transfer, msdInstance->queuedCbwStatus);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void USB_HostMsdSendQueuedCbw(usb_host_msd_instance_t *msdInstance)
+{
+    usb_host_transfer_t *transfer;
+
+    if ((msdInstance->queueStatus != kMSD_QueueWaiting) || (msdInstance->internalResetRecovery))
+    {
+        return;
+    }
+    /* the next CBW goes out only once the current command is in its CSW phase */
+    if (msdInstance->commandStatus != kMSD_CommandTransferCSW)
+    {
+        return;
+    }
+
+    if (msdInstance->queuedCommand.transfer == NULL)
+    {
+        if (USB_HostMallocTransfer(msdInstance->hostHandle, &(msdInstance->queuedCommand.transfer)) !=
+            kStatus_USB_Success)
+        {
+            msdInstance->queuedCommand.transfer = NULL;
+            return; /* the CBW is sent when the command starts */
+        }
+    }
+    transfer = msdInstance->queuedCommand.transfer;
+    transfer->direction = USB_OUT;
+    transfer->transferBuffer = (uint8_t *)(&(msdInstance->queuedCommand.cbwBlock));
+    transfer->transferLength = USB_HOST_UFI_CBW_LENGTH;
+    transfer->callbackFn = USB_HostMsdQueuedCbwCallback;
+    transfer->callbackParam = msdInstance;
+    msdInstance->queueStatus = kMSD_QueueTransferCBW;
+    if (USB_HostSend(msdInstance->hostHandle, msdInstance->outPipe, transfer) != kStatus_USB_Success)
+    {
+        msdInstance->queueStatus = kMSD_QueueWaiting;
+    }
+}
+
+static void USB_HostMsdQueuedCbwCallback(void *param, usb_host_transfer_t *transfer, usb_status_t status)
+{
+    usb_host_msd_instance_t *msdInstance = (usb_host_msd_instance_t *)param;
+
+    if (transfer == msdInstance->msdCommand.transfer) /* the command has started meanwhile */
+    {
+        msdInstance->queueStatus = kMSD_QueueIdle;
+        USB_HostMsdCbwCallback(param, transfer, status);
+    }
+    else if (msdInstance->queueStatus == kMSD_QueueTransferCBW)
+    {
+        /* keep the result until the ongoing command is done */
+        msdInstance->queuedCbwStatus = status;
+        msdInstance->queueStatus = kMSD_QueueCBWDone;
+    }
+    else
+    {
+        /* cancelled to be sent again, or with the command */
+    }
 }
 
 static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, usb_status_t status)
@@ -351,7 +526,8 @@ static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, u
     {
         /* kStatus_USB_Success */
         if ((transfer->transferSofar == USB_HOST_UFI_CSW_LENGTH) &&
-            (msdInstance->msdCommand.cswBlock.CSWSignature == USB_LONG_TO_LITTLE_ENDIAN(USB_HOST_MSD_CSW_SIGNATURE)))
+            (msdInstance->msdCommand.cswBlock.CSWSignature == USB_LONG_TO_LITTLE_ENDIAN(USB_HOST_MSD_CSW_SIGNATURE)) &&
+            (msdInstance->msdCommand.cswBlock.CSWTag == msdInstance->msdCommand.cbwBlock.CBWTag))
         {
             switch (msdInstance->msdCommand.cswBlock.CSWStatus)
             {
@@ -364,12 +540,7 @@ static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, u
                     break;
 
                 case 2:
-                    msdInstance->internalResetRecovery = 1;
-                    msdInstance->commandStatus = kMSD_CommandErrorDone;
-                    if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-                    {
-                        USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-                    }
+                    USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
                     break;
 
                 default:
@@ -379,13 +550,7 @@ static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, u
         }
         else
         {
-            /* mass reset recovery to end ufi command */
-            msdInstance->internalResetRecovery = 1;
-            msdInstance->commandStatus = kMSD_CommandErrorDone;
-            if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-            {
-                USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-            }
+            USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
         }
     }
     else
@@ -409,13 +574,7 @@ static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, u
             }
             else
             {
-                /* mass reset recovery to continue ufi command */
-                msdInstance->internalResetRecovery = 1;
-                msdInstance->commandStatus = kMSD_CommandErrorDone;
-                if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-                {
-                    USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-                }
+                USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
             }
         }
         else if (status == kStatus_USB_TransferCancel) /* case 2: cancel */
@@ -434,13 +593,7 @@ static void USB_HostMsdCswCallback(void *param, usb_host_transfer_t *transfer, u
             }
             else
             {
-                /* mass reset recovery to continue ufi command */
-                msdInstance->internalResetRecovery = 1;
-                msdInstance->commandStatus = kMSD_CommandErrorDone;
-                if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-                {
-                    USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-                }
+                USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
             }
         }
     }
@@ -470,13 +623,7 @@ static void USB_HostMsdCbwCallback(void *param, usb_host_transfer_t *transfer, u
             }
             else
             {
-                /* mass reset recovery to continue ufi command */
-                msdInstance->internalResetRecovery = 1;
-                msdInstance->commandStatus = kMSD_CommandErrorDone;
-                if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-                {
-                    USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-                }
+                USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
             }
         }
     }
@@ -493,7 +640,7 @@ static void USB_HostMsdCbwCallback(void *param, usb_host_transfer_t *transfer, u
                 /* clear stall to continue the ufi command */
                 if (USB_HostMsdClearHalt(
                         msdInstance, USB_HostMsdClearHaltCallback,
-                        (USB_REQUEST_TYPE_DIR_OUT | ((usb_host_pipe_t *)msdInstance->inPipe)->endpointAddress)) !=
+                        (USB_REQUEST_TYPE_DIR_OUT | ((usb_host_pipe_t *)msdInstance->outPipe)->endpointAddress)) !=
                     kStatus_USB_Success)
                 {
                     USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
@@ -501,13 +648,7 @@ static void USB_HostMsdCbwCallback(void *param, usb_host_transfer_t *transfer, u
             }
             else
             {
-                /* mass reset recovery to continue ufi command */
-                msdInstance->internalResetRecovery = 1;
-                msdInstance->commandStatus = kMSD_CommandErrorDone;
-                if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-                {
-                    USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-                }
+                USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
             }
         }
         else if (status == kStatus_USB_TransferCancel) /* case 2: cancel */
@@ -526,13 +667,7 @@ static void USB_HostMsdCbwCallback(void *param, usb_host_transfer_t *transfer, u
             }
             else
             {
-                /* mass reset recovery to continue ufi command */
-                msdInstance->internalResetRecovery = 1;
-                msdInstance->commandStatus = kMSD_CommandErrorDone;
-                if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-                {
-                    USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-                }
+                USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
             }
         }
         return;
@@ -560,11 +695,11 @@ static void USB_HostMsdDataCallback(void *param, usb_host_transfer_t *transfer,
             }
             if (transfer->direction == USB_IN)
             {
-                direction = USB_REQUEST_TYPE_DIR_IN;
+                direction = USB_REQUEST_TYPE_DIR_IN | ((usb_host_pipe_t *)msdInstance->inPipe)->endpointAddress;
             }
             else
             {
-                direction = USB_REQUEST_TYPE_DIR_OUT;
+                direction = USB_REQUEST_TYPE_DIR_OUT | ((usb_host_pipe_t *)msdInstance->outPipe)->endpointAddress;
             }
 
             if (msdInstance->msdCommand.retryTime == 0)
@@ -572,9 +707,7 @@ static void USB_HostMsdDataCallback(void *param, usb_host_transfer_t *transfer,
                 msdInstance->commandStatus = kMSD_CommandTransferCSW; /* next step */
             }
             /* clear stall to continue the ufi command */
-            if (USB_HostMsdClearHalt(msdInstance, USB_HostMsdClearHaltCallback,
-                                     (direction | ((usb_host_pipe_t *)msdInstance->inPipe)->endpointAddress)) !=
-                kStatus_USB_Success)
+            if (USB_HostMsdClearHalt(msdInstance, USB_HostMsdClearHaltCallback, direction) != kStatus_USB_Success)
             {
                 USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
             }
@@ -585,13 +718,7 @@ static void USB_HostMsdDataCallback(void *param, usb_host_transfer_t *transfer,
         }
         else /* case 3: error */
         {
-            /* mass reset recovery to finish ufi command */
-            msdInstance->internalResetRecovery = 1;
-            msdInstance->commandStatus = kMSD_CommandErrorDone;
-            if (USB_HostMsdMassStorageReset(msdInstance, NULL, NULL) != kStatus_USB_Success)
-            {
-                USB_HostMsdCommandDone(msdInstance, kStatus_USB_Error);
-            }
+            USB_HostMsdResetRecovery(msdInstance); /* mass reset recovery to end ufi command */
         }
     }
 }
@@ -675,6 +802,7 @@ static usb_status_t USB_HostMsdProcessCommand(usb_host_msd_instance_t *msdInstan
                 /* don't break */
             }
         case kMSD_CommandTransferCSW: /* ufi CSW phase */
+            msdInstance->commandStatus = kMSD_CommandTransferCSW;
             transfer->direction = USB_IN;
             transfer->transferBuffer = (uint8_t *)&msdInstance->msdCommand.cswBlock;
             transfer->transferLength = USB_HOST_UFI_CSW_LENGTH;
@@ -687,6 +815,11 @@ static usb_status_t USB_HostMsdProcessCommand(usb_host_msd_instance_t *msdInstan
                 usb_echo("host recv error\r\n");
 #endif
             }
+            else
+            {
+                /* the next command's CBW waits on the bulk-out pipe while the CSW comes in */
+                USB_HostMsdSendQueuedCbw(msdInstance);
+            }
             break;
 
         case kMSD_CommandDone:
@@ -723,7 +856,8 @@ usb_status_t USB_HostMsdCommand(usb_host_class_handle classHandle,
                                 uint8_t byteValues[10])
 {
     usb_host_msd_instance_t *msdInstance = (usb_host_msd_instance_t *)classHandle;
-    usb_host_cbw_t *cbwPointer = &(msdInstance->msdCommand.cbwBlock);
+    usb_host_msd_command_t *command;
+    usb_host_cbw_t *cbwPointer;
     uint8_t index = 0;
 
     if (classHandle == NULL)
@@ -731,14 +865,28 @@ usb_status_t USB_HostMsdCommand(usb_host_class_handle classHandle,
         return kStatus_USB_InvalidHandle;
     }
 
-    if (msdInstance->commandStatus != kMSD_CommandIdle)
+    if (msdInstance->commandStatus == kMSD_CommandIdle)
+    {
+        command = &(msdInstance->msdCommand);
+        /* save the application callback function */
+        msdInstance->commandCallbackFn = callbackFn;
+        msdInstance->commandCallbackParam = callbackParam;
+    }
+    else if ((msdInstance->queueStatus == kMSD_QueueIdle) && (!msdInstance->internalResetRecovery) &&
+             ((msdInstance->commandStatus == kMSD_CommandTransferCBW) ||
+              (msdInstance->commandStatus == kMSD_CommandTransferData) ||
+              (msdInstance->commandStatus == kMSD_CommandTransferCSW)))
+    {
+        /* queue it behind the ongoing command */
+        command = &(msdInstance->queuedCommand);
+        msdInstance->queuedCallbackFn = callbackFn;
+        msdInstance->queuedCallbackParam = callbackParam;
+    }
+    else
     {
         return kStatus_USB_Busy;
     }
-
-    /* save the application callback function */
-    msdInstance->commandCallbackFn = callbackFn;
-    msdInstance->commandCallbackParam = callbackParam;
+    cbwPointer = &(command->cbwBlock);
 
     /* initialize CBWCB fields */
     for (index = 0; index < USB_HOST_UFI_BLOCK_DATA_VALID_LENGTH; ++index)
@@ -747,26 +895,35 @@ usb_status_t USB_HostMsdCommand(usb_host_class_handle classHandle,
     }
 
     /* initialize CBW fields */
+    cbwPointer->CBWSignature = USB_LONG_TO_LITTLE_ENDIAN(USB_HOST_MSD_CBW_SIGNATURE);
+    cbwPointer->CBWTag = USB_LONG_TO_LITTLE_ENDIAN(++msdInstance->commandTag);
     cbwPointer->CBWDataTransferLength = USB_LONG_TO_LITTLE_ENDIAN(bufferLength);
     cbwPointer->CBWFlags = direction;
     cbwPointer->CBWLun = (byteValues[1] >> USB_HOST_UFI_LOGICAL_UNIT_POSITION);
     cbwPointer->CBWCBLength = USB_HOST_UFI_BLOCK_DATA_VALID_LENGTH;
 
-    msdInstance->commandStatus = kMSD_CommandTransferCBW;
     if (direction == USB_HOST_MSD_CBW_FLAGS_DIRECTION_IN)
     {
-        msdInstance->msdCommand.dataDirection = USB_IN;
+        command->dataDirection = USB_IN;
     }
     else
     {
-        msdInstance->msdCommand.dataDirection = USB_OUT;
+        command->dataDirection = USB_OUT;
     }
-    msdInstance->msdCommand.dataBuffer = buffer;
+    command->dataBuffer = buffer;
 
-    msdInstance->msdCommand.dataLength = bufferLength;
-    msdInstance->msdCommand.dataSofar = 0;
-    msdInstance->msdCommand.retryTime = USB_HOST_MSD_RETRY_MAX_TIME;
+    command->dataLength = bufferLength;
+    command->dataSofar = 0;
+    command->retryTime = USB_HOST_MSD_RETRY_MAX_TIME;
+
+    if (command == &(msdInstance->queuedCommand))
+    {
+        msdInstance->queueStatus = kMSD_QueueWaiting;
+        USB_HostMsdSendQueuedCbw(msdInstance); /* send the CBW now if the CSW phase has started */
+        return kStatus_USB_Success;
+    }
 
+    msdInstance->commandStatus = kMSD_CommandTransferCBW;
     return USB_HostMsdProcessCommand(msdInstance); /* start to process ufi command */
 }
 
@@ -1047,6 +1204,10 @@ usb_status_t USB_HostMsdDeinit(usb_device_handle deviceHandle, usb_host_class_ha
         {
             USB_HostFreeTransfer(msdInstance->hostHandle, msdInstance->msdCommand.transfer);
         }
+        if (msdInstance->queuedCommand.transfer)
+        {
+            USB_HostFreeTransfer(msdInstance->hostHandle, msdInstance->queuedCommand.transfer);
+        }
         USB_HostCloseDeviceInterface(deviceHandle,
                                      msdInstance->interfaceHandle); /* notify host driver the interface is closed */
         USB_OsaMemoryFree(msdInstance);
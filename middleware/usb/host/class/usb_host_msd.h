@@ -73,6 +73,17 @@ typedef enum _usb_host_msd_command_status
     kMSD_CommandErrorDone,
 } usb_host_msd_command_status_t;
 
+/*! @brief State of the command queued behind the one in progress */
+typedef enum _usb_host_msd_queue_status
+{
+    kMSD_QueueIdle = 0,    /*!< No command is queued*/
+    kMSD_QueueWaiting,     /*!< A command is queued, its CBW is not sent yet*/
+    kMSD_QueueTransferCBW, /*!< A command is queued, its CBW is on the bulk-out pipe*/
+    kMSD_QueueCBWDone,     /*!< A command is queued, its CBW transfer has completed*/
+    kMSD_QueueCBWInUse,    /*!< No command is queued, but the CBW of the command in progress is still being sent
+                                from the queue*/
+} usb_host_msd_queue_status_t;
+
 /*! @brief MSC Bulk-Only command block wrapper (CBW) */
 typedef struct _usb_host_cbw
 {
@@ -142,7 +153,13 @@ typedef struct _usb_host_msd_instance
     void *controlCallbackParam;                /*!< MSD control transfer callback parameter*/
     usb_host_transfer_t *controlTransfer;      /*!< Ongoing control transfer*/
     usb_host_msd_command_t msdCommand;         /*!< Ongoing MSD UFI command information*/
+    usb_host_msd_command_t queuedCommand;      /*!< MSD UFI command waiting for the ongoing one*/
+    transfer_callback_t queuedCallbackFn;      /*!< Queued MSD UFI command callback function pointer*/
+    void *queuedCallbackParam;                 /*!< Queued MSD UFI command callback parameter*/
+    usb_status_t queuedCbwStatus;              /*!< Result of the queued command's CBW transfer*/
+    uint32_t commandTag;                       /*!< Tag of the last CBW, echoed back in its CSW*/
     uint8_t commandStatus;                     /*!< UFI command process status, see command_status_t*/
+    uint8_t queueStatus;                       /*!< Queued UFI command status, see usb_host_msd_queue_status_t*/
     uint8_t internalResetRecovery; /*!< 1 - class driver internal mass storage reset recovery is on-going; 0 -
                                       application call USB_HostMsdMassStorageReset to reset or there is no reset*/
 } usb_host_msd_instance_t;
@@ -295,6 +312,11 @@ extern usb_status_t USB_HostMsdGetMaxLun(usb_host_class_handle classHandle,
  * This function implements the UFI READ(10) command. This command requests that the UFI
  * device transfer data to the host.
  *
+ * One command can be issued while another is in progress. It is queued, and its CBW is put
+ * on the bulk-out pipe once the command in progress has entered its CSW phase, so the host
+ * controller sends it right after the device returns the CSW. The callbacks come in the
+ * order the commands were issued.
+ *
  * @param[in] classHandle    The class MSD handle.
  * @param[in] logicalUnit    Logical unit number.
  * @param[in] blockAddress   The start block address.
@@ -306,7 +328,8 @@ extern usb_status_t USB_HostMsdGetMaxLun(usb_host_class_handle classHandle,
  *
  * @retval kStatus_USB_Success        The device is initialized successfully.
  * @retval kStatus_USB_InvalidHandle  The classHandle is NULL pointer.
- * @retval kStatus_USB_Busy           The previous command is executing or there is no idle transfer.
+ * @retval kStatus_USB_Busy           A command is already queued behind the executing one, or there is no idle
+ *                                    transfer.
  * @retval kStatus_USB_Error          Send transfer fail. See the USB_HostSend/USB_HostRecv.
  * @retval kStatus_USB_Success        Callback return status, the command succeed.
  * @retval kStatus_USB_MSDStatusFail  Callback return status, the CSW status indicate this command fail.
@@ -344,6 +344,20 @@ extern void USB_HostKhciTaskFunction(void *hostHandle);
  */
 extern void USB_HostEhciTaskFunction(void *hostHandle);
 
+/*!
+ * @brief EHCI task pending check.
+ *
+ * The function tells whether the EHCI task has controller messages left to handle, including the ones the
+ * task function posts to itself. In the bare metal environment, the main function can sleep until the next
+ * EHCI interrupt once this returns 0.
+ *
+ * @param[in] hostHandle The host handle.
+ *
+ * @retval 1 USB_HostEhciTaskFunction has messages to handle.
+ * @retval 0 Nothing is pending.
+ */
+extern uint8_t USB_HostEhciTaskPending(void *hostHandle);
+
 /*!
  * @brief OHCI task function.
  *
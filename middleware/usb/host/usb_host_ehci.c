@@ -194,6 +194,17 @@ static usb_status_t USB_HostEhciQhQtdListInit(usb_host_ehci_instance_t *ehciInst
                                               usb_host_ehci_pipe_t *ehciPipePointer,
                                               usb_host_transfer_t *transfer);
 
+/*!
+ * @brief compute the data length of one bulk or interrupt qtd.
+ *
+ * @param dataAddress    qtd data start address.
+ * @param endAddress     transfer data end address.
+ * @param maxPacketSize  pipe's max packet size.
+ *
+ *@return the qtd's length.
+ */
+static uint32_t USB_HostEhciQtdDataLength(uint32_t dataAddress, uint32_t endAddress, uint32_t maxPacketSize);
+
 /*!
  * @brief release the qtd list.
  *
@@ -1908,8 +1919,16 @@ static usb_status_t USB_HostEhciQhQtdListInit(usb_host_ehci_instance_t *ehciInst
     }
     else
     {
-        qtdNumber =
-            (((transfer->transferLength) & 0xFFFFC000U) >> 14) + (((transfer->transferLength) & 0x00003FFF) ? 1 : 0);
+        /* one qtd transfers up to five pages of data */
+        qtdNumber   = 0;
+        dataAddress = (uint32_t)transfer->transferBuffer;
+        endAddress  = dataAddress + transfer->transferLength;
+        do
+        {
+            dataAddress +=
+                USB_HostEhciQtdDataLength(dataAddress, endAddress, ehciPipePointer->pipeCommon.maxPacketSize);
+            qtdNumber++;
+        } while (dataAddress < endAddress);
     }
 
     vltQhPointer = (volatile usb_host_ehci_qh_t *)ehciPipePointer->ehciQh;
@@ -2018,11 +2037,9 @@ static usb_status_t USB_HostEhciQhQtdListInit(usb_host_ehci_instance_t *ehciInst
         qtdPointer  = BaseQtdPointer;
         while (1)
         {
-            endAddress = dataAddress + (16 * 1024);
-            if (endAddress > (uint32_t)(transfer->transferBuffer + transfer->transferLength))
-            {
-                endAddress = (uint32_t)(transfer->transferBuffer + transfer->transferLength);
-            }
+            endAddress = (uint32_t)(transfer->transferBuffer + transfer->transferLength);
+            endAddress = dataAddress +
+                         USB_HostEhciQtdDataLength(dataAddress, endAddress, ehciPipePointer->pipeCommon.maxPacketSize);
 
             qtdPointer->alternateNextQtdPointer = EHCI_HOST_T_INVALID_VALUE;
             /* dt: set; ioc: 0; C_Page: 0; PID Code: IN/OUT; Status: Active */
@@ -2095,6 +2112,23 @@ static usb_status_t USB_HostEhciQhQtdListInit(usb_host_ehci_instance_t *ehciInst
     return kStatus_USB_Success;
 }
 
+static uint32_t USB_HostEhciQtdDataLength(uint32_t dataAddress, uint32_t endAddress, uint32_t maxPacketSize)
+{
+    /* the buffer pointers cover the rest of the first page and four more pages */
+    uint32_t length = (5 * 4 * 1024) - (dataAddress & 0x00000FFFU);
+
+    if (length >= (endAddress - dataAddress))
+    {
+        return (endAddress - dataAddress);
+    }
+    /* only the last qtd can end with a short packet */
+    if (maxPacketSize != 0)
+    {
+        length -= (length % maxPacketSize);
+    }
+    return length;
+}
+
 static uint32_t USB_HostEhciQtdListRelease(usb_host_ehci_instance_t *ehciInstance,
                                            usb_host_ehci_qtd_t *ehciQtdStart,
                                            usb_host_ehci_qtd_t *ehciQtdEnd)
@@ -4648,6 +4682,19 @@ void USB_HostEhciTaskFunction(void *hostHandle)
     }
 }
 
+uint8_t USB_HostEhciTaskPending(void *hostHandle)
+{
+    usb_host_ehci_instance_t *ehciInstance;
+
+    if (hostHandle == NULL)
+    {
+        return 0;
+    }
+    ehciInstance = (usb_host_ehci_instance_t *)((usb_host_instance_t *)hostHandle)->controllerHandle;
+
+    return (USB_OsaEventCheck(ehciInstance->taskEventHandle, 0xFF, NULL) == kStatus_USB_OSA_Success) ? 1U : 0U;
+}
+
 void USB_HostEhciIsrFunction(void *hostHandle)
 {
     usb_host_ehci_instance_t *ehciInstance;